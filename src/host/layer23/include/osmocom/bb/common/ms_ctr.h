@@ -0,0 +1,37 @@
+#ifndef _MS_CTR_H
+#define _MS_CTR_H
+
+#include <osmocom/core/rate_ctr.h>
+
+enum ms_ctr {
+	MS_CTR_L1CTL_RX,
+	MS_CTR_L1CTL_TX,
+	MS_CTR_L1CTL_BIT_ERR,
+	MS_CTR_LAPDM_RETRANS,
+	MS_CTR_RR_CHAN_REQ,
+	MS_CTR_RR_PAGING,
+	MS_CTR_RR_IMM_ASS,
+	MS_CTR_RR_IMM_ASS_REJ,
+	MS_CTR_RR_RA_FAIL,
+	MS_CTR_RR_CHAN_REL,
+	MS_CTR_RR_TIMEOUT,
+	MS_CTR_MM_LOC_UPD_REQ,
+	MS_CTR_MM_LOC_UPD_ACC,
+	MS_CTR_MM_LOC_UPD_REJ,
+	MS_CTR_MM_TIMEOUT,
+};
+
+struct osmocom_ms;
+
+/* counters are optional, the group is NULL if allocation failed */
+#define MS_CTR_INC(ms, idx) \
+	do { \
+		if ((ms)->ctrg) \
+			rate_ctr_inc(&(ms)->ctrg->ctr[idx]); \
+	} while (0)
+
+int ms_ctr_init(struct osmocom_ms *ms);
+void ms_ctr_lapdm(struct osmocom_ms *ms);
+int ms_ctr_export(void *ctx, const char *dest, unsigned int interval);
+
+#endif /* _MS_CTR_H */
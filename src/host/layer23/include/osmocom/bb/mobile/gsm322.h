@@ -162,6 +162,7 @@ struct gsm322_cellsel {
 
 	struct llist_head	event_queue; /* event messages */
 	struct llist_head	ba_list; /* BCCH Allocation per PLMN */
+	void			*si_pool; /* talloc pool for sysinfo */
 	struct gsm322_cs_list	list[1024+299];
 					/* cell selection list per frequency. */
 	/* scan and tune state */
@@ -233,7 +233,7 @@ static int rx_ph_data_ind(struct osmocom_ms *ms, struct msgb *msg)
 	}
 
 	if (dl->fire_crc >= 2) {
-printf("Dropping frame with %u bit errors\n", dl->num_biterr);
+		MS_CTR_INC(ms, MS_CTR_L1CTL_BIT_ERR);
 		LOGP(DL1C, LOGL_NOTICE, "Dropping frame with %u bit errors\n",
 			dl->num_biterr);
 		msgb_free(msg);
@@ -905,6 +905,7 @@ int l1ctl_recv(struct osmocom_ms *ms, struct msgb *msg)
 		return -1;
 	}
 
+	MS_CTR_INC(ms, MS_CTR_L1CTL_RX);
 	l1h = (struct l1ctl_hdr *) msg->l1h;
 
 	/* move the l1 header pointer to point _BEHIND_ l1ctl_hdr,
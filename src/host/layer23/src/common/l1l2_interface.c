@@ -41,6 +41,7 @@
 
 #define GSM_L2_LENGTH 256
 #define GSM_L2_HEADROOM 32
+#define L1L2_WQ_BATCH 16
 
 static int layer2_read(struct osmo_fd *fd)
 {
@@ -86,22 +87,6 @@ static int layer2_read(struct osmo_fd *fd)
 	return 0;
 }
 
-static int layer2_write(struct osmo_fd *fd, struct msgb *msg)
-{
-	int rc;
-
-	if (fd->fd <= 0)
-		return -EINVAL;
-
-	rc = write(fd->fd, msg->data, msg->len);
-	if (rc != msg->len) {
-		LOGP(DL1C, LOGL_ERROR, "Failed to write data: rc: %d\n", rc);
-		return rc;
-	}
-
-	return 0;
-}
-
 int layer2_open(struct osmocom_ms *ms, const char *socket_path)
 {
 	int rc;
@@ -126,11 +111,12 @@ int layer2_open(struct osmocom_ms *ms, const char *socket_path)
 		return rc;
 	}
 
-	osmo_wqueue_init(&ms->l2_wq, 100);
+	/* bursts of L1CTL messages are written with one writev(), a
+	 * short write no longer breaks the framing */
+	osmo_wqueue_init_batch(&ms->l2_wq, 100, L1L2_WQ_BATCH);
 	ms->l2_wq.bfd.data = ms;
 	ms->l2_wq.bfd.when = BSC_FD_READ;
 	ms->l2_wq.read_cb = layer2_read;
-	ms->l2_wq.write_cb = layer2_write;
 
 	rc = osmo_fd_register(&ms->l2_wq.bfd);
 	if (rc != 0) {
@@ -173,6 +159,7 @@ int osmo_send_l1(struct osmocom_ms *ms, struct msgb *msg)
 		msgb_free(msg);
 		return -1;
 	}
+	MS_CTR_INC(ms, MS_CTR_L1CTL_TX);
 
 	return 0;
 }
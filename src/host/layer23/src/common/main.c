@@ -63,6 +63,8 @@ int (*l23_app_work) (struct osmocom_ms *ms) = NULL;
 int (*l23_app_exit) (struct osmocom_ms *ms) = NULL;
 int quit = 0;
 struct gsmtap_inst *gsmtap_inst;
+static const char *stats_dest = NULL;
+static unsigned int stats_interval = 10;
 
 const char *openbsc_copyright =
 	"%s"
@@ -111,6 +113,11 @@ static void print_help()
 		printf("  -u --vty-ip		The VTY IP to bind telnet to. "
 			"(default %s)\n", vty_ip);
 
+	printf("  -e --stats DEST		Export counters to host:port or "
+		"unix:path\n");
+	printf("  -E --stats-interval SEC	Seconds between two exports. "
+		"(default %u)\n", stats_interval);
+
 	if (app && app->cfg_print_help)
 		app->cfg_print_help();
 }
@@ -130,11 +137,13 @@ static void build_config(char **opt, struct option **option)
 		{"vty-ip", 1, 0, 'u'},
 		{"vty-port", 1, 0, 'v'},
 		{"debug", 1, 0, 'd'},
+		{"stats", 1, 0, 'e'},
+		{"stats-interval", 1, 0, 'E'},
 	};
 
 
 	app = l23_app_info();
-	*opt = talloc_asprintf(l23_ctx, "hs:S:a:i:v:d:u:%s",
+	*opt = talloc_asprintf(l23_ctx, "hs:S:a:i:v:d:u:e:E:%s",
 			       app && app->getopt_string ? app->getopt_string : "");
 
 	len = ARRAY_SIZE(long_options);
@@ -189,6 +198,12 @@ static void handle_options(int argc, char **argv)
 		case 'd':
 			log_parse_category_mask(stderr_target, optarg);
 			break;
+		case 'e':
+			stats_dest = optarg;
+			break;
+		case 'E':
+			stats_interval = atoi(optarg);
+			break;
 		default:
 			if (app && app->cfg_handle_opt)
 				app->cfg_handle_opt(c, optarg);
@@ -235,6 +250,7 @@ int main(int argc, char **argv)
 	log_set_all_filter(stderr_target, 1);
 
 	l23_ctx = talloc_named_const(NULL, 1, "layer2 context");
+	rate_ctr_init(l23_ctx);
 
 	ms = talloc_zero(l23_ctx, struct osmocom_ms);
 	if (!ms) {
@@ -247,6 +263,7 @@ int main(int argc, char **argv)
 	llist_add_tail(&ms->entity, &ms_list);
 
 	sprintf(ms->name, "1");
+	ms_ctr_init(ms);
 
 	ms->test_arfcn = 871;
 
@@ -268,6 +285,7 @@ int main(int argc, char **argv)
 	ms->lapdm_channel.lapdm_acch.l3_ctx = ms;
 	lapdm_channel_init(&ms->lapdm_channel, LAPDM_MODE_MS);
 	lapdm_channel_set_l1(&ms->lapdm_channel, l1ctl_ph_prim_cb, ms);
+	ms_ctr_lapdm(ms);
 
 	rc = l23_app_init(ms);
 	if (rc < 0)
@@ -282,6 +300,9 @@ int main(int argc, char **argv)
 		gsmtap_source_add_sink(gsmtap_inst);
 	}
 
+	if (stats_dest && ms_ctr_export(l23_ctx, stats_dest, stats_interval))
+		exit(1);
+
 	signal(SIGINT, sighandler);
 	signal(SIGHUP, sighandler);
 	signal(SIGTERM, sighandler);
@@ -0,0 +1,105 @@
+/* Per MS event counters */
+
+/* (C) 2026 by the OsmocomBB developers
+ *
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <errno.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/stats_export.h>
+
+#include <osmocom/bb/common/osmocom_data.h>
+#include <osmocom/bb/common/ms_ctr.h>
+
+static const struct rate_ctr_desc ms_ctr_desc[] = {
+	[MS_CTR_L1CTL_RX] =	  { "l1ctl:rx", "L1CTL messages received" },
+	[MS_CTR_L1CTL_TX] =	  { "l1ctl:tx", "L1CTL messages sent" },
+	[MS_CTR_L1CTL_BIT_ERR] =  { "l1ctl:bit_err",
+				    "Frames dropped due to bit errors" },
+	[MS_CTR_LAPDM_RETRANS] =  { "lapdm:retrans",
+				    "LAPDm frames retransmitted on T200" },
+	[MS_CTR_RR_CHAN_REQ] =	  { "rr:chan_req", "Channel requests" },
+	[MS_CTR_RR_PAGING] =	  { "rr:paging", "Paging requests for us" },
+	[MS_CTR_RR_IMM_ASS] =	  { "rr:imm_ass",
+				    "Immediate assignments for us" },
+	[MS_CTR_RR_IMM_ASS_REJ] = { "rr:imm_ass_rej",
+				    "Immediate assignment rejects for us" },
+	[MS_CTR_RR_RA_FAIL] =	  { "rr:ra_fail", "Random access failures" },
+	[MS_CTR_RR_CHAN_REL] =	  { "rr:chan_rel", "Channel releases" },
+	[MS_CTR_RR_TIMEOUT] =	  { "rr:timeout", "RR timer expiries" },
+	[MS_CTR_MM_LOC_UPD_REQ] = { "mm:loc_upd_req",
+				    "Location updating requests" },
+	[MS_CTR_MM_LOC_UPD_ACC] = { "mm:loc_upd_acc",
+				    "Location updating accepts" },
+	[MS_CTR_MM_LOC_UPD_REJ] = { "mm:loc_upd_rej",
+				    "Location updating rejects" },
+	[MS_CTR_MM_TIMEOUT] =	  { "mm:timeout", "MM timer expiries" },
+};
+
+static const struct rate_ctr_group_desc ms_ctrg_desc = {
+	.group_name_prefix = "ms",
+	.group_description = "Mobile station",
+	.num_ctr = ARRAY_SIZE(ms_ctr_desc),
+	.ctr_desc = ms_ctr_desc,
+};
+
+/* allocate the counters of an MS, they are freed together with it */
+int ms_ctr_init(struct osmocom_ms *ms)
+{
+	static unsigned int idx;
+
+	ms->ctrg = rate_ctr_group_alloc(ms, &ms_ctrg_desc, idx++);
+	if (!ms->ctrg) {
+		fprintf(stderr, "Failed to allocate counters of MS '%s'\n",
+			ms->name);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+/* let LAPDm count its retransmissions, after lapdm_channel_init() */
+void ms_ctr_lapdm(struct osmocom_ms *ms)
+{
+	struct rate_ctr *ctr;
+	int i;
+
+	if (!ms->ctrg)
+		return;
+
+	ctr = &ms->ctrg->ctr[MS_CTR_LAPDM_RETRANS];
+	for (i = 0; i < _NR_DL_SAPI; i++) {
+		ms->lapdm_channel.lapdm_dcch.datalink[i].dl.ctr_retrans = ctr;
+		ms->lapdm_channel.lapdm_acch.datalink[i].dl.ctr_retrans = ctr;
+	}
+}
+
+/* export all counters to "host:port" or "unix:path" */
+int ms_ctr_export(void *ctx, const char *dest, unsigned int interval)
+{
+	if (!osmo_stats_export_create(ctx, dest, "l23", interval)) {
+		fprintf(stderr, "Failed to export counters to '%s'\n", dest);
+		return -EINVAL;
+	}
+
+	return 0;
+}
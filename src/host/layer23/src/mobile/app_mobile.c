@@ -37,6 +37,7 @@
 #include <osmocom/bb/mobile/app_mobile.h>
 #include <osmocom/bb/mobile/mncc.h>
 #include <osmocom/bb/mobile/voice.h>
+#include <osmocom/bb/mobile/transaction.h>
 #include <osmocom/vty/telnet_interface.h>
 
 #include <osmocom/core/msgb.h>
@@ -46,6 +47,9 @@
 
 #include <l1ctl_proto.h>
 
+/* number of transactions allocated from the pool of each MS */
+#define MOBILE_TRANS_POOL	4
+
 extern void *l23_ctx;
 extern struct llist_head ms_list;
 extern int vty_reading;
@@ -150,6 +154,8 @@ int mobile_exit(struct osmocom_ms *ms, int force)
 	gsm411_sms_exit(ms);
 	gsm_sim_exit(ms);
 	lapdm_channel_exit(&ms->lapdm_channel);
+	talloc_free(ms->trans_pool);
+	ms->trans_pool = NULL;
 
 	ms->shutdown = 2; /* being down */
 	vty_notify(ms, NULL);
@@ -168,6 +174,7 @@ int mobile_init(struct osmocom_ms *ms)
 
 	lapdm_channel_init(&ms->lapdm_channel, LAPDM_MODE_MS);
 	lapdm_channel_set_l1(&ms->lapdm_channel, l1ctl_ph_prim_cb, ms);
+	ms_ctr_lapdm(ms);
 
 	gsm_sim_init(ms);
 	gsm48_cc_init(ms);
@@ -178,6 +185,9 @@ int mobile_init(struct osmocom_ms *ms)
 	gsm48_rr_init(ms);
 	gsm48_mm_init(ms);
 	INIT_LLIST_HEAD(&ms->trans_list);
+	/* transactions are short lived, keep a few of them in one block */
+	ms->trans_pool = talloc_pool(ms, MOBILE_TRANS_POOL *
+		(sizeof(struct gsm_trans) + 128));
 	gsm322_init(ms);
 
 	rc = layer2_open(ms, ms->settings.layer2_socket_path);
@@ -228,6 +238,7 @@ struct osmocom_ms *mobile_new(char *name)
 	llist_add_tail(&ms->entity, &ms_list);
 
 	strcpy(ms->name, name);
+	ms_ctr_init(ms);
 
 	ms->l2_wq.bfd.fd = -1;
 	ms->sap_wq.bfd.fd = -1;
@@ -64,6 +64,10 @@ static int gsm322_nb_meas_ind(struct osmocom_ms *ms, uint16_t arfcn,
 #define SYNC_RETRIES		1
 #define SYNC_RETRIES_SERVING	2
 
+/* number of sysinfo structures allocated from the pool before we fall
+ * back to individual allocations */
+#define SYSINFO_POOL_CELLS	32
+
 /* time for trying to sync and read BCCH of neighbour cell again
  * NOTE: This value is not defined by TS, i think. */
 #define GSM58_TRY_AGAIN		30
@@ -2147,7 +2151,7 @@ static int gsm322_search_end(struct osmocom_ms *ms)
 		cs->arfcn = cs->sel_arfcn;
 		cs->arfci = arfcn2index(cs->arfcn);
 		if (!cs->list[cs->arfci].sysinfo)
-			cs->list[cs->arfci].sysinfo = talloc_zero(l23_ctx,
+			cs->list[cs->arfci].sysinfo = talloc_zero(cs->si_pool,
 							struct gsm48_sysinfo);
 		if (!cs->list[cs->arfci].sysinfo)
 			exit(-ENOMEM);
@@ -2254,7 +2258,7 @@ static int gsm322_cs_scan(struct osmocom_ms *ms)
 		memset(cs->list[cs->arfci].sysinfo, 0,
 			sizeof(struct gsm48_sysinfo));
 	else
-		cs->list[cs->arfci].sysinfo = talloc_zero(l23_ctx,
+		cs->list[cs->arfci].sysinfo = talloc_zero(cs->si_pool,
 						struct gsm48_sysinfo);
 	if (!cs->list[cs->arfci].sysinfo)
 		exit(-ENOMEM);
@@ -4411,7 +4415,7 @@ no_cell_found:
 		memset(cs->list[cs->arfci].sysinfo, 0,
 			sizeof(struct gsm48_sysinfo));
 	else
-		cs->list[cs->arfci].sysinfo = talloc_zero(l23_ctx,
+		cs->list[cs->arfci].sysinfo = talloc_zero(cs->si_pool,
 						struct gsm48_sysinfo);
 	if (!cs->list[cs->arfci].sysinfo)
 		exit(-ENOMEM);
@@ -4583,7 +4587,7 @@ printf("%d time to sync again: %u\n", nb->arfcn, now + GSM58_READ_AGAIN - nb->wh
 			memset(cs->list[cs->arfci].sysinfo, 0,
 				sizeof(struct gsm48_sysinfo));
 		else
-			cs->list[cs->arfci].sysinfo = talloc_zero(l23_ctx,
+			cs->list[cs->arfci].sysinfo = talloc_zero(cs->si_pool,
 							struct gsm48_sysinfo);
 		if (!cs->list[cs->arfci].sysinfo)
 			exit(-ENOMEM);
@@ -5030,6 +5034,13 @@ int gsm322_init(struct osmocom_ms *ms)
 	plmn->ms = ms;
 	cs->ms = ms;
 
+	/* the sysinfo of a scan is allocated from one block, it is given
+	 * back when all of them are flushed */
+	cs->si_pool = talloc_pool(ms, SYSINFO_POOL_CELLS *
+		(sizeof(struct gsm48_sysinfo) + 128));
+	if (!cs->si_pool)
+		return -ENOMEM;
+
 	/* set initial state */
 	plmn->state = 0;
 	cs->state = 0;
@@ -5166,5 +5177,7 @@ int gsm322_exit(struct osmocom_ms *ms)
 	llist_for_each_safe(lh, lh2, &cs->nb_list)
 		gsm322_nb_free(container_of(lh, struct gsm322_neighbour,
 				entry));
+	talloc_free(cs->si_pool);
+	cs->si_pool = NULL;
 	return 0;
 }
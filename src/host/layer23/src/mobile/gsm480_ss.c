@@ -1067,20 +1067,20 @@ static int gsm480_rx_release_comp(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	int rc = 0;
 
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
-		rc = gsm480_rx_fac_ie(trans, TLVP_VAL(&tp, GSM48_IE_FACILITY),
-			*(TLVP_VAL(&tp, GSM48_IE_FACILITY)-1));
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
+		rc = gsm480_rx_fac_ie(trans, TLVS_VAL(&tp, GSM48_IE_FACILITY),
+			*(TLVS_VAL(&tp, GSM48_IE_FACILITY)-1));
 	} else {
 		/* facility optional */
 		LOGP(DSS, LOGL_INFO, "No facility IE received\n");
-		if (TLVP_PRESENT(&tp, GSM48_IE_CAUSE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_CAUSE)) {
 			rc = gsm480_rx_cause_ie(trans,
-				TLVP_VAL(&tp, GSM48_IE_CAUSE),
-				*(TLVP_VAL(&tp, GSM48_IE_CAUSE)-1));
+				TLVS_VAL(&tp, GSM48_IE_CAUSE),
+				*(TLVS_VAL(&tp, GSM48_IE_CAUSE)-1));
 		}
 	}
 
@@ -1100,17 +1100,17 @@ static int gsm480_rx_facility(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	int rc = 0;
 
 	/* go register state */
 	trans->ss.state = GSM480_SS_ST_ACTIVE;
 
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
 		GSM48_IE_FACILITY, 0);
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
-		rc = gsm480_rx_fac_ie(trans, TLVP_VAL(&tp, GSM48_IE_FACILITY),
-			*(TLVP_VAL(&tp, GSM48_IE_FACILITY)-1));
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
+		rc = gsm480_rx_fac_ie(trans, TLVS_VAL(&tp, GSM48_IE_FACILITY),
+			*(TLVS_VAL(&tp, GSM48_IE_FACILITY)-1));
 	} else {
 		LOGP(DSS, LOGL_INFO, "No facility IE received\n");
 		/* release 3.7.5 */
@@ -1132,16 +1132,16 @@ static int gsm480_rx_register(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	int rc = 0;
 
 	/* go register state */
 	trans->ss.state = GSM480_SS_ST_ACTIVE;
 
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
-		rc = gsm480_rx_fac_ie(trans, TLVP_VAL(&tp, GSM48_IE_FACILITY),
-			*(TLVP_VAL(&tp, GSM48_IE_FACILITY)-1));
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
+		rc = gsm480_rx_fac_ie(trans, TLVS_VAL(&tp, GSM48_IE_FACILITY),
+			*(TLVS_VAL(&tp, GSM48_IE_FACILITY)-1));
 	} else {
 		/* facility optional */
 		LOGP(DSS, LOGL_INFO, "No facility IE received\n");
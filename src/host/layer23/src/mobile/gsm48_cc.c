@@ -622,28 +622,28 @@ static int gsm48_cc_rx_progress(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc progress;
 
 	LOGP(DCC, LOGL_INFO, "received PROGRESS\n");
 
 	memset(&progress, 0, sizeof(struct gsm_mncc));
 	progress.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
 		GSM48_IE_PROGR_IND, 0);
 	/* progress */
-	if (TLVP_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
 		progress.fields |= MNCC_F_PROGRESS;
 		gsm48_decode_progress(&progress.progress,
-				TLVP_VAL(&tp, GSM48_IE_PROGR_IND)-1);
+				TLVS_VAL(&tp, GSM48_IE_PROGR_IND)-1);
 		/* store last progress indicator */
 		trans->cc.prog_ind = progress.progress.descr;
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		progress.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&progress.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	return mncc_recvmsg(trans->ms, trans, MNCC_PROGRESS_IND, &progress);
@@ -655,7 +655,7 @@ static int gsm48_cc_rx_call_proceeding(struct gsm_trans *trans,
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc call_proc;
 
 	LOGP(DCC, LOGL_INFO, "sending CALL PROCEEDING\n");
@@ -664,32 +664,32 @@ static int gsm48_cc_rx_call_proceeding(struct gsm_trans *trans,
 
 	memset(&call_proc, 0, sizeof(struct gsm_mncc));
 	call_proc.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 #if 0
 	/* repeat */
-	if (TLVP_PRESENT(&tp, GSM48_IE_REPEAT_CIR))
+	if (TLVS_PRESENT(&tp, GSM48_IE_REPEAT_CIR))
 		call_conf.repeat = 1;
-	if (TLVP_PRESENT(&tp, GSM48_IE_REPEAT_SEQ))
+	if (TLVS_PRESENT(&tp, GSM48_IE_REPEAT_SEQ))
 		call_conf.repeat = 2;
 #endif
 	/* bearer capability */
-	if (TLVP_PRESENT(&tp, GSM48_IE_BEARER_CAP)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_BEARER_CAP)) {
 		call_proc.fields |= MNCC_F_BEARER_CAP;
 		gsm48_decode_bearer_cap(&call_proc.bearer_cap,
-				  TLVP_VAL(&tp, GSM48_IE_BEARER_CAP)-1);
+				  TLVS_VAL(&tp, GSM48_IE_BEARER_CAP)-1);
 	}
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		call_proc.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&call_proc.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 
 	/* progress */
-	if (TLVP_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
 		call_proc.fields |= MNCC_F_PROGRESS;
 		gsm48_decode_progress(&call_proc.progress,
-				TLVP_VAL(&tp, GSM48_IE_PROGR_IND)-1);
+				TLVS_VAL(&tp, GSM48_IE_PROGR_IND)-1);
 		/* store last progress indicator */
 		trans->cc.prog_ind = call_proc.progress.descr;
 	}
@@ -711,7 +711,7 @@ static int gsm48_cc_rx_alerting(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc alerting;
 
 	LOGP(DCC, LOGL_INFO, "received ALERTING\n");
@@ -721,24 +721,24 @@ static int gsm48_cc_rx_alerting(struct gsm_trans *trans, struct msgb *msg)
 
 	memset(&alerting, 0, sizeof(struct gsm_mncc));
 	alerting.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		alerting.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&alerting.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 	/* progress */
-	if (TLVP_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
 		alerting.fields |= MNCC_F_PROGRESS;
 		gsm48_decode_progress(&alerting.progress,
-				TLVP_VAL(&tp, GSM48_IE_PROGR_IND)-1);
+				TLVS_VAL(&tp, GSM48_IE_PROGR_IND)-1);
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		alerting.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&alerting.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	new_cc_state(trans, GSM_CSTATE_CALL_DELIVERED);
@@ -752,7 +752,7 @@ static int gsm48_cc_rx_connect(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc connect;
 
 	LOGP(DCC, LOGL_INFO, "received CONNECT\n");
@@ -761,30 +761,30 @@ static int gsm48_cc_rx_connect(struct gsm_trans *trans, struct msgb *msg)
 
 	memset(&connect, 0, sizeof(struct gsm_mncc));
 	connect.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		connect.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&connect.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 	/* connected */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CONN_BCD)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CONN_BCD)) {
 		connect.fields |= MNCC_F_CONNECTED;
 		gsm48_decode_connected(&connect.connected,
-				TLVP_VAL(&tp, GSM48_IE_CONN_BCD)-1);
+				TLVS_VAL(&tp, GSM48_IE_CONN_BCD)-1);
 	}
 	/* progress */
-	if (TLVP_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
 		connect.fields |= MNCC_F_PROGRESS;
 		gsm48_decode_progress(&connect.progress,
-				TLVP_VAL(&tp, GSM48_IE_PROGR_IND)-1);
+				TLVS_VAL(&tp, GSM48_IE_PROGR_IND)-1);
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		connect.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&connect.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	/* ACTIVE state is set during this: */
@@ -822,62 +822,62 @@ static int gsm48_cc_rx_setup(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc setup;
 
 	LOGP(DCC, LOGL_INFO, "received SETUP\n");
 
 	memset(&setup, 0, sizeof(struct gsm_mncc));
 	setup.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 
 	/* bearer capability */
-	if (TLVP_PRESENT(&tp, GSM48_IE_BEARER_CAP)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_BEARER_CAP)) {
 		setup.fields |= MNCC_F_BEARER_CAP;
 		gsm48_decode_bearer_cap(&setup.bearer_cap,
-				  TLVP_VAL(&tp, GSM48_IE_BEARER_CAP)-1);
+				  TLVS_VAL(&tp, GSM48_IE_BEARER_CAP)-1);
 	}
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		setup.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&setup.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 	/* progress */
-	if (TLVP_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
 		setup.fields |= MNCC_F_PROGRESS;
 		gsm48_decode_progress(&setup.progress,
-				TLVP_VAL(&tp, GSM48_IE_PROGR_IND)-1);
+				TLVS_VAL(&tp, GSM48_IE_PROGR_IND)-1);
 	}
 	/* signal */
-	if (TLVP_PRESENT(&tp, GSM48_IE_SIGNAL)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_SIGNAL)) {
 		setup.fields |= MNCC_F_SIGNAL;
 		gsm48_decode_signal(&setup.signal,
-				TLVP_VAL(&tp, GSM48_IE_SIGNAL)-1);
+				TLVS_VAL(&tp, GSM48_IE_SIGNAL)-1);
 	}
 	/* calling party bcd number */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CALLING_BCD)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CALLING_BCD)) {
 		setup.fields |= MNCC_F_CALLING;
 		gsm48_decode_calling(&setup.calling,
-			      TLVP_VAL(&tp, GSM48_IE_CALLING_BCD)-1);
+			      TLVS_VAL(&tp, GSM48_IE_CALLING_BCD)-1);
 	}
 	/* called party bcd number */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CALLED_BCD)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CALLED_BCD)) {
 		setup.fields |= MNCC_F_CALLED;
 		gsm48_decode_called(&setup.called,
-			      TLVP_VAL(&tp, GSM48_IE_CALLED_BCD)-1);
+			      TLVS_VAL(&tp, GSM48_IE_CALLED_BCD)-1);
 	}
 	/* redirecting party bcd number */
-	if (TLVP_PRESENT(&tp, GSM48_IE_REDIR_BCD)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_REDIR_BCD)) {
 		setup.fields |= MNCC_F_REDIRECTING;
 		gsm48_decode_redirecting(&setup.redirecting,
-			      TLVP_VAL(&tp, GSM48_IE_REDIR_BCD)-1);
+			      TLVS_VAL(&tp, GSM48_IE_REDIR_BCD)-1);
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		setup.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&setup.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	new_cc_state(trans, GSM_CSTATE_CALL_PRESENT);
@@ -1075,19 +1075,19 @@ static int gsm48_cc_rx_start_dtmf_ack(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc dtmf;
 
 	LOGP(DCC, LOGL_INFO, "received START DTMF ACKNOWLEDGE\n");
 
 	memset(&dtmf, 0, sizeof(struct gsm_mncc));
 	dtmf.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 	/* keypad facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_KPD_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_KPD_FACILITY)) {
 		dtmf.fields |= MNCC_F_KEYPAD;
 		gsm48_decode_keypad(&dtmf.keypad,
-			      TLVP_VAL(&tp, GSM48_IE_KPD_FACILITY)-1);
+			      TLVS_VAL(&tp, GSM48_IE_KPD_FACILITY)-1);
 	}
 
 	return mncc_recvmsg(trans->ms, trans, MNCC_START_DTMF_RSP, &dtmf);
@@ -1138,14 +1138,14 @@ static int gsm48_cc_rx_stop_dtmf_ack(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc dtmf;
 
 	LOGP(DCC, LOGL_INFO, "received STOP DTMF ACKNOWLEDGE\n");
 
 	memset(&dtmf, 0, sizeof(struct gsm_mncc));
 	dtmf.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 
 	return mncc_recvmsg(trans->ms, trans, MNCC_STOP_DTMF_RSP, &dtmf);
 }
@@ -1334,7 +1334,7 @@ static int gsm48_cc_rx_userinfo(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc user;
 
 	LOGP(DCC, LOGL_INFO, "received USERINFO\n");
@@ -1346,13 +1346,13 @@ static int gsm48_cc_rx_userinfo(struct gsm_trans *trans, struct msgb *msg)
 			"error.\n");
 		return -EINVAL;
 	}
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
 		GSM48_IE_USER_USER, 0);
 	/* user-user */
 	gsm48_decode_useruser(&user.useruser,
-			TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+			TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	/* more data */
-	if (TLVP_PRESENT(&tp, GSM48_IE_MORE_DATA))
+	if (TLVS_PRESENT(&tp, GSM48_IE_MORE_DATA))
 		user.more = 1;
 
 	return mncc_recvmsg(trans->ms, trans, MNCC_USERINFO_IND, &user);
@@ -1416,7 +1416,7 @@ static int gsm48_cc_rx_modify_reject(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc modify;
 
 	LOGP(DCC, LOGL_INFO, "received MODIFY REJECT\n");
@@ -1430,19 +1430,19 @@ static int gsm48_cc_rx_modify_reject(struct gsm_trans *trans, struct msgb *msg)
 			"error.\n");
 		return -EINVAL;
 	}
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
 		GSM48_IE_BEARER_CAP, GSM48_IE_CAUSE);
 	/* bearer capability */
-	if (TLVP_PRESENT(&tp, GSM48_IE_BEARER_CAP)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_BEARER_CAP)) {
 		modify.fields |= MNCC_F_BEARER_CAP;
 		gsm48_decode_bearer_cap(&modify.bearer_cap,
-				  TLVP_VAL(&tp, GSM48_IE_BEARER_CAP)-1);
+				  TLVS_VAL(&tp, GSM48_IE_BEARER_CAP)-1);
 	}
 	/* cause */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CAUSE)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CAUSE)) {
 		modify.fields |= MNCC_F_CAUSE;
 		gsm48_decode_cause(&modify.cause,
-			     TLVP_VAL(&tp, GSM48_IE_CAUSE)-1);
+			     TLVS_VAL(&tp, GSM48_IE_CAUSE)-1);
 	}
 
 	new_cc_state(trans, GSM_CSTATE_ACTIVE);
@@ -1674,7 +1674,7 @@ static int gsm48_cc_rx_disconnect(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc disc;
 
 	LOGP(DCC, LOGL_INFO, "received DISCONNECT\n");
@@ -1685,31 +1685,31 @@ static int gsm48_cc_rx_disconnect(struct gsm_trans *trans, struct msgb *msg)
 
 	memset(&disc, 0, sizeof(struct gsm_mncc));
 	disc.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len,
 		GSM48_IE_CAUSE, 0);
 	/* cause */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CAUSE)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CAUSE)) {
 		disc.fields |= MNCC_F_CAUSE;
 		gsm48_decode_cause(&disc.cause,
-			     TLVP_VAL(&tp, GSM48_IE_CAUSE)-1);
+			     TLVS_VAL(&tp, GSM48_IE_CAUSE)-1);
 	}
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		disc.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&disc.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 	/* progress */
-	if (TLVP_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_PROGR_IND)) {
 		disc.fields |= MNCC_F_PROGRESS;
 		gsm48_decode_progress(&disc.progress,
-				TLVP_VAL(&tp, GSM48_IE_PROGR_IND)-1);
+				TLVS_VAL(&tp, GSM48_IE_PROGR_IND)-1);
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		disc.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&disc.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	/* store disconnect cause for T305 expiry */
@@ -1723,7 +1723,7 @@ static int gsm48_cc_rx_release(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc rel;
 
 	LOGP(DCC, LOGL_INFO, "received RELEASE\n");
@@ -1732,24 +1732,24 @@ static int gsm48_cc_rx_release(struct gsm_trans *trans, struct msgb *msg)
 
 	memset(&rel, 0, sizeof(struct gsm_mncc));
 	rel.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 	/* cause */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CAUSE)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CAUSE)) {
 		rel.fields |= MNCC_F_CAUSE;
 		gsm48_decode_cause(&rel.cause,
-			     TLVP_VAL(&tp, GSM48_IE_CAUSE)-1);
+			     TLVS_VAL(&tp, GSM48_IE_CAUSE)-1);
 	}
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		rel.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&rel.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		rel.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&rel.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	/* in case we receive a relase, when we are already in NULL state */
@@ -1792,7 +1792,7 @@ static int gsm48_cc_rx_release_compl(struct gsm_trans *trans, struct msgb *msg)
 {
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm_mncc rel;
 
 	LOGP(DCC, LOGL_INFO, "received RELEASE COMPLETE\n");
@@ -1801,24 +1801,24 @@ static int gsm48_cc_rx_release_compl(struct gsm_trans *trans, struct msgb *msg)
 
 	memset(&rel, 0, sizeof(struct gsm_mncc));
 	rel.callref = trans->callref;
-	tlv_parse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_att_tlvdef, gh->data, payload_len, 0, 0);
 	/* cause */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CAUSE)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CAUSE)) {
 		rel.fields |= MNCC_F_CAUSE;
 		gsm48_decode_cause(&rel.cause,
-			     TLVP_VAL(&tp, GSM48_IE_CAUSE)-1);
+			     TLVS_VAL(&tp, GSM48_IE_CAUSE)-1);
 	}
 	/* facility */
-	if (TLVP_PRESENT(&tp, GSM48_IE_FACILITY)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_FACILITY)) {
 		rel.fields |= MNCC_F_FACILITY;
 		gsm48_decode_facility(&rel.facility,
-				TLVP_VAL(&tp, GSM48_IE_FACILITY)-1);
+				TLVS_VAL(&tp, GSM48_IE_FACILITY)-1);
 	}
 	/* user-user */
-	if (TLVP_PRESENT(&tp, GSM48_IE_USER_USER)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_USER_USER)) {
 		rel.fields |= MNCC_F_USERUSER;
 		gsm48_decode_useruser(&rel.useruser,
-				TLVP_VAL(&tp, GSM48_IE_USER_USER)-1);
+				TLVS_VAL(&tp, GSM48_IE_USER_USER)-1);
 	}
 
 	if (trans->callref) {
@@ -334,6 +334,7 @@ static void timeout_mm_t3210(void *arg)
 	struct gsm48_mmlayer *mm = arg;
 
 	LOGP(DMM, LOGL_INFO, "timer T3210 (loc. upd. timeout) has fired\n");
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3210, NULL);
 }
 
@@ -343,6 +344,7 @@ static void timeout_mm_t3211(void *arg)
 
 	LOGP(DSUM, LOGL_INFO, "Location update retry\n");
 	LOGP(DMM, LOGL_INFO, "timer T3211 (loc. upd. retry delay) has fired\n");
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3211, NULL);
 }
 
@@ -359,6 +361,7 @@ static void timeout_mm_t3212(void *arg)
 	 && mm->substate == GSM48_MM_SST_ATTEMPT_UPDATE)
 		mm->lupd_attempt = 0;
 
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3212, NULL);
 }
 
@@ -369,6 +372,7 @@ static void timeout_mm_t3213(void *arg)
 	LOGP(DSUM, LOGL_INFO, "Location update retry\n");
 	LOGP(DMM, LOGL_INFO, "timer T3213 (delay after RA failure) has "
 		"fired\n");
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3213, NULL);
 }
 
@@ -378,6 +382,7 @@ static void timeout_mm_t3230(void *arg)
 
 	LOGP(DMM, LOGL_INFO, "timer T3230 (MM connection timeout) has "
 		"fired\n");
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3230, NULL);
 }
 
@@ -387,6 +392,7 @@ static void timeout_mm_t3220(void *arg)
 
 	LOGP(DMM, LOGL_INFO, "timer T3220 (IMSI detach keepalive) has "
 		"fired\n");
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3220, NULL);
 }
 
@@ -395,6 +401,7 @@ static void timeout_mm_t3240(void *arg)
 	struct gsm48_mmlayer *mm = arg;
 
 	LOGP(DMM, LOGL_INFO, "timer T3240 (RR release timeout) has fired\n");
+	MS_CTR_INC(mm->ms, MS_CTR_MM_TIMEOUT);
 	gsm48_mm_ev(mm->ms, GSM48_MM_EVENT_TIMEOUT_T3240, NULL);
 }
 
@@ -2034,24 +2041,25 @@ static int gsm48_mm_rx_info(struct osmocom_ms *ms, struct msgb *msg)
 	struct gsm48_mmlayer *mm = &ms->mmlayer;
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 
 	if (payload_len < 0) {
 		LOGP(DMM, LOGL_NOTICE, "Short read of MM INFORMATION message "
 			"error.\n");
 		return -EINVAL;
 	}
-	tlv_parse(&tp, &gsm48_mm_att_tlvdef, gh->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_mm_att_tlvdef, gh->data,
+		payload_len, 0, 0);
 
 	/* long name */
-	if (TLVP_PRESENT(&tp, GSM48_IE_NAME_LONG)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_NAME_LONG)) {
 		decode_network_name(mm->name_long, sizeof(mm->name_long),
-				TLVP_VAL(&tp, GSM48_IE_NAME_LONG)-1);
+				TLVS_VAL(&tp, GSM48_IE_NAME_LONG)-1);
 	}
 	/* short name */
-	if (TLVP_PRESENT(&tp, GSM48_IE_NAME_SHORT)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_NAME_SHORT)) {
 		decode_network_name(mm->name_short, sizeof(mm->name_short),
-				TLVP_VAL(&tp, GSM48_IE_NAME_SHORT)-1);
+				TLVS_VAL(&tp, GSM48_IE_NAME_SHORT)-1);
 	}
 
 	return 0;
@@ -2079,19 +2087,16 @@ static int gsm48_mm_sysinfo(struct osmocom_ms *ms, struct msgb *msg)
 	if (s->t3212 && s->t3212 != mm->t3212_value) {
 		if (osmo_timer_pending(&mm->t3212)) {
 			int t;
-			struct timeval current_time;
+			struct timeval rest;
 
 			/* get rest time */
-			gettimeofday(&current_time, NULL);
-			t = mm->t3212.timeout.tv_sec - current_time.tv_sec;
-			if (t < 0)
-				t = 0;
+			osmo_timer_remaining(&mm->t3212, &rest);
+			t = rest.tv_sec;
 			LOGP(DMM, LOGL_INFO, "New T3212 while timer is running "
 				"(value %d rest %d)\n", s->t3212, t);
 
 			/* rest time modulo given value */
-			mm->t3212.timeout.tv_sec = current_time.tv_sec
-				+ (t % s->t3212);
+			osmo_timer_schedule(&mm->t3212, t % s->t3212, 0);
 		} else {
 			uint32_t rand = random();
 
@@ -2331,6 +2336,7 @@ static int gsm48_mm_tx_loc_upd_req(struct osmocom_ms *ms)
 	uint8_t buf[11];
 
 	LOGP(DMM, LOGL_INFO, "LOCATION UPDATING REQUEST\n");
+	MS_CTR_INC(ms, MS_CTR_MM_LOC_UPD_REQ);
 
 	nmsg = gsm48_l3_msgb_alloc();
 	if (!nmsg)
@@ -2396,7 +2402,7 @@ static int gsm48_mm_rx_loc_upd_acc(struct osmocom_ms *ms, struct msgb *msg)
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	struct gsm48_loc_area_id *lai = (struct gsm48_loc_area_id *) gh->data;
 	unsigned int payload_len = msgb_l3len(msg) - sizeof(*gh);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct msgb *nmsg;
 
 	if (payload_len < sizeof(struct gsm48_loc_area_id)) {
@@ -2405,12 +2411,13 @@ static int gsm48_mm_rx_loc_upd_acc(struct osmocom_ms *ms, struct msgb *msg)
 			"message error.\n");
 		return -EINVAL;
 	}
-	tlv_parse(&tp, &gsm48_mm_att_tlvdef,
+	tlv_parse_sparse(&tp, &gsm48_mm_att_tlvdef,
 		gh->data + sizeof(struct gsm48_loc_area_id),
 		payload_len - sizeof(struct gsm48_loc_area_id), 0, 0);
 
 	/* update has finished */
 	mm->lupd_pending = 0;
+	MS_CTR_INC(ms, MS_CTR_MM_LOC_UPD_ACC);
 
 	/* RA was successfull */
 	mm->lupd_ra_failure = 0;
@@ -2452,12 +2459,12 @@ static int gsm48_mm_rx_loc_upd_acc(struct osmocom_ms *ms, struct msgb *msg)
 	gsm322_del_forbidden_la(ms, subscr->mcc, subscr->mnc, subscr->lac);
 
 	/* MI */
-	if (TLVP_PRESENT(&tp, GSM48_IE_MOBILE_ID)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_MOBILE_ID)) {
 		const uint8_t *mi;
 		uint8_t mi_type;
 		uint32_t tmsi;
 
-		mi = TLVP_VAL(&tp, GSM48_IE_MOBILE_ID)-1;
+		mi = TLVS_VAL(&tp, GSM48_IE_MOBILE_ID)-1;
 		if (mi[0] < 1)
 			goto short_read;
 		mi_type = mi[1] & GSM_MI_TYPE_MASK;
@@ -2500,7 +2507,7 @@ static int gsm48_mm_rx_loc_upd_acc(struct osmocom_ms *ms, struct msgb *msg)
 	gsm322_plmn_sendmsg(ms, nmsg);
 
 	/* follow on proceed */
-	if (TLVP_PRESENT(&tp, GSM48_IE_MOBILE_ID))
+	if (TLVS_PRESENT(&tp, GSM48_IE_MOBILE_ID))
 		LOGP(DMM, LOGL_NOTICE, "follow-on proceed not supported.\n");
 
 	/* start RR release timer */
@@ -2535,6 +2542,7 @@ static int gsm48_mm_rx_loc_upd_rej(struct osmocom_ms *ms, struct msgb *msg)
 
 	/* store until RR is released */
 	mm->lupd_rej_cause = *gh->data;
+	MS_CTR_INC(ms, MS_CTR_MM_LOC_UPD_REJ);
 
 	/* start RR release timer */
 	start_mm_t3240(mm);
@@ -729,6 +729,7 @@ static void timeout_rr_t3110(void *arg)
 	uint8_t *mode;
 
 	LOGP(DRR, LOGL_INFO, "timer T3110 has fired, release locally\n");
+	MS_CTR_INC(ms, MS_CTR_RR_TIMEOUT);
 
 	new_rr_state(rr, GSM48_RR_ST_REL_PEND);
 
@@ -749,12 +750,18 @@ static void timeout_rr_t3110(void *arg)
 
 static void timeout_rr_t3122(void *arg)
 {
+	struct gsm48_rrlayer *rr = arg;
+
 	LOGP(DRR, LOGL_INFO, "timer T3122 has fired\n");
+	MS_CTR_INC(rr->ms, MS_CTR_RR_TIMEOUT);
 }
 
 static void timeout_rr_t3124(void *arg)
 {
+	struct gsm48_rrlayer *rr = arg;
+
 	LOGP(DRR, LOGL_INFO, "timer T3124 has fired\n");
+	MS_CTR_INC(rr->ms, MS_CTR_RR_TIMEOUT);
 }
 
 static void timeout_rr_t3126(void *arg)
@@ -763,11 +770,13 @@ static void timeout_rr_t3126(void *arg)
 	struct osmocom_ms *ms = rr->ms;
 
 	LOGP(DRR, LOGL_INFO, "timer T3126 has fired\n");
+	MS_CTR_INC(ms, MS_CTR_RR_TIMEOUT);
 	if (rr->rr_est_req) {
 		struct msgb *msg = gsm48_rr_msgb_alloc(GSM48_RR_REL_IND);
 		struct gsm48_rr_hdr *rrh;
 
 		LOGP(DSUM, LOGL_INFO, "Requesting channel failed\n");
+		MS_CTR_INC(ms, MS_CTR_RR_RA_FAIL);
 		if (!msg)
 			return;
 		rrh = (struct gsm48_rr_hdr *)msg->data;
@@ -1316,6 +1325,9 @@ static int gsm48_rr_chan_req(struct osmocom_ms *ms, int cause, int paging,
 
 	LOGP(DSUM, LOGL_INFO, "Establish radio link due to %s request\n",
 		(paging) ? "paging" : "mobility management");
+	MS_CTR_INC(ms, MS_CTR_RR_CHAN_REQ);
+	if (paging)
+		MS_CTR_INC(ms, MS_CTR_RR_PAGING);
 
 	/* ignore paging, if not camping */
 	if (paging
@@ -1574,6 +1586,7 @@ fail:
 			struct gsm48_rr_hdr *rrh;
 
 			LOGP(DSUM, LOGL_INFO, "Requesting channel failed\n");
+			MS_CTR_INC(ms, MS_CTR_RR_RA_FAIL);
 			if (!msg)
 				return -ENOMEM;
 			rrh = (struct gsm48_rr_hdr *)msg->data;
@@ -2494,6 +2507,7 @@ static int gsm48_rr_rx_imm_ass(struct osmocom_ms *ms, struct msgb *msg)
 		memcpy(&rr->cd_now.mob_alloc_lv, &ia->mob_alloc_len,
 			ia->mob_alloc_len + 1);
 		rr->wait_assign = 2;
+		MS_CTR_INC(ms, MS_CTR_RR_IMM_ASS);
 		/* reset scheduler */
 		LOGP(DRR, LOGL_INFO, "resetting scheduler\n");
 		l1ctl_tx_reset_req(ms, L1CTL_RES_T_SCHED);
@@ -2632,6 +2646,7 @@ static int gsm48_rr_rx_imm_ass_ext(struct osmocom_ms *ms, struct msgb *msg)
 		memcpy(&rr->cd_now.mob_alloc_lv, &ia->mob_alloc_len,
 			ia->mob_alloc_len + 1);
 		rr->wait_assign = 2;
+		MS_CTR_INC(ms, MS_CTR_RR_IMM_ASS);
 		/* reset scheduler */
 		LOGP(DRR, LOGL_INFO, "resetting scheduler\n");
 		l1ctl_tx_reset_req(ms, L1CTL_RES_T_SCHED);
@@ -2648,6 +2663,7 @@ static int gsm48_rr_rx_imm_ass_ext(struct osmocom_ms *ms, struct msgb *msg)
 		memcpy(&rr->cd_now.mob_alloc_lv, &ia->mob_alloc_len,
 			ia->mob_alloc_len + 1);
 		rr->wait_assign = 2;
+		MS_CTR_INC(ms, MS_CTR_RR_IMM_ASS);
 		/* reset scheduler */
 		LOGP(DRR, LOGL_INFO, "resetting scheduler\n");
 		l1ctl_tx_reset_req(ms, L1CTL_RES_T_SCHED);
@@ -2690,6 +2706,7 @@ static int gsm48_rr_rx_imm_ass_rej(struct osmocom_ms *ms, struct msgb *msg)
 		LOGP(DRR, LOGL_INFO, "IMMEDIATE ASSIGNMENT REJECT "
 			"(ref 0x%02x)\n", req_ref->ra);
 		if (gsm48_match_ra(ms, req_ref)) {
+			MS_CTR_INC(ms, MS_CTR_RR_IMM_ASS_REJ);
 			/* wait indication */
 			t3122_value = *(((uint8_t *)&ia->wait_ind1) + i * 4);
 			if (t3122_value)
@@ -2715,7 +2732,7 @@ static int gsm48_rr_rx_add_ass(struct osmocom_ms *ms, struct msgb *msg)
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	struct gsm48_add_ass *aa = (struct gsm48_add_ass *)gh->data;
 	int payload_len = msgb_l3len(msg) - sizeof(*gh) - sizeof(*aa);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 
 	if (payload_len < 0) {
 		LOGP(DRR, LOGL_NOTICE, "Short read of ADDITIONAL ASSIGNMENT "
@@ -2723,7 +2740,8 @@ static int gsm48_rr_rx_add_ass(struct osmocom_ms *ms, struct msgb *msg)
 		return gsm48_rr_tx_rr_status(ms,
 			GSM48_RR_CAUSE_PROT_ERROR_UNSPC);
 	}
-	tlv_parse(&tp, &gsm48_rr_att_tlvdef, aa->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_rr_att_tlvdef, aa->data,
+		payload_len, 0, 0);
 
 	return gsm48_rr_tx_rr_status(ms, GSM48_RR_CAUSE_PROT_ERROR_UNSPC);
 }
@@ -3379,7 +3397,7 @@ static int gsm48_rr_rx_chan_rel(struct osmocom_ms *ms, struct msgb *msg)
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	struct gsm48_chan_rel *cr = (struct gsm48_chan_rel *)gh->data;
 	int payload_len = msgb_l3len(msg) - sizeof(*gh) - sizeof(*cr);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct msgb *nmsg;
 	uint8_t *mode;
 
@@ -3389,15 +3407,17 @@ static int gsm48_rr_rx_chan_rel(struct osmocom_ms *ms, struct msgb *msg)
 		return gsm48_rr_tx_rr_status(ms,
 			GSM48_RR_CAUSE_PROT_ERROR_UNSPC);
 	}
-	tlv_parse(&tp, &gsm48_rr_att_tlvdef, cr->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_rr_att_tlvdef, cr->data,
+		payload_len, 0, 0);
 
 	LOGP(DRR, LOGL_INFO, "channel release request with cause 0x%02x\n",
 		cr->rr_cause);
+	MS_CTR_INC(ms, MS_CTR_RR_CHAN_REL);
 
 	/* BA range */
-	if (TLVP_PRESENT(&tp, GSM48_IE_BA_RANGE)) {
-		gsm48_decode_ba_range(TLVP_VAL(&tp, GSM48_IE_BA_RANGE),
-			*(TLVP_VAL(&tp, GSM48_IE_BA_RANGE) - 1), rr->ba_range,
+	if (TLVS_PRESENT(&tp, GSM48_IE_BA_RANGE)) {
+		gsm48_decode_ba_range(TLVS_VAL(&tp, GSM48_IE_BA_RANGE),
+			*(TLVS_VAL(&tp, GSM48_IE_BA_RANGE) - 1), rr->ba_range,
 			&rr->ba_ranges,
 			sizeof(rr->ba_range) / sizeof(rr->ba_range[0]));
 		/* NOTE: the ranges are kept until IDLE state is returned
@@ -3671,7 +3691,7 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	struct gsm48_ass_cmd *ac = (struct gsm48_ass_cmd *)gh->data;
 	int payload_len = msgb_l3len(msg) - sizeof(*gh) - sizeof(*ac);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm48_rr_cd *cda = &rr->cd_after;
 	struct gsm48_rr_cd *cdb = &rr->cd_before;
 	uint8_t ch_type, ch_subch, ch_ts;
@@ -3696,12 +3716,13 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 		return gsm48_rr_tx_rr_status(ms,
 			GSM48_RR_CAUSE_PROT_ERROR_UNSPC);
 	}
-	tlv_parse(&tp, &gsm48_rr_att_tlvdef, ac->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_rr_att_tlvdef, ac->data,
+		payload_len, 0, 0);
 
 	/* decode channel description (before time) */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CH_DESC_1_BEFORE)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CH_DESC_1_BEFORE)) {
 		struct gsm48_chan_desc *ccd = (struct gsm48_chan_desc *)
-			TLVP_VAL(&tp, GSM48_IE_CH_DESC_1_BEFORE);
+			TLVS_VAL(&tp, GSM48_IE_CH_DESC_1_BEFORE);
 		cdb->chan_nr = ccd->chan_nr;
 		rsl_dec_chan_nr(cdb->chan_nr, &ch_type, &ch_subch, &ch_ts);
 		if (ccd->h0.h) {
@@ -3750,9 +3771,9 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	cda->start_tm.fn = (ms->meas.last_fn + TEST_STARTING_TIMER) % 42432;
 	LOGP(DRR, LOGL_INFO, " TESTING: starting time ahead\n");
 #else
-	if (TLVP_PRESENT(&tp, GSM48_IE_START_TIME)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_START_TIME)) {
 		gsm48_decode_start_time(cda, (struct gsm48_start_time *)
-			TLVP_VAL(&tp, GSM48_IE_START_TIME));
+			TLVS_VAL(&tp, GSM48_IE_START_TIME));
 		/* 9.1.2.5 "... before time IE is not present..." */
 		if (!before_time) {
 			LOGP(DRR, LOGL_INFO, " -> channel description after "
@@ -3772,9 +3793,9 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 
 	/* mobile allocation / frequency list after time */
 	if (cda->h) {
-		if (TLVP_PRESENT(&tp, GSM48_IE_MA_AFTER)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_MA_AFTER)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_MA_AFTER) - 1;
+				TLVS_VAL(&tp, GSM48_IE_MA_AFTER) - 1;
 
 			LOGP(DRR, LOGL_INFO, " after: hopping required and "
 				"mobile allocation available\n");
@@ -3784,9 +3805,9 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 			}
 			memcpy(cda->mob_alloc_lv, lv, *lv + 1);
 		} else
-		if (TLVP_PRESENT(&tp, GSM48_IE_FREQ_L_AFTER)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_FREQ_L_AFTER)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_FREQ_L_AFTER) - 1;
+				TLVS_VAL(&tp, GSM48_IE_FREQ_L_AFTER) - 1;
 
 			LOGP(DRR, LOGL_INFO, " after: hopping required and "
 				"frequency list available\n");
@@ -3803,9 +3824,9 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 
 	/* mobile allocation / frequency list before time */
 	if (cdb->h) {
-		if (TLVP_PRESENT(&tp, GSM48_IE_MA_BEFORE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_MA_BEFORE)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_MA_BEFORE) - 1;
+				TLVS_VAL(&tp, GSM48_IE_MA_BEFORE) - 1;
 
 			LOGP(DRR, LOGL_INFO, " before: hopping required and "
 				"mobile allocation available\n");
@@ -3815,9 +3836,9 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 			}
 			memcpy(cdb->mob_alloc_lv, lv, *lv + 1);
 		} else
-		if (TLVP_PRESENT(&tp, GSM48_IE_FREQ_L_BEFORE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_FREQ_L_BEFORE)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_FREQ_L_BEFORE) - 1;
+				TLVS_VAL(&tp, GSM48_IE_FREQ_L_BEFORE) - 1;
 
 			LOGP(DRR, LOGL_INFO, " before: hopping required and "
 				"frequency list available\n");
@@ -3827,10 +3848,10 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 			}
 			memcpy(cdb->freq_list_lv, lv, *lv + 1);
 		} else
-		if (TLVP_PRESENT(&tp, GSM48_IE_F_CH_SEQ_BEFORE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_F_CH_SEQ_BEFORE)) {
 			const uint8_t *v =
-				TLVP_VAL(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
-			uint8_t len = TLVP_LEN(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
+				TLVS_VAL(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
+			uint8_t len = TLVS_LEN(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
 
 			LOGP(DRR, LOGL_INFO, " before: hopping required and "
 				"frequency channel sequence available\n");
@@ -3861,9 +3882,9 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	}
 
 	/* cell channel description */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CELL_CH_DESC)) {
-		const uint8_t *v = TLVP_VAL(&tp, GSM48_IE_CELL_CH_DESC);
-		uint8_t len = TLVP_LEN(&tp, GSM48_IE_CELL_CH_DESC);
+	if (TLVS_PRESENT(&tp, GSM48_IE_CELL_CH_DESC)) {
+		const uint8_t *v = TLVS_VAL(&tp, GSM48_IE_CELL_CH_DESC);
+		uint8_t len = TLVS_LEN(&tp, GSM48_IE_CELL_CH_DESC);
 
 		LOGP(DRR, LOGL_INFO, " both: using cell channel description "
 			"in case of mobile allocation\n");
@@ -3884,17 +3905,17 @@ static int gsm48_rr_rx_ass_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	}
 
 	/* channel mode */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CHANMODE_1)) {
-		cda->mode = cdb->mode = *TLVP_VAL(&tp, GSM48_IE_CHANMODE_1);
+	if (TLVS_PRESENT(&tp, GSM48_IE_CHANMODE_1)) {
+		cda->mode = cdb->mode = *TLVS_VAL(&tp, GSM48_IE_CHANMODE_1);
 		LOGP(DRR, LOGL_INFO, " both: changing channel mode 0x%02x\n",
 			cda->mode);
 	} else
 		cda->mode = cdb->mode = rr->cd_now.mode;
 
 	/* cipher mode setting */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CIP_MODE_SET)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CIP_MODE_SET)) {
 		cda->cipher = cdb->cipher =
-			*TLVP_VAL(&tp, GSM48_IE_CIP_MODE_SET);
+			*TLVS_VAL(&tp, GSM48_IE_CIP_MODE_SET);
 		LOGP(DRR, LOGL_INFO, " both: changing cipher mode 0x%02x\n",
 			cda->cipher);
 	} else
@@ -4038,7 +4059,7 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	struct gsm48_hdr *gh = msgb_l3(msg);
 	struct gsm48_ho_cmd *ho = (struct gsm48_ho_cmd *)gh->data;
 	int payload_len = msgb_l3len(msg) - sizeof(*gh) - sizeof(*ho);
-	struct tlv_parsed tp;
+	struct tlv_sparse tp;
 	struct gsm48_rr_cd *cda = &rr->cd_after;
 	struct gsm48_rr_cd *cdb = &rr->cd_before;
 	uint16_t arfcn;
@@ -4072,20 +4093,21 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	rr->chan_req_val = ho->ho_ref;
 	rr->chan_req_mask = 0x00;
 
-	tlv_parse(&tp, &gsm48_rr_att_tlvdef, ho->data, payload_len, 0, 0);
+	tlv_parse_sparse(&tp, &gsm48_rr_att_tlvdef, ho->data,
+		payload_len, 0, 0);
 
 	/* sync ind */
-	if (TLVP_PRESENT(&tp, GSM48_IE_SYNC_IND)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_SYNC_IND)) {
 		gsm48_decode_sync_ind(rr, (struct gsm48_sync_ind *)
-			TLVP_VAL(&tp, GSM48_IE_SYNC_IND));
+			TLVS_VAL(&tp, GSM48_IE_SYNC_IND));
 		LOGP(DRR, LOGL_INFO, " (sync_ind=%d rot=%d nci=%d)\n",
 			rr->hando_sync_ind, rr->hando_rot, rr->hando_nci);
 	}
 
 	/* decode channel description (before time) */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CH_DESC_1_BEFORE)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CH_DESC_1_BEFORE)) {
 		struct gsm48_chan_desc *ccd = (struct gsm48_chan_desc *)
-			TLVP_VAL(&tp, GSM48_IE_CH_DESC_1_BEFORE);
+			TLVS_VAL(&tp, GSM48_IE_CH_DESC_1_BEFORE);
 		cdb->chan_nr = ccd->chan_nr;
 		rsl_dec_chan_nr(cdb->chan_nr, &ch_type, &ch_subch, &ch_ts);
 		if (ccd->h0.h) {
@@ -4134,9 +4156,9 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	cda->start_tm.fn = (ms->meas.last_fn + TEST_STARTING_TIMER) % 42432;
 	LOGP(DRR, LOGL_INFO, " TESTING: starting time ahead\n");
 #else
-	if (TLVP_PRESENT(&tp, GSM48_IE_START_TIME)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_START_TIME)) {
 		gsm48_decode_start_time(cda, (struct gsm48_start_time *)
-			TLVP_VAL(&tp, GSM48_IE_START_TIME));
+			TLVS_VAL(&tp, GSM48_IE_START_TIME));
 		/* 9.1.2.5 "... before time IE is not present..." */
 		if (!before_time) {
 			LOGP(DRR, LOGL_INFO, " -> channel description after "
@@ -4156,9 +4178,9 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 
 	/* mobile allocation / frequency list after time */
 	if (cda->h) {
-		if (TLVP_PRESENT(&tp, GSM48_IE_MA_AFTER)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_MA_AFTER)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_MA_AFTER) - 1;
+				TLVS_VAL(&tp, GSM48_IE_MA_AFTER) - 1;
 
 			LOGP(DRR, LOGL_INFO, " after: hopping required and "
 				"mobile allocation available\n");
@@ -4168,9 +4190,9 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 			}
 			memcpy(cda->mob_alloc_lv, lv, *lv + 1);
 		} else
-		if (TLVP_PRESENT(&tp, GSM48_IE_FREQ_L_AFTER)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_FREQ_L_AFTER)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_FREQ_L_AFTER) - 1;
+				TLVS_VAL(&tp, GSM48_IE_FREQ_L_AFTER) - 1;
 
 			LOGP(DRR, LOGL_INFO, " after: hopping required and "
 				"frequency list available\n");
@@ -4187,9 +4209,9 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 
 	/* mobile allocation / frequency list before time */
 	if (cdb->h) {
-		if (TLVP_PRESENT(&tp, GSM48_IE_MA_BEFORE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_MA_BEFORE)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_MA_BEFORE) - 1;
+				TLVS_VAL(&tp, GSM48_IE_MA_BEFORE) - 1;
 
 			LOGP(DRR, LOGL_INFO, " before: hopping required and "
 				"mobile allocation available\n");
@@ -4199,9 +4221,9 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 			}
 			memcpy(cdb->mob_alloc_lv, lv, *lv + 1);
 		} else
-		if (TLVP_PRESENT(&tp, GSM48_IE_FREQ_L_BEFORE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_FREQ_L_BEFORE)) {
 			const uint8_t *lv =
-				TLVP_VAL(&tp, GSM48_IE_FREQ_L_BEFORE) - 1;
+				TLVS_VAL(&tp, GSM48_IE_FREQ_L_BEFORE) - 1;
 
 			LOGP(DRR, LOGL_INFO, " before: hopping required and "
 				"frequency list available\n");
@@ -4211,10 +4233,10 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 			}
 			memcpy(cdb->freq_list_lv, lv, *lv + 1);
 		} else
-		if (TLVP_PRESENT(&tp, GSM48_IE_F_CH_SEQ_BEFORE)) {
+		if (TLVS_PRESENT(&tp, GSM48_IE_F_CH_SEQ_BEFORE)) {
 			const uint8_t *v =
-				TLVP_VAL(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
-			uint8_t len = TLVP_LEN(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
+				TLVS_VAL(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
+			uint8_t len = TLVS_LEN(&tp, GSM48_IE_F_CH_SEQ_BEFORE);
 
 			LOGP(DRR, LOGL_INFO, " before: hopping required and "
 				"frequency channel sequence available\n");
@@ -4245,9 +4267,9 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	}
 
 	/* cell channel description */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CELL_CH_DESC)) {
-		const uint8_t *v = TLVP_VAL(&tp, GSM48_IE_CELL_CH_DESC);
-		uint8_t len = TLVP_LEN(&tp, GSM48_IE_CELL_CH_DESC);
+	if (TLVS_PRESENT(&tp, GSM48_IE_CELL_CH_DESC)) {
+		const uint8_t *v = TLVS_VAL(&tp, GSM48_IE_CELL_CH_DESC);
+		uint8_t len = TLVS_LEN(&tp, GSM48_IE_CELL_CH_DESC);
 
 		LOGP(DRR, LOGL_INFO, " both: using cell channel description "
 			"in case of mobile allocation\n");
@@ -4268,17 +4290,17 @@ static int gsm48_rr_rx_hando_cmd(struct osmocom_ms *ms, struct msgb *msg)
 	}
 
 	/* channel mode */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CHANMODE_1)) {
-		cda->mode = cdb->mode = *TLVP_VAL(&tp, GSM48_IE_CHANMODE_1);
+	if (TLVS_PRESENT(&tp, GSM48_IE_CHANMODE_1)) {
+		cda->mode = cdb->mode = *TLVS_VAL(&tp, GSM48_IE_CHANMODE_1);
 		LOGP(DRR, LOGL_INFO, " both: changing channel mode 0x%02x\n",
 			cda->mode);
 	} else
 		cda->mode = cdb->mode = rr->cd_now.mode;
 
 	/* cipher mode setting */
-	if (TLVP_PRESENT(&tp, GSM48_IE_CIP_MODE_SET)) {
+	if (TLVS_PRESENT(&tp, GSM48_IE_CIP_MODE_SET)) {
 		cda->cipher = cdb->cipher =
-			*TLVP_VAL(&tp, GSM48_IE_CIP_MODE_SET);
+			*TLVS_VAL(&tp, GSM48_IE_CIP_MODE_SET);
 		LOGP(DRR, LOGL_INFO, " both: changing cipher mode 0x%02x\n",
 			cda->cipher);
 	} else
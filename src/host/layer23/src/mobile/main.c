@@ -58,6 +58,8 @@ int debug_set = 0;
 char *config_dir = NULL;
 int use_mncc_sock = 0;
 int daemonize = 0;
+static const char *stats_dest = NULL;
+static unsigned int stats_interval = 10;
 
 int mncc_recv_socket(struct osmocom_ms *ms, int msg_type, void *arg);
 
@@ -98,6 +100,10 @@ static void print_help()
 	printf("  -D --daemonize	Run as daemon\n");
 	printf("  -m --mncc-sock	Disable built-in MNCC handler and "
 		"offer socket\n");
+	printf("  -e --stats DEST		Export counters to host:port or "
+		"unix:path\n");
+	printf("  -E --stats-interval SEC	Seconds between two exports. "
+		"(default %u)\n", stats_interval);
 }
 
 static void handle_options(int argc, char **argv)
@@ -112,10 +118,12 @@ static void handle_options(int argc, char **argv)
 			{"debug", 1, 0, 'd'},
 			{"daemonize", 0, 0, 'D'},
 			{"mncc-sock", 0, 0, 'm'},
+			{"stats", 1, 0, 'e'},
+			{"stats-interval", 1, 0, 'E'},
 			{0, 0, 0, 0},
 		};
 
-		c = getopt_long(argc, argv, "hi:u:v:d:Dm",
+		c = getopt_long(argc, argv, "hi:u:v:d:Dme:E:",
 				long_options, &option_index);
 		if (c == -1)
 			break;
@@ -145,6 +153,12 @@ static void handle_options(int argc, char **argv)
 		case 'm':
 			use_mncc_sock = 1;
 			break;
+		case 'e':
+			stats_dest = optarg;
+			break;
+		case 'E':
+			stats_interval = atoi(optarg);
+			break;
 		default:
 			break;
 		}
@@ -205,6 +219,7 @@ int main(int argc, char **argv)
 
 	l23_ctx = talloc_named_const(NULL, 1, "layer2 context");
 	msgb_set_talloc_ctx(l23_ctx);
+	rate_ctr_init(l23_ctx);
 
 	handle_options(argc, argv);
 
@@ -221,6 +236,9 @@ int main(int argc, char **argv)
 		gsmtap_source_add_sink(gsmtap_inst);
 	}
 
+	if (stats_dest && ms_ctr_export(l23_ctx, stats_dest, stats_interval))
+		exit(1);
+
 	home = getenv("HOME");
 	if (home != NULL) {
 		len = strlen(home) + 1 + sizeof(osmocomcfg);
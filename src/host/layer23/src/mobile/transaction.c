@@ -67,7 +67,8 @@ struct gsm_trans *trans_alloc(struct osmocom_ms *ms,
 {
 	struct gsm_trans *trans;
 
-	trans = talloc_zero(l23_ctx, struct gsm_trans);
+	trans = talloc_zero((ms->trans_pool) ? ms->trans_pool : l23_ctx,
+		struct gsm_trans);
 	if (!trans)
 		return NULL;
 
@@ -0,0 +1,477 @@
+/* Emulation of the Calypso loader on the osmocon loader socket, to run
+ * osmoload without a phone */
+
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/crc16.h>
+
+#include <loader/protocol.h>
+
+/* emulated address space, addresses wrap around */
+#define MEM_SIZE	(16 * 1024 * 1024)
+
+/* one flash chip at address 0 */
+#define FLASH_SIZE	(4 * 1024 * 1024)
+#define FLASH_BLOCK	(64 * 1024)
+
+#define MSG_MAX		256
+
+/* octets added by HDLC: flags, dlci, control */
+#define HDLC_OVERHEAD	4
+
+/*
+ * The phone handles one request at a time.  A request arrives after the
+ * latency of the USB serial adapter and the time it takes on the wire,
+ * waits for the previous requests, is processed and the reply goes back
+ * the same way.  The wire is full duplex.
+ */
+struct reply {
+	struct llist_head list;
+	uint64_t due;
+	struct msgb *msg;
+};
+
+static struct {
+	uint8_t *mem;
+
+	struct osmo_fd listen_fd;
+	struct osmo_fd conn_fd;
+	uint8_t rx[4096];
+	unsigned int rx_len;
+
+	/* link model, all times in us */
+	unsigned int baudrate;
+	unsigned int latency;
+	unsigned int processing;
+	uint64_t rx_busy;
+	uint64_t cpu_busy;
+	uint64_t tx_busy;
+
+	/* every nth memory reply gets a wrong crc or is lost */
+	unsigned int corrupt_every;
+	unsigned int drop_every;
+	unsigned int mem_replies;
+
+	struct llist_head replies;
+	struct osmo_timer_list timer;
+
+	unsigned long requests;
+} emu;
+
+static uint64_t time_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint64_t wire_time(unsigned int len)
+{
+	/* 10 bits per octet, escaping is ignored */
+	return (uint64_t) (len + HDLC_OVERHEAD) * 10 * 1000000 / emu.baudrate;
+}
+
+static uint8_t *mem_ptr(uint32_t address, unsigned int len)
+{
+	address &= MEM_SIZE - 1;
+	if (address + len > MEM_SIZE)
+		address = MEM_SIZE - len;
+	return emu.mem + address;
+}
+
+static void schedule_next(void)
+{
+	struct reply *r;
+	uint64_t now;
+
+	if (llist_empty(&emu.replies))
+		return;
+
+	r = llist_entry(emu.replies.next, struct reply, list);
+	now = time_us();
+	if (r->due <= now)
+		osmo_timer_schedule(&emu.timer, 0, 0);
+	else
+		osmo_timer_schedule(&emu.timer, (r->due - now) / 1000000,
+				    (r->due - now) % 1000000);
+}
+
+static void send_reply(struct msgb *msg)
+{
+	uint16_t len = htons(msg->len);
+
+	if (emu.conn_fd.fd < 0 ||
+	    write(emu.conn_fd.fd, &len, sizeof(len)) != sizeof(len) ||
+	    write(emu.conn_fd.fd, msg->data, msg->len) != msg->len)
+		fprintf(stderr, "Failed to send a reply.\n");
+}
+
+static void reply_timer_cb(void *data)
+{
+	struct reply *r, *r2;
+	uint64_t now = time_us();
+
+	llist_for_each_entry_safe(r, r2, &emu.replies, list) {
+		if (r->due > now)
+			break;
+		send_reply(r->msg);
+		llist_del(&r->list);
+		msgb_free(r->msg);
+		free(r);
+	}
+
+	schedule_next();
+}
+
+/* queue the reply to a request of req_len octets received now */
+static void queue_reply(unsigned int req_len, struct msgb *msg)
+{
+	struct reply *r;
+	uint64_t t;
+
+	t = time_us() + emu.latency;
+	if (t < emu.rx_busy)
+		t = emu.rx_busy;
+	t += wire_time(req_len);
+	emu.rx_busy = t;
+
+	if (t < emu.cpu_busy)
+		t = emu.cpu_busy;
+	t += emu.processing;
+	emu.cpu_busy = t;
+
+	if (t < emu.tx_busy)
+		t = emu.tx_busy;
+	t += wire_time(msg->len);
+	emu.tx_busy = t;
+
+	r = malloc(sizeof(*r));
+	if (!r) {
+		msgb_free(msg);
+		return;
+	}
+	r->due = t + emu.latency;
+	r->msg = msg;
+	llist_add_tail(&r->list, &emu.replies);
+
+	schedule_next();
+}
+
+/* decide the fate of a memory reply, returns 0 to lose it */
+static int mem_reply_fate(uint16_t *crc)
+{
+	emu.mem_replies++;
+
+	if (emu.drop_every && !(emu.mem_replies % emu.drop_every))
+		return 0;
+	if (emu.corrupt_every && !(emu.mem_replies % emu.corrupt_every))
+		*crc ^= 0x5555;
+
+	return 1;
+}
+
+static void handle_request(struct msgb *msg)
+{
+	struct msgb *reply = msgb_alloc(MSG_MAX, "reply");
+	unsigned int req_len = msg->len;
+	uint8_t command, nbytes, chip;
+	uint32_t address;
+	uint16_t crc;
+	uint8_t *data;
+
+	emu.requests++;
+	command = msgb_get_u8(msg);
+
+	switch (command) {
+	case LOADER_PING:
+	case LOADER_RESET:
+	case LOADER_POWEROFF:
+	case LOADER_ENTER_ROM_LOADER:
+	case LOADER_ENTER_FLASH_LOADER:
+		msgb_put_u8(reply, command);
+		break;
+	case LOADER_MEM_READ:
+		nbytes = msgb_get_u8(msg);
+		address = msgb_get_u32(msg);
+		data = mem_ptr(address, nbytes);
+		crc = osmo_crc16(0, data, nbytes);
+		if (!mem_reply_fate(&crc))
+			goto drop;
+		msgb_put_u8(reply, LOADER_MEM_READ);
+		msgb_put_u8(reply, nbytes);
+		msgb_put_u16(reply, crc);
+		msgb_put_u32(reply, address);
+		memcpy(msgb_put(reply, nbytes), data, nbytes);
+		break;
+	case LOADER_MEM_WRITE:
+	case LOADER_FLASH_PROGRAM:
+		nbytes = msgb_get_u8(msg);
+		crc = msgb_get_u16(msg);
+		chip = 0;
+		if (command == LOADER_FLASH_PROGRAM) {
+			msgb_get_u8(msg);	/* align */
+			chip = msgb_get_u8(msg);
+		}
+		address = msgb_get_u32(msg);
+		data = msgb_get(msg, nbytes);
+		if (osmo_crc16(0, data, nbytes) == crc)
+			memcpy(mem_ptr(address, nbytes), data, nbytes);
+		crc = osmo_crc16(0, data, nbytes);
+		if (!mem_reply_fate(&crc))
+			goto drop;
+		msgb_put_u8(reply, command);
+		msgb_put_u8(reply, nbytes);
+		msgb_put_u16(reply, crc);
+		if (command == LOADER_FLASH_PROGRAM) {
+			msgb_put_u8(reply, 0);
+			msgb_put_u8(reply, chip);
+		}
+		msgb_put_u32(reply, address);
+		if (command == LOADER_FLASH_PROGRAM)
+			msgb_put_u32(reply, 0);
+		break;
+	case LOADER_JUMP:
+		address = msgb_get_u32(msg);
+		msgb_put_u8(reply, LOADER_JUMP);
+		msgb_put_u32(reply, address);
+		break;
+	case LOADER_FLASH_INFO:
+		msgb_put_u8(reply, LOADER_FLASH_INFO);
+		msgb_put_u8(reply, 1);
+		msgb_put_u32(reply, 0);
+		msgb_put_u32(reply, FLASH_SIZE);
+		msgb_put_u8(reply, 1);
+		msgb_put_u32(reply, FLASH_SIZE / FLASH_BLOCK);
+		msgb_put_u32(reply, FLASH_BLOCK);
+		break;
+	case LOADER_FLASH_ERASE:
+	case LOADER_FLASH_UNLOCK:
+	case LOADER_FLASH_LOCK:
+	case LOADER_FLASH_LOCKDOWN:
+	case LOADER_FLASH_GETLOCK:
+		chip = msgb_get_u8(msg);
+		address = msgb_get_u32(msg);
+		if (command == LOADER_FLASH_ERASE)
+			memset(mem_ptr(address & ~(FLASH_BLOCK - 1), FLASH_BLOCK),
+			       0xff, FLASH_BLOCK);
+		msgb_put_u8(reply, command);
+		msgb_put_u8(reply, chip);
+		msgb_put_u32(reply, address);
+		msgb_put_u32(reply, command == LOADER_FLASH_GETLOCK ?
+					LOADER_FLASH_UNLOCKED : 0);
+		break;
+	default:
+		fprintf(stderr, "Unknown command %u\n", command);
+		goto drop;
+	}
+
+	queue_reply(req_len, reply);
+	return;
+drop:
+	msgb_free(reply);
+}
+
+static void conn_close(void)
+{
+	struct reply *r, *r2;
+
+	printf("Connection closed after %lu requests\n", emu.requests);
+
+	llist_for_each_entry_safe(r, r2, &emu.replies, list) {
+		llist_del(&r->list);
+		msgb_free(r->msg);
+		free(r);
+	}
+	osmo_timer_del(&emu.timer);
+
+	close(emu.conn_fd.fd);
+	osmo_fd_unregister(&emu.conn_fd);
+	emu.conn_fd.fd = -1;
+	emu.listen_fd.when = BSC_FD_READ;
+}
+
+/* the fd is non-blocking, requests are taken from what arrived so far */
+static int conn_read(struct osmo_fd *fd, unsigned int flags)
+{
+	struct msgb *msg;
+	unsigned int len;
+	int rc;
+
+	rc = read(fd->fd, emu.rx + emu.rx_len, sizeof(emu.rx) - emu.rx_len);
+	if (rc <= 0) {
+		conn_close();
+		return 0;
+	}
+	emu.rx_len += rc;
+
+	while (emu.rx_len >= 2) {
+		len = emu.rx[0] << 8 | emu.rx[1];
+		if (len > MSG_MAX) {
+			conn_close();
+			return 0;
+		}
+		if (emu.rx_len < 2 + len)
+			break;
+
+		msg = msgb_alloc(MSG_MAX, "request");
+		memcpy(msgb_put(msg, len), emu.rx + 2, len);
+		handle_request(msg);
+		msgb_free(msg);
+
+		emu.rx_len -= 2 + len;
+		memmove(emu.rx, emu.rx + 2 + len, emu.rx_len);
+	}
+
+	return 0;
+}
+
+/* one osmoload at a time */
+static int conn_accept(struct osmo_fd *fd, unsigned int flags)
+{
+	int rc;
+
+	rc = accept(fd->fd, NULL, NULL);
+	if (rc < 0)
+		return 0;
+
+	emu.requests = 0;
+	emu.rx_len = 0;
+	emu.conn_fd.fd = rc;
+	emu.conn_fd.when = BSC_FD_READ;
+	emu.conn_fd.cb = conn_read;
+	osmo_fd_register(&emu.conn_fd);
+	fd->when = 0;
+
+	return 0;
+}
+
+static int listen_on(const char *path)
+{
+	struct sockaddr_un local;
+	int fd;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	memset(&local, 0, sizeof(local));
+	local.sun_family = AF_UNIX;
+	strncpy(local.sun_path, path, sizeof(local.sun_path) - 1);
+	unlink(local.sun_path);
+
+	if (bind(fd, (struct sockaddr *) &local, sizeof(local)) < 0 ||
+	    listen(fd, 0) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	emu.listen_fd.fd = fd;
+	emu.listen_fd.when = BSC_FD_READ;
+	emu.listen_fd.cb = conn_accept;
+
+	return osmo_fd_register(&emu.listen_fd);
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [ -h ] [ -l /tmp/osmocom_loader ] [ -b baudrate ]\n"
+	       "\t\t [ -L latency (us) ] [ -p processing (us) ]\n"
+	       "\t\t [ -c n ] [ -x n ]\n\n"
+	       "* Answer osmoload like the loader on a phone behind osmocon\n"
+	       "* -b, -L, -p: serial speed, one way latency of the serial\n"
+	       "  adapter, time the phone needs per request (default 115200,\n"
+	       "  2000, 100)\n"
+	       "* -c, -x: wrong crc in, or loss of, every nth memory reply\n",
+	       name);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *path = "/tmp/osmocom_loader";
+	int opt;
+
+	emu.baudrate = 115200;
+	emu.latency = 2000;
+	emu.processing = 100;
+
+	while ((opt = getopt(argc, argv, "hl:b:L:p:c:x:")) != -1) {
+		switch (opt) {
+		case 'l':
+			path = optarg;
+			break;
+		case 'b':
+			emu.baudrate = atoi(optarg);
+			break;
+		case 'L':
+			emu.latency = atoi(optarg);
+			break;
+		case 'p':
+			emu.processing = atoi(optarg);
+			break;
+		case 'c':
+			emu.corrupt_every = atoi(optarg);
+			break;
+		case 'x':
+			emu.drop_every = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (!emu.baudrate)
+		usage(argv[0]);
+
+	emu.mem = calloc(1, MEM_SIZE);
+	if (!emu.mem) {
+		fprintf(stderr, "Failed to allocate the memory.\n");
+		exit(1);
+	}
+
+	INIT_LLIST_HEAD(&emu.replies);
+	emu.timer.cb = reply_timer_cb;
+	emu.conn_fd.fd = -1;
+
+	if (listen_on(path) < 0) {
+		fprintf(stderr, "Failed to listen on %s: %s\n", path,
+			strerror(errno));
+		exit(1);
+	}
+
+	while (1)
+		osmo_select_main(0);
+
+	return 0;
+}
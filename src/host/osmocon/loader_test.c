@@ -0,0 +1,171 @@
+/* osmoload against the loader emulator with lost and corrupted replies,
+ * what is loaded must come back unchanged */
+
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define DATA_LEN	5000
+
+static char sock[64];
+
+static pid_t start(char *const argv[])
+{
+	pid_t pid;
+
+	pid = fork();
+	if (!pid) {
+		int fd = open("/dev/null", O_WRONLY);
+		dup2(fd, 1);
+		execv(argv[0], argv);
+		exit(127);
+	}
+
+	return pid;
+}
+
+static int run(char *const argv[])
+{
+	int status;
+
+	waitpid(start(argv), &status, 0);
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static pid_t start_emu(const char *corrupt, const char *drop)
+{
+	char *const argv[] = { "./loader_emu", "-l", sock, "-L", "0",
+			       "-p", "0", "-b", "10000000", "-c",
+			       (char *) corrupt, "-x", (char *) drop, NULL };
+	struct sockaddr_un sun;
+	pid_t pid;
+	int i, fd;
+
+	/* the socket of the previous one must not count */
+	unlink(sock);
+	pid = start(argv);
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	snprintf(sun.sun_path, sizeof(sun.sun_path), "%s", sock);
+
+	/* wait until it listens, the probe just looks like a closed osmoload */
+	for (i = 0; i < 50; i++) {
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (connect(fd, (struct sockaddr *) &sun, sizeof(sun)) == 0) {
+			close(fd);
+			break;
+		}
+		close(fd);
+		usleep(100000);
+	}
+
+	return pid;
+}
+
+static int compare(const char *a, const char *b)
+{
+	static uint8_t ba[DATA_LEN + 1], bb[DATA_LEN + 1];
+	FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+	int la = 0, lb = 0;
+
+	if (fa) {
+		la = fread(ba, 1, sizeof(ba), fa);
+		fclose(fa);
+	}
+	if (fb) {
+		lb = fread(bb, 1, sizeof(bb), fb);
+		fclose(fb);
+	}
+
+	return la == DATA_LEN && lb == DATA_LEN && !memcmp(ba, bb, DATA_LEN);
+}
+
+int main(int argc, char **argv)
+{
+	char in[64], out[64], len[16];
+	uint8_t data[DATA_LEN];
+	int rc_load, rc_dump, rc_prog, rc_fdump, ok_mem, ok_flash;
+	FILE *f;
+	pid_t emu;
+	int i;
+
+	snprintf(sock, sizeof(sock), "/tmp/loader_test_sock.%d", getpid());
+	snprintf(in, sizeof(in), "/tmp/loader_test_in.%d", getpid());
+	snprintf(out, sizeof(out), "/tmp/loader_test_out.%d", getpid());
+	snprintf(len, sizeof(len), "%x", DATA_LEN);
+
+	srand(1);
+	for (i = 0; i < DATA_LEN; i++)
+		data[i] = rand();
+	f = fopen(in, "wb");
+	fwrite(data, 1, sizeof(data), f);
+	fclose(f);
+
+	/* memory, with the 5th reply corrupted and the 7th lost */
+	{
+		char *const load[] = { "./osmoload", "-l", sock, "-w", "8",
+				       "memload", "800000", in, NULL };
+		char *const dump[] = { "./osmoload", "-l", sock, "-w", "8",
+				       "memdump", "800000", len, out, NULL };
+
+		emu = start_emu("5", "7");
+		rc_load = run(load);
+		rc_dump = run(dump);
+		kill(emu, SIGTERM);
+		waitpid(emu, NULL, 0);
+		ok_mem = compare(in, out);
+		unlink(out);
+	}
+
+	/* flash, corrupted replies only as a lost one takes 10s */
+	{
+		char *const prog[] = { "./osmoload", "-l", sock, "-w", "4",
+				       "fprogram", "0", "10000", in, NULL };
+		char *const dump[] = { "./osmoload", "-l", sock, "-w", "1",
+				       "memdump", "10000", len, out, NULL };
+
+		emu = start_emu("3", "0");
+		rc_prog = run(prog);
+		rc_fdump = run(dump);
+		kill(emu, SIGTERM);
+		waitpid(emu, NULL, 0);
+		ok_flash = compare(in, out);
+		unlink(out);
+	}
+
+	unlink(in);
+	unlink(sock);
+
+	printf("memload %d, memdump %d, %s\n", rc_load, rc_dump,
+		ok_mem ? "same" : "DIFFERENT");
+	printf("fprogram %d, memdump %d, %s\n", rc_prog, rc_fdump,
+		ok_flash ? "same" : "DIFFERENT");
+
+	return !rc_load && !rc_dump && ok_mem &&
+	       !rc_prog && !rc_fdump && ok_flash ? 0 : 1;
+}
@@ -23,6 +23,7 @@
  */
 
 #include <ctype.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +36,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/un.h>
 
 #include <sercomm.h>
@@ -44,6 +46,7 @@
 #include <osmocom/core/serial.h>
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/timer.h>
+#include <osmocom/core/write_queue.h>
 
 #include <arpa/inet.h>
 
@@ -62,6 +65,33 @@
 #define MTK_ADDRESS		0x40001400
 #define MTK_BLOCK_SIZE		1024
 
+/* HDLC framed octets handed to the serial port at once, small enough
+ * to not delay high priority DLCIs for long */
+#define HDLC_TX_BUF_SIZE	512
+
+/* frames queued for a tool that doesn't read fast enough, before
+ * dropping them and before giving up on the tool. One serial read can
+ * carry a few dozen frames, a write to the tool must take as many. */
+#define TOOL_WQ_DEPTH		256
+#define TOOL_WQ_BATCH		OSMO_WQUEUE_MAX_BATCH
+#define TOOL_MAX_DROPS		1024
+#define TOOL_MAX_FRAME		4096
+
+/* capture file: a header with magic, version and the wall clock time the
+ * capture started, then per frame the microseconds since the previous one
+ * on the monotonic clock,
+ * direction, dlci and length (all big endian) followed by the payload */
+#define CAPTURE_MAGIC		"OCAP"
+#define CAPTURE_VERSION		1
+#define CAPTURE_HDR_LEN		16
+#define CAPTURE_REC_LEN		8
+#define CAPTURE_MAX_FRAME	2048
+
+enum capture_dir {
+	CAPTURE_RX,	/* from the phone */
+	CAPTURE_TX,	/* to the phone */
+};
+
 struct tool_server *tool_server_for_dlci[256];
 
 /**
@@ -70,7 +100,15 @@ struct tool_server *tool_server_for_dlci[256];
 struct tool_connection {
 	struct tool_server *server;
 	struct llist_head entry;
-	struct osmo_fd fd;
+	struct osmo_wqueue wq;
+
+	/* frames dropped in total and since the queue became full */
+	unsigned long dropped;
+	unsigned int dropping;
+
+	/* received octets, length prefixed frames */
+	uint8_t rx[2 + TOOL_MAX_FRAME];
+	unsigned int rx_len;
 };
 
 /**
@@ -162,10 +200,42 @@ struct dnload {
 
 	struct tool_server layer2_server;
 	struct tool_server loader_server;
+
+	/* sercomm: framed octets, written up to hdlc_tx_ofs */
+	uint8_t hdlc_tx[HDLC_TX_BUF_SIZE];
+	int hdlc_tx_len;
+	int hdlc_tx_ofs;
+
+	/* frames to and from the phone are written here */
+	FILE *capture;
+	uint64_t capture_time;	/* monotonic, of the last frame */
+};
+
+/**
+ * replay of a capture instead of a phone
+ */
+struct replay {
+	FILE *file;
+	int fast;
+	int started;
+	int eof;
+	unsigned long frames;
+
+	/* capture time of the first and the next frame, all in us */
+	uint64_t first_time;
+	uint64_t next_time;
+	uint64_t start;
+	struct osmo_timer_list timer;
+
+	/* the next frame from the phone */
+	uint8_t dlci;
+	uint16_t len;
+	uint8_t data[CAPTURE_MAX_FRAME];
 };
 
 
 static struct dnload dnload;
+static struct replay replay;
 static struct osmo_timer_list tick_timer;
 
 /* Compal ramloader specific */
@@ -637,13 +707,30 @@ static int handle_write_dnload(void)
 
 static int handle_sercomm_write(void)
 {
-	uint8_t c;
+	int rc;
 
-	if (sercomm_drv_pull(&c) != 0) {
-		if (write(dnload.serial_fd.fd, &c, 1) != 1)
-			perror("short write");
-		} else
+	/* frame as many queued messages as fit into the buffer */
+	if (dnload.hdlc_tx_ofs >= dnload.hdlc_tx_len) {
+		dnload.hdlc_tx_ofs = 0;
+		dnload.hdlc_tx_len = sercomm_drv_pull_bulk(dnload.hdlc_tx,
+						sizeof(dnload.hdlc_tx));
+		if (!dnload.hdlc_tx_len) {
 			dnload.serial_fd.when &= ~BSC_FD_WRITE;
+			return 0;
+		}
+	}
+
+	rc = write(dnload.serial_fd.fd, dnload.hdlc_tx + dnload.hdlc_tx_ofs,
+		   dnload.hdlc_tx_len - dnload.hdlc_tx_ofs);
+	if (rc < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return 0;
+		perror("write to serial");
+		/* drop the buffer instead of failing on it forever */
+		rc = dnload.hdlc_tx_len - dnload.hdlc_tx_ofs;
+	}
+	/* the rest of a short write goes out next time */
+	dnload.hdlc_tx_ofs += rc;
 
 	return 0;
 }
@@ -684,6 +771,77 @@ static int handle_write(void)
 static uint8_t buffer[sizeof(phone_prompt1)];
 static uint8_t *bufptr = buffer;
 
+/* for intervals, not affected by setting the clock */
+static uint64_t time_us(void)
+{
+	struct timespec ts;
+
+	osmo_clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int capture_open(const char *filename)
+{
+	uint8_t hdr[CAPTURE_HDR_LEN];
+	struct timeval tv;
+	uint64_t start;
+	int i;
+
+	dnload.capture = fopen(filename, "w");
+	if (!dnload.capture) {
+		perror("Failed to open the capture file");
+		return -1;
+	}
+
+	osmo_gettimeofday(&tv, NULL);
+	start = (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+	dnload.capture_time = time_us();
+
+	memset(hdr, 0, sizeof(hdr));
+	memcpy(hdr, CAPTURE_MAGIC, 4);
+	hdr[4] = CAPTURE_VERSION;
+	for (i = 0; i < 8; i++)
+		hdr[8 + i] = start >> (56 - i * 8);
+	fwrite(hdr, 1, sizeof(hdr), dnload.capture);
+
+	return 0;
+}
+
+/* called for every frame, the file is flushed by capture_flush() */
+static void capture_frame(enum capture_dir dir, uint8_t dlci,
+			  const uint8_t *data, unsigned int len)
+{
+	uint8_t rec[CAPTURE_REC_LEN];
+	uint64_t delta;
+
+	if (!dnload.capture)
+		return;
+
+	/* longer pauses are shortened to ~71 minutes */
+	delta = time_us() - dnload.capture_time;
+	if (delta > UINT32_MAX)
+		delta = UINT32_MAX;
+	dnload.capture_time += delta;
+
+	rec[0] = delta >> 24;
+	rec[1] = delta >> 16;
+	rec[2] = delta >> 8;
+	rec[3] = delta;
+	rec[4] = dir;
+	rec[5] = dlci;
+	rec[6] = len >> 8;
+	rec[7] = len;
+	fwrite(rec, 1, sizeof(rec), dnload.capture);
+	fwrite(data, 1, len, dnload.capture);
+}
+
+/* once per serial read or tool message, not once per frame */
+static void capture_flush(void)
+{
+	if (dnload.capture)
+		fflush(dnload.capture);
+}
+
 static void hdlc_send_to_phone(uint8_t dlci, uint8_t *data, int len)
 {
 	struct msgb *msg;
@@ -699,6 +857,12 @@ static void hdlc_send_to_phone(uint8_t dlci, uint8_t *data, int len)
 		return;
 	}
 
+	capture_frame(CAPTURE_TX, dlci, data, len);
+
+	/* nobody to send it to */
+	if (replay.file)
+		return;
+
 	/* push the message into the stack */
 	msg = sercomm_alloc_msgb(512);
 	if (!msg) {
@@ -717,36 +881,125 @@ static void hdlc_send_to_phone(uint8_t dlci, uint8_t *data, int len)
 
 static void hdlc_console_cb(uint8_t dlci, struct msgb *msg)
 {
+	capture_frame(CAPTURE_RX, dlci, msg->data, msg->len);
 	write(1, msg->data, msg->len);
 	msgb_free(msg);
 }
 
+static void tool_close(struct tool_connection *con)
+{
+	if (con->dropped)
+		printf("Tool connection %d on dlci %u closed, %lu frames "
+			"dropped\n", con->wq.bfd.fd, con->server->dlci,
+			con->dropped);
+
+	close(con->wq.bfd.fd);
+	osmo_fd_unregister(&con->wq.bfd);
+	osmo_wqueue_clear(&con->wq);
+	llist_del(&con->entry);
+	talloc_free(con);
+}
+
+/* queue a frame for a tool, dropping it if the tool doesn't read */
+static void tool_send(struct tool_connection *con, struct msgb *msg)
+{
+	struct msgb *clone;
+
+	if (con->wq.current_length >= con->wq.max_length) {
+		if (!con->dropping++)
+			printf("Tool connection %d on dlci %u too slow, "
+				"dropping frames\n", con->wq.bfd.fd,
+				con->server->dlci);
+		con->dropped++;
+		if (con->dropping >= TOOL_MAX_DROPS) {
+			printf("Tool connection %d on dlci %u doesn't read, "
+				"closing it\n", con->wq.bfd.fd,
+				con->server->dlci);
+			tool_close(con);
+		}
+		return;
+	}
+
+	if (con->dropping) {
+		printf("Tool connection %d on dlci %u reading again, %u "
+			"frames dropped\n", con->wq.bfd.fd, con->server->dlci,
+			con->dropping);
+		con->dropping = 0;
+	}
+
+	/* all tools get the same data, freed when the last has sent it */
+	clone = msgb_clone_shared(msg, "tool frame");
+	if (!clone) {
+		con->dropped++;
+		return;
+	}
+	osmo_wqueue_enqueue(&con->wq, clone);
+}
+
 static void hdlc_tool_cb(uint8_t dlci, struct msgb *msg)
 {
 	struct tool_server *srv = tool_server_for_dlci[dlci];
 
+	capture_frame(CAPTURE_RX, dlci, msg->data, msg->len);
+
 	if(dnload.dump_rx) {
 		printf("hdlc_recv(dlci=%u): ", dlci);
 		osmocon_osmo_hexdump(msg->data, msg->len);
 	}
 
 	if(srv) {
-		struct tool_connection *con;
+		struct tool_connection *con, *con2;
 		uint16_t *len;
 
 		len = (uint16_t *) msgb_push(msg, 2);
 		*len = htons(msg->len - sizeof(*len));
 
-		llist_for_each_entry(con, &srv->connections, entry) {
-			if (write(con->fd.fd, msg->data, msg->len) != msg->len) {
-				fprintf(stderr,
-					"Failed to write msg to the socket..\n");
-				continue;
+		llist_for_each_entry_safe(con, con2, &srv->connections, entry)
+			tool_send(con, msg);
+	}
+
+	msgb_free(msg);
+}
+
+/* the phone's messages handle_read() looks for in the window */
+static const uint8_t *phone_msgs[] = {
+	phone_prompt1, phone_prompt2, phone_ack, phone_nack,
+	phone_nack_magic, ftmtool,
+};
+
+/* With a full window, HDLC data is read in large blocks.  The window then
+ * gets the first phone message found in the block, or the block's last
+ * octets, and advances by one octet like a single octet read would */
+static int handle_buffer_hdlc(void)
+{
+	static uint8_t rx[sizeof(buffer) + 4096];
+	unsigned int j;
+	int nbytes, i, pos;
+
+	memcpy(rx, buffer, sizeof(buffer));
+	nbytes = read(dnload.serial_fd.fd, rx + sizeof(buffer),
+		      sizeof(rx) - sizeof(buffer));
+	if (nbytes <= 0)
+		return nbytes;
+
+	i = sercomm_drv_rx_buf(rx + sizeof(buffer), nbytes);
+	if (i)
+		printf("Dropping %d samples\n", i);
+
+	pos = nbytes;
+	for (i = 1; i < nbytes && pos == nbytes; i++) {
+		for (j = 0; j < ARRAY_SIZE(phone_msgs); j++) {
+			if (rx[i] == phone_msgs[j][0] &&
+			    !memcmp(rx + i, phone_msgs[j], sizeof(buffer))) {
+				pos = i;
+				break;
 			}
 		}
 	}
+	memcpy(buffer, rx + pos, sizeof(buffer));
+	bufptr = buffer + sizeof(buffer) - 1;
 
-	msgb_free(msg);
+	return 1;
 }
 
 static int handle_buffer(int buf_used_len)
@@ -755,6 +1008,8 @@ static int handle_buffer(int buf_used_len)
 
 	buf_left = buf_used_len - (bufptr - buffer);
 	if (buf_left <= 0) {
+		if (dnload.expect_hdlc)
+			return handle_buffer_hdlc();
 		memmove(buffer, buffer+1, buf_used_len-1);
 		bufptr -= 1;
 		buf_left = 1;
@@ -1165,6 +1420,8 @@ static int serial_read(struct osmo_fd *fd, unsigned int flags)
 		if (rc == 1)
 			dnload.state = WAITING_PROMPT1;
 	}
+
+	capture_flush();
 	return 0;
 }
 
@@ -1195,10 +1452,15 @@ static int parse_mode(const char *arg)
 	"\t\t [ -m {c123,c123xor,c140,c140xor,c155,romload,mtk} ]\n" \
 	"\t\t [ -c /to-be-chainloaded-file.bin ]\n" \
 	"\t\t [ -i beacon-interval (mS) ]\n" \
+	"\t\t [ -w capture-file ]\n" \
+	"\t\t [ -r capture-file [ -f ] ]\n" \
 	"\t\t  file.bin\n\n" \
 	"* Open serial port /dev/ttyXXXX (connected to your phone)\n" \
 	"* Perform handshaking with the ramloader in the phone\n" \
-	"* Download file.bin to the attached phone (base address 0x00800100)\n"
+	"* Download file.bin to the attached phone (base address 0x00800100)\n" \
+	"* -w writes all HDLC frames to and from the phone to capture-file\n" \
+	"* -r plays the frames from the phone in capture-file to the tools\n" \
+	"  instead, in real time or with -f as fast as they are read\n"
 
 static int usage(const char *name)
 {
@@ -1213,62 +1475,228 @@ static int version(const char *name)
 	exit(2);
 }
 
-static int un_tool_read(struct osmo_fd *fd, unsigned int flags)
+static int replay_open(const char *filename, int fast)
 {
-	int rc, c;
-	uint16_t length = 0xffff;
-	uint8_t buf[4096];
-	struct tool_connection *con = (struct tool_connection *)fd->data;
+	uint8_t hdr[CAPTURE_HDR_LEN];
 
-	c = 0;
-	while(c < 2) {
-		rc = read(fd->fd, &buf + c, 2 - c);
-		if(rc == 0) {
-			// disconnect
-			goto close;
-		}
-		if(rc < 0) {
-			if(errno == EAGAIN) {
-				continue;
-			}
-			fprintf(stderr, "Err from socket: %s\n", strerror(errno));
-			goto close;
+	replay.file = fopen(filename, "r");
+	if (!replay.file) {
+		perror("Failed to open the capture file");
+		return -1;
+	}
+
+	if (fread(hdr, 1, sizeof(hdr), replay.file) != sizeof(hdr) ||
+	    memcmp(hdr, CAPTURE_MAGIC, 4) || hdr[4] != CAPTURE_VERSION) {
+		fprintf(stderr, "%s is not a capture file.\n", filename);
+		return -1;
+	}
+
+	replay.fast = fast;
+
+	return 0;
+}
+
+/* read the next frame from the phone, 0 at the end of the file */
+static int replay_next(void)
+{
+	uint8_t rec[CAPTURE_REC_LEN];
+	size_t rc;
+
+	while (1) {
+		rc = fread(rec, 1, sizeof(rec), replay.file);
+		if (rc == 0 && feof(replay.file))
+			return 0;
+		if (rc != sizeof(rec))
+			return -1;
+
+		replay.next_time += (uint32_t) (rec[0] << 24 | rec[1] << 16 |
+						rec[2] << 8 | rec[3]);
+		replay.dlci = rec[5];
+		replay.len = rec[6] << 8 | rec[7];
+		if (replay.len > sizeof(replay.data) ||
+		    fread(replay.data, 1, replay.len, replay.file) != replay.len)
+			return -1;
+
+		/* the tools send their own */
+		if (rec[4] == CAPTURE_RX)
+			return 1;
+	}
+}
+
+/* pass the frame through sercomm, like from the serial port */
+static void replay_frame(void)
+{
+	static uint8_t hdlc[2 * CAPTURE_MAX_FRAME + 4];
+	unsigned int i, n = 0;
+	uint8_t c;
+
+	hdlc[n++] = HDLC_FLAG;
+	hdlc[n++] = replay.dlci;
+	hdlc[n++] = HDLC_C_UI;
+	for (i = 0; i < replay.len; i++) {
+		c = replay.data[i];
+		if (c == HDLC_FLAG || c == HDLC_ESCAPE || c == 0x00) {
+			hdlc[n++] = HDLC_ESCAPE;
+			c ^= (1 << 5);
 		}
-		c += rc;
+		hdlc[n++] = c;
 	}
+	hdlc[n++] = HDLC_FLAG;
 
-	memcpy(&length, buf, sizeof length);
-	length = ntohs(length);
+	sercomm_drv_rx_buf(hdlc, n);
+}
 
-	c = 0;
-	while(c < length) {
-		rc = read(fd->fd, &buf + c, length - c);
-		if(rc == 0) {
-			// disconnect
-			goto close;
+/* the largest number of frames queued for any tool */
+static unsigned int replay_queued(void)
+{
+	struct tool_server *servers[] = {
+		&dnload.layer2_server, &dnload.loader_server,
+	};
+	struct tool_connection *con;
+	unsigned int i, queued = 0;
+
+	for (i = 0; i < ARRAY_SIZE(servers); i++) {
+		llist_for_each_entry(con, &servers[i]->connections, entry) {
+			if (con->wq.current_length > queued)
+				queued = con->wq.current_length;
 		}
-		if(rc < 0) {
-			if(errno == EAGAIN) {
-				continue;
+	}
+
+	return queued;
+}
+
+/* play the frames that are due, or in fast mode as many as the tools
+ * have room for; called again by the timer or when a tool was written */
+static void replay_pump(void)
+{
+	uint64_t now, due;
+	double secs;
+	int rc;
+
+	if (!replay.started)
+		return;
+
+	while (!replay.eof) {
+		if (replay.fast) {
+			if (replay_queued() >= TOOL_WQ_DEPTH / 2)
+				return;
+		} else {
+			now = time_us();
+			due = replay.start + replay.next_time - replay.first_time;
+			if (due > now) {
+				osmo_timer_schedule(&replay.timer,
+					(due - now) / 1000000,
+					(due - now) % 1000000);
+				return;
 			}
-			fprintf(stderr, "Err from socket: %s\n", strerror(errno));
+		}
+
+		replay_frame();
+		replay.frames++;
+
+		rc = replay_next();
+		if (rc < 0) {
+			fprintf(stderr, "The capture file is truncated.\n");
+			exit(1);
+		}
+		if (rc == 0)
+			replay.eof = 1;
+	}
+
+	/* done once the tools got everything */
+	if (replay_queued())
+		return;
+
+	secs = (time_us() - replay.start) / 1e6;
+	printf("Replayed %lu frames in %.3f s, %.0f frames/s\n",
+		replay.frames, secs, secs > 0 ? replay.frames / secs : 0);
+	exit(0);
+}
+
+static void replay_timer_cb(void *data)
+{
+	replay_pump();
+}
+
+/* the replay starts with the first tool connecting */
+static void replay_start(void)
+{
+	int rc;
+
+	rc = replay_next();
+	if (rc < 0) {
+		fprintf(stderr, "The capture file is truncated.\n");
+		exit(1);
+	}
+	replay.eof = rc == 0;
+	replay.first_time = replay.next_time;
+	replay.start = time_us();
+	replay.timer.cb = replay_timer_cb;
+	replay.started = 1;
+
+	printf("Replaying the capture %s\n",
+		replay.fast ? "as fast as possible" : "in real time");
+	replay_pump();
+}
+
+static int un_tool_read(struct osmo_fd *fd, unsigned int flags)
+{
+	struct tool_connection *con = (struct tool_connection *)fd->data;
+	unsigned int used = 0;
+	uint16_t length;
+	int rc;
+
+	rc = read(fd->fd, con->rx + con->rx_len, sizeof(con->rx) - con->rx_len);
+	if(rc == 0) {
+		// disconnect
+		goto close;
+	}
+	if(rc < 0) {
+		if(errno == EAGAIN || errno == EINTR)
+			return 0;
+		fprintf(stderr, "Err from socket: %s\n", strerror(errno));
+		goto close;
+	}
+	con->rx_len += rc;
+
+	/* all complete frames, a partial one waits for the next read */
+	while (con->rx_len - used >= 2) {
+		memcpy(&length, con->rx + used, sizeof length);
+		length = ntohs(length);
+		if (length > TOOL_MAX_FRAME) {
+			fprintf(stderr, "Frame from tool too long: %u\n", length);
 			goto close;
 		}
-		c += rc;
+		if (con->rx_len - used < 2 + length)
+			break;
+
+		hdlc_send_to_phone(con->server->dlci, con->rx + used + 2,
+				   length);
+		used += 2 + length;
 	}
 
-	hdlc_send_to_phone(con->server->dlci, buf, length);
+	memmove(con->rx, con->rx + used, con->rx_len - used);
+	con->rx_len -= used;
 
 	return 0;
 close:
-
-	close(fd->fd);
-	osmo_fd_unregister(fd);
-	llist_del(&con->entry);
-	talloc_free(con);
+	tool_close(con);
 	return -1;
 }
 
+static int tool_cb(struct osmo_fd *fd, unsigned int flags)
+{
+	/* the connection is gone if reading failed */
+	if ((flags & BSC_FD_READ) && un_tool_read(fd, flags) < 0)
+		goto out;
+
+	osmo_wqueue_bfd_cb(fd, flags & BSC_FD_WRITE);
+out:
+	capture_flush();
+	replay_pump();
+	return 0;
+}
+
 /* accept a new connection */
 static int tool_accept(struct osmo_fd *fd, unsigned int flags)
 {
@@ -1293,16 +1721,23 @@ static int tool_accept(struct osmo_fd *fd, unsigned int flags)
 
 	con->server = srv;
 
-	con->fd.fd = rc;
-	con->fd.when = BSC_FD_READ;
-	con->fd.cb = un_tool_read;
-	con->fd.data = con;
-	if (osmo_fd_register(&con->fd) != 0) {
+	/* frames to the tool are queued, a tool that doesn't read must not
+	 * stall the serial port */
+	fcntl(rc, F_SETFL, fcntl(rc, F_GETFL) | O_NONBLOCK);
+	osmo_wqueue_init_batch(&con->wq, TOOL_WQ_DEPTH, TOOL_WQ_BATCH);
+	con->wq.bfd.fd = rc;
+	con->wq.bfd.when = BSC_FD_READ;
+	con->wq.bfd.cb = tool_cb;
+	con->wq.bfd.data = con;
+	if (osmo_fd_register(&con->wq.bfd) != 0) {
 		fprintf(stderr, "Failed to register the fd.\n");
 		return -1;
 	}
 
 	llist_add(&con->entry, &srv->connections);
+
+	if (replay.file && !replay.started)
+		replay_start();
 	return 0;
 }
 
@@ -1375,6 +1810,12 @@ static int register_tool_server(struct tool_server *ts,
 
 extern void hdlc_tpudbg_cb(uint8_t dlci, struct msgb *msg);
 
+static void hdlc_debug_cb(uint8_t dlci, struct msgb *msg)
+{
+	capture_frame(CAPTURE_RX, dlci, msg->data, msg->len);
+	hdlc_tpudbg_cb(dlci, msg);
+}
+
 void parse_debug(const char *str)
 {
 	while(*str) {
@@ -1401,13 +1842,15 @@ int main(int argc, char **argv)
 	const char *serial_dev = "/dev/ttyUSB1";
 	const char *layer2_un_path = "/tmp/osmocom_l2";
 	const char *loader_un_path = "/tmp/osmocom_loader";
+	const char *capture_path = NULL, *replay_path = NULL;
+	int replay_fast = 0;
 
 	dnload.mode = MODE_C123;
 	dnload.chainload_filename = NULL;
 	dnload.previous_filename = NULL;
 	dnload.beacon_interval = DEFAULT_BEACON_INTERVAL;
 
-	while ((opt = getopt(argc, argv, "d:hl:p:m:c:s:i:v")) != -1) {
+	while ((opt = getopt(argc, argv, "d:hl:p:m:c:s:i:vw:r:f")) != -1) {
 		switch (opt) {
 		case 'p':
 			serial_dev = optarg;
@@ -1435,6 +1878,15 @@ int main(int argc, char **argv)
 		case 'i':
 			dnload.beacon_interval = atoi(optarg) * 1000;
 			break;
+		case 'w':
+			capture_path = optarg;
+			break;
+		case 'r':
+			replay_path = optarg;
+			break;
+		case 'f':
+			replay_fast = 1;
+			break;
 		case 'h':
 		default:
 			usage(argv[0]);
@@ -1448,29 +1900,42 @@ int main(int argc, char **argv)
 		dnload.filename = argv[optind];
 	}
 
-	dnload.serial_fd.fd = osmo_serial_init(serial_dev, MODEM_BAUDRATE);
-	if (dnload.serial_fd.fd < 0) {
-		fprintf(stderr, "Cannot open serial device %s\n", serial_dev);
+	if (capture_path && capture_open(capture_path) < 0)
 		exit(1);
-	}
 
-	if (osmo_fd_register(&dnload.serial_fd) != 0) {
-		fprintf(stderr, "Failed to register the serial.\n");
-		exit(1);
-	}
+	if (replay_path) {
+		/* no phone, the frames come from the capture */
+		if (replay_open(replay_path, replay_fast) < 0)
+			exit(1);
+		dnload.serial_fd.fd = -1;
+	} else {
+		dnload.serial_fd.fd = osmo_serial_init(serial_dev, MODEM_BAUDRATE);
+		if (dnload.serial_fd.fd < 0) {
+			fprintf(stderr, "Cannot open serial device %s\n", serial_dev);
+			exit(1);
+		}
 
-	/* Set serial socket to non-blocking mode of operation */
-	flags = fcntl(dnload.serial_fd.fd, F_GETFL);
-	flags |= O_NONBLOCK;
-	fcntl(dnload.serial_fd.fd, F_SETFL, flags);
+		if (osmo_fd_register(&dnload.serial_fd) != 0) {
+			fprintf(stderr, "Failed to register the serial.\n");
+			exit(1);
+		}
+
+		/* Set serial socket to non-blocking mode of operation */
+		flags = fcntl(dnload.serial_fd.fd, F_GETFL);
+		flags |= O_NONBLOCK;
+		fcntl(dnload.serial_fd.fd, F_SETFL, flags);
+
+		dnload.serial_fd.when = BSC_FD_READ;
+		dnload.serial_fd.cb = serial_read;
+	}
 
-	dnload.serial_fd.when = BSC_FD_READ;
-	dnload.serial_fd.cb = serial_read;
+	/* a tool that went away must not kill us while writing to it */
+	signal(SIGPIPE, SIG_IGN);
 
 	/* initialize the HDLC layer */
 	sercomm_init();
 	sercomm_register_rx_cb(SC_DLCI_CONSOLE, hdlc_console_cb);
-	sercomm_register_rx_cb(SC_DLCI_DEBUG, hdlc_tpudbg_cb);
+	sercomm_register_rx_cb(SC_DLCI_DEBUG, hdlc_debug_cb);
 
 	/* unix domain socket handling */
 	if (register_tool_server(&dnload.layer2_server, layer2_un_path,
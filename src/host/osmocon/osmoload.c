@@ -31,6 +31,7 @@
 #include <arpa/inet.h>
 
 #include <sys/stat.h>
+#include <sys/time.h>
 
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -48,6 +49,13 @@
 
 #define DEFAULT_SOCKET "/tmp/osmocom_loader"
 
+/* memory requests sent before waiting for a reply; the firmware has 32
+ * message buffers for requests and replies */
+#define MEM_DEFAULT_WINDOW 4
+#define MEM_MAX_WINDOW 16
+
+#define MEM_MAX_RETRIES 16
+
 static struct osmo_fd connection;
 
 enum {
@@ -62,6 +70,15 @@ enum {
 	STATE_DUMPING,
 };
 
+struct memreq {
+	int active;
+	uint32_t off;   /* offset of the request */
+	uint8_t len;    /* its length */
+	uint16_t crc;   /* crc of the data sent */
+	unsigned retries;
+	struct osmo_timer_list timer;
+};
+
 struct flashblock {
 	uint8_t fb_chip;
 	uint32_t fb_offset;
@@ -96,8 +113,12 @@ static struct {
 	uint32_t membase; /* target base address of operation */
 	uint32_t memlen;  /* length of entire operation */
 	uint32_t memoff;  /* offset for next request */
-	uint16_t memcrc;  /* crc for current request */
-	uint16_t memreq;  /* length of current request */
+
+	/* requests waiting for a reply */
+	unsigned window;
+	unsigned inflight;
+	struct memreq reqs[MEM_MAX_WINDOW];
+	struct timeval memstart;
 
 	/* array of all flash blocks */
 	uint8_t flashcommand;
@@ -107,13 +128,15 @@ static struct {
 
 static int usage(const char *name)
 {
-	printf("Usage: %s [ -v | -h ] [ -d tr ] [ -m {c123,c155} ] [ -l /tmp/osmocom_loader ] COMMAND ...\n", name);
+	printf("Usage: %s [ -v | -h ] [ -d tr ] [ -m {c123,c155} ] [ -l /tmp/osmocom_loader ] [ -w window ] COMMAND ...\n", name);
 
 	puts("\n  Memory commands:");
 	puts("    memget <hex-address> <hex-length>        - Peek at memory");
 	puts("    memput <hex-address> <hex-bytes>         - Poke at memory");
 	puts("    memdump <hex-address> <hex-length> <file>- Dump memory to file");
 	puts("    memload <hex-address> <file>             - Load file into memory");
+	printf("  memdump, memload and fprogram keep up to -w requests (default %d)\n", MEM_DEFAULT_WINDOW);
+	puts("  outstanding, -w 1 waits for each reply");
 
 	puts("\n  Flash commands:");
 	puts("    finfo                             - Information about flash chips");
@@ -206,22 +229,15 @@ loader_send_request(struct msgb *msg) {
 	}
 }
 
-static void loader_do_memdump(uint16_t crc, void *address, size_t length);
-static void loader_do_memload();
-static void loader_do_fprogram();
+static void loader_mem_reply(uint32_t address, uint8_t length, uint16_t crc, void *data);
+static void loader_mem_retry(struct memreq *r);
 static void loader_do_flashrange(uint8_t cmd, struct msgb *msg, uint8_t chip, uint32_t address, uint32_t status);
 
-static void memop_timeout(void *dummy) {
-	switch(osmoload.state) {
-	case STATE_LOAD_IN_PROGRESS:
-		printf("Timeout. Repeating.");
-		osmoload.memoff -= osmoload.memreq;
-		loader_do_memload();
-		break;
-	default:
-		break;
-	}
-	return;
+static void memop_timeout(void *data) {
+	struct memreq *r = data;
+
+	printf("\nTimeout at offset 0x%8.8x. Repeating.", r->off);
+	loader_mem_retry(r);
 }
 
 static void
@@ -409,34 +425,22 @@ loader_handle_reply(struct msgb *msg) {
 		break;
 	case STATE_DUMP_IN_PROGRESS:
 		if(cmd == LOADER_MEM_READ) {
-			loader_do_memdump(crc, data, length);
+			loader_mem_reply(address, length, crc, data);
 		}
 		break;
 	case STATE_LOAD_IN_PROGRESS:
 		if(cmd == LOADER_MEM_WRITE) {
-			if(osmoload.memcrc != crc) {
-				osmoload.memoff -= osmoload.memreq;
-				printf("\nbad crc %4.4x (not %4.4x) at offset 0x%8.8x", crc, osmoload.memcrc, osmoload.memoff);
-			} else {
-				putchar('.');
-			}
-			loader_do_memload();
+			loader_mem_reply(address, length, crc, NULL);
 		}
 		break;
 	case STATE_PROGRAM_GET_INFO:
 	case STATE_PROGRAM_IN_PROGRESS:
 		if(cmd == LOADER_FLASH_PROGRAM) {
-			if(osmoload.memcrc != crc) {
-				osmoload.memoff -= osmoload.memreq;
-				printf("\nbad crc %4.4x (not %4.4x) at offset 0x%8.8x", crc, osmoload.memcrc, osmoload.memoff);
-			} else {
-				putchar('.');
-			}
 			if(((int)status) != 0) {
 				printf("\nstatus %d, aborting\n", status);
 				exit(1);
 			}
-			loader_do_fprogram();
+			loader_mem_reply(address, length, crc, NULL);
 		}
 		break;
 	case STATE_FLASHRANGE_GET_INFO:
@@ -450,42 +454,51 @@ loader_handle_reply(struct msgb *msg) {
 	fflush(stdout);
 }
 
+/* with several requests outstanding replies arrive back to back, the
+ * socket is non-blocking, so they are collected here until complete */
 static int
 loader_read_cb(struct osmo_fd *fd, unsigned int flags) {
+	static uint8_t buf[4 * (MSGB_MAX + 2)];
+	static unsigned int buflen;
 	struct msgb *msg;
 	uint16_t len;
 	int rc;
 
-	msg = msgb_alloc(MSGB_MAX, "loader");
-	if (!msg) {
-		fprintf(stderr, "Failed to allocate msg.\n");
-		return -1;
-	}
-
-	rc = read(fd->fd, &len, sizeof(len));
-	if (rc < sizeof(len)) {
+	rc = read(fd->fd, buf + buflen, sizeof(buf) - buflen);
+	if (rc <= 0) {
+		if (rc < 0 && errno == EAGAIN) {
+			return 0;
+		}
 		fprintf(stderr, "Short read. Error.\n");
 		exit(2);
 	}
+	buflen += rc;
 
-	if (ntohs(len) > MSGB_MAX) {
-		fprintf(stderr, "Length is too big: %u\n", ntohs(len));
-		msgb_free(msg);
-		return -1;
-	}
+	while (buflen >= sizeof(len)) {
+		len = buf[0] << 8 | buf[1];
+		if (len > MSGB_MAX) {
+			fprintf(stderr, "Length is too big: %u\n", len);
+			exit(2);
+		}
+		if (buflen < sizeof(len) + len) {
+			break;
+		}
 
-	/* blocking read for the poor... we can starve in here... */
-	msg->l2h = msgb_put(msg, ntohs(len));
-	rc = read(fd->fd, msg->l2h, msgb_l2len(msg));
-	if (rc != msgb_l2len(msg)) {
-		fprintf(stderr, "Can not read data: rc: %d errno: %d\n", rc, errno);
-		msgb_free(msg);
-		return -1;
-	}
+		msg = msgb_alloc(MSGB_MAX, "loader");
+		if (!msg) {
+			fprintf(stderr, "Failed to allocate msg.\n");
+			return -1;
+		}
+		msg->l2h = msgb_put(msg, len);
+		memcpy(msg->l2h, buf + sizeof(len), len);
 
-	loader_handle_reply(msg);
+		loader_handle_reply(msg);
 
-	msgb_free(msg);
+		msgb_free(msg);
+
+		buflen -= sizeof(len) + len;
+		memmove(buf, buf + sizeof(len) + len, buflen);
+	}
 
 	return 0;
 }
@@ -599,138 +612,217 @@ loader_start_jump(uint32_t address) {
 
 
 static void
-loader_do_memdump(uint16_t crc, void *data, size_t length) {
-	int rc;
-
-	if(data && length) {
-		osmoload.memcrc = osmo_crc16(0, data, length);
-		if(osmoload.memcrc != crc) {
-			osmoload.memoff -= osmoload.memreq;
-			printf("\nbad crc %4.4x (not %4.4x) at offset 0x%8.8x", crc, osmoload.memcrc, osmoload.memoff);
-		} else {
-			putchar('.');
-		}
-
-		memcpy(osmoload.binbuf + osmoload.memoff, data, length);
-		osmoload.memoff += length;
-	}
-
-	uint32_t rembytes = osmoload.memlen - osmoload.memoff;
-
-	if(!rembytes) {
-		puts("done.");
-		osmoload.quit = 1;
-
-		unsigned c = osmoload.memlen;
-		char *p = osmoload.binbuf;
-		while(c) {
-			rc = fwrite(p, 1, c, osmoload.binfile);
-			if(ferror(osmoload.binfile)) {
-				printf("Could not read from file: %s\n", strerror(errno));
-				exit(1);
-			}
-			c -= rc;
-			p += rc;
-		}
-		fclose(osmoload.binfile);
-		osmoload.binfile = NULL;
-
-		free(osmoload.binbuf);
-
-		return;
-	}
-
-	uint8_t reqbytes = (rembytes < MEM_MSG_MAX) ? rembytes : MEM_MSG_MAX;
+loader_do_memdump(struct memreq *r) {
+	osmo_timer_schedule(&r->timer, 0, 500000);
 
 	struct msgb *msg = msgb_alloc(MSGB_MAX, "loader");
 
 	msgb_put_u8(msg, LOADER_MEM_READ);
-	msgb_put_u8(msg, reqbytes);
-	msgb_put_u32(msg, osmoload.membase + osmoload.memoff);
+	msgb_put_u8(msg, r->len);
+	msgb_put_u32(msg, osmoload.membase + r->off);
 	loader_send_request(msg);
 	msgb_free(msg);
 }
 
 static void
-loader_do_memload() {
-	uint32_t rembytes = osmoload.memlen - osmoload.memoff;
+loader_do_memload(struct memreq *r) {
+	osmo_timer_schedule(&r->timer, 0, 500000);
 
-	if(!rembytes) {
-		puts("done.");
-		osmoload.quit = 1;
-		return;
-	}
+	struct msgb *msg = msgb_alloc(MSGB_MAX, "loader");
+
+	msgb_put_u8(msg, LOADER_MEM_WRITE);
+	msgb_put_u8(msg, r->len);
+	msgb_put_u16(msg, r->crc);
+	msgb_put_u32(msg, osmoload.membase + r->off);
+
+	unsigned char *p = msgb_put(msg, r->len);
+	memcpy(p, osmoload.binbuf + r->off, r->len);
+
+#if 0
+	printf("Sending %u bytes at offset %u to address %x with crc %x\n",
+		   r->len, r->off, osmoload.membase + r->off, r->crc);
+#endif
 
-	osmo_timer_schedule(&osmoload.timeout, 0, 500000);
+	loader_send_request(msg);
 
-	uint8_t reqbytes = (rembytes < MEM_MSG_MAX) ? rembytes : MEM_MSG_MAX;
+	msgb_free(msg);
+}
 
-	osmoload.memcrc = osmo_crc16(0, (uint8_t *) osmoload.binbuf + osmoload.memoff, reqbytes);
-	osmoload.memreq = reqbytes;
+static void
+loader_do_fprogram(struct memreq *r) {
+	osmo_timer_schedule(&r->timer, 0, 10000000);
 
 	struct msgb *msg = msgb_alloc(MSGB_MAX, "loader");
 
-	msgb_put_u8(msg, LOADER_MEM_WRITE);
-	msgb_put_u8(msg, reqbytes);
-	msgb_put_u16(msg, osmoload.memcrc);
-	msgb_put_u32(msg, osmoload.membase + osmoload.memoff);
+	msgb_put_u8(msg, LOADER_FLASH_PROGRAM);
+	msgb_put_u8(msg, r->len);
+	msgb_put_u16(msg, r->crc);
+	msgb_put_u8(msg, 0); // XXX: align data to 16bit
+	msgb_put_u8(msg, osmoload.memchip);
+	msgb_put_u32(msg, osmoload.membase + r->off);
 
-	unsigned char *p = msgb_put(msg, reqbytes);
-	memcpy(p, osmoload.binbuf + osmoload.memoff, reqbytes);
+	unsigned char *p = msgb_put(msg, r->len);
+	memcpy(p, osmoload.binbuf + r->off, r->len);
 
 #if 0
 	printf("Sending %u bytes at offset %u to address %x with crc %x\n",
-		   reqbytes, osmoload.memoff, osmoload.membase + osmoload.memoff,
-		   osmoload.memcrc);
+		   r->len, r->off, osmoload.membase + r->off, r->crc);
 #endif
 
 	loader_send_request(msg);
 
 	msgb_free(msg);
+}
 
-	osmoload.memoff += reqbytes;
+static void
+loader_mem_send(struct memreq *r) {
+	switch(osmoload.state) {
+	case STATE_DUMP_IN_PROGRESS:
+		loader_do_memdump(r);
+		break;
+	case STATE_LOAD_IN_PROGRESS:
+		loader_do_memload(r);
+		break;
+	case STATE_PROGRAM_IN_PROGRESS:
+		loader_do_fprogram(r);
+		break;
+	default:
+		break;
+	}
 }
 
+/* send the same request again, nothing else is repeated */
 static void
-loader_do_fprogram() {
-	uint32_t rembytes = osmoload.memlen - osmoload.memoff;
+loader_mem_retry(struct memreq *r) {
+	if(++r->retries > MEM_MAX_RETRIES) {
+		printf("\ngiving up at offset 0x%8.8x\n", r->off);
+		exit(1);
+	}
+	loader_mem_send(r);
+}
 
-	if(!rembytes) {
-		puts("done.");
-		osmoload.quit = 1;
+static void
+loader_mem_done() {
+	int rc;
+	struct timeval tv;
+	double secs;
+
+	gettimeofday(&tv, NULL);
+	secs = (tv.tv_sec - osmoload.memstart.tv_sec)
+		+ (tv.tv_usec - osmoload.memstart.tv_usec) / 1e6;
+
+	puts("done.");
+	printf("%u bytes in %.3f s, %.0f bytes/s\n", osmoload.memlen, secs,
+		   secs > 0 ? osmoload.memlen / secs : 0);
+	osmoload.quit = 1;
+
+	if(osmoload.state != STATE_DUMP_IN_PROGRESS) {
 		return;
 	}
 
-	osmo_timer_schedule(&osmoload.timeout, 0, 10000000);
+	unsigned c = osmoload.memlen;
+	char *p = osmoload.binbuf;
+	while(c) {
+		rc = fwrite(p, 1, c, osmoload.binfile);
+		if(ferror(osmoload.binfile)) {
+			printf("Could not read from file: %s\n", strerror(errno));
+			exit(1);
+		}
+		c -= rc;
+		p += rc;
+	}
+	fclose(osmoload.binfile);
+	osmoload.binfile = NULL;
 
-	uint8_t reqbytes = (rembytes < MEM_MSG_MAX) ? rembytes : MEM_MSG_MAX;
+	free(osmoload.binbuf);
+}
 
-	osmoload.memcrc = osmo_crc16(0, (uint8_t *) osmoload.binbuf + osmoload.memoff, reqbytes);
-	osmoload.memreq = reqbytes;
+/* keep up to osmoload.window requests outstanding */
+static void
+loader_mem_fill() {
+	int i;
 
-	struct msgb *msg = msgb_alloc(MSGB_MAX, "loader");
+	while(osmoload.inflight < osmoload.window
+		  && osmoload.memoff < osmoload.memlen) {
+		struct memreq *r = NULL;
 
-	msgb_put_u8(msg, LOADER_FLASH_PROGRAM);
-	msgb_put_u8(msg, reqbytes);
-	msgb_put_u16(msg, osmoload.memcrc);
-	msgb_put_u8(msg, 0); // XXX: align data to 16bit
-	msgb_put_u8(msg, osmoload.memchip);
-	msgb_put_u32(msg, osmoload.membase + osmoload.memoff);
+		for(i = 0; i < osmoload.window; i++) {
+			if(!osmoload.reqs[i].active) {
+				r = &osmoload.reqs[i];
+				break;
+			}
+		}
 
-	unsigned char *p = msgb_put(msg, reqbytes);
-	memcpy(p, osmoload.binbuf + osmoload.memoff, reqbytes);
+		uint32_t rembytes = osmoload.memlen - osmoload.memoff;
+		uint8_t reqbytes = (rembytes < MEM_MSG_MAX) ? rembytes : MEM_MSG_MAX;
 
-#if 0
-	printf("Sending %u bytes at offset %u to address %x with crc %x\n",
-		   reqbytes, osmoload.memoff, osmoload.membase + osmoload.memoff,
-		   osmoload.memcrc);
-#endif
+		r->active = 1;
+		r->off = osmoload.memoff;
+		r->len = reqbytes;
+		r->retries = 0;
+		if(osmoload.state != STATE_DUMP_IN_PROGRESS) {
+			r->crc = osmo_crc16(0, (uint8_t *) osmoload.binbuf + r->off, reqbytes);
+		}
+		r->timer.cb = &memop_timeout;
+		r->timer.data = r;
 
-	loader_send_request(msg);
+		osmoload.memoff += reqbytes;
+		osmoload.inflight++;
 
-	msgb_free(msg);
+		loader_mem_send(r);
+	}
+
+	if(!osmoload.inflight) {
+		loader_mem_done();
+	}
+}
+
+/* replies are matched to requests by address, a reply to a request
+ * that was answered already (after a timeout) is ignored */
+static void
+loader_mem_reply(uint32_t address, uint8_t length, uint16_t crc, void *data) {
+	struct memreq *r = NULL;
+	uint16_t mycrc;
+	int i;
+
+	for(i = 0; i < osmoload.window; i++) {
+		if(osmoload.reqs[i].active
+		   && osmoload.membase + osmoload.reqs[i].off == address
+		   && osmoload.reqs[i].len == length) {
+			r = &osmoload.reqs[i];
+			break;
+		}
+	}
+	if(!r) {
+		return;
+	}
+
+	mycrc = data ? osmo_crc16(0, data, length) : r->crc;
+	if(mycrc != crc) {
+		printf("\nbad crc %4.4x (not %4.4x) at offset 0x%8.8x", crc, mycrc, r->off);
+		loader_mem_retry(r);
+		return;
+	}
+
+	putchar('.');
+	if(data) {
+		memcpy(osmoload.binbuf + r->off, data, length);
+	}
+
+	osmo_timer_del(&r->timer);
+	r->active = 0;
+	osmoload.inflight--;
 
-	osmoload.memoff += reqbytes;
+	loader_mem_fill();
+}
+
+static void
+loader_mem_start() {
+	memset(osmoload.reqs, 0, sizeof(osmoload.reqs));
+	osmoload.inflight = 0;
+	gettimeofday(&osmoload.memstart, NULL);
+
+	loader_mem_fill();
 }
 
 static void
@@ -754,7 +846,7 @@ loader_start_memdump(uint32_t length, uint32_t address, char *file) {
 	osmoload.memoff = 0;
 
 	osmoload.state = STATE_DUMP_IN_PROGRESS;
-	loader_do_memdump(0, NULL, 0);
+	loader_mem_start();
 }
 
 static void
@@ -803,7 +895,7 @@ loader_start_memload(uint32_t address, char *file) {
 	osmoload.memoff = 0;
 
 	osmoload.state = STATE_LOAD_IN_PROGRESS;
-	loader_do_memload();
+	loader_mem_start();
 }
 
 static void
@@ -948,7 +1040,7 @@ loader_start_fprogram(uint8_t chip, uint32_t address, char *file) {
 
 	osmoload.state = STATE_PROGRAM_IN_PROGRESS;
 
-	loader_do_fprogram();
+	loader_mem_start();
 }
 
 static void
@@ -1145,9 +1237,6 @@ loader_command(char *name, int cmdc, char **cmdv) {
 		osmoload.timeout.cb = &query_timeout;
 		osmo_timer_schedule(&osmoload.timeout, 0, 5000000);
 	}
-	if(osmoload.state == STATE_LOAD_IN_PROGRESS) {
-		osmoload.timeout.cb = &memop_timeout;
-	}
 
 }
 
@@ -1172,7 +1261,9 @@ main(int argc, char **argv) {
 	char *loader_un_path = "/tmp/osmocom_loader";
 	const char *debugopt;
 
-	while((opt = getopt(argc, argv, "d:hl:m:v")) != -1) {
+	osmoload.window = MEM_DEFAULT_WINDOW;
+
+	while((opt = getopt(argc, argv, "d:hl:m:vw:")) != -1) {
 		switch(opt) {
 		case 'd':
 			debugopt = optarg;
@@ -1191,6 +1282,13 @@ main(int argc, char **argv) {
 		case 'v':
 			version(argv[0]);
 			break;
+		case 'w':
+			osmoload.window = atoi(optarg);
+			if(osmoload.window < 1 || osmoload.window > MEM_MAX_WINDOW) {
+				printf("Window must be 1 to %d\n", MEM_MAX_WINDOW);
+				exit(2);
+			}
+			break;
 		case 'h':
 		default:
 			usage(argv[0]);
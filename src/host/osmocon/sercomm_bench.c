@@ -0,0 +1,195 @@
+/* HDLC transmit throughput over a pty pair, byte by byte vs. bulk */
+
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/time.h>
+
+#include <sercomm.h>
+
+#include <osmocom/core/msgb.h>
+
+#define FRAME_LEN	64	/* a typical L1CTL message */
+
+static unsigned int rx_frames, rx_bad;
+
+static void rx_cb(uint8_t dlci, struct msgb *msg)
+{
+	/* every 16th frame has octets that need escaping */
+	uint8_t c = rx_frames & 15 ? 0x42 : HDLC_FLAG;
+
+	if (dlci != SC_DLCI_L1A_L23 || msg->len != FRAME_LEN ||
+	    msg->data[0] != c || msg->data[FRAME_LEN - 1] != c)
+		rx_bad++;
+	rx_frames++;
+	msgb_free(msg);
+}
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int open_pty(int *master, int *slave)
+{
+	struct termios tio;
+
+	*master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (*master < 0 || grantpt(*master) < 0 || unlockpt(*master) < 0)
+		return -1;
+	*slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+	if (*slave < 0)
+		return -1;
+
+	/* a raw line, like osmo_serial_init() sets up */
+	tcgetattr(*slave, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(*slave, TCSANOW, &tio);
+	tcgetattr(*master, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(*master, TCSANOW, &tio);
+
+	fcntl(*master, F_SETFL, O_NONBLOCK);
+	fcntl(*slave, F_SETFL, O_NONBLOCK);
+
+	return 0;
+}
+
+static void enqueue(int n)
+{
+	struct msgb *msg;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		msg = sercomm_alloc_msgb(FRAME_LEN);
+		memset(msgb_put(msg, FRAME_LEN), i & 15 ? 0x42 : HDLC_FLAG,
+			FRAME_LEN);
+		sercomm_sendmsg(SC_DLCI_L1A_L23, msg);
+	}
+}
+
+/* what osmocon did: one write() per octet */
+static int write_bytewise(int fd)
+{
+	uint8_t c;
+
+	if (!sercomm_drv_pull(&c))
+		return 0;
+	if (write(fd, &c, 1) != 1)
+		return -1;
+
+	return 1;
+}
+
+static uint8_t buf[512];
+static int buf_len, buf_ofs;
+
+/* what osmocon does now */
+static int write_bulk(int fd)
+{
+	int rc;
+
+	if (buf_ofs >= buf_len) {
+		buf_ofs = 0;
+		buf_len = sercomm_drv_pull_bulk(buf, sizeof(buf));
+		if (!buf_len)
+			return 0;
+	}
+	rc = write(fd, buf + buf_ofs, buf_len - buf_ofs);
+	if (rc < 0)
+		return errno == EAGAIN ? 1 : -1;
+	buf_ofs += rc;
+
+	return 1;
+}
+
+static double run(int master, int slave, int n, int (*write_fn)(int),
+		  unsigned int *syscalls)
+{
+	struct pollfd pfd[2];
+	uint8_t rbuf[4096];
+	double t;
+	int rc, more = 1;
+
+	rx_frames = 0;
+	*syscalls = 0;
+	enqueue(n);
+
+	t = now();
+	while (rx_frames < n) {
+		pfd[0].fd = master;
+		pfd[0].events = more ? POLLOUT : 0;
+		pfd[1].fd = slave;
+		pfd[1].events = POLLIN;
+		if (poll(pfd, 2, 1000) <= 0)
+			break;
+
+		if (pfd[0].revents & POLLOUT) {
+			rc = write_fn(master);
+			if (rc < 0)
+				break;
+			more = rc;
+			(*syscalls)++;
+		}
+		if (pfd[1].revents & POLLIN) {
+			rc = read(slave, rbuf, sizeof(rbuf));
+			if (rc > 0)
+				sercomm_drv_rx_buf(rbuf, rc);
+		}
+	}
+	t = now() - t;
+
+	return rx_frames / t;
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : 2000;
+	int master, slave;
+	unsigned int syscalls;
+	double rate;
+
+	if (open_pty(&master, &slave) < 0) {
+		perror("pty");
+		return 1;
+	}
+
+	sercomm_init();
+	sercomm_register_rx_cb(SC_DLCI_L1A_L23, rx_cb);
+
+	rate = run(master, slave, n, write_bytewise, &syscalls);
+	printf("byte by byte: %10.0f frames/s, %u frames, %u writes\n", rate,
+		rx_frames, syscalls);
+	rate = run(master, slave, n * 10, write_bulk, &syscalls);
+	printf("bulk        : %10.0f frames/s, %u frames, %u writes\n", rate,
+		rx_frames, syscalls);
+	printf("bad frames: %u\n", rx_bad);
+
+	return 0;
+}
@@ -0,0 +1,181 @@
+/* sercomm_drv_rx_buf() must behave exactly like sercomm_drv_rx_char() */
+
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+
+#include <sercomm.h>
+
+#include <osmocom/core/msgb.h>
+
+#define STREAM_LEN	(1024 * 1024)
+
+static uint8_t stream[STREAM_LEN];
+
+/* what was received, as dlci, length, data */
+static uint8_t log_buf[2 * STREAM_LEN];
+static unsigned int log_len, frames;
+
+static void rx_cb(uint8_t dlci, struct msgb *msg)
+{
+	if (log_len + 3 + msg->len <= sizeof(log_buf)) {
+		log_buf[log_len++] = dlci;
+		log_buf[log_len++] = msg->len >> 8;
+		log_buf[log_len++] = msg->len;
+		memcpy(log_buf + log_len, msg->data, msg->len);
+		log_len += msg->len;
+	}
+	frames++;
+	msgb_free(msg);
+}
+
+static void put(unsigned int *n, uint8_t c)
+{
+	if (*n < STREAM_LEN)
+		stream[(*n)++] = c;
+}
+
+/* frames with escaped octets, some too long for the receive buffer,
+ * and some garbage in between */
+static void make_stream(void)
+{
+	unsigned int n = 0, len, i;
+	uint8_t c;
+
+	srand(1);
+	while (n < STREAM_LEN) {
+		switch (rand() % 8) {
+		case 0:
+			/* garbage, flags and escapes included */
+			for (len = rand() % 32; len; len--)
+				put(&n, rand() % 4 ? rand() : HDLC_ESCAPE);
+			break;
+		case 1:
+			/* longer than SERCOMM_RX_MSG_SIZE */
+			len = 2000 + rand() % 100;
+			goto frame;
+		default:
+			len = rand() % 300;
+		frame:
+			put(&n, HDLC_FLAG);
+			put(&n, rand() % 16);
+			put(&n, HDLC_C_UI);
+			for (i = 0; i < len; i++) {
+				c = rand() % 8 ? 0x42 + i : rand();
+				if (c == HDLC_FLAG || c == HDLC_ESCAPE || !c) {
+					put(&n, HDLC_ESCAPE);
+					c ^= 1 << 5;
+				}
+				put(&n, c);
+			}
+			put(&n, HDLC_FLAG);
+			break;
+		}
+	}
+}
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void init(void)
+{
+	int i;
+
+	sercomm_init();
+	for (i = 0; i < 16; i++)
+		sercomm_register_rx_cb(i, rx_cb);
+}
+
+/* octet by octet in a child process, as sercomm state is global */
+static int run_chars(unsigned int *dropped)
+{
+	int fds[2], i;
+	double t;
+
+	pipe(fds);
+	if (!fork()) {
+		init();
+		*dropped = 0;
+		t = now();
+		for (i = 0; i < STREAM_LEN; i++) {
+			if (!sercomm_drv_rx_char(stream[i]))
+				(*dropped)++;
+		}
+		t = now() - t;
+		fprintf(stderr, "octet by octet: %6.1f MB/s\n",
+			STREAM_LEN / t / 1e6);
+		write(fds[1], dropped, sizeof(*dropped));
+		write(fds[1], &frames, sizeof(frames));
+		write(fds[1], &log_len, sizeof(log_len));
+		write(fds[1], log_buf, log_len);
+		exit(0);
+	}
+
+	close(fds[1]);
+	return fds[0];
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t ref_log[sizeof(log_buf)];
+	unsigned int ref_dropped, ref_frames, ref_len, dropped = 0, chunk;
+	unsigned int i, got;
+	int fd, rc;
+	double t;
+
+	make_stream();
+
+	fd = run_chars(&ref_dropped);
+	read(fd, &ref_dropped, sizeof(ref_dropped));
+	read(fd, &ref_frames, sizeof(ref_frames));
+	read(fd, &ref_len, sizeof(ref_len));
+	for (got = 0; got < ref_len; got += rc) {
+		rc = read(fd, ref_log + got, ref_len - got);
+		if (rc <= 0)
+			break;
+	}
+	wait(NULL);
+
+	/* blocks of all sizes, splitting frames and escapes anywhere */
+	init();
+	t = now();
+	for (i = 0, chunk = 1; i < STREAM_LEN; i += chunk, chunk = chunk % 4099 + 1) {
+		if (chunk > STREAM_LEN - i)
+			chunk = STREAM_LEN - i;
+		dropped += sercomm_drv_rx_buf(stream + i, chunk);
+	}
+	t = now() - t;
+	fprintf(stderr, "blocks:         %6.1f MB/s\n", STREAM_LEN / t / 1e6);
+
+	printf("frames %u/%u, dropped %u/%u, log %s\n", frames, ref_frames,
+		dropped, ref_dropped,
+		log_len == ref_len && !memcmp(log_buf, ref_log, log_len) ?
+		"same" : "DIFFERENT");
+
+	return frames == ref_frames && dropped == ref_dropped &&
+	       log_len == ref_len && !memcmp(log_buf, ref_log, log_len) ? 0 : 1;
+}
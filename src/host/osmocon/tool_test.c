@@ -0,0 +1,292 @@
+/* osmocon with a fast and a slow layer2 client, the slow one must neither
+ * stall the fast one nor receive broken frames.  The frames are captured
+ * and replayed to another client afterwards. */
+
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <sercomm.h>
+
+#define NUM_FRAMES	4000
+#define FRAME_LEN	200
+
+static const uint8_t phone_ack[] = { 0x1b, 0xf6, 0x02, 0x00, 0x41, 0x03, 0x42 };
+
+static int open_pty(int *master, char *name, size_t len)
+{
+	struct termios tio;
+
+	*master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (*master < 0 || grantpt(*master) < 0 || unlockpt(*master) < 0)
+		return -1;
+	tcgetattr(*master, &tio);
+	cfmakeraw(&tio);
+	tcsetattr(*master, TCSANOW, &tio);
+	snprintf(name, len, "%s", ptsname(*master));
+
+	return 0;
+}
+
+static int connect_l2(const char *path)
+{
+	struct sockaddr_un sun;
+	int fd, i;
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	snprintf(sun.sun_path, sizeof(sun.sun_path), "%s", path);
+
+	for (i = 0; i < 50; i++) {
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (!connect(fd, (struct sockaddr *) &sun, sizeof(sun)))
+			return fd;
+		close(fd);
+		usleep(100000);
+	}
+
+	return -1;
+}
+
+/* HDLC frame on the L1A_L23 DLCI, the payload carries the number */
+static int make_frame(uint8_t *out, unsigned int nr)
+{
+	uint8_t c;
+	int n = 0, i;
+
+	out[n++] = HDLC_FLAG;
+	out[n++] = SC_DLCI_L1A_L23;
+	out[n++] = HDLC_C_UI;
+	for (i = 0; i < FRAME_LEN; i++) {
+		c = i < 2 ? nr >> (8 - i * 8) : nr + i;
+		if (c == HDLC_FLAG || c == HDLC_ESCAPE || !c) {
+			out[n++] = HDLC_ESCAPE;
+			c ^= 1 << 5;
+		}
+		out[n++] = c;
+	}
+	out[n++] = HDLC_FLAG;
+
+	return n;
+}
+
+/* parse length prefixed frames, returns -1 on a broken one */
+struct client {
+	int fd;
+	uint8_t buf[65536];
+	int len;
+	unsigned int frames;
+	int broken, eof;
+};
+
+static void client_read(struct client *cl)
+{
+	int rc, i, flen;
+	unsigned int nr;
+
+	rc = read(cl->fd, cl->buf + cl->len, sizeof(cl->buf) - cl->len);
+	if (rc == 0)
+		cl->eof = 1;
+	if (rc <= 0)
+		return;
+	cl->len += rc;
+
+	while (cl->len >= 2) {
+		flen = cl->buf[0] << 8 | cl->buf[1];
+		if (cl->len < 2 + flen)
+			break;
+		nr = cl->buf[2] << 8 | cl->buf[3];
+		if (flen != FRAME_LEN || nr != cl->frames)
+			cl->broken = 1;
+		for (i = 2; i < flen; i++) {
+			if (cl->buf[2 + i] != (uint8_t) (nr + i))
+				cl->broken = 1;
+		}
+		cl->frames++;
+		memmove(cl->buf, cl->buf + 2 + flen, cl->len - 2 - flen);
+		cl->len -= 2 + flen;
+	}
+}
+
+/* replay the capture as fast as possible, osmocon exits when done */
+static int replay(const char *cap, const char *l2, const char *loader,
+		  struct client *cl)
+{
+	struct pollfd pfd;
+	int status;
+	pid_t pid;
+
+	pid = fork();
+	if (!pid) {
+		int fd = open("/dev/null", O_WRONLY);
+		dup2(fd, 1);
+		execl("./osmocon", "osmocon", "-r", cap, "-f", "-s", l2,
+		      "-l", loader, NULL);
+		exit(1);
+	}
+
+	cl->fd = connect_l2(l2);
+	if (cl->fd < 0) {
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL, 0);
+		return -1;
+	}
+
+	while (!cl->eof && !cl->broken) {
+		pfd.fd = cl->fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 2000) <= 0)
+			break;
+		client_read(cl);
+	}
+	close(cl->fd);
+
+	if (!cl->eof)
+		kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char **argv)
+{
+	static char out[65536];
+	static uint8_t tx[2 * FRAME_LEN + 8];
+	static struct client fast, slow, replayed;
+	char tty[64], con[64], l2[64], loader[64], cap[64];
+	int master, con_master, out_len = 0, tx_len = 0, tx_ofs = 0;
+	unsigned int nr = 0;
+	int rcvbuf = 1024, rc, half;
+	struct pollfd pfd[3];
+	pid_t pid;
+
+	if (open_pty(&master, tty, sizeof(tty)) < 0 ||
+	    open_pty(&con_master, con, sizeof(con)) < 0) {
+		perror("pty");
+		return 1;
+	}
+	snprintf(l2, sizeof(l2), "/tmp/osmocon_test_l2.%d", getpid());
+	snprintf(loader, sizeof(loader), "/tmp/osmocon_test_ld.%d", getpid());
+	snprintf(cap, sizeof(cap), "/tmp/osmocon_test_cap.%d", getpid());
+
+	/* osmocon's output goes to a pty so it isn't block buffered */
+	pid = fork();
+	if (!pid) {
+		int fd = open(con, O_RDWR);
+		dup2(fd, 1);
+		execl("./osmocon", "osmocon", "-p", tty, "-s", l2, "-l", loader,
+		      "-w", cap, NULL);
+		exit(1);
+	}
+
+	fast.fd = connect_l2(l2);
+	slow.fd = connect_l2(l2);
+	half = connect_l2(l2);
+	if (fast.fd < 0 || slow.fd < 0 || half < 0) {
+		fprintf(stderr, "Can't connect to osmocon\n");
+		kill(pid, SIGTERM);
+		return 1;
+	}
+	setsockopt(slow.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	/* a tool sending the start of a frame only must not stall the
+	 * others */
+	write(half, "\x00\x08\x01\x02", 4);
+
+	/* the phone's code is running, from now on it talks HDLC */
+	write(master, phone_ack, sizeof(phone_ack));
+	usleep(100000);
+	fcntl(master, F_SETFL, O_NONBLOCK);
+
+	while (fast.frames < NUM_FRAMES && !fast.broken) {
+		pfd[0].fd = master;
+		pfd[0].events = nr < NUM_FRAMES ? POLLOUT : 0;
+		pfd[1].fd = fast.fd;
+		pfd[1].events = POLLIN;
+		pfd[2].fd = con_master;
+		pfd[2].events = POLLIN;
+		if (poll(pfd, 3, 2000) <= 0)
+			break;
+
+		if (pfd[0].revents & POLLOUT) {
+			if (tx_ofs == tx_len) {
+				tx_len = make_frame(tx, nr++);
+				tx_ofs = 0;
+			}
+			rc = write(master, tx + tx_ofs, tx_len - tx_ofs);
+			if (rc > 0)
+				tx_ofs += rc;
+		}
+		if (pfd[1].revents & POLLIN)
+			client_read(&fast);
+		if (pfd[2].revents & POLLIN) {
+			rc = read(con_master, out + out_len,
+				  sizeof(out) - 1 - out_len);
+			if (rc > 0)
+				out_len += rc;
+		}
+	}
+
+	/* what the slow client got before osmocon gave up on it */
+	fcntl(slow.fd, F_SETFL, O_NONBLOCK);
+	while (!slow.eof && !slow.broken) {
+		pfd[0].fd = slow.fd;
+		pfd[0].events = POLLIN;
+		if (poll(pfd, 1, 2000) <= 0)
+			break;
+		client_read(&slow);
+	}
+	usleep(100000);
+	fcntl(con_master, F_SETFL, O_NONBLOCK);
+	rc = read(con_master, out + out_len, sizeof(out) - 1 - out_len);
+	if (rc > 0)
+		out_len += rc;
+	out[out_len] = '\0';
+
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+
+	rc = replay(cap, l2, loader, &replayed);
+	unlink(l2);
+	unlink(loader);
+	unlink(cap);
+
+	printf("fast client: %u/%u frames%s\n", fast.frames, NUM_FRAMES,
+		fast.broken ? ", BROKEN" : "");
+	printf("slow client: %u frames%s%s\n", slow.frames,
+		slow.broken ? ", BROKEN" : "", slow.eof ? ", closed" : "");
+	printf("replay: %u/%u frames%s, exit %d\n", replayed.frames,
+		NUM_FRAMES, replayed.broken ? ", BROKEN" : "", rc);
+	printf("osmocon said:\n%s", out);
+
+	return fast.frames == NUM_FRAMES && !fast.broken && !slow.broken &&
+	       slow.eof && strstr(out, "dropping") &&
+	       replayed.frames == NUM_FRAMES && !replayed.broken && !rc ? 0 : 1;
+}
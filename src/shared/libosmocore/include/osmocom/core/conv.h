@@ -101,6 +101,35 @@ int  osmo_conv_encode_flush(struct osmo_conv_encoder *encoder, ubit_t *output);
 int  osmo_conv_encode(const struct osmo_conv_code *code,
                       const ubit_t *input, ubit_t *output);
 
+	/* Table driven */
+
+/*! \brief number of input bits consumed per lookup of the encoder tables */
+#define CONV_LUT_BITS	4
+
+/*! \brief precomputed tables to encode a given code
+ *
+ *  Built once per code by \ref osmo_conv_encode_lut_alloc, the tables give
+ *  the next state and output bits for \ref CONV_LUT_BITS input bits at a
+ *  time and turn the puncturing list into the list of kept raw positions.
+ */
+struct osmo_conv_encode_lut {
+	const struct osmo_conv_code *code; /*!< \brief for which code? */
+	int out_len;		/*!< \brief output length (after puncturing) */
+	int raw_len;		/*!< \brief output length before puncturing */
+	uint8_t *next_state;	/*!< \brief [n_states][1 << CONV_LUT_BITS] */
+	ubit_t *next_output;	/*!< \brief [n_states][1 << CONV_LUT_BITS]
+				 *   [CONV_LUT_BITS * N] */
+	uint16_t *keep;		/*!< \brief raw index of each output bit, NULL
+				 *   if not punctured */
+	ubit_t *raw;		/*!< \brief raw output (tmp in encode) */
+};
+
+struct osmo_conv_encode_lut *
+osmo_conv_encode_lut_alloc(const struct osmo_conv_code *code);
+void osmo_conv_encode_lut_free(struct osmo_conv_encode_lut *lut);
+int  osmo_conv_encode_lut(struct osmo_conv_encode_lut *lut,
+                          const ubit_t *input, ubit_t *output);
+
 
 /* Decoding */
 
@@ -120,8 +149,24 @@ struct osmo_conv_decoder {
 	unsigned int *ae;	/*!< \brief accumulated error */
 	unsigned int *ae_next;	/*!< \brief next accumulated error (tmp in scan) */
 	uint8_t *state_history;	/*!< \brief state history [len][n_states] */
+
+	int32_t *acc_mask;	/*!< \brief output bit masks [2][N][n_states] for
+				 *   the SIMD backends, NULL if not applicable */
+	sbit_t *in_sym;		/*!< \brief input symbols of a step (tmp in scan) */
+};
+
+/*! \brief implementations of the add-compare-select step of the decoder */
+enum osmo_conv_backend {
+	CONV_BACKEND_AUTO = 0,	/*!< \brief Best available on this host */
+	CONV_BACKEND_SCALAR,	/*!< \brief Portable C code */
+	CONV_BACKEND_SSE2,	/*!< \brief x86 SSE2 */
+	CONV_BACKEND_AVX2,	/*!< \brief x86 AVX2 */
 };
 
+int osmo_conv_decode_set_backend(enum osmo_conv_backend backend);
+enum osmo_conv_backend osmo_conv_decode_get_backend(void);
+const char *osmo_conv_backend_name(enum osmo_conv_backend backend);
+
 void osmo_conv_decode_init(struct osmo_conv_decoder *decoder,
                            const struct osmo_conv_code *code,
                            int len, int start_state);
@@ -140,6 +185,13 @@ int osmo_conv_decode_get_output(struct osmo_conv_decoder *decoder,
 int osmo_conv_decode(const struct osmo_conv_code *code,
                      const sbit_t *input, ubit_t *output);
 
+	/* All-in-one, reusing an initialized decoder */
+int osmo_conv_decode_ctx(struct osmo_conv_decoder *decoder,
+                         const sbit_t *input, ubit_t *output);
+int osmo_conv_decode_batch(struct osmo_conv_decoder *decoder,
+                           const sbit_t *input, ubit_t *output,
+                           int n, int *rv);
+
 
 /*! }@ */
 
@@ -52,6 +52,22 @@ void osmo_crcXXgen_set_bits(const struct osmo_crcXXgen_code *code,
                             const ubit_t *in, int len, ubit_t *crc_bits);
 
 
+/*! \brief lookup tables to compute a CRC of max XX bits 8 bytes at a time */
+struct osmo_crcXXgen_table {
+	const struct osmo_crcXXgen_code *code; /*!< \brief for which code? */
+	uintXX_t poly;       /*!< \brief Polynom shifted up to the MSB */
+	uintXX_t t[8][256];  /*!< \brief Slice-by-8 tables, t[0] is bytewise */
+};
+
+void osmo_crcXXgen_table_init(struct osmo_crcXXgen_table *tab,
+                              const struct osmo_crcXXgen_code *code);
+
+uintXX_t osmo_crcXXgen_table_compute_bits(const struct osmo_crcXXgen_table *tab,
+                                          const ubit_t *in, int len);
+uintXX_t osmo_crcXXgen_table_compute_pbits(const struct osmo_crcXXgen_table *tab,
+                                           const pbit_t *in, int len);
+
+
 /*! }@ */
 
 #endif /* __OSMO_CRCXXGEN_H__ */
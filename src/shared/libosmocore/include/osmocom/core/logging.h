@@ -20,8 +20,16 @@
 #define DEBUG
 
 #ifdef DEBUG
-#define DEBUGP(ss, fmt, args...) logp(ss, __FILE__, __LINE__, 0, fmt, ## args)
-#define DEBUGPC(ss, fmt, args...) logp(ss, __FILE__, __LINE__, 1, fmt, ## args)
+#define DEBUGP(ss, fmt, args...) \
+	do { \
+		if (log_check_level(ss, LOGL_DEBUG)) \
+			logp(ss, __FILE__, __LINE__, 0, fmt, ## args); \
+	} while (0)
+#define DEBUGPC(ss, fmt, args...) \
+	do { \
+		if (log_check_level(ss, LOGL_DEBUG)) \
+			logp(ss, __FILE__, __LINE__, 1, fmt, ## args); \
+	} while (0)
 #else
 #define DEBUGP(xss, fmt, args...)
 #define DEBUGPC(ss, fmt, args...)
@@ -38,9 +46,15 @@ void logp(int subsys, char *file, int line, int cont, const char *format, ...) _
  *  \param[in] level logging level (e.g. \ref LOGL_NOTICE)
  *  \param[in] fmt format string
  *  \param[in] args variable argument list
+ *
+ * The arguments are only evaluated if at least one log target may
+ * output the message, see \ref log_check_level.
  */
 #define LOGP(ss, level, fmt, args...) \
-	logp2(ss, level, __FILE__, __LINE__, 0, fmt, ##args)
+	do { \
+		if (log_check_level(ss, level)) \
+			logp2(ss, level, __FILE__, __LINE__, 0, fmt, ##args); \
+	} while (0)
 
 /*! \brief Continue a log message through the Osmocom logging framework
  *  \param[in] ss logging subsystem (e.g. \ref DLGLOBAL)
@@ -49,7 +63,10 @@ void logp(int subsys, char *file, int line, int cont, const char *format, ...) _
  *  \param[in] args variable argument list
  */
 #define LOGPC(ss, level, fmt, args...) \
-	logp2(ss, level, __FILE__, __LINE__, 1, fmt, ##args)
+	do { \
+		if (log_check_level(ss, level)) \
+			logp2(ss, level, __FILE__, __LINE__, 1, fmt, ##args); \
+	} while (0)
 
 /*! \brief different log levels */
 #define LOGL_DEBUG	1	/*!< \brief debugging information */
@@ -108,14 +125,63 @@ struct log_info {
 	unsigned int num_cat_user;
 };
 
+extern struct log_info *osmo_log_info;
+extern uint8_t *osmo_log_level_summary;
+
+/*! \brief Check whether any log target may output a message
+ *  \param[in] subsys logging subsystem
+ *  \param[in] level logging level of the message
+ *  \returns 0 if the message would be discarded by all targets
+ *
+ * This only looks at the per-category summary maintained by the
+ * logging core, so it is cheap enough to be done before the arguments
+ * of a log message are evaluated.  Filters are applied later, so a
+ * non-zero result doesn't mean the message is actually written.
+ */
+static inline int log_check_level(int subsys, unsigned int level)
+{
+	if (!osmo_log_level_summary)
+		return 1;
+
+	/* library-internal categories are after the user ones */
+	if (subsys < 0)
+		subsys = -subsys + osmo_log_info->num_cat_user - 1;
+
+	if (subsys >= osmo_log_info->num_cat)
+		return 1;
+
+	return level >= osmo_log_level_summary[subsys];
+}
+
 /*! \brief Type of logging target */
 enum log_target_type {
 	LOG_TGT_TYPE_VTY,	/*!< \brief VTY logging */
 	LOG_TGT_TYPE_SYSLOG,	/*!< \brief syslog based logging */
 	LOG_TGT_TYPE_FILE,	/*!< \brief text file logging */
 	LOG_TGT_TYPE_STDERR,	/*!< \brief stderr logging */
+	LOG_TGT_TYPE_ASYNC,	/*!< \brief ring buffered file/stderr logging */
+	LOG_TGT_TYPE_BINARY,	/*!< \brief binary file logging */
 };
 
+/*! \brief What an asynchronous log target does if its ring is full */
+enum log_async_overflow {
+	LOG_ASYNC_DROP,		/*!< \brief drop the line and count it */
+	LOG_ASYNC_BLOCK,	/*!< \brief wait for the writer thread */
+};
+
+/*! \brief Counters of an asynchronous log target */
+struct log_async_stats {
+	unsigned long records;		/*!< \brief lines queued */
+	unsigned long dropped;		/*!< \brief lines dropped */
+	unsigned long dropped_bytes;	/*!< \brief bytes dropped */
+	unsigned long blocked;		/*!< \brief waits for the writer */
+	unsigned long max_fill;		/*!< \brief highest ring fill level */
+	unsigned long fill;		/*!< \brief current ring fill level */
+};
+
+struct log_async;
+struct log_binary;
+
 /*! \brief structure representing a logging target */
 struct log_target {
         struct llist_head entry;		/*!< \brief linked list */
@@ -152,6 +218,17 @@ struct log_target {
 		struct {
 			void *vty;
 		} tgt_vty;
+
+		struct {
+			const char *fname;
+			struct log_async *ring;
+		} tgt_async;
+
+		struct {
+			FILE *out;
+			const char *fname;
+			struct log_binary *state;
+		} tgt_binary;
 	};
 
 	/*! \brief call-back function to be called when the logging framework
@@ -162,6 +239,21 @@ struct log_target {
 	 */
         void (*output) (struct log_target *target, unsigned int level,
 			const char *string);
+
+	/*! \brief call-back function used instead of \a output for targets
+	 *	   that want the message before it is formatted
+	 *  \param[in] target logging target
+	 *  \param[in] subsys category index of the message
+	 *  \param[in] level log level of the message
+	 *  \param[in] file source file name
+	 *  \param[in] line source line number
+	 *  \param[in] cont is this a continuation (LOGPC)
+	 *  \param[in] format printf format string
+	 *  \param[in] ap arguments of the format string
+	 */
+	void (*raw_output) (struct log_target *target, unsigned int subsys,
+			    unsigned int level, const char *file, int line,
+			    int cont, const char *format, va_list ap);
 };
 
 /* use the above macros */
@@ -195,9 +287,25 @@ struct log_target *log_target_create_file(const char *fname);
 struct log_target *log_target_create_syslog(const char *ident, int option,
 					    int facility);
 int log_target_file_reopen(struct log_target *tgt);
+struct log_target *log_target_create_async(const char *fname,
+					   unsigned int size);
+int log_target_async_set_overflow(struct log_target *target,
+				  enum log_async_overflow overflow);
+int log_target_async_set_size(struct log_target *target, unsigned int size);
+int log_target_async_get_config(struct log_target *target,
+				enum log_async_overflow *overflow,
+				unsigned int *size);
+int log_target_async_get_stats(struct log_target *target,
+			       struct log_async_stats *stats);
+void log_target_async_flush(struct log_target *target);
+int log_target_async_reopen(struct log_target *target);
+struct log_target *log_target_create_binary(const char *fname);
+void log_target_binary_set_segment_size(struct log_target *target,
+					unsigned int size);
 
 void log_add_target(struct log_target *target);
 void log_del_target(struct log_target *target);
+void log_update_level_summary(void);
 
 /* Generate command string for VTY use */
 const char *log_vty_command_string(const struct log_info *info);
@@ -0,0 +1,107 @@
+#ifndef _OSMOCORE_LOGGING_BINARY_H
+#define _OSMOCORE_LOGGING_BINARY_H
+
+/*! \addtogroup logging
+ *  @{
+ */
+
+/*! \file logging_binary.h
+ *  \brief File format of the binary log target and a reader for it
+ *
+ * A binary log is a sequence of records, each starting with a
+ * \ref log_bin_hdr.  It is made of segments, every segment starts with
+ * a \ref LOG_BIN_SYNC record and is self-contained: the file names and
+ * format strings used by the messages of a segment are defined (again)
+ * by \ref LOG_BIN_STR records within it.  So a reader can start at any
+ * sync record, which is what seeking by time does.
+ *
+ * All fields are in the byte order of the writer, the sync record
+ * allows the reader to check for it.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define LOG_BIN_MAGIC		"OSMOBLOG"
+#define LOG_BIN_VERSION		1
+#define LOG_BIN_BYTE_ORDER	0x01020304
+
+/*! \brief maximum length of a record, including the header */
+#define LOG_BIN_MAX_REC		4096
+
+/*! \brief Record types */
+enum log_bin_type {
+	LOG_BIN_SYNC	= 1,	/*!< \brief segment start */
+	LOG_BIN_STR	= 2,	/*!< \brief string definition */
+	LOG_BIN_MSG	= 3,	/*!< \brief message with raw arguments */
+	LOG_BIN_TEXT	= 4,	/*!< \brief message formatted by the writer */
+};
+
+#define LOG_BIN_F_CONT	0x01	/*!< \brief continuation (LOGPC) */
+
+/*! \brief Header of every record */
+struct log_bin_hdr {
+	uint16_t len;		/*!< \brief record length incl. header */
+	uint8_t type;		/*!< \brief \ref log_bin_type */
+	uint8_t flags;		/*!< \brief LOG_BIN_F_* */
+} __attribute__ ((packed));
+
+/*! \brief \ref LOG_BIN_SYNC record */
+struct log_bin_sync {
+	struct log_bin_hdr hdr;
+	char magic[8];		/*!< \brief \ref LOG_BIN_MAGIC */
+	uint32_t byte_order;	/*!< \brief \ref LOG_BIN_BYTE_ORDER */
+	uint8_t version;	/*!< \brief \ref LOG_BIN_VERSION */
+	uint8_t reserved[3];
+	uint64_t time_us;	/*!< \brief time of the segment start */
+} __attribute__ ((packed));
+
+/*! \brief \ref LOG_BIN_STR record, followed by the string (no NUL)
+ *
+ * Ids are assigned from 1 upwards in every segment.
+ */
+struct log_bin_str {
+	struct log_bin_hdr hdr;
+	uint16_t id;
+} __attribute__ ((packed));
+
+/*! \brief \ref LOG_BIN_MSG and \ref LOG_BIN_TEXT record
+ *
+ * For \ref LOG_BIN_MSG the arguments follow in the order of the format
+ * string: 4 bytes for int sized values and each '*' width/precision,
+ * 8 bytes for longer integers, pointers and floating point values
+ * (as double), a 16 bit length and the characters for strings.
+ * For \ref LOG_BIN_TEXT fmt_id is 0 and the formatted text follows.
+ */
+struct log_bin_msg {
+	struct log_bin_hdr hdr;
+	uint64_t time_us;	/*!< \brief time in microseconds */
+	uint16_t subsys;	/*!< \brief category index */
+	uint8_t level;		/*!< \brief log level */
+	uint8_t reserved;
+	uint16_t file_id;	/*!< \brief \ref log_bin_str of the file */
+	uint16_t fmt_id;	/*!< \brief \ref log_bin_str of the format */
+	uint32_t line;		/*!< \brief source line */
+} __attribute__ ((packed));
+
+struct log_bin_reader;
+
+/*! \brief One message as returned by \ref log_bin_reader_next */
+struct log_bin_entry {
+	uint64_t time_us;	/*!< \brief time in microseconds */
+	unsigned int subsys;	/*!< \brief category index */
+	unsigned int level;	/*!< \brief log level */
+	int cont;		/*!< \brief continuation of the previous */
+	const char *file;	/*!< \brief source file */
+	unsigned int line;	/*!< \brief source line */
+	const char *text;	/*!< \brief formatted message */
+};
+
+struct log_bin_reader *log_bin_reader_open(void *ctx, FILE *in);
+void log_bin_reader_close(struct log_bin_reader *r);
+int log_bin_reader_next(struct log_bin_reader *r, struct log_bin_entry *e);
+int log_bin_reader_seek(struct log_bin_reader *r, uint64_t time_us);
+
+/*! }@ */
+
+#endif /* _OSMOCORE_LOGGING_BINARY_H */
@@ -61,6 +61,9 @@ struct msgb {
 	uint16_t data_len;   /*!< \brief length of underlying data array */
 	uint16_t len;	     /*!< \brief length of bytes used in msgb */
 
+	struct msgb *_shared;	/*!< \brief msgb owning the data of a clone */
+	unsigned int _refcnt;	/*!< \brief number of users of the data */
+
 	unsigned char *head;	/*!< \brief start of underlying memory buffer */
 	unsigned char *tail;	/*!< \brief end of message in buffer */
 	unsigned char *data;	/*!< \brief start of message in buffer */
@@ -72,6 +75,18 @@ extern void msgb_free(struct msgb *m);
 extern void msgb_enqueue(struct llist_head *queue, struct msgb *msg);
 extern struct msgb *msgb_dequeue(struct llist_head *queue);
 extern void msgb_reset(struct msgb *m);
+extern struct msgb *msgb_clone_shared(struct msgb *msg, const char *name);
+
+/*! \brief Check whether the data of a msgb is shared with clones
+ *  \param[in] msg message buffer
+ *  \returns 1 if the data is referenced by more than one msgb, 0 if not
+ */
+static inline int msgb_is_shared(const struct msgb *msg)
+{
+	if (msg->_shared)
+		return 1;
+	return msg->_refcnt > 1;
+}
 
 #ifdef MSGB_DEBUG
 #include <osmocom/core/panic.h>
@@ -365,6 +380,21 @@ uint8_t *msgb_data(const struct msgb *msg);
 uint16_t msgb_length(const struct msgb *msg);
 void msgb_set_talloc_ctx(void *ctx);
 
+/*! \brief Number of size classes of the msgb pool (not in embedded
+ * builds) */
+#define MSGB_POOL_CLASSES	7
+
+/*! \brief Statistics of one size class of the msgb pool */
+struct msgb_pool_stats {
+	uint16_t size;		/*!< \brief data size of the class */
+	unsigned int hits;	/*!< \brief allocations served by the pool */
+	unsigned int misses;	/*!< \brief allocations that went to talloc */
+	unsigned int free;	/*!< \brief msgbs currently in the freelist */
+};
+
+void msgb_pool_init(unsigned int max_free);
+void msgb_pool_get_stats(struct msgb_pool_stats *stats);
+
 /*! }@ */
 
 #endif /* _MSGB_H */
@@ -57,6 +57,8 @@ struct rate_ctr_group_desc {
 struct rate_ctr_group {
 	/*! \brief Linked list of all counter groups in the system */
 	struct llist_head list;
+	/*! \brief Hash bucket list, for the lookup by name and index */
+	struct llist_head hash_list;
 	/*! \brief Pointer to the counter group class */
 	const struct rate_ctr_group_desc *desc;
 	/*! \brief The index of this ctr_group within its class */
@@ -83,6 +85,8 @@ int rate_ctr_init(void *tall_ctx);
 
 struct rate_ctr_group *rate_ctr_get_group_by_name_idx(const char *name, const unsigned int idx);
 const struct rate_ctr *rate_ctr_get_by_name(const struct rate_ctr_group *ctrg, const char *name);
+int rate_ctr_for_each_group(int (*handle_group)(struct rate_ctr_group *,
+						 void *), void *data);
 
 /*! }@ */
 #endif /* RATE_CTR_H */
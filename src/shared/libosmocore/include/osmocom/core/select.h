@@ -36,6 +36,15 @@ struct osmo_fd {
 	unsigned int priv_nr;
 };
 
+/*! \brief Implementations of osmo_select_main() */
+enum osmo_select_backend {
+	OSMO_SELECT_SELECT = 0,	/*!< \brief select() (default) */
+	OSMO_SELECT_EPOLL,	/*!< \brief epoll, Linux only */
+};
+
+int osmo_select_set_backend(enum osmo_select_backend backend);
+enum osmo_select_backend osmo_select_get_backend(void);
+
 int osmo_fd_register(struct osmo_fd *fd);
 void osmo_fd_unregister(struct osmo_fd *fd);
 int osmo_select_main(int polling);
@@ -0,0 +1,31 @@
+#ifndef _OSMOCORE_STATS_EXPORT_H
+#define _OSMOCORE_STATS_EXPORT_H
+
+/*! \addtogroup rate_ctr
+ *  @{
+ */
+
+/*! \file stats_export.h
+ *  \brief Periodic export of all counters to a statsd-like sink
+ */
+
+#include <stddef.h>
+
+/*! \brief maximum size of one datagram sent to the sink */
+#define OSMO_STATS_MAX_DGRAM	1024
+
+struct osmo_stats_export;
+
+struct osmo_stats_export *osmo_stats_export_create(void *ctx,
+						   const char *dest,
+						   const char *prefix,
+						   unsigned int interval);
+void osmo_stats_export_destroy(struct osmo_stats_export *exp);
+int osmo_stats_export_send(struct osmo_stats_export *exp);
+unsigned long osmo_stats_export_errors(const struct osmo_stats_export *exp);
+
+int osmo_stats_snapshot(char *buf, size_t len, const char *prefix);
+
+/*! }@ */
+
+#endif /* _OSMOCORE_STATS_EXPORT_H */
@@ -30,6 +30,7 @@
 #define TIMER_H
 
 #include <sys/time.h>
+#include <time.h>
 
 #include <osmocom/core/linuxlist.h>
 #include <osmocom/core/linuxrbtree.h>
@@ -61,10 +62,19 @@ struct osmo_timer_list {
 	void *data;		  /*!< \brief user data for callback */
 };
 
+/*! \brief Timer implementations, see osmo_timers_set_backend() */
+enum osmo_timer_backend {
+	OSMO_TIMER_RBTREE = 0,	/*!< \brief rb-tree, gettimeofday() (default) */
+	OSMO_TIMER_WHEEL,	/*!< \brief timing wheel, monotonic clock */
+};
+
 /**
  * timer management
  */
 
+int osmo_timers_set_backend(enum osmo_timer_backend backend);
+enum osmo_timer_backend osmo_timers_get_backend(void);
+
 void osmo_timer_add(struct osmo_timer_list *timer);
 
 void osmo_timer_schedule(struct osmo_timer_list *timer, int seconds, int microseconds);
@@ -73,6 +83,23 @@ void osmo_timer_del(struct osmo_timer_list *timer);
 
 int osmo_timer_pending(struct osmo_timer_list *timer);
 
+int osmo_timer_remaining(const struct osmo_timer_list *timer,
+			 struct timeval *remaining);
+
+
+/*! \brief Clock sources of the timers, see osmo_clock_set_mode() */
+enum osmo_clock_mode {
+	OSMO_CLOCK_REAL = 0,	/*!< \brief system clocks (default) */
+	OSMO_CLOCK_VIRTUAL,	/*!< \brief virtual time, discrete event mode */
+};
+
+int osmo_clock_set_mode(enum osmo_clock_mode mode);
+enum osmo_clock_mode osmo_clock_get_mode(void);
+void osmo_clock_set(const struct timeval *tv);
+void osmo_clock_advance(const struct timeval *delta);
+
+int osmo_gettimeofday(struct timeval *tv, struct timezone *tz);
+int osmo_clock_gettime(clockid_t clk_id, struct timespec *tp);
 
 /*
  * internal timer list management
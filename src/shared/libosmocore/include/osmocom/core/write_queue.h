@@ -33,6 +33,9 @@
 #include <osmocom/core/select.h>
 #include <osmocom/core/msgb.h>
 
+/*! \brief maximum number of messages written at once in batch mode */
+#define OSMO_WQUEUE_MAX_BATCH	64
+
 /*! write queue instance */
 struct osmo_wqueue {
 	/*! \brief osmocom file descriptor */
@@ -51,9 +54,17 @@ struct osmo_wqueue {
 	int (*write_cb)(struct osmo_fd *fd, struct msgb *msg);
 	/*! \brief call-back in case qeueue has exceptions */
 	int (*except_cb)(struct osmo_fd *fd);
+
+	/*! \brief maximum number of messages written per writable event,
+	 *  1 to write them one by one with \ref write_cb */
+	unsigned int batch;
+	/*! \brief socket type of \ref bfd, 0 if not yet known */
+	int sock_type;
 };
 
 void osmo_wqueue_init(struct osmo_wqueue *queue, int max_length);
+void osmo_wqueue_init_batch(struct osmo_wqueue *queue, int max_length,
+			    unsigned int batch);
 void osmo_wqueue_clear(struct osmo_wqueue *queue);
 int osmo_wqueue_enqueue(struct osmo_wqueue *queue, struct msgb *data);
 int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what);
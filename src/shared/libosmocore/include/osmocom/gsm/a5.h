@@ -58,6 +58,12 @@ void osmo_a5(int n, const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul);
 void osmo_a5_1(const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul);
 void osmo_a5_2(const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul);
 
+/*! \brief Bytes of packed cipher stream per frame and direction */
+#define OSMO_A5_BATCH_BYTES	15
+
+int osmo_a5_batch(int n, const uint8_t *key, const uint32_t *fn,
+                  unsigned int num, pbit_t *dl, pbit_t *ul);
+
 /*! }@ */
 
 #endif /* __OSMO_A5_H__ */
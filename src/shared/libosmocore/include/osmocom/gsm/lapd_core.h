@@ -158,6 +158,7 @@ struct lapd_datalink {
 	uint8_t range_hist; /*!< \brief range of history buffer 2..2^n */
 	struct msgb *rcv_buffer; /*!< \brief buffer to assemble the received message */
 	struct msgb *cont_res; /*!< \brief buffer to store content resolution data on network side, to detect multiple phones on same channel */
+	struct rate_ctr *ctr_retrans; /*!< \brief counts retransmissions on T200 expiry, if set */
 };
 
 void lapd_dl_init(struct lapd_datalink *dl, uint8_t k, uint8_t v_range,
@@ -314,6 +314,47 @@ void tlv_def_patch(struct tlv_definition *dst, const struct tlv_definition *src)
 #define TLVP_LEN(x, y)		(x)->lv[y].len
 #define TLVP_VAL(x, y)		(x)->lv[y].val
 
+/*! \brief maximum number of IEs in a \ref tlv_sparse */
+#define TLV_SPARSE_MAX_IE	32
+
+/*! \brief result of the TLV parser, only holding the IEs found
+ *
+ * Unlike \ref tlv_parsed, it doesn't need to be cleared before each
+ * parse, so the cost only depends on the number of IEs in the message.
+ * Lookups walk the IEs found, which is cheap for the few IEs of a
+ * typical L3 message.  Use the TLVS_* macros, the TLVP_* ones are for
+ * \ref tlv_parsed only.
+ */
+struct tlv_sparse {
+	uint8_t num;				/*!< \brief number of IEs */
+	uint8_t tag[TLV_SPARSE_MAX_IE];		/*!< \brief tag of each IE */
+	struct tlv_p_entry ie[TLV_SPARSE_MAX_IE]; /*!< \brief IEs */
+};
+
+extern const struct tlv_p_entry tlv_sparse_none;
+
+int tlv_parse_sparse(struct tlv_sparse *dec, const struct tlv_definition *def,
+		     const uint8_t *buf, int buf_len, uint8_t lv_tag,
+		     uint8_t lv_tag2);
+
+/*! \brief find an IE in a \ref tlv_sparse
+ *  \returns the last IE with \a tag, an empty entry if not present */
+static inline const struct tlv_p_entry *
+tlv_sparse_get(const struct tlv_sparse *dec, uint8_t tag)
+{
+	int i;
+
+	for (i = dec->num - 1; i >= 0; i--) {
+		if (dec->tag[i] == tag)
+			return &dec->ie[i];
+	}
+	return &tlv_sparse_none;
+}
+
+#define TLVS_PRESENT(x, y)	(tlv_sparse_get(x, y)->val)
+#define TLVS_LEN(x, y)		tlv_sparse_get(x, y)->len
+#define TLVS_VAL(x, y)		tlv_sparse_get(x, y)->val
+
 /*! }@ */
 
 #endif /* _TLV_H */
@@ -1,5 +1,12 @@
 
+#include "config.h"
+
 #include <stdint.h>
+#include <string.h>
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
 
 #include <osmocom/core/bits.h>
 
@@ -12,6 +19,290 @@
  */
 
 
+/* Conversion kernels ----------------------------------------------------- */
+
+/* The bulk of every conversion goes through one of the kernels below. They
+ * handle whole bytes of packed bits (resp. any number of soft bits), with an
+ * SSE2/AVX2 version picked at runtime for the start of the buffer and a
+ * 64 bit SWAR or plain C version for the rest. Any non-zero ubit counts as
+ * a 1. */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define BITS_SWAR 1
+#endif
+
+/* 8 ubits to one byte, first ubit in the MSB (or the LSB in lsb_mode) */
+static inline uint8_t _pack8(const ubit_t *in, int lsb_mode)
+{
+#ifdef BITS_SWAR
+	uint64_t x;
+	memcpy(&x, in, 8);
+	/* bit 7 of each non-zero byte, moved down to bit 0 */
+	x = ((((x & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | x) >> 7)
+		& 0x0101010101010101ULL;
+	/* gather them in the top byte */
+	return (x * (lsb_mode ? 0x0102040810204080ULL : 0x8040201008040201ULL)) >> 56;
+#else
+	uint8_t byte = 0;
+	int i;
+	for (i = 0; i < 8; i++)
+		byte |= (!!in[i]) << (lsb_mode ? i : 7 - i);
+	return byte;
+#endif
+}
+
+static inline void _unpack8(ubit_t *out, uint8_t byte, int lsb_mode)
+{
+#ifdef BITS_SWAR
+	/* byte i of x keeps the bit going to out[i], then turned into 0/1 */
+	uint64_t x = (byte * 0x0101010101010101ULL) &
+		(lsb_mode ? 0x8040201008040201ULL : 0x0102040810204080ULL);
+	x = ((x + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+	memcpy(out, &x, 8);
+#else
+	int i;
+	for (i = 0; i < 8; i++)
+		out[i] = (byte >> (lsb_mode ? i : 7 - i)) & 1;
+#endif
+}
+
+#ifdef HAVE_X86_SIMD
+
+static int _bits_simd = -1;
+
+/* 0 = none, 1 = SSE2, 2 = AVX2 */
+static int _bits_simd_level(void)
+{
+	if (_bits_simd < 0) {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			_bits_simd = 2;
+		else if (__builtin_cpu_supports("sse2"))
+			_bits_simd = 1;
+		else
+			_bits_simd = 0;
+	}
+
+	return _bits_simd;
+}
+
+__attribute__((target("sse2")))
+static unsigned int _ubit2pbit_sse2(pbit_t *out, const ubit_t *in,
+				    unsigned int n_bytes)
+{
+	const __m128i zero = _mm_setzero_si128();
+	unsigned int i;
+
+	for (i = 0; i + 2 <= n_bytes; i += 2) {
+		__m128i v = _mm_loadu_si128((const __m128i *) &in[8 * i]);
+		unsigned int m;
+
+		/* zero bytes, reversed within each 8 bytes so that the first
+		 * ubit ends up in the MSB of the movemask byte */
+		v = _mm_cmpeq_epi8(v, zero);
+		v = _mm_shufflelo_epi16(v, 0x1b);
+		v = _mm_shufflehi_epi16(v, 0x1b);
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		m = ~_mm_movemask_epi8(v);
+
+		out[i]   = m;
+		out[i+1] = m >> 8;
+	}
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static unsigned int _ubit2pbit_avx2(pbit_t *out, const ubit_t *in,
+				    unsigned int n_bytes)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i rev = _mm256_setr_epi8(
+		7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+		7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n_bytes; i += 4) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) &in[8 * i]);
+		uint32_t m;
+
+		v = _mm256_shuffle_epi8(_mm256_cmpeq_epi8(v, zero), rev);
+		m = ~_mm256_movemask_epi8(v);
+
+		memcpy(&out[i], &m, 4);
+	}
+
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int _pbit2ubit_sse2(ubit_t *out, const pbit_t *in,
+				    unsigned int n_bytes)
+{
+	const __m128i mask = _mm_setr_epi8(
+		0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+		0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+	const __m128i one = _mm_set1_epi8(1);
+	unsigned int i;
+
+	for (i = 0; i + 2 <= n_bytes; i += 2) {
+		__m128i v = _mm_cvtsi32_si128(in[i] | (in[i+1] << 8));
+
+		/* each input byte repeated 8 times */
+		v = _mm_unpacklo_epi8(v, v);
+		v = _mm_unpacklo_epi16(v, v);
+		v = _mm_unpacklo_epi32(v, v);
+
+		v = _mm_cmpeq_epi8(_mm_and_si128(v, mask), mask);
+		_mm_storeu_si128((__m128i *) &out[8 * i], _mm_and_si128(v, one));
+	}
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static unsigned int _pbit2ubit_avx2(ubit_t *out, const pbit_t *in,
+				    unsigned int n_bytes)
+{
+	const __m256i mask = _mm256_setr_epi8(
+		0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+		0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+		0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+		0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+	const __m256i spread = _mm256_setr_epi8(
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	const __m256i one = _mm256_set1_epi8(1);
+	unsigned int i;
+
+	for (i = 0; i + 4 <= n_bytes; i += 4) {
+		uint32_t w;
+		__m256i v;
+
+		memcpy(&w, &in[i], 4);
+		v = _mm256_shuffle_epi8(_mm256_set1_epi32(w), spread);
+		v = _mm256_cmpeq_epi8(_mm256_and_si256(v, mask), mask);
+		_mm256_storeu_si256((__m256i *) &out[8 * i],
+				    _mm256_and_si256(v, one));
+	}
+
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int _sbit2ubit_sse2(ubit_t *out, const sbit_t *in,
+				    unsigned int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) &in[i]);
+		v = _mm_and_si128(_mm_cmpgt_epi8(zero, v), one);
+		_mm_storeu_si128((__m128i *) &out[i], v);
+	}
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static unsigned int _sbit2ubit_avx2(ubit_t *out, const sbit_t *in,
+				    unsigned int n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi8(1);
+	unsigned int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) &in[i]);
+		v = _mm256_and_si256(_mm256_cmpgt_epi8(zero, v), one);
+		_mm256_storeu_si256((__m256i *) &out[i], v);
+	}
+
+	return i;
+}
+
+__attribute__((target("sse2")))
+static unsigned int _ubit2sbit_sse2(sbit_t *out, const ubit_t *in,
+				    unsigned int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i s0 = _mm_set1_epi8(127);
+	const __m128i s1 = _mm_set1_epi8(-127);
+	unsigned int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *) &in[i]);
+		v = _mm_cmpeq_epi8(v, zero);
+		v = _mm_or_si128(_mm_and_si128(v, s0), _mm_andnot_si128(v, s1));
+		_mm_storeu_si128((__m128i *) &out[i], v);
+	}
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static unsigned int _ubit2sbit_avx2(sbit_t *out, const ubit_t *in,
+				    unsigned int n)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i s0 = _mm256_set1_epi8(127);
+	const __m256i s1 = _mm256_set1_epi8(-127);
+	unsigned int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) &in[i]);
+		v = _mm256_blendv_epi8(s1, s0, _mm256_cmpeq_epi8(v, zero));
+		_mm256_storeu_si256((__m256i *) &out[i], v);
+	}
+
+	return i;
+}
+
+#endif /* HAVE_X86_SIMD */
+
+static void _ubit2pbit_bytes(pbit_t *out, const ubit_t *in,
+			     unsigned int n_bytes)
+{
+	unsigned int i = 0;
+
+#ifdef HAVE_X86_SIMD
+	switch (_bits_simd_level()) {
+	case 2:
+		i = _ubit2pbit_avx2(out, in, n_bytes);
+		break;
+	case 1:
+		i = _ubit2pbit_sse2(out, in, n_bytes);
+		break;
+	}
+#endif
+
+	for (; i < n_bytes; i++)
+		out[i] = _pack8(&in[8 * i], 0);
+}
+
+static void _pbit2ubit_bytes(ubit_t *out, const pbit_t *in,
+			     unsigned int n_bytes)
+{
+	unsigned int i = 0;
+
+#ifdef HAVE_X86_SIMD
+	switch (_bits_simd_level()) {
+	case 2:
+		i = _pbit2ubit_avx2(out, in, n_bytes);
+		break;
+	case 1:
+		i = _pbit2ubit_sse2(out, in, n_bytes);
+		break;
+	}
+#endif
+
+	for (; i < n_bytes; i++)
+		_unpack8(&out[8 * i], in[i], 0);
+}
+
+
 /*! \brief convert unpacked bits to packed bits, return length in bytes
  *  \param[out] out output buffer of packed bits
  *  \param[in] in input buffer of unpacked bits
@@ -19,25 +310,22 @@
  */
 int osmo_ubit2pbit(pbit_t *out, const ubit_t *in, unsigned int num_bits)
 {
+	unsigned int n_bytes = num_bits / 8;
 	unsigned int i;
-	uint8_t curbyte = 0;
-	pbit_t *outptr = out;
 
-	for (i = 0; i < num_bits; i++) {
-		uint8_t bitnum = 7 - (i % 8);
+	_ubit2pbit_bytes(out, in, n_bytes);
+
+	/* we have a non-modulo-8 bitcount */
+	if (num_bits % 8) {
+		uint8_t curbyte = 0;
 
-		curbyte |= (in[i] << bitnum);
+		for (i = 0; i < num_bits % 8; i++)
+			curbyte |= (!!in[8 * n_bytes + i]) << (7 - i);
 
-		if(i % 8 == 7){
-			*outptr++ = curbyte;
-			curbyte = 0;
-		}
+		out[n_bytes++] = curbyte;
 	}
-	/* we have a non-modulo-8 bitcount */
-	if (i % 8)
-		*outptr++ = curbyte;
 
-	return outptr - out;
+	return n_bytes;
 }
 
 /*! \brief convert packed bits to unpacked bits, return length in bytes
@@ -47,38 +335,25 @@ int osmo_ubit2pbit(pbit_t *out, const ubit_t *in, unsigned int num_bits)
  */
 int osmo_pbit2ubit(ubit_t *out, const pbit_t *in, unsigned int num_bits)
 {
+	unsigned int n_bytes = num_bits / 8;
 	unsigned int i;
-	ubit_t *cur = out;
-	ubit_t *limit = out + num_bits;
-
-	for (i = 0; i < (num_bits/8)+1; i++) {
-		pbit_t byte = in[i];
-		*cur++ = (byte >> 7) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 6) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 5) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 4) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 3) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 2) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 1) & 1;
-		if (cur >= limit)
-			break;
-		*cur++ = (byte >> 0) & 1;
-		if (cur >= limit)
-			break;
-	}
-	return cur - out;
+
+	_pbit2ubit_bytes(out, in, n_bytes);
+
+	for (i = 0; i < num_bits % 8; i++)
+		out[8 * n_bytes + i] = (in[n_bytes] >> (7 - i)) & 1;
+
+	return num_bits;
+}
+
+static inline void _ubit2pbit_one(pbit_t *out, unsigned int op, ubit_t bit,
+				  int lsb_mode)
+{
+	int bn = lsb_mode ? (op&7) : (7-(op&7));
+	if (bit)
+		out[op>>3] |= 1 << bn;
+	else
+		out[op>>3] &= ~(1 << bn);
 }
 
 /*! \brief convert unpacked bits to packed bits (extended options)
@@ -94,15 +369,29 @@ int osmo_ubit2pbit_ext(pbit_t *out, unsigned int out_ofs,
                        const ubit_t *in, unsigned int in_ofs,
                        unsigned int num_bits, int lsb_mode)
 {
-	int i, op, bn;
-	for (i=0; i<num_bits; i++) {
-		op = out_ofs + i;
-		bn = lsb_mode ? (op&7) : (7-(op&7));
-		if (in[in_ofs+i])
-			out[op>>3] |= 1 << bn;
-		else
-			out[op>>3] &= ~(1 << bn);
+	unsigned int i, j, n_bytes;
+
+	/* up to a byte boundary of the output, bytes in bulk, then the rest */
+	for (i=0; i<num_bits && ((out_ofs + i) & 7); i++)
+		_ubit2pbit_one(out, out_ofs + i, in[in_ofs + i], lsb_mode);
+
+	n_bytes = (num_bits - i) / 8;
+	if (n_bytes) {
+		pbit_t *o = &out[(out_ofs + i) >> 3];
+
+		if (lsb_mode) {
+			for (j=0; j<n_bytes; j++)
+				o[j] = _pack8(&in[in_ofs + i + 8 * j], 1);
+		} else {
+			_ubit2pbit_bytes(o, &in[in_ofs + i], n_bytes);
+		}
+
+		i += 8 * n_bytes;
 	}
+
+	for (; i<num_bits; i++)
+		_ubit2pbit_one(out, out_ofs + i, in[in_ofs + i], lsb_mode);
+
 	return ((out_ofs + num_bits - 1) >> 3) + 1;
 }
 
@@ -119,15 +408,88 @@ int osmo_pbit2ubit_ext(ubit_t *out, unsigned int out_ofs,
                        const pbit_t *in, unsigned int in_ofs,
                        unsigned int num_bits, int lsb_mode)
 {
-	int i, ip, bn;
+	unsigned int i, j, ip, bn, n_bytes;
+
 	for (i=0; i<num_bits; i++) {
 		ip = in_ofs + i;
+		if (!(ip & 7) && num_bits - i >= 8) {
+			/* input is byte aligned, do whole bytes */
+			n_bytes = (num_bits - i) / 8;
+			if (lsb_mode) {
+				for (j=0; j<n_bytes; j++)
+					_unpack8(&out[out_ofs + i + 8 * j],
+						in[(ip >> 3) + j], 1);
+			} else {
+				_pbit2ubit_bytes(&out[out_ofs + i], &in[ip >> 3],
+						 n_bytes);
+			}
+			i += 8 * n_bytes - 1;
+			continue;
+		}
 		bn = lsb_mode ? (ip&7) : (7-(ip&7));
 		out[out_ofs+i] = !!(in[ip>>3] & (1<<bn));
 	}
 	return out_ofs + num_bits;
 }
 
+/*! \brief convert soft bits to unpacked bits (hard decision)
+ *  \param[out] out output buffer of unpacked bits
+ *  \param[in] in input buffer of soft bits
+ *  \param[in] num_bits number of bits
+ *  \returns number of bits converted
+ *
+ * Negative soft bits give a 1, as for the convolutional decoder.
+ */
+int osmo_sbit2ubit(ubit_t *out, const sbit_t *in, unsigned int num_bits)
+{
+	unsigned int i = 0;
+
+#ifdef HAVE_X86_SIMD
+	switch (_bits_simd_level()) {
+	case 2:
+		i = _sbit2ubit_avx2(out, in, num_bits);
+		break;
+	case 1:
+		i = _sbit2ubit_sse2(out, in, num_bits);
+		break;
+	}
+#endif
+
+	for (; i < num_bits; i++)
+		out[i] = in[i] < 0;
+
+	return num_bits;
+}
+
+/*! \brief convert unpacked bits to soft bits of full confidence
+ *  \param[out] out output buffer of soft bits
+ *  \param[in] in input buffer of unpacked bits
+ *  \param[in] num_bits number of bits
+ *  \returns number of bits converted
+ *
+ * A 1 becomes -127, a 0 becomes 127.
+ */
+int osmo_ubit2sbit(sbit_t *out, const ubit_t *in, unsigned int num_bits)
+{
+	unsigned int i = 0;
+
+#ifdef HAVE_X86_SIMD
+	switch (_bits_simd_level()) {
+	case 2:
+		i = _ubit2sbit_avx2(out, in, num_bits);
+		break;
+	case 1:
+		i = _ubit2sbit_sse2(out, in, num_bits);
+		break;
+	}
+#endif
+
+	for (; i < num_bits; i++)
+		out[i] = in[i] ? -127 : 127;
+
+	return num_bits;
+}
+
 /* generalized bit reversal function, Chapter 7 "Hackers Delight" */
 uint32_t osmo_bit_reversal(uint32_t x, enum osmo_br_mode k)
 {
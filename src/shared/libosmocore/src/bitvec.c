@@ -30,6 +30,7 @@
 
 #include <errno.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <osmocom/core/bitvec.h>
 
@@ -97,14 +98,12 @@ enum bit_value bitvec_get_bit_pos_high(const struct bitvec *bv,
 {
 	unsigned int bytenum = bytenum_from_bitnum(bitnr);
 	unsigned int bitnum = 7 - (bitnr % 8);
-	uint8_t bitval;
 
 	if (bytenum >= bv->data_len)
 		return -EINVAL;
 
-	bitval = bitval2mask(H, bitnum);
-
-	if ((bv->data[bytenum] & (1 << bitnum)) == bitval)
+	/* H is the inverse of the 0x2b padding bit at that position */
+	if (((bv->data[bytenum] ^ 0x2b) >> bitnum) & 1)
 		return H;
 
 	return L;
@@ -117,14 +116,23 @@ enum bit_value bitvec_get_bit_pos_high(const struct bitvec *bv,
  */
 unsigned int bitvec_get_nth_set_bit(const struct bitvec *bv, unsigned int n)
 {
-	unsigned int i, k = 0;
+	unsigned int i, k = 0, cnt;
+	uint8_t byte;
+
+	if (!n)
+		return 0;
 
-	for (i = 0; i < bv->data_len*8; i++) {
-		if (bitvec_get_bit_pos(bv, i) == ONE) {
-			k++;
-			if (k == n)
-				return i;
+	for (i = 0; i < bv->data_len; i++) {
+		byte = bv->data[i];
+		cnt = __builtin_popcount(byte);
+		if (k + cnt < n) {
+			k += cnt;
+			continue;
 		}
+		/* the bit is in this byte, drop the set bits before it */
+		for (; k + 1 < n; k++)
+			byte &= ~(0x80 >> (__builtin_clz(byte) - 24));
+		return i * 8 + __builtin_clz(byte) - 24;
 	}
 
 	return 0;
@@ -201,8 +209,18 @@ int bitvec_set_bits(struct bitvec *bv, enum bit_value *bits, int count)
 	return 0;
 }
 
-/*! \brief set multiple bits (based on numeric value) at current pos */
-int bitvec_set_uint(struct bitvec *bv, unsigned int ui, int num_bits)
+/* the bytes covering num_bits at bit position pos, at most 5 for 32 bits,
+ * and the number of bits after the field in the last of them */
+static inline int field_bytes(unsigned int pos, int num_bits, int *tail)
+{
+	int n = (pos % 8 + num_bits + 7) / 8;
+
+	*tail = n * 8 - pos % 8 - num_bits;
+	return n;
+}
+
+static int bitvec_set_uint_slow(struct bitvec *bv, unsigned int ui,
+				int num_bits)
 {
 	int i, rc;
 
@@ -218,8 +236,32 @@ int bitvec_set_uint(struct bitvec *bv, unsigned int ui, int num_bits)
 	return 0;
 }
 
-/*! \brief get multiple bits (based on numeric value) from current pos */
-int bitvec_get_uint(struct bitvec *bv, int num_bits)
+/*! \brief set multiple bits (based on numeric value) at current pos */
+int bitvec_set_uint(struct bitvec *bv, unsigned int ui, int num_bits)
+{
+	unsigned int byte = bv->cur_bit / 8;
+	uint64_t mask, val;
+	int i, n, tail;
+
+	/* bit by bit if it doesn't fit, so partial writes stay the same */
+	if (num_bits <= 0 || num_bits > 32
+	 || bv->cur_bit + num_bits > bv->data_len * 8)
+		return bitvec_set_uint_slow(bv, ui, num_bits);
+
+	n = field_bytes(bv->cur_bit, num_bits, &tail);
+	mask = ((1ULL << num_bits) - 1) << tail;
+	val = ((uint64_t) ui << tail) & mask;
+	for (i = n - 1; i >= 0; i--) {
+		bv->data[byte + i] = (bv->data[byte + i] & ~mask) | val;
+		mask >>= 8;
+		val >>= 8;
+	}
+	bv->cur_bit += num_bits;
+
+	return 0;
+}
+
+static int bitvec_get_uint_slow(struct bitvec *bv, int num_bits)
 {
 	int i;
 	unsigned int ui = 0;
@@ -236,6 +278,91 @@ int bitvec_get_uint(struct bitvec *bv, int num_bits)
 	return ui;
 }
 
+/*! \brief get multiple bits (based on numeric value) from current pos */
+int bitvec_get_uint(struct bitvec *bv, int num_bits)
+{
+	unsigned int byte = bv->cur_bit / 8;
+	uint64_t w = 0;
+	int i, n, tail;
+
+	if (num_bits <= 0 || num_bits > 32
+	 || bv->cur_bit + num_bits > bv->data_len * 8)
+		return bitvec_get_uint_slow(bv, num_bits);
+
+	n = field_bytes(bv->cur_bit, num_bits, &tail);
+	for (i = 0; i < n; i++)
+		w = (w << 8) | bv->data[byte + i];
+	bv->cur_bit += num_bits;
+
+	return (w >> tail) & ((1ULL << num_bits) - 1);
+}
+
+/*! \brief get multiple bytes from current pos
+ *  \param[in] bv bit vector
+ *  \param[out] bytes buffer for the octets
+ *  \param[in] count number of octets to read
+ *  \returns 0 on success, -EINVAL if there are not enough bits left
+ *
+ * The position doesn't need to be octet aligned.
+ */
+int bitvec_get_bytes(struct bitvec *bv, uint8_t *bytes, unsigned int count)
+{
+	unsigned int byte = bv->cur_bit / 8, shift = bv->cur_bit % 8, i;
+
+	if (bv->cur_bit + count * 8 > bv->data_len * 8)
+		return -EINVAL;
+
+	if (!shift)
+		memcpy(bytes, bv->data + byte, count);
+	else {
+		for (i = 0; i < count; i++)
+			bytes[i] = (bv->data[byte + i] << shift) |
+				   (bv->data[byte + i + 1] >> (8 - shift));
+	}
+	bv->cur_bit += count * 8;
+
+	return 0;
+}
+
+/*! \brief set multiple bytes at current pos
+ *  \param[in] bv bit vector
+ *  \param[in] bytes octets to write
+ *  \param[in] count number of octets to write
+ *  \returns 0 on success, -EINVAL if there is not enough room left
+ *
+ * The position doesn't need to be octet aligned.
+ */
+int bitvec_set_bytes(struct bitvec *bv, const uint8_t *bytes,
+		     unsigned int count)
+{
+	unsigned int byte = bv->cur_bit / 8, shift = bv->cur_bit % 8, i;
+	uint8_t keep, lo;
+
+	if (bv->cur_bit + count * 8 > bv->data_len * 8)
+		return -EINVAL;
+
+	if (!shift)
+		memcpy(bv->data + byte, bytes, count);
+	else if (count) {
+		/* bits before the position in the first byte and after the
+		 * field in the last one are kept */
+		keep = 0xff << (8 - shift);
+		bv->data[byte] &= keep;
+		for (i = 0; i < count; i++) {
+			bv->data[byte + i] |= bytes[i] >> shift;
+			lo = bytes[i] << (8 - shift);
+			if (i + 1 < count)
+				bv->data[byte + i + 1] = lo;
+			else
+				bv->data[byte + i + 1] =
+					(bv->data[byte + i + 1] & ~keep) | lo;
+		}
+	}
+	bv->cur_bit += count * 8;
+
+	return 0;
+}
+
 /*! \brief pad all remaining bits up to num_bits */
 int bitvec_spare_padding(struct bitvec *bv, unsigned int up_to_bit)
 {
@@ -247,15 +374,53 @@ int bitvec_spare_padding(struct bitvec *bv, unsigned int up_to_bit)
 	return 0;
 }
 
-/*! \brief find first bit set in bit vector */
+static inline uint64_t load_be64(const uint8_t *p)
+{
+	uint64_t w;
+
+	memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+/*! \brief find first bit set in bit vector
+ *
+ * Bit 0 is the MSB of the first octet, so loading the octets as big
+ * endian words lets us count leading zeros to find the first bit.
+ */
 int bitvec_find_bit_pos(const struct bitvec *bv, unsigned int n,
 			enum bit_value val)
 {
-	unsigned int i;
+	unsigned int byte = n / 8, len = bv->data_len;
+	uint8_t inv, b;
+	uint64_t w;
+
+	if (val != ZERO && val != ONE)
+		return -1;
+	if (byte >= len)
+		return -1;
+
+	/* search for ones in the inverted data to find a zero */
+	inv = (val == ZERO) ? 0xff : 0x00;
+
+	b = (bv->data[byte] ^ inv) & (0xff >> (n % 8));
+	if (b)
+		return byte * 8 + __builtin_clz(b) - 24;
+
+	for (byte++; byte + 8 <= len; byte += 8) {
+		w = load_be64(bv->data + byte);
+		if (val == ZERO)
+			w = ~w;
+		if (w)
+			return byte * 8 + __builtin_clzll(w);
+	}
 
-	for (i = n; i < bv->data_len*8; i++) {
-		if (bitvec_get_bit_pos(bv, i) == val)
-			return i;
+	for (; byte < len; byte++) {
+		b = bv->data[byte] ^ inv;
+		if (b)
+			return byte * 8 + __builtin_clz(b) - 24;
 	}
 
 	return -1;
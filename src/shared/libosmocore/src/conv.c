@@ -30,15 +30,18 @@
  *  \file Osmocom convolutional encoder and decoder
  */
 #include "config.h"
-#ifdef HAVE_ALLOCA_H
-#include <alloca.h>
-#endif
+#include <errno.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
 #include <osmocom/core/bits.h>
 #include <osmocom/core/conv.h>
+#include <osmocom/core/utils.h>
 
 
 /* ------------------------------------------------------------------------ */
@@ -232,17 +235,540 @@ osmo_conv_encode(const struct osmo_conv_code *code,
 }
 
 
+/* Table driven encoding ------------------------------------------------- */
+
+/*! \brief Build the tables to encode a code several input bits at a time
+ *  \param[in] code description of convolutional code, len must be set
+ *  \returns tables to pass to \ref osmo_conv_encode_lut or NULL on error
+ *
+ * Building the tables costs about as much as encoding a few blocks, so
+ * this is meant to be done once per code, e.g. at startup.
+ */
+struct osmo_conv_encode_lut *
+osmo_conv_encode_lut_alloc(const struct osmo_conv_code *code)
+{
+	struct osmo_conv_encode_lut *lut;
+	int n_states, n_in, stride;
+	int s, v, b, j, i, o;
+
+	if (code->len <= 0 || code->K > 9)
+		return NULL;
+
+	n_states = 1 << (code->K - 1);
+	n_in = 1 << CONV_LUT_BITS;
+	stride = CONV_LUT_BITS * code->N;
+
+	lut = calloc(1, sizeof(*lut));
+	if (!lut)
+		return NULL;
+
+	lut->code = code;
+	lut->out_len = osmo_conv_get_output_length(code, 0);
+	lut->raw_len = code->len * code->N;
+	if (code->term == CONV_TERM_FLUSH)
+		lut->raw_len += code->N * (code->K - 1);
+
+	lut->next_state  = malloc(n_states * n_in);
+	lut->next_output = malloc(n_states * n_in * stride);
+	if (!lut->next_state || !lut->next_output)
+		goto err;
+
+	/* Walk the trellis CONV_LUT_BITS steps from each state, first input
+	 * bit being the MSB of the table index */
+	for (s=0; s<n_states; s++) {
+		for (v=0; v<n_in; v++) {
+			ubit_t *out = &lut->next_output[(s * n_in + v) * stride];
+			uint8_t state = s;
+
+			for (b=0; b<CONV_LUT_BITS; b++) {
+				int bit = (v >> (CONV_LUT_BITS - b - 1)) & 1;
+				uint8_t ov = code->next_output[state][bit];
+
+				for (j=0; j<code->N; j++)
+					*out++ = (ov >> (code->N - j - 1)) & 1;
+
+				state = code->next_state[state][bit];
+			}
+
+			lut->next_state[s * n_in + v] = state;
+		}
+	}
+
+	/* Puncturing as the list of raw positions we keep */
+	if (code->puncture) {
+		if (lut->raw_len > 0xffff)
+			goto err;
+
+		lut->keep = malloc(sizeof(uint16_t) * lut->out_len);
+		lut->raw  = malloc(lut->raw_len);
+		if (!lut->keep || !lut->raw)
+			goto err;
+
+		for (i=0, o=0, j=0; i<lut->raw_len; i++) {
+			if (code->puncture[j] == i)
+				j++;
+			else
+				lut->keep[o++] = i;
+		}
+	}
+
+	return lut;
+
+err:
+	osmo_conv_encode_lut_free(lut);
+	return NULL;
+}
+
+/*! \brief Free tables allocated by \ref osmo_conv_encode_lut_alloc */
+void
+osmo_conv_encode_lut_free(struct osmo_conv_encode_lut *lut)
+{
+	if (!lut)
+		return;
+
+	free(lut->next_state);
+	free(lut->next_output);
+	free(lut->keep);
+	free(lut->raw);
+	free(lut);
+}
+
+/*! \brief Table driven all-in-one convolutional encoding function
+ *  \param[in] lut tables of the code, from \ref osmo_conv_encode_lut_alloc
+ *  \param[in] input array of unpacked bits (uncoded)
+ *  \param[out] output array of unpacked bits (encoded)
+ *  \return Number of produced output bits
+ *
+ * Produces the same output as \ref osmo_conv_encode.
+ */
+int
+osmo_conv_encode_lut(struct osmo_conv_encode_lut *lut,
+                     const ubit_t *input, ubit_t *output)
+{
+	const struct osmo_conv_code *code = lut->code;
+	const int n_in = 1 << CONV_LUT_BITS;
+	const int stride = CONV_LUT_BITS * code->N;
+	ubit_t *raw = code->puncture ? lut->raw : output;
+	uint8_t state = 0;
+	int i, j, o;
+
+	if (code->term == CONV_TERM_TAIL_BITING) {
+		int eidx = code->len - code->K + 1;
+		for (i=0; i<(code->K-1); i++)
+			state = (state << 1) | input[eidx + i];
+	}
+
+	/* Bulk of the input, CONV_LUT_BITS at a time */
+	for (i=0, o=0; i+CONV_LUT_BITS<=code->len; i+=CONV_LUT_BITS, o+=stride) {
+		int v = 0;
+
+		for (j=0; j<CONV_LUT_BITS; j++)
+			v = (v << 1) | input[i + j];
+
+		v += state * n_in;
+		memcpy(&raw[o], &lut->next_output[v * stride], stride);
+		state = lut->next_state[v];
+	}
+
+	/* Remaining input bits and flushing one by one */
+	for (; i<code->len; i++) {
+		uint8_t out = code->next_output[state][input[i]];
+		state = code->next_state[state][input[i]];
+
+		for (j=0; j<code->N; j++)
+			raw[o++] = (out >> (code->N - j - 1)) & 1;
+	}
+
+	if (code->term == CONV_TERM_FLUSH) {
+		for (i=0; i<code->K-1; i++) {
+			uint8_t out;
+
+			if (code->next_term_output) {
+				out   = code->next_term_output[state];
+				state = code->next_term_state[state];
+			} else {
+				out   = code->next_output[state][0];
+				state = code->next_state[state][0];
+			}
+
+			for (j=0; j<code->N; j++)
+				raw[o++] = (out >> (code->N - j - 1)) & 1;
+		}
+	}
+
+	if (!code->puncture)
+		return o;
+
+	/* Puncture */
+	for (i=0; i<lut->out_len; i++)
+		output[i] = raw[lut->keep[i]];
+
+	return lut->out_len;
+}
+
+
 /* ------------------------------------------------------------------------ */
 /* Decoding (viterbi)                                                       */
 /* ------------------------------------------------------------------------ */
 
 #define MAX_AE 0x00ffffff
 
+/* Largest N the accelerated ACS kernels have room for */
+#define CONV_ACC_MAX_N	8
+
+
+/* Add-compare-select implementations ------------------------------------ */
+
+typedef void (*conv_acs_fn)(struct osmo_conv_decoder *decoder,
+                            const sbit_t *in_sym, uint8_t *state_history);
+
+/* One trellis step of the reference decoder: for every state and input bit
+ * compute the path error and keep the first survivor with the least error */
+static void
+_conv_acs_scalar(struct osmo_conv_decoder *decoder,
+                 const sbit_t *in_sym, uint8_t *state_history)
+{
+	const struct osmo_conv_code *code = decoder->code;
+	int n_states = decoder->n_states;
+	unsigned int *ae = decoder->ae;
+	unsigned int *ae_next = decoder->ae_next;
+	int s, b, j;
+
+	/* Reset next accumulated error */
+	for (s=0; s<n_states; s++) {
+		ae_next[s] = MAX_AE;
+	}
+
+	/* Scan all state */
+	for (s=0; s<n_states; s++)
+	{
+		/* Scan possible input bits */
+		for (b=0; b<2; b++)
+		{
+			int nae, ov, e;
+			uint8_t m;
+
+			/* Next output and state */
+			uint8_t out   = code->next_output[s][b];
+			uint8_t state = code->next_state[s][b];
+
+			/* New error for this path */
+			nae = ae[s];			/* start from last error */
+			m = 1 << (code->N - 1);		/* mask for 'out' bit selection */
+
+			for (j=0; j<code->N; j++) {
+				int is = (int)in_sym[j];
+				if (is) {
+					ov = (out & m) ? -127 : 127; /* sbit_t value for it */
+					e = is - ov;                 /* raw error for this bit */
+					nae += (e * e) >> 9;         /* acc the squared/scaled value */
+				}
+				m >>= 1;                     /* next mask bit */
+			}
+
+			/* Is it survivor ? */
+			if (ae_next[state] > nae) {
+				ae_next[state] = nae;
+				state_history[state] = s;
+			}
+		}
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+
+/* The per bit error of the scalar code only takes two values per step, one
+ * for a 0 and one for a 1 output bit. Return the error of the all-zero
+ * output and fill delta[] with what a 1 in each bit position adds to it */
+static inline int
+_conv_acc_bm_prep(int N, const sbit_t *in_sym, int *delta)
+{
+	int j, sum = 0;
+
+	for (j=0; j<N; j++) {
+		int is = (int)in_sym[j];
+		if (is) {
+			int e0 = is - 127, e1 = is + 127;
+			int a = (e0 * e0) >> 9;
+			sum += a;
+			delta[j] = ((e1 * e1) >> 9) - a;
+		} else {
+			delta[j] = 0;
+		}
+	}
+
+	return sum;
+}
+
+/* The SIMD kernels rely on the predecessors of state d being d/2 and
+ * d/2 + n_states/2, which holds for all shift register codes, recursive or
+ * not. Fills in the output bit masks of both branches into each state and
+ * returns 0, or -1 if the code doesn't have this structure. */
+static int
+_conv_acc_init_mask(const struct osmo_conv_code *code, int n_states,
+                    int32_t *mask)
+{
+	int d, k, j;
+
+	for (d=0; d<n_states; d++) {
+		for (k=0; k<2; k++) {
+			int s = (d >> 1) + k * (n_states >> 1);
+			uint8_t out;
+
+			if (code->next_state[s][0] == d)
+				out = code->next_output[s][0];
+			else if (code->next_state[s][1] == d)
+				out = code->next_output[s][1];
+			else
+				return -1;
+
+			for (j=0; j<code->N; j++)
+				mask[(k * code->N + j) * n_states + d] =
+					(out >> (code->N - j - 1)) & 1 ? -1 : 0;
+		}
+	}
+
+	return 0;
+}
+
+__attribute__((target("sse2")))
+static void
+_conv_acs_sse2(struct osmo_conv_decoder *decoder,
+               const sbit_t *in_sym, uint8_t *state_history)
+{
+	const int N = decoder->code->N;
+	const int n_states = decoder->n_states;
+	const int h = n_states >> 1;
+	const int32_t *m0 = decoder->acc_mask;
+	const int32_t *m1 = m0 + N * n_states;
+	const unsigned int *ae = decoder->ae;
+	unsigned int *ae_next = decoder->ae_next;
+	int delta_s[CONV_ACC_MAX_N];
+	__m128i delta[CONV_ACC_MAX_N];
+	__m128i bm, vmax, vh;
+	int d, q, j;
+
+	bm = _mm_set1_epi32(_conv_acc_bm_prep(N, in_sym, delta_s));
+	for (j=0; j<N; j++)
+		delta[j] = _mm_set1_epi32(delta_s[j]);
+	vmax = _mm_set1_epi32(MAX_AE);
+	vh = _mm_set1_epi32(h);
+
+	/* 4 destination states per vector, 16 per history store */
+	for (d=0; d<n_states; d+=16) {
+		__m128i surv[4];
+
+		for (q=0; q<4; q++) {
+			int o = d + 4 * q;
+			__m128i a0, a1, bm0, bm1, sel, best, ovf;
+
+			/* Path errors of both predecessors, ae[o/2] twice, ... */
+			a0 = _mm_loadl_epi64((const __m128i *) &ae[o >> 1]);
+			a0 = _mm_unpacklo_epi32(a0, a0);
+			a1 = _mm_loadl_epi64((const __m128i *) &ae[h + (o >> 1)]);
+			a1 = _mm_unpacklo_epi32(a1, a1);
+
+			/* Branch errors */
+			bm0 = bm1 = bm;
+			for (j=0; j<N; j++) {
+				bm0 = _mm_add_epi32(bm0, _mm_and_si128(delta[j],
+					_mm_loadu_si128((const __m128i *) &m0[j * n_states + o])));
+				bm1 = _mm_add_epi32(bm1, _mm_and_si128(delta[j],
+					_mm_loadu_si128((const __m128i *) &m1[j * n_states + o])));
+			}
+			a0 = _mm_add_epi32(a0, bm0);
+			a1 = _mm_add_epi32(a1, bm1);
+
+			/* Survivor, first predecessor wins ties like the scalar
+			 * code, error saturated at MAX_AE */
+			sel  = _mm_cmplt_epi32(a1, a0);
+			best = _mm_or_si128(_mm_and_si128(sel, a1),
+			                    _mm_andnot_si128(sel, a0));
+			ovf  = _mm_cmpgt_epi32(best, vmax);
+			best = _mm_or_si128(_mm_and_si128(ovf, vmax),
+			                    _mm_andnot_si128(ovf, best));
+			_mm_storeu_si128((__m128i *) &ae_next[o], best);
+
+			surv[q] = _mm_add_epi32(
+				_mm_setr_epi32(o >> 1, o >> 1, (o >> 1) + 1, (o >> 1) + 1),
+				_mm_and_si128(sel, vh));
+		}
+
+		_mm_storeu_si128((__m128i *) &state_history[d],
+			_mm_packus_epi16(_mm_packs_epi32(surv[0], surv[1]),
+			                 _mm_packs_epi32(surv[2], surv[3])));
+	}
+}
+
+__attribute__((target("avx2")))
+static void
+_conv_acs_avx2(struct osmo_conv_decoder *decoder,
+               const sbit_t *in_sym, uint8_t *state_history)
+{
+	const int N = decoder->code->N;
+	const int n_states = decoder->n_states;
+	const int h = n_states >> 1;
+	const int32_t *m0 = decoder->acc_mask;
+	const int32_t *m1 = m0 + N * n_states;
+	const unsigned int *ae = decoder->ae;
+	unsigned int *ae_next = decoder->ae_next;
+	int delta_s[CONV_ACC_MAX_N];
+	__m256i delta[CONV_ACC_MAX_N];
+	__m256i bm, vmax, vh, dup, pack;
+	int d, q, j;
+
+	bm = _mm256_set1_epi32(_conv_acc_bm_prep(N, in_sym, delta_s));
+	for (j=0; j<N; j++)
+		delta[j] = _mm256_set1_epi32(delta_s[j]);
+	vmax = _mm256_set1_epi32(MAX_AE);
+	vh = _mm256_set1_epi32(h);
+	dup  = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	pack = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	/* 8 destination states per vector, 16 per history store */
+	for (d=0; d<n_states; d+=16) {
+		__m256i surv[2], p;
+
+		for (q=0; q<2; q++) {
+			int o = d + 8 * q;
+			__m256i a0, a1, bm0, bm1, sel, best;
+
+			a0 = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i *) &ae[o >> 1])), dup);
+			a1 = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i *) &ae[h + (o >> 1)])), dup);
+
+			bm0 = bm1 = bm;
+			for (j=0; j<N; j++) {
+				bm0 = _mm256_add_epi32(bm0, _mm256_and_si256(delta[j],
+					_mm256_loadu_si256((const __m256i *) &m0[j * n_states + o])));
+				bm1 = _mm256_add_epi32(bm1, _mm256_and_si256(delta[j],
+					_mm256_loadu_si256((const __m256i *) &m1[j * n_states + o])));
+			}
+			a0 = _mm256_add_epi32(a0, bm0);
+			a1 = _mm256_add_epi32(a1, bm1);
+
+			sel  = _mm256_cmpgt_epi32(a0, a1);
+			best = _mm256_blendv_epi8(a0, a1, sel);
+			best = _mm256_min_epi32(best, vmax);
+			_mm256_storeu_si256((__m256i *) &ae_next[o], best);
+
+			surv[q] = _mm256_add_epi32(
+				_mm256_add_epi32(_mm256_set1_epi32(o >> 1), dup),
+				_mm256_and_si256(sel, vh));
+		}
+
+		/* Packing works per 128 bit lane, put the dwords back in order */
+		p = _mm256_packs_epi32(surv[0], surv[1]);
+		p = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(p, p), pack);
+		_mm_storeu_si128((__m128i *) &state_history[d],
+			_mm256_castsi256_si128(p));
+	}
+}
+
+#endif /* HAVE_X86_SIMD */
+
+static enum osmo_conv_backend _conv_backend = CONV_BACKEND_AUTO;
+static conv_acs_fn _conv_acs = _conv_acs_scalar;
+
+static const struct value_string conv_backend_names[] = {
+	{ CONV_BACKEND_AUTO,	"auto" },
+	{ CONV_BACKEND_SCALAR,	"scalar" },
+	{ CONV_BACKEND_SSE2,	"sse2" },
+	{ CONV_BACKEND_AVX2,	"avx2" },
+	{ 0, NULL }
+};
+
+/*! \brief Get a human readable name of a decoder backend */
+const char *
+osmo_conv_backend_name(enum osmo_conv_backend backend)
+{
+	return get_value_string(conv_backend_names, backend);
+}
+
+/*! \brief Select the add-compare-select implementation used by the decoder
+ *  \param[in] backend Backend to use, \ref CONV_BACKEND_AUTO for the fastest
+ *  \returns 0 on success, -ENOTSUP if not available on this host or build
+ *
+ * Codes the accelerated backends can't handle always use the scalar code.
+ */
+int
+osmo_conv_decode_set_backend(enum osmo_conv_backend backend)
+{
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+
+	if (backend == CONV_BACKEND_AUTO) {
+		if (__builtin_cpu_supports("avx2"))
+			backend = CONV_BACKEND_AVX2;
+		else if (__builtin_cpu_supports("sse2"))
+			backend = CONV_BACKEND_SSE2;
+		else
+			backend = CONV_BACKEND_SCALAR;
+	}
+#else
+	if (backend == CONV_BACKEND_AUTO)
+		backend = CONV_BACKEND_SCALAR;
+#endif
+
+	switch (backend) {
+	case CONV_BACKEND_SCALAR:
+		_conv_acs = _conv_acs_scalar;
+		break;
+#ifdef HAVE_X86_SIMD
+	case CONV_BACKEND_SSE2:
+		if (!__builtin_cpu_supports("sse2"))
+			return -ENOTSUP;
+		_conv_acs = _conv_acs_sse2;
+		break;
+	case CONV_BACKEND_AVX2:
+		if (!__builtin_cpu_supports("avx2"))
+			return -ENOTSUP;
+		_conv_acs = _conv_acs_avx2;
+		break;
+#endif
+	default:
+		return -ENOTSUP;
+	}
+
+	_conv_backend = backend;
+
+	return 0;
+}
+
+/*! \brief Get the add-compare-select implementation used by the decoder */
+enum osmo_conv_backend
+osmo_conv_decode_get_backend(void)
+{
+	if (_conv_backend == CONV_BACKEND_AUTO)
+		osmo_conv_decode_set_backend(CONV_BACKEND_AUTO);
+
+	return _conv_backend;
+}
+
+
+/* Decoder --------------------------------------------------------------- */
+
+#define _CONV_ALIGN(x)	(((x) + 7) & ~7)
+
+/*! \brief Initialize a convolutional decoder
+ *  \param[out] decoder Decoder state to initialize
+ *  \param[in] code Description of convolutional code
+ *  \param[in] len Number of data bits to decode, 0 for code->len
+ *  \param[in] start_state Start state, -1 if unknown
+ *
+ * All the memory the decoder needs is allocated here in a single block, so
+ * an initialized decoder can be used for any number of blocks through
+ * \ref osmo_conv_decode_ctx or \ref osmo_conv_decode_batch without further
+ * allocations until \ref osmo_conv_decode_deinit.
+ */
 void
 osmo_conv_decode_init(struct osmo_conv_decoder *decoder,
                       const struct osmo_conv_code *code, int len, int start_state)
 {
 	int n_states;
+	size_t sh_size, ae_size, mask_size;
+	uint8_t *mem;
 
 	/* Init */
 	if (len <= 0)
@@ -256,11 +782,33 @@ osmo_conv_decode_init(struct osmo_conv_decoder *decoder,
 	decoder->n_states = n_states;
 	decoder->len = len;
 
-	/* Allocate arrays */
-	decoder->ae      = malloc(sizeof(unsigned int) * n_states);
-	decoder->ae_next = malloc(sizeof(unsigned int) * n_states);
+	/* Backend selection */
+	if (_conv_backend == CONV_BACKEND_AUTO)
+		osmo_conv_decode_set_backend(CONV_BACKEND_AUTO);
+
+	/* Allocate arrays, state_history first as it owns the block */
+	sh_size = _CONV_ALIGN(sizeof(uint8_t) * n_states * (len + code->K - 1));
+	ae_size = _CONV_ALIGN(sizeof(unsigned int) * n_states);
+	mask_size = 0;
+#ifdef HAVE_X86_SIMD
+	if (code->N <= CONV_ACC_MAX_N && n_states >= 16 && n_states <= 256)
+		mask_size = sizeof(int32_t) * 2 * code->N * n_states;
+#endif
+
+	mem = malloc(sh_size + 2 * ae_size + mask_size + code->N);
 
-	decoder->state_history = malloc(sizeof(uint8_t) * n_states * (len + decoder->code->K - 1));
+	decoder->state_history = mem;
+	decoder->ae      = (unsigned int *) (mem + sh_size);
+	decoder->ae_next = (unsigned int *) (mem + sh_size + ae_size);
+	decoder->in_sym  = (sbit_t *) (mem + sh_size + 2 * ae_size + mask_size);
+
+#ifdef HAVE_X86_SIMD
+	if (mask_size) {
+		decoder->acc_mask = (int32_t *) (mem + sh_size + 2 * ae_size);
+		if (_conv_acc_init_mask(code, n_states, decoder->acc_mask))
+			decoder->acc_mask = NULL;
+	}
+#endif
 
 	/* Classic reset */
 	osmo_conv_decode_reset(decoder, start_state);
@@ -310,8 +858,7 @@ osmo_conv_decode_rewind(struct osmo_conv_decoder *decoder)
 void
 osmo_conv_decode_deinit(struct osmo_conv_decoder *decoder)
 {
-	free(decoder->ae);
-	free(decoder->ae_next);
+	/* ae, ae_next, acc_mask and in_sym live in the same block */
 	free(decoder->state_history);
 
 	memset(decoder, 0x00, sizeof(struct osmo_conv_decoder));
@@ -323,24 +870,24 @@ osmo_conv_decode_scan(struct osmo_conv_decoder *decoder,
 {
 	const struct osmo_conv_code *code = decoder->code;
 
-	int i, s, b, j;
+	int i, j;
 
 	int n_states;
-	unsigned int *ae;
-	unsigned int *ae_next;
+	unsigned int *ae_tmp;
 	uint8_t *state_history;
 	sbit_t *in_sym;
+	conv_acs_fn acs;
 
 	int i_idx, p_idx;
 
 	/* Prepare */
 	n_states = decoder->n_states;
 
-	ae      = decoder->ae;
-	ae_next = decoder->ae_next;
 	state_history = &decoder->state_history[n_states * decoder->o_idx];
 
-	in_sym  = alloca(sizeof(sbit_t) * code->N);
+	in_sym  = decoder->in_sym;
+
+	acs = decoder->acc_mask ? _conv_acs : _conv_acs_scalar;
 
 	i_idx = 0;
 	p_idx = decoder->p_idx;
@@ -348,11 +895,6 @@ osmo_conv_decode_scan(struct osmo_conv_decoder *decoder,
 	/* Scan the treillis */
 	for (i=0; i<n; i++)
 	{
-		/* Reset next accumulated error */
-		for (s=0; s<n_states; s++) {
-			ae_next[s] = MAX_AE;
-		}
-
 		/* Get input */
 		if (code->puncture) {
 			/* Hard way ... */
@@ -372,43 +914,13 @@ osmo_conv_decode_scan(struct osmo_conv_decoder *decoder,
 			i_idx += code->N;
 		}
 
-		/* Scan all state */
-		for (s=0; s<n_states; s++)
-		{
-			/* Scan possible input bits */
-			for (b=0; b<2; b++)
-			{
-				int nae, ov, e;
-				uint8_t m;
-
-				/* Next output and state */
-				uint8_t out   = code->next_output[s][b];
-				uint8_t state = code->next_state[s][b];
-
-				/* New error for this path */
-				nae = ae[s];			/* start from last error */
-				m = 1 << (code->N - 1);		/* mask for 'out' bit selection */
-
-				for (j=0; j<code->N; j++) {
-					int is = (int)in_sym[j];
-					if (is) {
-						ov = (out & m) ? -127 : 127; /* sbit_t value for it */
-						e = is - ov;                 /* raw error for this bit */
-						nae += (e * e) >> 9;         /* acc the squared/scaled value */
-					}
-					m >>= 1;                     /* next mask bit */
-				}
-
-				/* Is it survivor ? */
-				if (ae_next[state] > nae) {
-					ae_next[state] = nae;
-					state_history[(n_states * i) + state] = s;
-				}
-			}
-		}
+		/* Add-compare-select over all states */
+		acs(decoder, in_sym, &state_history[n_states * i]);
 
-		/* Copy accumulated error */
-		memcpy(ae, ae_next, sizeof(unsigned int) * n_states);
+		/* Next accumulated error becomes the current one */
+		ae_tmp = decoder->ae;
+		decoder->ae = decoder->ae_next;
+		decoder->ae_next = ae_tmp;
 	}
 
 	/* Update decoder state */
@@ -441,7 +953,7 @@ osmo_conv_decode_flush(struct osmo_conv_decoder *decoder,
 	ae_next = decoder->ae_next;
 	state_history = &decoder->state_history[n_states * decoder->o_idx];
 
-	in_sym  = alloca(sizeof(sbit_t) * code->N);
+	in_sym  = decoder->in_sym;
 
 	i_idx = 0;
 	p_idx = decoder->p_idx;
@@ -589,39 +1101,93 @@ osmo_conv_decode_get_output(struct osmo_conv_decoder *decoder,
 	return min_ae;
 }
 
-/*! \brief All-in-one convolutional decoding function
- *  \param[in] code description of convolutional code to be used
+/*! \brief All-in-one convolutional decoding with an existing decoder
+ *  \param[in] decoder decoder initialized for the code with len = 0
  *  \param[in] input array of soft bits (coded)
  *  \param[out] output array of unpacked bits (decoded)
+ *  \return Error of the decoded path, as for \ref osmo_conv_decode
  *
- * This is an all-in-one function, taking care of
- * \ref osmo_conv_decode_init, \ref osmo_conv_decode_scan,
- * \ref osmo_conv_decode_flush, \ref osmo_conv_decode_get_output and
- * \ref osmo_conv_decode_deinit.
+ * Same as \ref osmo_conv_decode but uses the tables of the given decoder
+ * instead of allocating new ones, the decoder can be reused right away.
  */
 int
-osmo_conv_decode(const struct osmo_conv_code *code,
-                 const sbit_t *input, ubit_t *output)
+osmo_conv_decode_ctx(struct osmo_conv_decoder *decoder,
+                     const sbit_t *input, ubit_t *output)
 {
-	struct osmo_conv_decoder decoder;
-	int rv, l;
+	const struct osmo_conv_code *code = decoder->code;
+	int l;
 
-	osmo_conv_decode_init(&decoder, code, 0, 0);
+	osmo_conv_decode_reset(decoder, 0);
 
 	if (code->term == CONV_TERM_TAIL_BITING) {
-		osmo_conv_decode_scan(&decoder, input, code->len);
-		osmo_conv_decode_rewind(&decoder);
+		osmo_conv_decode_scan(decoder, input, code->len);
+		osmo_conv_decode_rewind(decoder);
 	}
 
-	l = osmo_conv_decode_scan(&decoder, input, code->len);
+	l = osmo_conv_decode_scan(decoder, input, code->len);
 
 	if (code->term == CONV_TERM_FLUSH)
-		l = osmo_conv_decode_flush(&decoder, &input[l]);
+		osmo_conv_decode_flush(decoder, &input[l]);
 
-	rv = osmo_conv_decode_get_output(&decoder, output,
+	return osmo_conv_decode_get_output(decoder, output,
 		code->term == CONV_TERM_FLUSH,		/* has_flush */
 		code->term == CONV_TERM_FLUSH ? 0 : -1	/* end_state */
 	);
+}
+
+/*! \brief Decode several consecutive blocks of the same code
+ *  \param[in] decoder decoder initialized for the code with len = 0
+ *  \param[in] input n blocks of soft bits, each of the coded length
+ *  \param[out] output n blocks of unpacked bits, each code->len long
+ *  \param[in] n number of blocks
+ *  \param[out] rv per block return value of \ref osmo_conv_decode_ctx,
+ *               may be NULL
+ *  \return 0 on success, -EINVAL if the decoder is too small for the code
+ */
+int
+osmo_conv_decode_batch(struct osmo_conv_decoder *decoder,
+                       const sbit_t *input, ubit_t *output,
+                       int n, int *rv)
+{
+	const struct osmo_conv_code *code = decoder->code;
+	int i, in_len;
+
+	if (decoder->len < code->len)
+		return -EINVAL;
+
+	in_len = osmo_conv_get_output_length(code, 0);
+
+	for (i=0; i<n; i++) {
+		int r = osmo_conv_decode_ctx(decoder,
+			&input[i * in_len], &output[i * code->len]);
+		if (rv)
+			rv[i] = r;
+	}
+
+	return 0;
+}
+
+/*! \brief All-in-one convolutional decoding function
+ *  \param[in] code description of convolutional code to be used
+ *  \param[in] input array of soft bits (coded)
+ *  \param[out] output array of unpacked bits (decoded)
+ *
+ * This is an all-in-one function, taking care of
+ * \ref osmo_conv_decode_init, \ref osmo_conv_decode_scan,
+ * \ref osmo_conv_decode_flush, \ref osmo_conv_decode_get_output and
+ * \ref osmo_conv_decode_deinit. To decode many blocks, rather keep a
+ * decoder around and use \ref osmo_conv_decode_ctx.
+ */
+int
+osmo_conv_decode(const struct osmo_conv_code *code,
+                 const sbit_t *input, ubit_t *output)
+{
+	struct osmo_conv_decoder decoder;
+	int rv;
+
+	osmo_conv_decode_init(&decoder, code, 0, 0);
+
+	rv = osmo_conv_decode_ctx(&decoder, input, output);
 
 	osmo_conv_decode_deinit(&decoder);
 
@@ -8,6 +8,8 @@
  * Version 2. See the file COPYING for more details.
  */
 
+#include "config.h"
+
 #include <osmocom/core/crc16.h>
 
 /** CRC table for the CRC-16. The poly is 0x8005 (x^16 + x^15 + x^2 + 1) */
@@ -46,6 +48,27 @@ uint16_t const osmo_crc16_table[256] = {
 	0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
 };
 
+#ifndef EMBEDDED
+/* Slice-by-8 tables, [0] is osmo_crc16_table and [k] is [k-1] followed by
+ * one more zero byte. Built on first use to keep them out of the binary. */
+static uint16_t crc16_table8[8][256];
+static int crc16_table8_ready = 0;
+
+static void crc16_table8_init(void)
+{
+	int i, k;
+
+	for (i = 0; i < 256; i++)
+		crc16_table8[0][i] = osmo_crc16_table[i];
+
+	for (k = 1; k < 8; k++)
+		for (i = 0; i < 256; i++)
+			crc16_table8[k][i] = osmo_crc16_byte(crc16_table8[k-1][i], 0);
+
+	crc16_table8_ready = 1;
+}
+#endif
+
 /**
  * crc16 - compute the CRC-16 for the data buffer
  * @crc:	previous CRC value
@@ -56,6 +79,23 @@ uint16_t const osmo_crc16_table[256] = {
  */
 uint16_t osmo_crc16(uint16_t crc, uint8_t const *buffer, size_t len)
 {
+#ifndef EMBEDDED
+	if (len >= 8 && !crc16_table8_ready)
+		crc16_table8_init();
+
+	while (len >= 8) {
+		uint16_t x = crc ^ (buffer[0] | (buffer[1] << 8));
+
+		crc = crc16_table8[7][x & 0xff] ^ crc16_table8[6][x >> 8] ^
+		      crc16_table8[5][buffer[2]] ^ crc16_table8[4][buffer[3]] ^
+		      crc16_table8[3][buffer[4]] ^ crc16_table8[2][buffer[5]] ^
+		      crc16_table8[1][buffer[6]] ^ crc16_table8[0][buffer[7]];
+
+		buffer += 8;
+		len -= 8;
+	}
+#endif
+
 	while (len--)
 		crc = osmo_crc16_byte(crc, *buffer++);
 	return crc;
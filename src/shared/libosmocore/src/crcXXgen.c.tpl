@@ -31,6 +31,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 
 #include <osmocom/core/bits.h>
 #include <osmocom/core/crcXXgen.h>
@@ -53,7 +54,7 @@ osmo_crcXXgen_compute_bits(const struct osmo_crcXXgen_code *code,
 	for (i=0; i<len; i++) {
 		uintXX_t bit = in[i] & 1;
 		crc ^= (bit << n);
-		if (crc & (1 << n)) {
+		if (crc & ((uintXX_t)1 << n)) {
 			crc <<= 1;
 			crc ^= poly;
 		} else {
@@ -115,6 +116,177 @@ osmo_crcXXgen_set_bits(const struct osmo_crcXXgen_code *code,
 		crc_bits[i] = ((crc >> (code->bits-i-1)) & 1);
 }
 
+
+/* Table driven versions. They work on the CRC register shifted up to the
+ * MSB of a uintXX_t, which lets any CRC of up to XX bits be processed a
+ * whole byte at a time. */
+
+#define CRCXX_W		(sizeof(uintXX_t) * 8)
+
+/*! \brief Build the lookup tables for a CRC code
+ *  \param[out] tab Tables to initialize
+ *  \param[in] code Description of the CRC code, must outlive the tables
+ */
+void
+osmo_crcXXgen_table_init(struct osmo_crcXXgen_table *tab,
+                         const struct osmo_crcXXgen_code *code)
+{
+	const uintXX_t top = (uintXX_t)1 << (CRCXX_W - 1);
+	int i, j, k;
+
+	tab->code = code;
+	tab->poly = code->poly << (CRCXX_W - code->bits);
+
+	for (i=0; i<256; i++) {
+		uintXX_t crc = (uintXX_t)i << (CRCXX_W - 8);
+
+		for (j=0; j<8; j++) {
+			if (crc & top)
+				crc = (uintXX_t)(crc << 1) ^ tab->poly;
+			else
+				crc = (uintXX_t)(crc << 1);
+		}
+
+		tab->t[0][i] = crc;
+	}
+
+	/* t[k] is t[k-1] followed by one more zero byte */
+	for (k=1; k<8; k++) {
+		for (i=0; i<256; i++) {
+			uintXX_t crc = tab->t[k-1][i];
+			tab->t[k][i] = (uintXX_t)(crc << 8) ^
+			               tab->t[0][crc >> (CRCXX_W - 8)];
+		}
+	}
+}
+
+static inline uintXX_t
+_crcXX_byte(const struct osmo_crcXXgen_table *tab, uintXX_t crc, uint8_t byte)
+{
+	return (uintXX_t)(crc << 8) ^
+	       tab->t[0][(uint8_t)((crc >> (CRCXX_W - 8)) ^ byte)];
+}
+
+static inline uintXX_t
+_crcXX_block(const struct osmo_crcXXgen_table *tab, uintXX_t crc,
+             const uint8_t *in)
+{
+	uint8_t x[8];
+	uintXX_t r = 0;
+	int k;
+
+	/* The register is at most 8 bytes and gets fully shifted out */
+	memcpy(x, in, 8);
+	for (k=0; k<sizeof(uintXX_t); k++)
+		x[k] ^= crc >> (CRCXX_W - 8 * (k + 1));
+
+	for (k=0; k<8; k++)
+		r ^= tab->t[7-k][x[k]];
+
+	return r;
+}
+
+static inline uintXX_t
+_crcXX_bits(const struct osmo_crcXXgen_table *tab, uintXX_t crc,
+            uint8_t byte, int n)
+{
+	const uintXX_t top = (uintXX_t)1 << (CRCXX_W - 1);
+	int j;
+
+	/* n bits from the MSB of byte */
+	crc ^= (uintXX_t)byte << (CRCXX_W - 8);
+
+	for (j=0; j<n; j++) {
+		if (crc & top)
+			crc = (uintXX_t)(crc << 1) ^ tab->poly;
+		else
+			crc = (uintXX_t)(crc << 1);
+	}
+
+	return crc;
+}
+
+static inline uint8_t
+_crcXX_pack(const ubit_t *in, int n)
+{
+	uint8_t byte = 0;
+	int j;
+
+	for (j=0; j<n; j++)
+		byte |= (in[j] & 1) << (7 - j);
+
+	return byte;
+}
+
+static inline uint8_t
+_crcXX_pack8(const ubit_t *in)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	/* Gather the LSB of the 8 bytes into the top byte, first one as MSB */
+	uint64_t x;
+	memcpy(&x, in, 8);
+	return ((x & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56;
+#else
+	return _crcXX_pack(in, 8);
+#endif
+}
+
+/*! \brief Compute the CRC value of an array of hard-bits using tables
+ *  \param[in] tab Tables of the CRC code, see \ref osmo_crcXXgen_table_init
+ *  \param[in] in Input hard-bits array
+ *  \param[in] len Length of the array in bits
+ *
+ * Same result as \ref osmo_crcXXgen_compute_bits
+ */
+uintXX_t
+osmo_crcXXgen_table_compute_bits(const struct osmo_crcXXgen_table *tab,
+                                 const ubit_t *in, int len)
+{
+	const struct osmo_crcXXgen_code *code = tab->code;
+	uintXX_t crc = code->init << (CRCXX_W - code->bits);
+	uint8_t block[8];
+	int i, k;
+
+	for (i=0; i+64<=len; i+=64) {
+		for (k=0; k<8; k++)
+			block[k] = _crcXX_pack8(&in[i + 8 * k]);
+		crc = _crcXX_block(tab, crc, block);
+	}
+
+	for (; i+8<=len; i+=8)
+		crc = _crcXX_byte(tab, crc, _crcXX_pack8(&in[i]));
+
+	if (i < len)
+		crc = _crcXX_bits(tab, crc, _crcXX_pack(&in[i], len - i), len - i);
+
+	return (crc >> (CRCXX_W - code->bits)) ^ code->remainder;
+}
+
+/*! \brief Compute the CRC value of an array of packed bits using tables
+ *  \param[in] tab Tables of the CRC code, see \ref osmo_crcXXgen_table_init
+ *  \param[in] in Input packed bits, MSB first as in \ref osmo_pbit2ubit
+ *  \param[in] len Length of the input in bits
+ */
+uintXX_t
+osmo_crcXXgen_table_compute_pbits(const struct osmo_crcXXgen_table *tab,
+                                  const pbit_t *in, int len)
+{
+	const struct osmo_crcXXgen_code *code = tab->code;
+	uintXX_t crc = code->init << (CRCXX_W - code->bits);
+	int i, n_bytes = len >> 3;
+
+	for (i=0; i+8<=n_bytes; i+=8)
+		crc = _crcXX_block(tab, crc, &in[i]);
+
+	for (; i<n_bytes; i++)
+		crc = _crcXX_byte(tab, crc, in[i]);
+
+	if (len & 7)
+		crc = _crcXX_bits(tab, crc, in[n_bytes] & (0xff00 >> (len & 7)), len & 7);
+
+	return (crc >> (CRCXX_W - code->bits)) ^ code->remainder;
+}
+
 /*! }@ */
 
 /* vim: set syntax=c: */
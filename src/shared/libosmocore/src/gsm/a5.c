@@ -34,6 +34,9 @@
  *  \brief Osmocom GSM A5 ciphering algorithm implementation
  */
 
+#include "../../config.h"
+
+#include <errno.h>
 #include <string.h>
 
 #include <osmocom/gsm/a5.h>
@@ -364,4 +367,304 @@ osmo_a5_2(const uint8_t *key, uint32_t fn, ubit_t *dl, ubit_t *ul)
 	}
 }
 
+
+/* ------------------------------------------------------------------------ */
+/* Batch (bitsliced) A5/1 & A5/2                                            */
+/* ------------------------------------------------------------------------ */
+
+/* Each bit of the LFSRs is held in a word whose bit l belongs to frame l of
+ * the batch, so one pass runs A5_BATCH_LANES frames in parallel. The key
+ * load is common to all frames and the frame count load is done per frame
+ * with the scalar code above (all clocks are forced there), only the
+ * irregularly clocked part runs bitsliced. */
+
+#define A5_BATCH_LANES	256
+
+typedef uint64_t a5w_t __attribute__((vector_size(A5_BATCH_LANES / 8)));
+
+#define A5W_ELEMS	(A5_BATCH_LANES / 64)
+
+/* Offsets of the registers in the bitsliced state */
+#define A5B_R1		0
+#define A5B_R2		(A5B_R1 + A5_R1_LEN)
+#define A5B_R3		(A5B_R2 + A5_R2_LEN)
+#define A5B_R4		(A5B_R3 + A5_R3_LEN)
+#define A5B_BITS	(A5B_R4 + A5_R4_LEN)
+
+/* Output bits, padded to whole bytes */
+#define A5B_OUT_BITS	(OSMO_A5_BATCH_BYTES * 8)
+
+/*! \brief Conditionally clock one bitsliced LFSR
+ *  \param[in,out] r Register bits, LSB first
+ *  \param[in] len Register length
+ *  \param[in] fb Feedback bit (computed before the shift)
+ *  \param[in] clk Lanes that are clocked
+ */
+static inline __attribute__((always_inline)) void
+_a5b_clock(a5w_t *r, int len, const a5w_t *fb, const a5w_t *clk)
+{
+	int k;
+
+	for (k=len-1; k>0; k--)
+		r[k] ^= *clk & (r[k] ^ r[k-1]);
+
+	r[0] ^= *clk & (r[0] ^ *fb);
+}
+
+/*! \brief Majority of three bitsliced bits */
+#define A5B_MAJ(a, b, c) (((a) & (b)) | ((a) & (c)) | ((b) & (c)))
+
+static inline __attribute__((always_inline)) void
+_a5b_clock_123(a5w_t *R, const a5w_t *c1, const a5w_t *c2, const a5w_t *c3)
+{
+	a5w_t *r1 = &R[A5B_R1], *r2 = &R[A5B_R2], *r3 = &R[A5B_R3];
+	a5w_t fb;
+
+	fb = r1[13] ^ r1[16] ^ r1[17] ^ r1[18];
+	_a5b_clock(r1, A5_R1_LEN, &fb, c1);
+
+	fb = r2[20] ^ r2[21];
+	_a5b_clock(r2, A5_R2_LEN, &fb, c2);
+
+	fb = r3[7] ^ r3[20] ^ r3[21] ^ r3[22];
+	_a5b_clock(r3, A5_R3_LEN, &fb, c3);
+}
+
+static inline __attribute__((always_inline)) void
+_a5b_1_clock(a5w_t *R)
+{
+	a5w_t b1 = R[A5B_R1 + 8], b2 = R[A5B_R2 + 10], b3 = R[A5B_R3 + 10];
+	a5w_t maj = A5B_MAJ(b1, b2, b3);
+	a5w_t c1 = ~(maj ^ b1), c2 = ~(maj ^ b2), c3 = ~(maj ^ b3);
+
+	_a5b_clock_123(R, &c1, &c2, &c3);
+}
+
+static inline __attribute__((always_inline)) void
+_a5b_2_clock(a5w_t *R)
+{
+	a5w_t *r4 = &R[A5B_R4];
+	a5w_t b1 = r4[10], b2 = r4[3], b3 = r4[7];
+	a5w_t maj = A5B_MAJ(b1, b2, b3);
+	a5w_t c1 = ~(maj ^ b1), c2 = ~(maj ^ b2), c3 = ~(maj ^ b3);
+	a5w_t fb = r4[11] ^ r4[16];
+	int k;
+
+	_a5b_clock_123(R, &c1, &c2, &c3);
+
+	for (k=A5_R4_LEN-1; k>0; k--)
+		r4[k] = r4[k-1];
+	r4[0] = fb;
+}
+
+static inline __attribute__((always_inline)) void
+_a5b_output(int n, const a5w_t *R, a5w_t *o)
+{
+	const a5w_t *r1 = &R[A5B_R1], *r2 = &R[A5B_R2], *r3 = &R[A5B_R3];
+
+	*o = r1[18] ^ r2[21] ^ r3[22];
+
+	if (n == 2)
+		*o ^=	A5B_MAJ( r1[15], ~r1[14],  r1[12]) ^
+			A5B_MAJ(~r2[16],  r2[13],  r2[9])  ^
+			A5B_MAJ( r3[18],  r3[16], ~r3[13]);
+}
+
+/*! \brief Write bitsliced output words as packed bits, one row per lane */
+static void
+_a5b_store(const uint64_t (*o)[A5W_ELEMS], unsigned int lanes, pbit_t *out)
+{
+	unsigned int g, j, b, c;
+
+	for (g=0; g<lanes; g+=8) {
+		for (j=0; j<OSMO_A5_BATCH_BYTES; j++) {
+			uint64_t x = 0, t;
+
+			/* 8x8 bit block: bit c of byte 7-b is output bit
+			 * 8j+b of lane g+c, transposed so that byte c holds
+			 * the output byte of lane g+c */
+			for (b=0; b<8; b++)
+				x |= ((o[8*j+b][g>>6] >> (g&63)) & 0xff) << (8*(7-b));
+
+			t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+			x = x ^ t ^ (t << 7);
+			t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+			x = x ^ t ^ (t << 14);
+			t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+			x = x ^ t ^ (t << 28);
+
+			for (c=0; c<8 && g+c<lanes; c++)
+				out[(g+c) * OSMO_A5_BATCH_BYTES + j] = x >> (8*c);
+		}
+	}
+}
+
+static inline __attribute__((always_inline)) void
+_a5_batch_core(int n, const uint32_t (*st)[4], unsigned int lanes,
+               pbit_t *dl, pbit_t *ul)
+{
+	static const int reg_ofs[4] = { A5B_R1, A5B_R2, A5B_R3, A5B_R4 };
+	a5w_t R[A5B_BITS], o[A5B_OUT_BITS];
+	unsigned int l;
+	int i, j;
+
+	/* Transpose the per-frame states */
+	memset(R, 0, sizeof(R));
+
+	for (l=0; l<lanes; l++) {
+		for (j=0; j<(n == 2 ? 4 : 3); j++) {
+			uint32_t v = st[l][j];
+			while (v) {
+				R[reg_ofs[j] + __builtin_ctz(v)][l>>6] |= 1ULL << (l&63);
+				v &= v - 1;
+			}
+		}
+	}
+
+	/* Mix */
+	for (i=0; i<(n == 2 ? 99 : 100); i++) {
+		if (n == 2)
+			_a5b_2_clock(R);
+		else
+			_a5b_1_clock(R);
+	}
+
+	/* Output, DL then UL */
+	memset(&o[114], 0, sizeof(a5w_t) * (A5B_OUT_BITS - 114));
+
+	for (j=0; j<2; j++) {
+		pbit_t *out = j ? ul : dl;
+
+		for (i=0; i<114; i++) {
+			if (n == 2)
+				_a5b_2_clock(R);
+			else
+				_a5b_1_clock(R);
+			_a5b_output(n, R, &o[i]);
+		}
+
+		if (out)
+			_a5b_store((const uint64_t (*)[A5W_ELEMS]) o, lanes, out);
+	}
+}
+
+static void
+_a5_batch_generic(int n, const uint32_t (*st)[4], unsigned int lanes,
+                  pbit_t *dl, pbit_t *ul)
+{
+	_a5_batch_core(n, st, lanes, dl, ul);
+}
+
+#ifdef HAVE_X86_SIMD
+__attribute__((target("avx2")))
+static void
+_a5_batch_avx2(int n, const uint32_t (*st)[4], unsigned int lanes,
+               pbit_t *dl, pbit_t *ul)
+{
+	_a5_batch_core(n, st, lanes, dl, ul);
+}
+#endif
+
+/*! \brief Generate A5/x cipher streams for many frames of the same key
+ *  \param[in] n Which A5/x method to use (0, 1 or 2)
+ *  \param[in] key 8 byte array for the key (as received from the SIM)
+ *  \param[in] fn Array of \a num frame numbers
+ *  \param[in] num Number of frames
+ *  \param[out] dl Downlink cipher streams, packed (or NULL)
+ *  \param[out] ul Uplink cipher streams, packed (or NULL)
+ *  \returns 0 on success, -ENOTSUP for an unsupported A5/x
+ *
+ * The cipher stream of frame \a fn[i] goes to the OSMO_A5_BATCH_BYTES bytes
+ * at offset i * OSMO_A5_BATCH_BYTES of \a dl and \a ul, as packed bits
+ * (MSB first, the last 6 bits zero). The result is the same as osmo_a5()
+ * followed by osmo_ubit2pbit(), but up to 256 frames are computed at once
+ * by a bitsliced implementation.
+ */
+int
+osmo_a5_batch(int n, const uint8_t *key, const uint32_t *fn, unsigned int num,
+              pbit_t *dl, pbit_t *ul)
+{
+	void (*kernel)(int, const uint32_t (*)[4], unsigned int, pbit_t *, pbit_t *);
+	uint32_t r_key[4] = {0, 0, 0, 0};
+	uint32_t st[A5_BATCH_LANES][4];
+	unsigned int ofs, lanes, l;
+	uint32_t b, fn_count;
+	int i, j;
+
+	if (n == 0) {
+		if (dl)
+			memset(dl, 0x00, num * OSMO_A5_BATCH_BYTES);
+		if (ul)
+			memset(ul, 0x00, num * OSMO_A5_BATCH_BYTES);
+		return 0;
+	}
+
+	if (n != 1 && n != 2)
+		return -ENOTSUP;
+
+	kernel = _a5_batch_generic;
+#ifdef HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		kernel = _a5_batch_avx2;
+#endif
+
+	/* Key load, common to all frames */
+	for (i=0; i<64; i++)
+	{
+		b = ( key[7 - (i>>3)] >> (i&7) ) & 1;
+
+		if (n == 2)
+			_a5_2_clock(r_key, 1);
+		else
+			_a5_1_clock(r_key, 1);
+
+		for (j=0; j<4; j++)
+			r_key[j] ^= b;
+	}
+
+	for (ofs=0; ofs<num; ofs+=lanes)
+	{
+		lanes = num - ofs;
+		if (lanes > A5_BATCH_LANES)
+			lanes = A5_BATCH_LANES;
+
+		/* Frame count load, per frame */
+		for (l=0; l<lanes; l++)
+		{
+			uint32_t *r = st[l];
+
+			memcpy(r, r_key, sizeof(r_key));
+
+			fn_count = osmo_a5_fn_count(fn[ofs + l]);
+
+			for (i=0; i<22; i++)
+			{
+				b = (fn_count >> i) & 1;
+
+				if (n == 2)
+					_a5_2_clock(r, 1);
+				else
+					_a5_1_clock(r, 1);
+
+				for (j=0; j<4; j++)
+					r[j] ^= b;
+			}
+
+			if (n == 2) {
+				r[0] |= 1 << 15;
+				r[1] |= 1 << 16;
+				r[2] |= 1 << 18;
+				r[3] |= 1 << 10;
+			}
+		}
+
+		kernel(n, (const uint32_t (*)[4]) st, lanes,
+		       dl ? &dl[ofs * OSMO_A5_BATCH_BYTES] : NULL,
+		       ul ? &ul[ofs * OSMO_A5_BATCH_BYTES] : NULL);
+	}
+
+	return 0;
+}
+
 /*! }@ */
@@ -102,16 +102,26 @@ static unsigned char gsm_7bit_alphabet[] = {
 	0xff, 0x7d, 0x08, 0xff, 0xff, 0xff, 0x7c, 0xff, 0x0c, 0x06, 0xff, 0xff, 0x7e, 0xff, 0xff
 };
 
-/* GSM 03.38 6.2.1 Character lookup for decoding */
-static int gsm_septet_lookup(uint8_t ch)
-{
-	int i = 0;
-	for (; i < sizeof(gsm_7bit_alphabet); i++) {
-		if (gsm_7bit_alphabet[i] == ch)
-			return i;
-	}
-	return -1;
-}
+/* GSM 03.38 6.2.1 Character lookup for decoding, the first character
+ * of gsm_7bit_alphabet mapping to each septet, 0xff if there is none */
+static const unsigned char gsm_septet_lookup[128] = {
+	0x40, 0xa3, 0x24, 0xa5, 0xe8, 0xe9, 0xf9, 0xec,
+	0xf2, 0xc7, 0x0a, 0xd8, 0x89, 0x0d, 0xc5, 0xe5,
+	0xff, 0x5f, 0xff, 0xff, 0x5e, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xc6, 0xe6, 0xdf, 0xc9,
+	0x20, 0x21, 0x22, 0x23, 0xff, 0x25, 0x26, 0x27,
+	0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+	0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+	0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+	0x7c, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47,
+	0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+	0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57,
+	0x58, 0x59, 0x5a, 0xbb, 0xae, 0xbd, 0x93, 0xff,
+	0xff, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67,
+	0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+	0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+	0x78, 0x79, 0x7a, 0xa7, 0xbf, 0xa8, 0xbc, 0xe0,
+};
 
 /* Compute the number of octets from the number of septets, for instance: 47 septets needs 41,125 = 42 octets */
 uint8_t gsm_get_octet_len(const uint8_t sept_len){
@@ -122,14 +132,52 @@ uint8_t gsm_get_octet_len(const uint8_t sept_len){
 	return octet_len;
 }
 
+static inline uint64_t load_le64(const uint8_t *p)
+{
+	uint64_t w;
+
+	memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	return w;
+}
+
+static inline void store_le64(uint8_t *p, uint64_t w)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	w = __builtin_bswap64(w);
+#endif
+	memcpy(p, &w, sizeof(w));
+}
+
+/* 8 septets in the low 7 bits of each octet <-> 56 bit word */
+static inline uint64_t septets_pack(uint64_t w)
+{
+	w &= 0x7f7f7f7f7f7f7f7fULL;
+	w = (w & 0x007f007f007f007fULL) | ((w & 0x7f007f007f007f00ULL) >> 1);
+	w = (w & 0x00003fff00003fffULL) | ((w & 0x3fff00003fff0000ULL) >> 2);
+	w = (w & 0x000000000fffffffULL) | ((w & 0x0fffffff00000000ULL) >> 4);
+
+	return w;
+}
+
+static inline uint64_t septets_unpack(uint64_t w)
+{
+	w = (w & 0x000000000fffffffULL) | ((w & 0x00fffffff0000000ULL) << 4);
+	w = (w & 0x00003fff00003fffULL) | ((w & 0x0fffc0000fffc000ULL) << 2);
+	w = (w & 0x007f007f007f007fULL) | ((w & 0x3f803f803f803f80ULL) << 1);
+
+	return w;
+}
+
 /* GSM 03.38 6.2.1 Character unpacking */
 int gsm_7bit_decode_hdr(char *text, const uint8_t *user_data, uint8_t septet_l, uint8_t ud_hdr_ind)
 {
 	int i = 0;
 	int shift = 0;
-
-	uint8_t *rtext = calloc(septet_l, sizeof(uint8_t));
-	uint8_t tmp;
+	int octet_l = gsm_get_octet_len(septet_l);
+	uint8_t rtext[256];
 
 	/* skip the user data header */
 	if (ud_hdr_ind) {
@@ -140,7 +188,18 @@ int gsm_7bit_decode_hdr(char *text, const uint8_t *user_data, uint8_t septet_l,
 		septet_l = septet_l - shift;
 	}
 
-	for (i = 0; i < septet_l; i++) {
+	/* 7 octets to 8 septets at a time, as long as the 8 octets loaded
+	 * are part of the user data */
+	for (i = 0; i + 8 <= septet_l; i += 8) {
+		int bit = (i + shift) * 7;
+
+		if ((bit >> 3) + 8 > octet_l)
+			break;
+		store_le64(rtext + i, septets_unpack(
+				load_le64(user_data + (bit >> 3)) >> (bit & 7)));
+	}
+
+	for (; i < septet_l; i++) {
 		rtext[i] =
 			((user_data[((i + shift) * 7 + 7) >> 3] <<
 			  (7 - (((i + shift) * 7 + 7) & 7))) |
@@ -151,19 +210,17 @@ int gsm_7bit_decode_hdr(char *text, const uint8_t *user_data, uint8_t septet_l,
 	for (i = 0; i < septet_l; i++) {
 		/* this is an extension character */
 		if(rtext[i] == 0x1b && i + 1 < septet_l){
-			tmp = rtext[i+1];
-			*(text++) = gsm_7bit_alphabet[0x7f + tmp];
+			*(text++) = gsm_7bit_alphabet[0x7f + rtext[i+1]];
 			i++;
 			continue;
 		}
 
-		*(text++) = gsm_septet_lookup(rtext[i]);
+		*(text++) = gsm_septet_lookup[rtext[i]];
 	}
 
 	if (ud_hdr_ind)
 		i += shift;
 	*text = '\0';
-	free(rtext);
 
 	return i;
 }
@@ -176,10 +233,10 @@ int gsm_7bit_decode(char *text, const uint8_t *user_data, uint8_t septet_l)
 /* GSM 03.38 6.2.1 Prepare character packing */
 int gsm_septet_encode(uint8_t *result, const char *data)
 {
-	int i, y = 0;
+	int y = 0;
 	uint8_t ch;
-	for (i = 0; i < strlen(data); i++) {
-		ch = data[i];
+
+	for (; (ch = *data); data++) {
 		switch(ch){
 		/* fall-through for extension characters */
 		case 0x0c:
@@ -202,47 +259,43 @@ int gsm_septet_encode(uint8_t *result, const char *data)
 	return y;
 }
 
-/* 7bit to octet packing */
+/* 7bit to octet packing, 'padding' zero bits are put in front of the
+ * first septet */
 int gsm_septets2octets(uint8_t *result, uint8_t *rdata, uint8_t septet_len, uint8_t padding){
-	int i = 0, z = 0;
-	uint8_t cb, nb;
-	int shift = 0;
-	uint8_t *data = calloc(septet_len + 1, sizeof(uint8_t));
-
-	if (padding) {
-		shift = 7 - padding;
-		/* the first zero is needed for padding */
-		memcpy(data + 1, rdata, septet_len);
-		septet_len++;
-	} else
-		memcpy(data, rdata, septet_len);
-
-	for (i = 0; i < septet_len; i++) {
-		if (shift == 7) {
-			/*
-			 * special end case with the. This is necessary if the
-			 * last septet fits into the previous octet. E.g. 48
-			 * non-extension characters:
-			 *   ....ag ( a = 1100001, g = 1100111)
-			 * result[40] = 100001 XX, result[41] = 1100111 1 */
-			if (i + 1 < septet_len) {
-				shift = 0;
-				continue;
-			} else if (i + 1 == septet_len)
-				break;
+	int i = 0, k, z = 0;
+	int bits = padding;
+	uint64_t acc = 0;
+
+	for (; bits >= 8; bits -= 8)
+		result[z++] = 0;
+
+	/* 8 septets to 7 octets at a time, the 'bits' (< 8) bits left
+	 * over stay in the accumulator */
+	for (i = 0; i + 8 <= septet_len; i += 8) {
+		acc |= septets_pack(load_le64(rdata + i)) << bits;
+		/* the 8th octet is overwritten by the next septets */
+		if (i + 8 < septet_len)
+			store_le64(result + z, acc);
+		else {
+			for (k = 0; k < 7; k++)
+				result[z + k] = acc >> (k * 8);
 		}
+		z += 7;
+		acc >>= 56;
+	}
 
-		cb = (data[i] & 0x7f) >> shift;
-		if (i + 1 < septet_len) {
-			nb = (data[i + 1] & 0x7f) << (7 - shift);
-			cb = cb | nb;
+	for (; i < septet_len; i++) {
+		acc |= (uint64_t) (rdata[i] & 0x7f) << bits;
+		bits += 7;
+		while (bits >= 8) {
+			result[z++] = acc;
+			acc >>= 8;
+			bits -= 8;
 		}
-
-		result[z++] = cb;
-		shift++;
 	}
 
-	free(data);
+	if (bits)
+		result[z++] = acc;
 
 	return z;
 }
@@ -251,12 +304,18 @@ int gsm_septets2octets(uint8_t *result, uint8_t *rdata, uint8_t septet_len, uint
 int gsm_7bit_encode(uint8_t *result, const char *data)
 {
 	int y = 0, z = 0;
+	size_t len = strlen(data);
+	uint8_t buf[2 * 160];
+	uint8_t *rdata = buf;
+
 	/* prepare for the worst case, every character expanding to two bytes */
-	uint8_t *rdata = calloc(strlen(data) * 2, sizeof(uint8_t));
+	if (len * 2 > sizeof(buf))
+		rdata = calloc(len * 2, sizeof(uint8_t));
 	y = gsm_septet_encode(rdata, data);
 	z = gsm_septets2octets(result, rdata, y, 0);
 
-	free(rdata);
+	if (rdata != buf)
+		free(rdata);
 
 	/*
 	 * We don't care about the number of octets (z), because they are not
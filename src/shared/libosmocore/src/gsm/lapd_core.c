@@ -81,6 +81,7 @@
 #include <osmocom/core/msgb.h>
 #include <osmocom/core/utils.h>
 #include <osmocom/core/talloc.h>
+#include <osmocom/core/rate_ctr.h>
 #include <osmocom/gsm/lapd_core.h>
 
 /* TS 04.06 Table 4 / Section 3.8.1 */
@@ -572,6 +573,8 @@ static void lapd_t200_cb(void *data)
 		lapd_send_resend(dl);
 		/* increment re-transmission counter */
 		dl->retrans_ctr++;
+		if (dl->ctr_retrans)
+			rate_ctr_inc(dl->ctr_retrans);
 		/* restart T200 (PH-READY-TO-SEND) */
 		lapd_start_t200(dl);
 		break;
@@ -596,6 +599,8 @@ static void lapd_t200_cb(void *data)
 		lapd_send_resend(dl);
 		/* increment re-transmission counter */
 		dl->retrans_ctr++;
+		if (dl->ctr_retrans)
+			rate_ctr_inc(dl->ctr_retrans);
 		/* restart T200 (PH-READY-TO-SEND) */
 		lapd_start_t200(dl);
 		break;
@@ -609,6 +614,9 @@ static void lapd_t200_cb(void *data)
 		if (dl->retrans_ctr < dl->n200) {
 			uint8_t vs = sub_mod(dl->v_send, 1, dl->v_range);
 			uint8_t h = do_mod(vs, dl->range_hist);
+
+			if (dl->ctr_retrans)
+				rate_ctr_inc(dl->ctr_retrans);
 			/* retransmit I frame (V_s-1) with P=1, if any */
 			if (dl->tx_hist[h].msg) {
 				struct msgb *msg;
@@ -166,6 +166,78 @@ int tlv_parse(struct tlv_parsed *dec, const struct tlv_definition *def,
 	return num_parsed;
 }
 
+const struct tlv_p_entry tlv_sparse_none;
+
+static inline int tlv_sparse_add(struct tlv_sparse *dec, uint8_t tag,
+				 uint16_t len, const uint8_t *val)
+{
+	if (dec->num >= TLV_SPARSE_MAX_IE)
+		return -4;
+	dec->tag[dec->num] = tag;
+	dec->ie[dec->num].len = len;
+	dec->ie[dec->num].val = val;
+	dec->num++;
+
+	return 0;
+}
+
+/*! \brief Parse an entire buffer of TLV encoded IEs into a \ref tlv_sparse
+ *  \param[out] dec caller-allocated pointer to \ref tlv_sparse
+ *  \param[in] def structure defining the valid TLV tags / configurations
+ *  \param[in] buf the input data buffer to be parsed
+ *  \param[in] buf_len length of the input data buffer
+ *  \param[in] lv_tag an initial LV tag at the start of the buffer
+ *  \param[in] lv_tag2 a second initial LV tag following the \a lv_tag
+ *  \returns number of IEs parsed, -4 if there are more than
+ *  \ref TLV_SPARSE_MAX_IE, other negative values like \ref tlv_parse
+ *
+ * Same as \ref tlv_parse, use TLVS_PRESENT(), TLVS_LEN() and TLVS_VAL()
+ * on the result.
+ */
+int tlv_parse_sparse(struct tlv_sparse *dec, const struct tlv_definition *def,
+		     const uint8_t *buf, int buf_len, uint8_t lv_tag,
+		     uint8_t lv_tag2)
+{
+	int ofs = 0, rv;
+	uint16_t len;
+
+	dec->num = 0;
+
+	if (lv_tag) {
+		if (ofs > buf_len)
+			return -1;
+		len = buf[ofs] + 1;
+		if (ofs + len > buf_len)
+			return -2;
+		tlv_sparse_add(dec, lv_tag, buf[ofs], &buf[ofs+1]);
+		ofs += len;
+	}
+	if (lv_tag2) {
+		if (ofs > buf_len)
+			return -1;
+		len = buf[ofs] + 1;
+		if (ofs + len > buf_len)
+			return -2;
+		tlv_sparse_add(dec, lv_tag2, buf[ofs], &buf[ofs+1]);
+		ofs += len;
+	}
+
+	while (ofs < buf_len) {
+		uint8_t tag;
+		const uint8_t *val;
+
+		rv = tlv_parse_one(&tag, &len, &val, def,
+		                   &buf[ofs], buf_len-ofs);
+		if (rv < 0)
+			return rv;
+		if (tlv_sparse_add(dec, tag, len, val) < 0)
+			return -4;
+		ofs += rv;
+	}
+
+	return dec->num;
+}
+
 /*! \brief take a master (src) tlvdev and fill up all empty slots in 'dst' */
 void tlv_def_patch(struct tlv_definition *dst, const struct tlv_definition *src)
 {
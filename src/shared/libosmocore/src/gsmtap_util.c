@@ -47,6 +47,8 @@
  */
 /*! \file gsmtap_util.c */
 
+#define GSMTAP_WQ_BATCH	32
+
 
 /*! \brief convert RSL channel number to GSMTAP channel type
  *  \param[in] rsl_cantype RSL channel type
@@ -264,24 +266,6 @@ int gsmtap_send(struct gsmtap_inst *gti, uint16_t arfcn, uint8_t ts,
 		signal_dbm, snr, data, len);
 }
 
-/* Callback from select layer if we can write to the socket */
-static int gsmtap_wq_w_cb(struct osmo_fd *ofd, struct msgb *msg)
-{
-	int rc;
-
-	rc = write(ofd->fd, msg->data, msg->len);
-	if (rc < 0) {
-		perror("writing msgb to gsmtap fd");
-		return rc;
-	}
-	if (rc != msg->len) {
-		perror("short write to gsmtap fd");
-		return -EIO;
-	}
-
-	return 0;
-}
-
 /* Callback from select layer if we can read from the sink socket */
 static int gsmtap_sink_fd_cb(struct osmo_fd *fd, unsigned int flags)
 {
@@ -350,8 +334,8 @@ struct gsmtap_inst *gsmtap_source_init(const char *host, uint16_t port,
 	gti->sink_ofd.fd = -1;
 
 	if (ofd_wq_mode) {
-		osmo_wqueue_init(&gti->wq, 64);
-		gti->wq.write_cb = &gsmtap_wq_w_cb;
+		/* all queued frames go out with one sendmmsg() */
+		osmo_wqueue_init_batch(&gti->wq, 64, GSMTAP_WQ_BATCH);
 
 		osmo_fd_register(&gti->wq.bfd);
 	}
@@ -43,11 +43,19 @@
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/utils.h>
 #include <osmocom/core/logging.h>
+#include <osmocom/core/timer.h>
 
 #include <osmocom/vty/logging.h>	/* for LOGGING_STR. */
 
 struct log_info *osmo_log_info;
 
+/*! \brief lowest level any registered target outputs, per category
+ *
+ * Indexed like the categories of a target, 0xff if no target outputs
+ * the category at all.  Kept up to date by the functions changing
+ * targets, see \ref log_update_level_summary */
+uint8_t *osmo_log_level_summary;
+
 static struct log_context log_context;
 static void *tall_log_ctx = NULL;
 LLIST_HEAD(osmo_log_target_list);
@@ -203,6 +211,7 @@ void log_parse_category_mask(struct log_target* target, const char *_mask)
 	} while ((category_token = strtok(NULL, ":")));
 
 	free(mask);
+	log_update_level_summary();
 }
 
 static const char* color(int subsys)
@@ -213,6 +222,12 @@ static const char* color(int subsys)
 	return NULL;
 }
 
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+/* in logging_async.c */
+void _log_target_async_stamp(struct log_target *target, unsigned int ofs);
+void _log_target_async_destroy(struct log_target *target);
+#endif
+
 static void _output(struct log_target *target, unsigned int subsys,
 		    unsigned int level, char *file, int line, int cont,
 		    const char *format, va_list ap)
@@ -231,12 +246,26 @@ static void _output(struct log_target *target, unsigned int subsys,
 		}
 	}
 	if (!cont) {
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+		if (target->print_timestamp &&
+		    target->type == LOG_TGT_TYPE_ASYNC) {
+			/* formatted by the writer thread */
+			_log_target_async_stamp(target, offset);
+		} else
+#endif
 		if (target->print_timestamp) {
-			char *timestr;
-			time_t tm;
-			tm = time(NULL);
-			timestr = ctime(&tm);
-			timestr[strlen(timestr)-1] = '\0';
+			/* ctime() only changes once a second */
+			static char timestr[32];
+			static time_t timestr_sec = -1;
+			struct timeval tv;
+			osmo_gettimeofday(&tv, NULL);
+			if (tv.tv_sec != timestr_sec) {
+				time_t tm = tv.tv_sec;
+				char *s = ctime(&tm);
+				snprintf(timestr, sizeof(timestr), "%.*s",
+					 (int)strlen(s) - 1, s);
+				timestr_sec = tv.tv_sec;
+			}
 			ret = snprintf(buf + offset, rem, "%s ", timestr);
 			if (ret < 0)
 				goto err;
@@ -272,8 +301,12 @@ void osmo_vlogp(int subsys, int level, char *file, int line,
 	if (subsys < 0)
 		subsys = subsys_lib2index(subsys);
 
-	if (subsys > osmo_log_info->num_cat)
-		subsys = DLGLOBAL;
+	if (subsys >= osmo_log_info->num_cat)
+		subsys = subsys_lib2index(DLGLOBAL);
+
+	/* no target is interested */
+	if (level < osmo_log_level_summary[subsys])
+		return;
 
 	llist_for_each_entry(tar, &osmo_log_target_list, entry) {
 		struct log_category *category;
@@ -309,7 +342,12 @@ void osmo_vlogp(int subsys, int level, char *file, int line,
 		 * in undefined state. Since _output uses vsnprintf and it may
 		 * be called several times, we have to pass a copy of ap. */
 		va_copy(bp, ap);
-		_output(tar, subsys, level, file, line, cont, format, bp);
+		if (tar->raw_output)
+			tar->raw_output(tar, subsys, level, file, line, cont,
+					format, bp);
+		else
+			_output(tar, subsys, level, file, line, cont, format,
+				bp);
 		va_end(bp);
 	}
 }
@@ -339,6 +377,7 @@ void logp2(int subsys, unsigned int level, char *file, int line, int cont, const
 void log_add_target(struct log_target *target)
 {
 	llist_add_tail(&target->entry, &osmo_log_target_list);
+	log_update_level_summary();
 }
 
 /*! \brief Unregister a log target from the logging core
@@ -347,6 +386,50 @@ void log_add_target(struct log_target *target)
 void log_del_target(struct log_target *target)
 {
 	llist_del(&target->entry);
+	/* may be called again for an already removed target */
+	INIT_LLIST_HEAD(&target->entry);
+	log_update_level_summary();
+}
+
+/*! \brief Recompute the per-category level summary
+ *
+ * The summary is what \ref LOGP checks before evaluating its
+ * arguments.  All log_set_* functions take care of it, this only
+ * needs to be called after modifying target->categories or
+ * target->loglevel directly.
+ */
+void log_update_level_summary(void)
+{
+	struct log_target *tar;
+	int i;
+
+	if (!osmo_log_level_summary)
+		return;
+
+	memset(osmo_log_level_summary, 0xff, osmo_log_info->num_cat);
+
+	llist_for_each_entry(tar, &osmo_log_target_list, entry) {
+		/* nothing passes the filters, see osmo_vlogp() */
+		if (!(tar->filter_map & LOG_FILTER_ALL) &&
+		    !osmo_log_info->filter_fn)
+			continue;
+
+		for (i = 0; i < osmo_log_info->num_cat; i++) {
+			const struct log_category *cat = &tar->categories[i];
+			uint8_t level;
+
+			if (!cat->enabled)
+				continue;
+
+			if (tar->loglevel != 0)
+				level = tar->loglevel;
+			else
+				level = cat->loglevel;
+
+			if (level < osmo_log_level_summary[i])
+				osmo_log_level_summary[i] = level;
+		}
+	}
 }
 
 /*! \brief Reset (clear) the logging context */
@@ -389,6 +472,8 @@ void log_set_all_filter(struct log_target *target, int all)
 		target->filter_map |= LOG_FILTER_ALL;
 	else
 		target->filter_map &= ~LOG_FILTER_ALL;
+
+	log_update_level_summary();
 }
 
 /*! \brief Enable or disable the use of colored output
@@ -416,6 +501,7 @@ void log_set_print_timestamp(struct log_target *target, int print_timestamp)
 void log_set_log_level(struct log_target *target, int log_level)
 {
 	target->loglevel = log_level;
+	log_update_level_summary();
 }
 
 void log_set_category_filter(struct log_target *target, int category,
@@ -425,6 +511,7 @@ void log_set_category_filter(struct log_target *target, int category,
 		return;
 	target->categories[category].enabled = !!enable;
 	target->categories[category].loglevel = level;
+	log_update_level_summary();
 }
 
 static void _file_output(struct log_target *target, unsigned int level,
@@ -529,12 +616,26 @@ struct log_target *log_target_find(int type, const char *fname)
 		if (tgt->type == LOG_TGT_TYPE_FILE) {
 			if (!strcmp(fname, tgt->tgt_file.fname))
 				return tgt;
+		} else if (tgt->type == LOG_TGT_TYPE_BINARY) {
+			if (!strcmp(fname, tgt->tgt_binary.fname))
+				return tgt;
+		} else if (tgt->type == LOG_TGT_TYPE_ASYNC) {
+			/* NULL for the one writing to stderr */
+			if (!fname && !tgt->tgt_async.fname)
+				return tgt;
+			if (fname && tgt->tgt_async.fname &&
+			    !strcmp(fname, tgt->tgt_async.fname))
+				return tgt;
 		} else
 			return tgt;
 	}
 	return NULL;
 }
 
+/* in logging_binary.c */
+void _log_target_binary_destroy(struct log_target *target);
+int _log_target_binary_reopen(struct log_target *target);
+
 /*! \brief Unregister, close and delete a log target */
 void log_target_destroy(struct log_target *target)
 {
@@ -542,6 +643,13 @@ void log_target_destroy(struct log_target *target)
 	/* just in case, to make sure we don't have any references */
 	log_del_target(target);
 
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+	if (target->type == LOG_TGT_TYPE_ASYNC)
+		_log_target_async_destroy(target);
+#endif
+	if (target->type == LOG_TGT_TYPE_BINARY)
+		_log_target_binary_destroy(target);
+
 	if (target->output == &_file_output) {
 /* since C89/C99 says stderr is a macro, we can safely do this! */
 #ifdef stderr
@@ -560,6 +668,13 @@ void log_target_destroy(struct log_target *target)
 /*! \brief close and re-open a log file (for log file rotation) */
 int log_target_file_reopen(struct log_target *target)
 {
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+	if (target->type == LOG_TGT_TYPE_ASYNC)
+		return log_target_async_reopen(target);
+#endif
+	if (target->type == LOG_TGT_TYPE_BINARY)
+		return _log_target_binary_reopen(target);
+
 	fclose(target->tgt_file.out);
 
 	target->tgt_file.out = fopen(target->tgt_file.fname, "a");
@@ -751,6 +866,15 @@ int log_init(const struct log_info *inf, void *ctx)
 			&internal_cat[i], sizeof(struct log_info_cat));
 	}
 
+	osmo_log_level_summary = talloc_array(osmo_log_info, uint8_t,
+					      osmo_log_info->num_cat);
+	if (!osmo_log_level_summary) {
+		talloc_free(osmo_log_info);
+		osmo_log_info = NULL;
+		return -ENOMEM;
+	}
+	log_update_level_summary();
+
 	return 0;
 }
 
@@ -0,0 +1,594 @@
+/* Asynchronous, ring buffered logging target */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \addtogroup logging
+ *  @{
+ */
+
+/*! \file logging_async.c
+ *
+ * The output callback of this target only copies the formatted line
+ * into a ring buffer.  A writer thread drains the ring into the file,
+ * so a slow disk or terminal doesn't stall the main loop.  The ring
+ * has exactly one producer (the thread running the osmocom main loop)
+ * and one consumer (the writer), so head and tail only need ordered
+ * loads and stores, the mutex is only taken to sleep and wake up.
+ *
+ * The timestamp of a line is taken when it is logged, but only kept as
+ * seconds and microseconds in the record.  The writer formats it.
+ */
+
+#include "../config.h"
+
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/timer.h>
+
+/* record header, the line follows, padded to REC_ALIGN */
+struct rec_hdr {
+	uint32_t len;		/* or REC_WRAP */
+	uint32_t stamp_ofs;	/* where the timestamp goes in the line */
+	struct timeval stamp;
+};
+
+#define REC_HDR		sizeof(struct rec_hdr)
+#define REC_ALIGN	8
+#define REC_WRAP	0xffffffff	/* rest of the ring is unused */
+#define REC_NO_STAMP	0xffffffff
+
+/* The writer is only woken up once the ring is a quarter full, else it
+ * polls with this period, so a busy producer doesn't pay for a wakeup
+ * per line */
+#define WRITER_WAIT_US	10000
+/* bound for waiting on the writer, in case it is gone */
+#define SPACE_WAIT_US	100000
+
+#define ASYNC_MIN_SIZE	8192
+#define ASYNC_MAX_SIZE	(64 * 1024 * 1024)
+
+struct log_async {
+	uint8_t *buf;
+	uint32_t size;
+
+	/* free running byte counters, only written by producer / consumer */
+	unsigned long head;
+	unsigned long tail;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t data_cond;
+	pthread_cond_t space_cond;
+	int wait_data;
+	int wait_space;
+	int stop;
+
+	enum log_async_overflow overflow;
+	struct log_async_stats stats;
+
+	/* timestamp for the next record, set by _output() */
+	uint32_t stamp_ofs;
+	struct timeval stamp;
+
+	/* only touched by the writer, under lock for reopen */
+	FILE *out;
+	pthread_mutex_t out_lock;
+	time_t timestr_sec;
+	char timestr[32];
+};
+
+static inline unsigned long load_acq(unsigned long *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_rel(unsigned long *p, unsigned long v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static uint32_t rec_size(uint32_t len)
+{
+	return (REC_HDR + len + REC_ALIGN - 1) & ~(REC_ALIGN - 1);
+}
+
+/* wake up the other side if it sleeps, the flags are re-checked with
+ * the lock held so a wakeup can't get lost */
+static void wake(struct log_async *la, int *flag, pthread_cond_t *cond)
+{
+	if (!__atomic_load_n(flag, __ATOMIC_SEQ_CST))
+		return;
+
+	pthread_mutex_lock(&la->lock);
+	__atomic_store_n(flag, 0, __ATOMIC_SEQ_CST);
+	pthread_cond_signal(cond);
+	pthread_mutex_unlock(&la->lock);
+}
+
+static void sleep_on(struct log_async *la, int *flag, pthread_cond_t *cond,
+		     int usec)
+{
+	struct timespec ts;
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	ts.tv_sec = tv.tv_sec;
+	ts.tv_nsec = (tv.tv_usec + usec) * 1000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&la->lock);
+	if (__atomic_load_n(flag, __ATOMIC_SEQ_CST))
+		pthread_cond_timedwait(cond, &la->lock, &ts);
+	__atomic_store_n(flag, 0, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&la->lock);
+}
+
+/* bytes the producer needs to append a record of len bytes at head */
+static uint32_t ring_need(struct log_async *la, unsigned long head,
+			  uint32_t len)
+{
+	uint32_t pos = head & (la->size - 1);
+	uint32_t need = rec_size(len);
+
+	if (pos + need > la->size)
+		need += la->size - pos;
+
+	return need;
+}
+
+static void ring_put(struct log_async *la, unsigned long head,
+		     const char *str, uint32_t len)
+{
+	uint32_t pos = head & (la->size - 1);
+	struct rec_hdr *hdr;
+
+	if (pos + rec_size(len) > la->size) {
+		*(uint32_t *)(la->buf + pos) = REC_WRAP;
+		head += la->size - pos;
+		pos = 0;
+	}
+
+	hdr = (struct rec_hdr *)(la->buf + pos);
+	hdr->len = len;
+	hdr->stamp_ofs = la->stamp_ofs;
+	hdr->stamp = la->stamp;
+	memcpy(la->buf + pos + REC_HDR, str, len);
+
+	store_rel(&la->head, head + rec_size(len));
+}
+
+static void _async_output(struct log_target *target, unsigned int level,
+			  const char *log)
+{
+	struct log_async *la = target->tgt_async.ring;
+	uint32_t len = strlen(log);
+	unsigned long head = la->head;
+	unsigned long fill;
+	uint32_t need;
+
+	/* can't ever fit, _output() doesn't produce those anyway */
+	if (rec_size(len) > la->size / 2) {
+		la->stats.dropped++;
+		la->stats.dropped_bytes += len;
+		la->stamp_ofs = REC_NO_STAMP;
+		return;
+	}
+
+	need = ring_need(la, head, len);
+
+	while (head + need - load_acq(&la->tail) > la->size) {
+		if (la->overflow == LOG_ASYNC_DROP || la->stop) {
+			la->stats.dropped++;
+			la->stats.dropped_bytes += len;
+			la->stamp_ofs = REC_NO_STAMP;
+			return;
+		}
+
+		/* LOG_ASYNC_BLOCK: wait for the writer to make room */
+		__atomic_store_n(&la->wait_space, 1, __ATOMIC_SEQ_CST);
+		if (head + need - __atomic_load_n(&la->tail, __ATOMIC_SEQ_CST)
+		    <= la->size)
+			break;
+		wake(la, &la->wait_data, &la->data_cond);
+		sleep_on(la, &la->wait_space, &la->space_cond, SPACE_WAIT_US);
+		la->stats.blocked++;
+	}
+
+	ring_put(la, head, log, len);
+	la->stamp_ofs = REC_NO_STAMP;
+	la->stats.records++;
+
+	fill = head + need - load_acq(&la->tail);
+	if (fill > la->stats.max_fill)
+		la->stats.max_fill = fill;
+
+	if (fill >= la->size / 4) {
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		wake(la, &la->wait_data, &la->data_cond);
+	}
+}
+
+/* as the other targets do, ctime() only changes once a second */
+static void rec_write(struct log_async *la, const struct rec_hdr *hdr)
+{
+	const uint8_t *line = (const uint8_t *)(hdr + 1);
+	uint32_t ofs = hdr->stamp_ofs;
+
+	if (ofs > hdr->len) {
+		fwrite(line, 1, hdr->len, la->out);
+		return;
+	}
+
+	if (hdr->stamp.tv_sec != la->timestr_sec) {
+		time_t tm = hdr->stamp.tv_sec;
+		char s[32];
+
+		if (!ctime_r(&tm, s))
+			s[0] = '\0';
+		snprintf(la->timestr, sizeof(la->timestr), "%.*s",
+			 (int)strcspn(s, "\n"), s);
+		la->timestr_sec = hdr->stamp.tv_sec;
+	}
+
+	fwrite(line, 1, ofs, la->out);
+	fprintf(la->out, "%s ", la->timestr);
+	fwrite(line + ofs, 1, hdr->len - ofs, la->out);
+}
+
+/* write out everything between tail and head, returns bytes consumed */
+static unsigned long ring_drain(struct log_async *la)
+{
+	unsigned long head = load_acq(&la->head);
+	unsigned long tail = la->tail;
+	unsigned long start = tail;
+
+	if (head == tail)
+		return 0;
+
+	pthread_mutex_lock(&la->out_lock);
+	while (tail != head) {
+		uint32_t pos = tail & (la->size - 1);
+		uint32_t len = *(uint32_t *)(la->buf + pos);
+
+		if (len == REC_WRAP) {
+			tail += la->size - pos;
+			continue;
+		}
+
+		if (la->out)
+			rec_write(la, (struct rec_hdr *)(la->buf + pos));
+		tail += rec_size(len);
+	}
+	if (la->out)
+		fflush(la->out);
+	pthread_mutex_unlock(&la->out_lock);
+
+	__atomic_store_n(&la->tail, tail, __ATOMIC_SEQ_CST);
+	wake(la, &la->wait_space, &la->space_cond);
+
+	return tail - start;
+}
+
+static void *async_writer(void *data)
+{
+	struct log_async *la = data;
+
+	while (1) {
+		if (ring_drain(la))
+			continue;
+
+		if (__atomic_load_n(&la->stop, __ATOMIC_ACQUIRE))
+			break;
+
+		__atomic_store_n(&la->wait_data, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&la->head, __ATOMIC_SEQ_CST) != la->tail)
+			continue;
+		sleep_on(la, &la->wait_data, &la->data_cond, WRITER_WAIT_US);
+	}
+
+	/* whatever came in before stop was set */
+	ring_drain(la);
+
+	return NULL;
+}
+
+/* start the writer on buf, if that fails the ring stays usable but
+ * stopped, so the producer drops instead of waiting for nobody */
+static int async_run(struct log_async *la, uint8_t *buf, uint32_t size)
+{
+	int rc;
+
+	la->buf = buf;
+	la->size = size;
+	la->head = la->tail = 0;
+	la->stop = 0;
+
+	rc = pthread_create(&la->thread, NULL, async_writer, la);
+	if (rc) {
+		la->stop = 1;
+		return -rc;
+	}
+
+	return 0;
+}
+
+static int async_start(struct log_async *la, uint32_t size)
+{
+	uint8_t *buf;
+	int rc;
+
+	buf = talloc_size(la, size);
+	if (!buf)
+		return -ENOMEM;
+
+	rc = async_run(la, buf, size);
+	if (rc < 0) {
+		talloc_free(la->buf);
+		la->buf = NULL;
+	}
+
+	return rc;
+}
+
+static void async_stop(struct log_async *la)
+{
+	/* no writer if async_run() failed */
+	if (!la->stop) {
+		__atomic_store_n(&la->stop, 1, __ATOMIC_RELEASE);
+		__atomic_store_n(&la->wait_data, 1, __ATOMIC_SEQ_CST);
+		wake(la, &la->wait_data, &la->data_cond);
+		pthread_join(la->thread, NULL);
+	}
+
+	talloc_free(la->buf);
+	la->buf = NULL;
+}
+
+static uint32_t async_round_size(unsigned int size)
+{
+	uint32_t s = ASYNC_MIN_SIZE;
+
+	while (s < size && s < ASYNC_MAX_SIZE)
+		s <<= 1;
+
+	return s;
+}
+
+/*! \brief Create a new asynchronous log target
+ *  \param[in] fname File name of the log file, NULL for stderr
+ *  \param[in] size Size of the ring buffer in bytes (rounded up to a
+ *  power of two, at least 8 KiB)
+ *  \returns Log target in case of success, NULL otherwise
+ *
+ * The target starts with the \ref LOG_ASYNC_DROP overflow policy.
+ */
+struct log_target *log_target_create_async(const char *fname,
+					   unsigned int size)
+{
+	struct log_target *target;
+	struct log_async *la;
+
+	target = log_target_create();
+	if (!target)
+		return NULL;
+
+	la = talloc_zero(target, struct log_async);
+	if (!la)
+		goto err;
+
+	if (fname) {
+		la->out = fopen(fname, "a");
+		if (!la->out)
+			goto err;
+		target->tgt_async.fname = talloc_strdup(target, fname);
+	} else
+		la->out = stderr;
+
+	pthread_mutex_init(&la->lock, NULL);
+	pthread_mutex_init(&la->out_lock, NULL);
+	pthread_cond_init(&la->data_cond, NULL);
+	pthread_cond_init(&la->space_cond, NULL);
+	la->overflow = LOG_ASYNC_DROP;
+	la->stamp_ofs = REC_NO_STAMP;
+	la->timestr_sec = -1;
+
+	if (async_start(la, async_round_size(size)) < 0) {
+		if (la->out != stderr)
+			fclose(la->out);
+		goto err;
+	}
+
+	target->type = LOG_TGT_TYPE_ASYNC;
+	target->tgt_async.ring = la;
+	target->output = _async_output;
+
+	return target;
+
+err:
+	talloc_free(target);
+	return NULL;
+}
+
+/*! \brief Set the overflow policy of an asynchronous log target
+ *  \param[in] target Log target to be affected
+ *  \param[in] overflow what to do if the ring buffer is full
+ *  \returns 0 on success, -EINVAL if not an asynchronous target
+ */
+int log_target_async_set_overflow(struct log_target *target,
+				  enum log_async_overflow overflow)
+{
+	if (target->type != LOG_TGT_TYPE_ASYNC)
+		return -EINVAL;
+
+	target->tgt_async.ring->overflow = overflow;
+
+	return 0;
+}
+
+/*! \brief Change the ring buffer size of an asynchronous log target
+ *  \param[in] target Log target to be affected
+ *  \param[in] size New size in bytes, rounded like in
+ *  \ref log_target_create_async
+ *  \returns 0 on success, negative in case of error
+ *
+ * The pending log lines are written out before the ring is replaced.
+ * If the new ring can't be allocated, the old one stays in use.  If the
+ * writer thread can't be restarted, log lines are dropped until a later
+ * call succeeds.
+ */
+int log_target_async_set_size(struct log_target *target, unsigned int size)
+{
+	struct log_async *la;
+	uint8_t *buf;
+
+	if (target->type != LOG_TGT_TYPE_ASYNC)
+		return -EINVAL;
+
+	la = target->tgt_async.ring;
+	size = async_round_size(size);
+	if (size == la->size)
+		return 0;
+
+	buf = talloc_size(la, size);
+	if (!buf)
+		return -ENOMEM;
+
+	async_stop(la);
+
+	return async_run(la, buf, size);
+}
+
+/*! \brief Get the overflow policy and size of an asynchronous log target */
+int log_target_async_get_config(struct log_target *target,
+				enum log_async_overflow *overflow,
+				unsigned int *size)
+{
+	if (target->type != LOG_TGT_TYPE_ASYNC)
+		return -EINVAL;
+
+	*overflow = target->tgt_async.ring->overflow;
+	*size = target->tgt_async.ring->size;
+
+	return 0;
+}
+
+/*! \brief Get the counters of an asynchronous log target
+ *  \param[in] target Log target
+ *  \param[out] stats counters, including the current fill level
+ *  \returns 0 on success, -EINVAL if not an asynchronous target
+ */
+int log_target_async_get_stats(struct log_target *target,
+			       struct log_async_stats *stats)
+{
+	struct log_async *la;
+
+	if (target->type != LOG_TGT_TYPE_ASYNC)
+		return -EINVAL;
+
+	la = target->tgt_async.ring;
+	*stats = la->stats;
+	stats->fill = la->head - load_acq(&la->tail);
+
+	return 0;
+}
+
+/*! \brief Wait until an asynchronous log target has written everything
+ *  \param[in] target Log target
+ */
+void log_target_async_flush(struct log_target *target)
+{
+	struct log_async *la;
+
+	if (target->type != LOG_TGT_TYPE_ASYNC)
+		return;
+
+	la = target->tgt_async.ring;
+	while (load_acq(&la->tail) != la->head) {
+		__atomic_store_n(&la->wait_space, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&la->tail, __ATOMIC_SEQ_CST) == la->head)
+			break;
+		wake(la, &la->wait_data, &la->data_cond);
+		sleep_on(la, &la->wait_space, &la->space_cond, SPACE_WAIT_US);
+	}
+}
+
+/*! \brief close and re-open the file of an asynchronous log target */
+int log_target_async_reopen(struct log_target *target)
+{
+	struct log_async *la = target->tgt_async.ring;
+	int rc = 0;
+
+	if (!target->tgt_async.fname)
+		return 0;
+
+	pthread_mutex_lock(&la->out_lock);
+	/* NULL after a failed reopen */
+	if (la->out)
+		fclose(la->out);
+	la->out = fopen(target->tgt_async.fname, "a");
+	if (!la->out)
+		rc = -errno;
+	pthread_mutex_unlock(&la->out_lock);
+
+	return rc;
+}
+
+/* called by _output() instead of formatting the timestamp, which is to
+ * be inserted at ofs of the line that follows */
+void _log_target_async_stamp(struct log_target *target, unsigned int ofs)
+{
+	struct log_async *la = target->tgt_async.ring;
+
+	osmo_gettimeofday(&la->stamp, NULL);
+	la->stamp_ofs = ofs;
+}
+
+/* called by log_target_destroy(), stops the writer after draining */
+void _log_target_async_destroy(struct log_target *target)
+{
+	struct log_async *la = target->tgt_async.ring;
+
+	async_stop(la);
+
+	if (la->out && la->out != stderr)
+		fclose(la->out);
+	la->out = NULL;
+
+	pthread_cond_destroy(&la->data_cond);
+	pthread_cond_destroy(&la->space_cond);
+	pthread_mutex_destroy(&la->out_lock);
+	pthread_mutex_destroy(&la->lock);
+}
+
+#endif /* HAVE_PTHREAD_H && !EMBEDDED */
+
+/*! }@ */
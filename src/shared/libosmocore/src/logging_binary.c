@@ -0,0 +1,980 @@
+/* Binary logging target and reader */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \addtogroup logging
+ *  @{
+ */
+
+/*! \file logging_binary.c
+ *
+ * The binary target doesn't format anything.  It stores the time,
+ * category, level, ids for file name and format string and the raw
+ * arguments of every message, see \ref logging_binary.h for the format.
+ * File names and format strings are remembered by their address, so
+ * they are only written once per segment.  Formats the writer can't
+ * take apart (positional arguments, wide characters, %m) are
+ * formatted by vsnprintf() and stored as text.
+ *
+ * The reader expands the records to text again, used by the
+ * osmo-binlog utility.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/logging.h>
+#include <osmocom/core/logging_binary.h>
+
+#define BIN_MAX_ARGS		32
+#define BIN_HASH_SIZE		1024	/* initial size, power of two */
+#define BIN_MAX_ID		0xffff
+#define BIN_SEGMENT_SIZE	(1024 * 1024)
+#define BIN_STR_NULL		0xffff	/* string length of a NULL %s */
+#define BIN_FLUSH_SEC		1
+
+/* what a conversion takes from the argument list */
+enum bin_arg {
+	ARG_NONE,	/* %% */
+	ARG_INT,	/* int and everything promoted to it, 4 bytes */
+	ARG_STAR,	/* '*' width or precision, 4 bytes */
+	ARG_LONG,	/* the rest is stored in 8 bytes */
+	ARG_LLONG,
+	ARG_INTMAX,
+	ARG_SIZE,
+	ARG_PTRDIFF,
+	ARG_DOUBLE,
+	ARG_LDOUBLE,
+	ARG_PTR,
+	ARG_STR,	/* 16 bit length and the characters */
+	ARG_NPTR,	/* %n, nothing stored */
+};
+
+enum bin_mod {
+	MOD_NONE,
+	MOD_HH,
+	MOD_H,
+	MOD_L,
+	MOD_LL,
+	MOD_LD,
+	MOD_J,
+	MOD_Z,
+	MOD_T,
+};
+
+/* one conversion of a format string */
+struct bin_conv {
+	int width_star;
+	int prec_star;
+	int prec;		/* -1 if none or '*' */
+	enum bin_mod mod;
+	unsigned int mod_off;	/* offset of the length modifier */
+	char conv;
+};
+
+/* a file name or format string the writer has seen, identified by its
+ * address: a buffer holding a format must not be reused for another one */
+struct bin_str {
+	const char *ptr;	/* address, the hash key */
+	char *copy;		/* what was parsed and defined */
+	uint32_t gen;		/* segment in which id is defined */
+	uint16_t id;
+	int8_t nargs;		/* -1 if to be stored as text */
+	uint8_t args[BIN_MAX_ARGS];
+	int8_t prec[BIN_MAX_ARGS];	/* of ARG_STR: -1 none, -2 star */
+	int16_t prec_lit[BIN_MAX_ARGS];
+};
+
+struct log_binary {
+	struct bin_str *strs;
+	unsigned int hash_size;
+	unsigned int hash_used;
+	uint32_t gen;
+	uint16_t next_id;
+	unsigned int seg_bytes;
+	unsigned int seg_size;
+	int need_sync;
+	struct osmo_timer_list flush_timer;
+};
+
+/* parse the conversion after a '%', returns its length or -1 */
+static int parse_conv(const char *fmt, struct bin_conv *c)
+{
+	const char *p = fmt;
+
+	memset(c, 0, sizeof(*c));
+	c->prec = -1;
+
+	while (*p && strchr("-+ #0'I", *p))
+		p++;
+
+	if (*p == '*') {
+		c->width_star = 1;
+		p++;
+	} else {
+		while (*p >= '0' && *p <= '9')
+			p++;
+		/* positional arguments */
+		if (*p == '$')
+			return -1;
+	}
+
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			c->prec_star = 1;
+			p++;
+		} else {
+			c->prec = 0;
+			while (*p >= '0' && *p <= '9')
+				c->prec = c->prec * 10 + *p++ - '0';
+		}
+	}
+
+	c->mod_off = p - fmt;
+	switch (*p) {
+	case 'h':
+		if (p[1] == 'h') {
+			c->mod = MOD_HH;
+			p++;
+		} else
+			c->mod = MOD_H;
+		p++;
+		break;
+	case 'l':
+		if (p[1] == 'l') {
+			c->mod = MOD_LL;
+			p++;
+		} else
+			c->mod = MOD_L;
+		p++;
+		break;
+	case 'q':
+		c->mod = MOD_LL;
+		p++;
+		break;
+	case 'L':
+		c->mod = MOD_LD;
+		p++;
+		break;
+	case 'j':
+		c->mod = MOD_J;
+		p++;
+		break;
+	case 'z':
+	case 'Z':
+		c->mod = MOD_Z;
+		p++;
+		break;
+	case 't':
+		c->mod = MOD_T;
+		p++;
+		break;
+	}
+
+	if (!*p)
+		return -1;
+	c->conv = *p++;
+
+	return p - fmt;
+}
+
+/* argument type of a conversion, -1 if not supported */
+static int conv_arg(const struct bin_conv *c)
+{
+	switch (c->conv) {
+	case '%':
+		return ARG_NONE;
+	case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+		switch (c->mod) {
+		case MOD_NONE:
+		case MOD_HH:
+		case MOD_H:
+			return ARG_INT;
+		case MOD_L:
+			return ARG_LONG;
+		case MOD_LL:
+		case MOD_LD:
+			return ARG_LLONG;
+		case MOD_J:
+			return ARG_INTMAX;
+		case MOD_Z:
+			return ARG_SIZE;
+		case MOD_T:
+			return ARG_PTRDIFF;
+		}
+		break;
+	case 'c':
+		return c->mod == MOD_NONE ? ARG_INT : -1;
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+		if (c->mod == MOD_NONE || c->mod == MOD_L)
+			return ARG_DOUBLE;
+		if (c->mod == MOD_LD)
+			return ARG_LDOUBLE;
+		break;
+	case 's':
+		return c->mod == MOD_NONE ? ARG_STR : -1;
+	case 'p':
+		return ARG_PTR;
+	case 'n':
+		return ARG_NPTR;
+	}
+
+	return -1;
+}
+
+/* Writer */
+
+static void bin_parse_fmt(struct bin_str *e)
+{
+	const char *p = e->copy;
+	struct bin_conv c;
+	int n = 0, len, type;
+
+	while ((p = strchr(p, '%'))) {
+		len = parse_conv(p + 1, &c);
+		if (len < 0)
+			goto text;
+		p += 1 + len;
+
+		type = conv_arg(&c);
+		if (type < 0)
+			goto text;
+		if (type == ARG_NONE)
+			continue;
+
+		if (n + c.width_star + c.prec_star + 1 > BIN_MAX_ARGS)
+			goto text;
+		if (c.width_star)
+			e->args[n++] = ARG_STAR;
+		if (c.prec_star)
+			e->args[n++] = ARG_STAR;
+		e->args[n] = type;
+		e->prec[n] = c.prec_star ? -2 : (c.prec >= 0 ? 0 : -1);
+		e->prec_lit[n] = c.prec > 0x7fff ? 0x7fff : c.prec;
+		n++;
+	}
+	e->nargs = n;
+	return;
+
+text:
+	e->nargs = -1;
+}
+
+static inline unsigned int bin_hash(const char *s)
+{
+	return ((uintptr_t)s >> 2) * 2654435761u;
+}
+
+/* the slot of s, or the free one where it belongs */
+static struct bin_str *bin_slot(struct bin_str *strs, unsigned int size,
+				const char *s)
+{
+	unsigned int i = bin_hash(s);
+
+	while (1) {
+		struct bin_str *e = &strs[i & (size - 1)];
+
+		if (e->ptr == s || !e->ptr)
+			return e;
+		i++;
+	}
+}
+
+/* double the table, the entries keep their ids */
+static int bin_grow(struct log_binary *lb)
+{
+	unsigned int size = lb->hash_size * 2, i;
+	struct bin_str *strs;
+
+	strs = talloc_zero_array(lb, struct bin_str, size);
+	if (!strs)
+		return -ENOMEM;
+
+	for (i = 0; i < lb->hash_size; i++) {
+		if (lb->strs[i].ptr)
+			*bin_slot(strs, size, lb->strs[i].ptr) = lb->strs[i];
+	}
+
+	talloc_free(lb->strs);
+	lb->strs = strs;
+	lb->hash_size = size;
+
+	return 0;
+}
+
+/* find or add a string, NULL if out of memory */
+static struct bin_str *bin_lookup(struct log_binary *lb, const char *s,
+				  int is_fmt)
+{
+	struct bin_str *e;
+
+	e = bin_slot(lb->strs, lb->hash_size, s);
+	if (e->ptr)
+		return e;
+
+	/* at most half full, so that probing stays short */
+	if (lb->hash_used + 1 > lb->hash_size / 2) {
+		if (bin_grow(lb) < 0)
+			return NULL;
+		e = bin_slot(lb->strs, lb->hash_size, s);
+	}
+
+	e->copy = talloc_strdup(lb, s);
+	if (!e->copy)
+		return NULL;
+	e->ptr = s;
+	e->gen = 0;
+	e->nargs = 0;
+	if (is_fmt)
+		bin_parse_fmt(e);
+	lb->hash_used++;
+
+	return e;
+}
+
+static void bin_write(struct log_target *target, const void *rec,
+		      unsigned int len)
+{
+	struct log_binary *lb = target->tgt_binary.state;
+
+	fwrite(rec, len, 1, target->tgt_binary.out);
+	lb->seg_bytes += len;
+
+	if (!osmo_timer_pending(&lb->flush_timer))
+		osmo_timer_schedule(&lb->flush_timer, BIN_FLUSH_SEC, 0);
+}
+
+static void bin_sync(struct log_target *target, uint64_t time_us)
+{
+	struct log_binary *lb = target->tgt_binary.state;
+	struct log_bin_sync sync;
+
+	memset(&sync, 0, sizeof(sync));
+	sync.hdr.len = sizeof(sync);
+	sync.hdr.type = LOG_BIN_SYNC;
+	memcpy(sync.magic, LOG_BIN_MAGIC, sizeof(sync.magic));
+	sync.byte_order = LOG_BIN_BYTE_ORDER;
+	sync.version = LOG_BIN_VERSION;
+	sync.time_us = time_us;
+
+	lb->seg_bytes = 0;
+	bin_write(target, &sync, sizeof(sync));
+
+	lb->gen++;
+	lb->next_id = 1;
+	lb->need_sync = 0;
+}
+
+/* make sure the string has an id in this segment, 0 if it has none */
+static uint16_t bin_define(struct log_target *target, struct bin_str *e)
+{
+	struct log_binary *lb = target->tgt_binary.state;
+	uint8_t rec[LOG_BIN_MAX_REC];
+	struct log_bin_str *str = (struct log_bin_str *) rec;
+	unsigned int len;
+
+	if (!e)
+		return 0;
+	if (e->gen == lb->gen)
+		return e->id;
+
+	len = strlen(e->copy);
+	if (len > sizeof(rec) - sizeof(*str))
+		len = sizeof(rec) - sizeof(*str);
+
+	str->hdr.len = sizeof(*str) + len;
+	str->hdr.type = LOG_BIN_STR;
+	str->hdr.flags = 0;
+	str->id = lb->next_id;
+	memcpy(rec + sizeof(*str), e->copy, len);
+	bin_write(target, rec, str->hdr.len);
+
+	e->id = lb->next_id++;
+	e->gen = lb->gen;
+
+	return e->id;
+}
+
+#define PUT(p, type, v) \
+	do { type _v = v; memcpy(p, &_v, sizeof(_v)); p += sizeof(_v); } \
+	while (0)
+
+static void _binary_raw_output(struct log_target *target, unsigned int subsys,
+			       unsigned int level, const char *file, int line,
+			       int cont, const char *format, va_list ap)
+{
+	struct log_binary *lb = target->tgt_binary.state;
+	uint8_t rec[LOG_BIN_MAX_REC];
+	struct log_bin_msg *msg = (struct log_bin_msg *) rec;
+	uint8_t *p = rec + sizeof(*msg), *end = rec + sizeof(rec);
+	struct bin_str *f, *e;
+	struct timeval tv;
+	uint64_t now;
+	int i, star = -1;
+
+	osmo_gettimeofday(&tv, NULL);
+	now = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+	/* two new strings need to fit into this segment */
+	if (lb->need_sync || lb->seg_bytes >= lb->seg_size ||
+	    lb->next_id >= BIN_MAX_ID - 2)
+		bin_sync(target, now);
+
+	f = bin_lookup(lb, file, 0);
+	e = bin_lookup(lb, format, 1);
+
+	msg->hdr.flags = cont ? LOG_BIN_F_CONT : 0;
+	msg->time_us = now;
+	msg->subsys = subsys;
+	msg->level = level;
+	msg->reserved = 0;
+	msg->file_id = bin_define(target, f);
+	msg->line = line;
+
+	if (!e || e->nargs < 0) {
+		int len = vsnprintf((char *) p, end - p, format, ap);
+		if (len < 0)
+			len = 0;
+		if (len > end - p - 1)
+			len = end - p - 1;
+		msg->hdr.type = LOG_BIN_TEXT;
+		msg->fmt_id = 0;
+		p += len;
+		goto out;
+	}
+
+	msg->hdr.type = LOG_BIN_MSG;
+	msg->fmt_id = bin_define(target, e);
+
+	for (i = 0; i < e->nargs; i++) {
+		switch (e->args[i]) {
+		case ARG_STAR:
+			star = va_arg(ap, int);
+			PUT(p, int32_t, star);
+			break;
+		case ARG_INT:
+			PUT(p, int32_t, va_arg(ap, int));
+			break;
+		case ARG_LONG:
+			PUT(p, int64_t, va_arg(ap, long));
+			break;
+		case ARG_LLONG:
+			PUT(p, int64_t, va_arg(ap, long long));
+			break;
+		case ARG_INTMAX:
+			PUT(p, int64_t, va_arg(ap, intmax_t));
+			break;
+		case ARG_SIZE:
+			PUT(p, int64_t, va_arg(ap, size_t));
+			break;
+		case ARG_PTRDIFF:
+			PUT(p, int64_t, va_arg(ap, ptrdiff_t));
+			break;
+		case ARG_DOUBLE:
+			PUT(p, double, va_arg(ap, double));
+			break;
+		case ARG_LDOUBLE:
+			PUT(p, double, va_arg(ap, long double));
+			break;
+		case ARG_PTR:
+			PUT(p, uint64_t, (uintptr_t) va_arg(ap, void *));
+			break;
+		case ARG_NPTR:
+			va_arg(ap, void *);
+			break;
+		case ARG_STR: {
+			const char *s = va_arg(ap, const char *);
+			/* leave room for the remaining numbers */
+			int max = end - p - 2 - 8 * (e->nargs - i - 1);
+			size_t len;
+
+			if (e->prec[i] == -2 && star >= 0 && star < max)
+				max = star;
+			else if (e->prec[i] == 0 && e->prec_lit[i] < max)
+				max = e->prec_lit[i];
+			if (max < 0)
+				max = 0;
+
+			if (!s) {
+				PUT(p, uint16_t, BIN_STR_NULL);
+				break;
+			}
+			/* %.*s may point to something not terminated */
+			len = strnlen(s, max);
+			PUT(p, uint16_t, len);
+			memcpy(p, s, len);
+			p += len;
+			break;
+		}
+		}
+	}
+
+out:
+	msg->hdr.len = p - rec;
+	bin_write(target, rec, msg->hdr.len);
+}
+
+static void bin_flush_cb(void *data)
+{
+	struct log_target *target = data;
+
+	fflush(target->tgt_binary.out);
+}
+
+/*! \brief Create a new binary log target
+ *  \param[in] fname File name of the log file
+ *  \returns Log target in case of success, NULL otherwise
+ *
+ * Use the osmo-binlog utility to turn the file into text.
+ */
+struct log_target *log_target_create_binary(const char *fname)
+{
+	struct log_target *target;
+	struct log_binary *lb;
+
+	target = log_target_create();
+	if (!target)
+		return NULL;
+
+	lb = talloc_zero(target, struct log_binary);
+	if (!lb)
+		goto err;
+	lb->strs = talloc_zero_array(lb, struct bin_str, BIN_HASH_SIZE);
+	if (!lb->strs)
+		goto err;
+	lb->hash_size = BIN_HASH_SIZE;
+	lb->seg_size = BIN_SEGMENT_SIZE;
+	lb->need_sync = 1;
+	lb->flush_timer.cb = bin_flush_cb;
+	lb->flush_timer.data = target;
+
+	target->tgt_binary.out = fopen(fname, "a");
+	if (!target->tgt_binary.out)
+		goto err;
+
+	target->type = LOG_TGT_TYPE_BINARY;
+	target->tgt_binary.fname = talloc_strdup(target, fname);
+	target->tgt_binary.state = lb;
+	target->raw_output = _binary_raw_output;
+
+	return target;
+
+err:
+	talloc_free(target);
+	return NULL;
+}
+
+/*! \brief Set after how many bytes a binary log starts a new segment
+ *  \param[in] target Log target to be affected
+ *  \param[in] size segment size in bytes
+ *
+ * Smaller segments make seeking by time more precise, but the file
+ * names and format strings are repeated in every segment.
+ */
+void log_target_binary_set_segment_size(struct log_target *target,
+					unsigned int size)
+{
+	if (target->type != LOG_TGT_TYPE_BINARY)
+		return;
+
+	target->tgt_binary.state->seg_size = size;
+}
+
+/* called by log_target_file_reopen() */
+int _log_target_binary_reopen(struct log_target *target)
+{
+	fclose(target->tgt_binary.out);
+
+	target->tgt_binary.out = fopen(target->tgt_binary.fname, "a");
+	if (!target->tgt_binary.out)
+		return -errno;
+
+	/* the new file has to start with a sync record */
+	target->tgt_binary.state->need_sync = 1;
+
+	return 0;
+}
+
+/* called by log_target_destroy() */
+void _log_target_binary_destroy(struct log_target *target)
+{
+	osmo_timer_del(&target->tgt_binary.state->flush_timer);
+
+	if (target->tgt_binary.out)
+		fclose(target->tgt_binary.out);
+	target->tgt_binary.out = NULL;
+}
+
+/* Reader */
+
+struct log_bin_reader {
+	FILE *in;
+	void *seg_ctx;		/* strings of the current segment */
+	char **strs;
+	int synced;
+	uint64_t skip_before;
+	uint8_t rec[LOG_BIN_MAX_REC];
+	char text[4096];
+};
+
+static void reader_reset(struct log_bin_reader *r)
+{
+	talloc_free(r->seg_ctx);
+	r->seg_ctx = talloc_new(r);
+	memset(r->strs, 0, (BIN_MAX_ID + 1) * sizeof(char *));
+}
+
+/*! \brief Start reading a binary log
+ *  \param[in] ctx talloc context
+ *  \param[in] in file, only needs to be seekable for \ref
+ *  log_bin_reader_seek
+ *  \returns reader, NULL on allocation failure
+ */
+struct log_bin_reader *log_bin_reader_open(void *ctx, FILE *in)
+{
+	struct log_bin_reader *r;
+
+	r = talloc_zero(ctx, struct log_bin_reader);
+	if (!r)
+		return NULL;
+
+	r->strs = talloc_zero_array(r, char *, BIN_MAX_ID + 1);
+	if (!r->strs) {
+		talloc_free(r);
+		return NULL;
+	}
+	r->in = in;
+	reader_reset(r);
+
+	return r;
+}
+
+/*! \brief Free a reader, the file is not closed */
+void log_bin_reader_close(struct log_bin_reader *r)
+{
+	talloc_free(r);
+}
+
+static int check_sync(const struct log_bin_sync *sync)
+{
+	if (sync->hdr.type != LOG_BIN_SYNC || sync->hdr.len < sizeof(*sync))
+		return -EINVAL;
+	if (memcmp(sync->magic, LOG_BIN_MAGIC, sizeof(sync->magic)))
+		return -EINVAL;
+	if (sync->byte_order != LOG_BIN_BYTE_ORDER)
+		return -EPROTO;
+	if (sync->version != LOG_BIN_VERSION)
+		return -EPROTO;
+
+	return 0;
+}
+
+#define GET(p, end, type, v) \
+	do { \
+		if ((end) - (p) < (int) sizeof(type)) \
+			goto trunc; \
+		memcpy(&(v), p, sizeof(type)); \
+		p += sizeof(type); \
+	} while (0)
+
+#define FMT_ARG(val) \
+	do { \
+		switch (nstar) { \
+		case 0: \
+			ret = snprintf(o, rem, spec, val); \
+			break; \
+		case 1: \
+			ret = snprintf(o, rem, spec, star[0], val); \
+			break; \
+		default: \
+			ret = snprintf(o, rem, spec, star[0], star[1], val); \
+		} \
+	} while (0)
+
+/* expand the arguments of a LOG_BIN_MSG record into r->text */
+static void reader_format(struct log_bin_reader *r, const char *fmt,
+			  const uint8_t *p, const uint8_t *end)
+{
+	char *o = r->text;
+	int rem = sizeof(r->text);
+	char str[LOG_BIN_MAX_REC + 1];
+	char spec[64];
+	struct bin_conv c;
+	int len, ret;
+
+	while (*fmt && rem > 1) {
+		int32_t star[2], i32;
+		int64_t i64;
+		uint64_t u64;
+		uint16_t slen;
+		double d;
+		int nstar = 0, type;
+
+		if (*fmt != '%') {
+			*o++ = *fmt++;
+			rem--;
+			continue;
+		}
+
+		len = parse_conv(fmt + 1, &c);
+		type = len < 0 ? -1 : conv_arg(&c);
+		if (type < 0 || len + 5 > (int) sizeof(spec))
+			goto trunc;
+
+		if (c.width_star)
+			GET(p, end, int32_t, star[nstar++]);
+		if (c.prec_star)
+			GET(p, end, int32_t, star[nstar++]);
+
+		/* same flags, width and precision, our length modifier */
+		spec[0] = '%';
+		memcpy(spec + 1, fmt + 1, c.mod_off);
+		spec[1 + c.mod_off] = '\0';
+		if (type == ARG_INT)
+			strncat(spec, fmt + 1 + c.mod_off, len - c.mod_off);
+		else {
+			if (type >= ARG_LONG && type <= ARG_PTRDIFF)
+				strcat(spec, "ll");
+			strncat(spec, &c.conv, 1);
+		}
+		fmt += 1 + len;
+
+		ret = 0;
+		switch (type) {
+		case ARG_NONE:
+			*o = '%';
+			ret = 1;
+			break;
+		case ARG_INT:
+			GET(p, end, int32_t, i32);
+			FMT_ARG(i32);
+			break;
+		case ARG_LONG:
+		case ARG_LLONG:
+		case ARG_INTMAX:
+		case ARG_SIZE:
+		case ARG_PTRDIFF:
+			GET(p, end, int64_t, i64);
+			FMT_ARG((long long) i64);
+			break;
+		case ARG_DOUBLE:
+		case ARG_LDOUBLE:
+			GET(p, end, double, d);
+			FMT_ARG(d);
+			break;
+		case ARG_PTR:
+			GET(p, end, uint64_t, u64);
+			FMT_ARG((void *)(uintptr_t) u64);
+			break;
+		case ARG_STR:
+			GET(p, end, uint16_t, slen);
+			if (slen == BIN_STR_NULL) {
+				FMT_ARG("(null)");
+				break;
+			}
+			if (end - p < slen)
+				goto trunc;
+			memcpy(str, p, slen);
+			str[slen] = '\0';
+			p += slen;
+			FMT_ARG(str);
+			break;
+		case ARG_NPTR:
+			break;
+		}
+
+		if (ret < 0)
+			ret = 0;
+		if (ret >= rem)
+			ret = rem - 1;
+		o += ret;
+		rem -= ret;
+	}
+	*o = '\0';
+	return;
+
+trunc:
+	/* rest of the format as it is */
+	snprintf(o, rem, "%s", fmt);
+}
+
+/*! \brief Read the next message of a binary log
+ *  \param[in] r reader
+ *  \param[out] e message, valid until the next call
+ *  \returns 1 if a message was read, 0 at the end of the file,
+ *  negative in case of a broken file
+ */
+int log_bin_reader_next(struct log_bin_reader *r, struct log_bin_entry *e)
+{
+	struct log_bin_hdr *hdr = (struct log_bin_hdr *) r->rec;
+	struct log_bin_msg *msg = (struct log_bin_msg *) r->rec;
+	struct log_bin_str *str = (struct log_bin_str *) r->rec;
+	const uint8_t *body;
+	const char *fmt;
+	int rc;
+
+	while (1) {
+		if (fread(hdr, sizeof(*hdr), 1, r->in) != 1)
+			return 0;
+		if (hdr->len < sizeof(*hdr) || hdr->len > LOG_BIN_MAX_REC)
+			return -EINVAL;
+		if (hdr->len > sizeof(*hdr) &&
+		    fread(hdr + 1, hdr->len - sizeof(*hdr), 1, r->in) != 1)
+			return 0;
+
+		switch (hdr->type) {
+		case LOG_BIN_SYNC:
+			rc = check_sync((struct log_bin_sync *) r->rec);
+			if (rc < 0)
+				return rc;
+			reader_reset(r);
+			r->synced = 1;
+			continue;
+		case LOG_BIN_STR:
+			if (!r->synced || hdr->len < sizeof(*str))
+				continue;
+			r->strs[str->id] = talloc_strndup(r->seg_ctx,
+					(char *) (str + 1),
+					hdr->len - sizeof(*str));
+			continue;
+		case LOG_BIN_MSG:
+		case LOG_BIN_TEXT:
+			if (!r->synced || hdr->len < sizeof(*msg))
+				continue;
+			if (msg->time_us < r->skip_before)
+				continue;
+			break;
+		default:
+			continue;
+		}
+
+		body = (uint8_t *) (msg + 1);
+		if (hdr->type == LOG_BIN_TEXT) {
+			snprintf(r->text, sizeof(r->text), "%.*s",
+				 (int) (r->rec + hdr->len - body), body);
+		} else {
+			fmt = r->strs[msg->fmt_id];
+			if (fmt)
+				reader_format(r, fmt, body, r->rec + hdr->len);
+			else
+				snprintf(r->text, sizeof(r->text),
+					 "<unknown format %u>\n", msg->fmt_id);
+		}
+
+		e->time_us = msg->time_us;
+		e->subsys = msg->subsys;
+		e->level = msg->level;
+		e->cont = !!(hdr->flags & LOG_BIN_F_CONT);
+		e->file = r->strs[msg->file_id] ? r->strs[msg->file_id] : "?";
+		e->line = msg->line;
+		e->text = r->text;
+
+		return 1;
+	}
+}
+
+/* find the first sync record in [from, to), returns its offset or -1 */
+static off_t find_sync(struct log_bin_reader *r, off_t from, off_t to,
+		       uint64_t *time_us)
+{
+	uint8_t buf[65536];
+	const size_t len = sizeof(struct log_bin_sync);
+	struct log_bin_sync sync;
+
+	while (from < to) {
+		size_t n, i;
+
+		if (fseeko(r->in, from, SEEK_SET) < 0)
+			return -1;
+		n = fread(buf, 1, sizeof(buf), r->in);
+		if (n < len)
+			return -1;
+
+		for (i = 0; i + len <= n && from + (off_t) i < to; i++) {
+			if (buf[i + sizeof(struct log_bin_hdr)] != LOG_BIN_MAGIC[0])
+				continue;
+			memcpy(&sync, buf + i, len);
+			if (check_sync(&sync) < 0)
+				continue;
+			*time_us = sync.time_us;
+			return from + i;
+		}
+
+		/* the next chunk overlaps so nothing is missed */
+		from += n - len + 1;
+	}
+
+	return -1;
+}
+
+/*! \brief Skip to the first message not older than a given time
+ *  \param[in] r reader
+ *  \param[in] time_us time in microseconds since the epoch
+ *  \returns 0 on success, negative if there is no sync record
+ *
+ * If the file is seekable, the segment containing the time is found by
+ * bisection, else the messages are read and skipped.
+ */
+int log_bin_reader_seek(struct log_bin_reader *r, uint64_t time_us)
+{
+	off_t lo, hi, mid, off, size;
+	uint64_t t;
+
+	r->skip_before = time_us;
+
+	if (fseeko(r->in, 0, SEEK_END) < 0)
+		return 0;
+	size = ftello(r->in);
+
+	lo = find_sync(r, 0, size, &t);
+	if (lo < 0)
+		return -EINVAL;
+
+	hi = size;
+	if (t <= time_us) {
+		/* last sync at or before time_us is in [lo, hi) */
+		while (hi - lo > 1) {
+			mid = lo + (hi - lo) / 2;
+			off = find_sync(r, mid, hi, &t);
+			if (off < 0 || t > time_us)
+				hi = mid;
+			else
+				lo = off;
+		}
+	}
+
+	if (fseeko(r->in, lo, SEEK_SET) < 0)
+		return -errno;
+	r->synced = 0;
+	reader_reset(r);
+
+	return 0;
+}
+
+/*! }@ */
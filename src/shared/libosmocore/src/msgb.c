@@ -29,6 +29,8 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include "config.h"
+
 #include <osmocom/core/msgb.h>
 //#include <openbsc/gsm_data.h>
 #include <osmocom/core/talloc.h>
@@ -36,6 +38,124 @@
 
 void *tall_msgb_ctx;
 
+#ifndef EMBEDDED
+/* Optional freelist pool, see msgb_pool_init(). A released msgb whose
+ * talloc chunk is exactly the size of a class goes to the freelist of
+ * that class (through its list member), and msgb_alloc() takes from
+ * there first, only clearing the header. The free ones are kept under
+ * their own talloc context so they don't show up as live messages.
+ * Embedded builds have no talloc behind _talloc_zero()/talloc_free()
+ * and no pool. */
+static const uint16_t msgb_pool_sizes[MSGB_POOL_CLASSES] = {
+	64, 128, 256, 512, 1024, 2048, 4096,
+};
+
+static struct {
+	unsigned int max_free;	/* per class, 0 = pool disabled */
+	void *ctx;
+	struct llist_head free[MSGB_POOL_CLASSES];
+	struct msgb_pool_stats stats[MSGB_POOL_CLASSES];
+} msgb_pool;
+
+static int msgb_pool_class(uint16_t size)
+{
+	int i;
+
+	for (i = 0; i < MSGB_POOL_CLASSES; i++)
+		if (size <= msgb_pool_sizes[i])
+			return i;
+
+	return -1;
+}
+
+static void msgb_pool_drain(void)
+{
+	struct msgb *msg, *tmp;
+	int i;
+
+	for (i = 0; i < MSGB_POOL_CLASSES; i++) {
+		llist_for_each_entry_safe(msg, tmp, &msgb_pool.free[i], list) {
+			llist_del(&msg->list);
+			talloc_free(msg);
+		}
+		msgb_pool.stats[i].free = 0;
+	}
+}
+
+/*! \brief Enable or disable the msgb freelist pool
+ *  \param[in] max_free maximum number of free msgbs kept per size class,
+ *  0 to disable the pool (and release all free msgbs)
+ *
+ * With the pool enabled, msgb_alloc() rounds the allocation up to the
+ * next size class (64 to 4096 octets, larger ones are not pooled) and
+ * reuses a previously released msgb of that class if there is one.
+ * msgb->data_len still is the requested size. Unlike the talloc path,
+ * the data area of the message is not cleared, only the header is.
+ */
+void msgb_pool_init(unsigned int max_free)
+{
+	int i;
+
+	if (!msgb_pool.ctx) {
+		msgb_pool.ctx = talloc_named_const(NULL, 0, "msgb pool");
+		for (i = 0; i < MSGB_POOL_CLASSES; i++) {
+			INIT_LLIST_HEAD(&msgb_pool.free[i]);
+			msgb_pool.stats[i].size = msgb_pool_sizes[i];
+		}
+	}
+
+	msgb_pool.max_free = max_free;
+
+	if (!max_free)
+		msgb_pool_drain();
+}
+
+/*! \brief Get the statistics of the msgb pool
+ *  \param[out] stats array of MSGB_POOL_CLASSES entries, one per class
+ */
+void msgb_pool_get_stats(struct msgb_pool_stats *stats)
+{
+	int i;
+
+	for (i = 0; i < MSGB_POOL_CLASSES; i++) {
+		stats[i] = msgb_pool.stats[i];
+		stats[i].size = msgb_pool_sizes[i];
+	}
+}
+
+static struct msgb *msgb_pool_alloc(uint16_t size, const char *name)
+{
+	struct msgb_pool_stats *st;
+	struct msgb *msg;
+	int c;
+
+	c = msgb_pool_class(size);
+	if (c < 0)
+		return NULL;
+
+	st = &msgb_pool.stats[c];
+
+	if (!llist_empty(&msgb_pool.free[c])) {
+		msg = llist_entry(msgb_pool.free[c].next, struct msgb, list);
+		llist_del(&msg->list);
+		st->free--;
+		st->hits++;
+		talloc_steal(tall_msgb_ctx, msg);
+		talloc_set_name_const(msg, name);
+	} else {
+		msg = talloc_named_const(tall_msgb_ctx,
+			sizeof(*msg) + msgb_pool_sizes[c], name);
+		if (!msg)
+			return NULL;
+		st->misses++;
+	}
+
+	memset(msg, 0, sizeof(*msg));
+
+	return msg;
+}
+#endif /* !EMBEDDED */
+
 /*! \brief Allocate a new message buffer
  * \param[in] size Length in octets, including headroom
  * \param[in] name Human-readable name to be associated with msgb
@@ -43,12 +163,19 @@ void *tall_msgb_ctx;
  * This function allocates a 'struct msgb' as well as the underlying
  * memory buffer for the actual message data (size specified by \a size)
  * using the talloc memory context previously set by \ref msgb_set_talloc_ctx
+ * (or from the pool, see \ref msgb_pool_init)
  */
 struct msgb *msgb_alloc(uint16_t size, const char *name)
 {
-	struct msgb *msg;
+	struct msgb *msg = NULL;
 
-	msg = _talloc_zero(tall_msgb_ctx, sizeof(*msg) + size, name);
+#ifndef EMBEDDED
+	if (msgb_pool.max_free)
+		msg = msgb_pool_alloc(size, name);
+#endif
+
+	if (!msg)
+		msg = _talloc_zero(tall_msgb_ctx, sizeof(*msg) + size, name);
 
 	if (!msg) {
 		//LOGP(DRSL, LOGL_FATAL, "unable to allocate msgb\n");
@@ -60,15 +187,90 @@ struct msgb *msgb_alloc(uint16_t size, const char *name)
 	msg->data = msg->_data;
 	msg->head = msg->_data;
 	msg->tail = msg->_data;
+	msg->_refcnt = 1;
 
 	return msg;
 }
 
+/*! \brief Create a clone of a message buffer sharing its data
+ *  \param[in] msg message buffer (or clone) to be cloned
+ *  \param[in] name Human-readable name to be associated with the clone
+ *  \returns new message buffer, NULL on allocation failure
+ *
+ * The clone only consists of a new 'struct msgb' with its own head,
+ * data and tail cursors, layer header pointers and control buffer, all
+ * initialized from \a msg.  The data itself is not copied but
+ * referenced, and only released once the original and all clones have
+ * been passed to \ref msgb_free, in any order.  This allows to enqueue
+ * one received frame to several consumers without copying it.
+ *
+ * As the data is shared, it must be treated as read-only by all users
+ * (see \ref msgb_is_shared).  msgb_pull() and the like only move the
+ * cursors of one msgb and are fine, but a clone has no tailroom.
+ */
+struct msgb *msgb_clone_shared(struct msgb *msg, const char *name)
+{
+	struct msgb *root = msg->_shared ? msg->_shared : msg;
+	struct msgb *clone;
+
+	clone = _talloc_zero(tall_msgb_ctx, sizeof(*clone), name);
+	if (!clone)
+		return NULL;
+
+	clone->dst = msg->dst;
+	clone->lchan = msg->lchan;
+	clone->l1h = msg->l1h;
+	clone->l2h = msg->l2h;
+	clone->l3h = msg->l3h;
+	clone->l4h = msg->l4h;
+	memcpy(clone->cb, msg->cb, sizeof(clone->cb));
+
+	clone->head = msg->head;
+	clone->data = msg->data;
+	clone->tail = msg->tail;
+	clone->len = msg->len;
+	clone->data_len = msg->tail - msg->head;
+
+	clone->_shared = root;
+	root->_refcnt++;
+
+	return clone;
+}
+
 /*! \brief Release given message buffer
  * \param[in] m Message buffer to be free'd
  */
 void msgb_free(struct msgb *m)
 {
+	if (m->_shared) {
+		struct msgb *root = m->_shared;
+
+		talloc_free(m);
+		m = root;
+	}
+
+	/* the data is still referenced by clones (or the original) */
+	if (m->_refcnt > 1) {
+		m->_refcnt--;
+		return;
+	}
+
+#ifndef EMBEDDED
+	if (msgb_pool.max_free) {
+		int c = msgb_pool_class(m->data_len);
+
+		/* whatever allocated it, a chunk of the class size fits */
+		if (c >= 0 && msgb_pool.stats[c].free < msgb_pool.max_free &&
+		    talloc_get_size(m) == sizeof(*m) + msgb_pool_sizes[c]) {
+			talloc_steal(msgb_pool.ctx, m);
+			talloc_set_name_const(m, "msgb (free)");
+			llist_add(&m->list, &msgb_pool.free[c]);
+			msgb_pool.stats[c].free++;
+			return;
+		}
+	}
+#endif
+
 	talloc_free(m);
 }
 
@@ -110,13 +312,21 @@ struct msgb *msgb_dequeue(struct llist_head *queue)
  * This will re-set the various internal pointers into the underlying
  * message buffer, i.e. remvoe all headroom and treat the msgb as
  * completely empty.  It also initializes the control buffer to zero.
+ * A clone stays without tailroom, as the data is not its own.
  */
 void msgb_reset(struct msgb *msg)
 {
+	unsigned char *buf = msg->_data;
+
+	if (msg->_shared) {
+		buf = msg->_shared->_data;
+		msg->data_len = 0;
+	}
+
 	msg->len = 0;
-	msg->data = msg->_data;
-	msg->head = msg->_data;
-	msg->tail = msg->_data;
+	msg->data = buf;
+	msg->head = buf;
+	msg->tail = buf;
 
 	msg->trx = NULL;
 	msg->lchan = NULL;
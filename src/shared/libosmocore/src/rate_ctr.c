@@ -38,12 +38,43 @@
 
 static LLIST_HEAD(rate_ctr_groups);
 
+/* groups hashed by name and index, for rate_ctr_get_group_by_name_idx() */
+#define RATE_CTR_HASH_SIZE	64
+static struct llist_head rate_ctr_hash[RATE_CTR_HASH_SIZE];
+
 static void *tall_rate_ctr_ctx;
 
+static struct llist_head *rate_ctr_bucket(const char *name, unsigned int idx)
+{
+	unsigned int h = idx;
+
+	if (!rate_ctr_hash[0].next) {
+		unsigned int i;
+		for (i = 0; i < RATE_CTR_HASH_SIZE; i++)
+			INIT_LLIST_HEAD(&rate_ctr_hash[i]);
+	}
+
+	while (*name)
+		h = h * 31 + *name++;
+
+	return &rate_ctr_hash[h & (RATE_CTR_HASH_SIZE - 1)];
+}
+
+static int rate_ctr_group_destructor(struct rate_ctr_group *grp)
+{
+	llist_del(&grp->list);
+	llist_del(&grp->hash_list);
+
+	return 0;
+}
+
 /*! \brief Allocate a new group of counters according to description
  *  \param[in] ctx \ref talloc context
  *  \param[in] desc Rate counter group description
  *  \param[in] idx Index of new counter group
+ *
+ * The group is unregistered when it is freed, also if that happens
+ * through freeing \a ctx.
  */
 struct rate_ctr_group *rate_ctr_group_alloc(void *ctx,
 					    const struct rate_ctr_group_desc *desc,
@@ -66,6 +97,9 @@ struct rate_ctr_group *rate_ctr_group_alloc(void *ctx,
 	group->idx = idx;
 
 	llist_add(&group->list, &rate_ctr_groups);
+	llist_add(&group->hash_list,
+		  rate_ctr_bucket(desc->group_name_prefix, idx));
+	talloc_set_destructor(group, rate_ctr_group_destructor);
 
 	return group;
 }
@@ -73,7 +107,6 @@ struct rate_ctr_group *rate_ctr_group_alloc(void *ctx,
 /*! \brief Free the memory for the specified group of counters */
 void rate_ctr_group_free(struct rate_ctr_group *grp)
 {
-	llist_del(&grp->list);
 	talloc_free(grp);
 }
 
@@ -146,18 +179,34 @@ struct rate_ctr_group *rate_ctr_get_group_by_name_idx(const char *name, const un
 {
 	struct rate_ctr_group *ctrg;
 
-	llist_for_each_entry(ctrg, &rate_ctr_groups, list) {
-		if (!ctrg->desc)
-			continue;
-
-		if (!strcmp(ctrg->desc->group_name_prefix, name) &&
-				ctrg->idx == idx) {
+	llist_for_each_entry(ctrg, rate_ctr_bucket(name, idx), hash_list) {
+		if (ctrg->idx == idx &&
+		    !strcmp(ctrg->desc->group_name_prefix, name))
 			return ctrg;
-		}
 	}
 	return NULL;
 }
 
+/*! \brief Iterate over all counter groups
+ *  \param[in] handle_group Call-back function, iteration stops if it
+ *  returns a negative value
+ *  \param[in] data Private data handed through to \a handle_group
+ */
+int rate_ctr_for_each_group(int (*handle_group)(struct rate_ctr_group *,
+						 void *), void *data)
+{
+	struct rate_ctr_group *ctrg;
+	int rc = 0;
+
+	llist_for_each_entry(ctrg, &rate_ctr_groups, list) {
+		rc = handle_group(ctrg, data);
+		if (rc < 0)
+			return rc;
+	}
+
+	return rc;
+}
+
 /*! \brief Search for counter group based on group name */
 const struct rate_ctr *rate_ctr_get_by_name(const struct rate_ctr_group *ctrg, const char *name)
 {
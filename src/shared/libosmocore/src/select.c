@@ -19,8 +19,12 @@
  *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include <osmocom/core/select.h>
 #include <osmocom/core/linuxlist.h>
@@ -28,6 +32,10 @@
 
 #include "../config.h"
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #ifdef HAVE_SYS_SELECT_H
 
 /*! \addtogroup select
@@ -42,6 +50,248 @@ static int maxfd = 0;
 static LLIST_HEAD(osmo_fds);
 static int unregistered_count;
 
+static enum osmo_select_backend select_backend = OSMO_SELECT_SELECT;
+
+#ifdef HAVE_SYS_EPOLL_H
+
+/* With epoll, the fds stay registered with the kernel and only the ready
+ * ones are dispatched. An fd is added when registered. As osmo_fd.when
+ * may be changed directly by its owner, each iteration compares it with
+ * the shadow of what was registered last, one integer per fd instead of
+ * building and scanning the fd_sets, and only calls epoll_ctl() for the
+ * changed ones. Events carry the fd number, looked up in a table indexed
+ * by it, so that unregistering from a callback simply clears the entry. */
+
+#define EPOLL_MAX_EVENTS	256
+
+struct epoll_entry {
+	struct osmo_fd *ofd;	/* NULL if not registered */
+	unsigned int when;	/* interest registered with the kernel */
+};
+
+static int epfd = -1;
+static struct epoll_entry *ep_tbl;
+static int ep_tbl_size;
+
+static int epoll_tbl_grow(int fd)
+{
+	struct epoll_entry *tbl;
+	int size = ep_tbl_size ? ep_tbl_size : 64;
+
+	while (size <= fd)
+		size *= 2;
+
+	tbl = realloc(ep_tbl, size * sizeof(*tbl));
+	if (!tbl)
+		return -ENOMEM;
+
+	memset(&tbl[ep_tbl_size], 0, (size - ep_tbl_size) * sizeof(*tbl));
+	ep_tbl = tbl;
+	ep_tbl_size = size;
+
+	return 0;
+}
+
+static uint32_t epoll_events(unsigned int when)
+{
+	uint32_t events = 0;
+
+	if (when & BSC_FD_READ)
+		events |= EPOLLIN;
+	if (when & BSC_FD_WRITE)
+		events |= EPOLLOUT;
+	if (when & BSC_FD_EXCEPT)
+		events |= EPOLLPRI;
+
+	return events;
+}
+
+/* Bring the kernel side in line with osmo_fd.when of one fd */
+static int epoll_update(struct osmo_fd *ufd)
+{
+	struct epoll_entry *e;
+	struct epoll_event ev;
+	unsigned int when = ufd->when & (BSC_FD_READ | BSC_FD_WRITE | BSC_FD_EXCEPT);
+	int op;
+
+	if (ufd->fd >= ep_tbl_size && epoll_tbl_grow(ufd->fd))
+		return -ENOMEM;
+
+	e = &ep_tbl[ufd->fd];
+	if (e->ofd == ufd && e->when == when)
+		return 0;
+
+	/* an fd without interest would still report hangups, so
+	 * it is taken out of the set altogether */
+	if (!when) {
+		if (e->when)
+			epoll_ctl(epfd, EPOLL_CTL_DEL, ufd->fd, NULL);
+		e->ofd = ufd;
+		e->when = 0;
+		return 0;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = epoll_events(when);
+	ev.data.fd = ufd->fd;
+
+	op = e->when ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if (epoll_ctl(epfd, op, ufd->fd, &ev) < 0) {
+		/* the kernel drops closed fds by itself, and keeps
+		 * the ones still open elsewhere */
+		if (errno == ENOENT)
+			epoll_ctl(epfd, EPOLL_CTL_ADD, ufd->fd, &ev);
+		else if (errno == EEXIST)
+			epoll_ctl(epfd, EPOLL_CTL_MOD, ufd->fd, &ev);
+	}
+
+	e->ofd = ufd;
+	e->when = when;
+
+	return 0;
+}
+
+/* Bring the kernel side in line with osmo_fd.when of all fds */
+static void epoll_sync(void)
+{
+	struct osmo_fd *ufd;
+
+	llist_for_each_entry(ufd, &osmo_fds, list)
+		epoll_update(ufd);
+}
+
+static void epoll_unregister(struct osmo_fd *fd)
+{
+	struct epoll_entry *e;
+
+	if (fd->fd < 0 || fd->fd >= ep_tbl_size)
+		return;
+
+	e = &ep_tbl[fd->fd];
+	if (e->ofd != fd)
+		return;
+
+	/* fails harmlessly if the fd was closed already */
+	if (e->when)
+		epoll_ctl(epfd, EPOLL_CTL_DEL, fd->fd, NULL);
+
+	e->ofd = NULL;
+	e->when = 0;
+}
+
+static int epoll_main(int polling)
+{
+	struct epoll_event events[EPOLL_MAX_EVENTS];
+	struct timeval *tv = NULL;
+	int timeout = -1, work = 0, n, i;
+
+	epoll_sync();
+
+	if (!polling) {
+		osmo_timers_prepare();
+		tv = osmo_timers_nearest();
+	}
+
+	if (polling)
+		timeout = 0;
+	else if (tv && osmo_clock_get_mode() == OSMO_CLOCK_VIRTUAL)
+		timeout = 0;
+	else if (tv)	/* rounded up, waking early would spin */
+		timeout = tv->tv_sec * 1000 + (tv->tv_usec + 999) / 1000;
+
+	n = epoll_wait(epfd, events, EPOLL_MAX_EVENTS, timeout);
+	if (n < 0)
+		return 0;
+
+	/* discrete event mode: nothing ready, jump to the next timer */
+	if (!n && !polling && tv && osmo_clock_get_mode() == OSMO_CLOCK_VIRTUAL) {
+		struct timeval next = *tv;
+		osmo_clock_advance(&next);
+	}
+
+	/* fire timers */
+	osmo_timers_update();
+
+	/* call registered callback functions */
+	for (i = 0; i < n; i++) {
+		int fd = events[i].data.fd;
+		uint32_t ev = events[i].events;
+		struct osmo_fd *ufd;
+		unsigned int flags = 0;
+
+		/* unregistered by an earlier callback? */
+		if (fd >= ep_tbl_size || !(ufd = ep_tbl[fd].ofd))
+			continue;
+
+		/* as select(), report hangups and errors as readable
+		 * (errors also as writable) */
+		if (ev & (EPOLLIN | EPOLLHUP | EPOLLERR))
+			flags |= BSC_FD_READ;
+		if (ev & (EPOLLOUT | EPOLLERR))
+			flags |= BSC_FD_WRITE;
+		if (ev & EPOLLPRI)
+			flags |= BSC_FD_EXCEPT;
+
+		flags &= ufd->when;
+		if (flags) {
+			work = 1;
+			ufd->cb(ufd, flags);
+		}
+	}
+
+	return work;
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
+
+/*! \brief select the implementation of osmo_select_main()
+ *  \param[in] backend the backend to use from now on
+ *  \returns 0 on success, negative on error
+ *
+ * The default is select(), which rebuilds the fd_sets from all registered
+ * fds on every call and is limited to FD_SETSIZE. epoll keeps the fds
+ * registered with the kernel and only dispatches the ready ones. Registered
+ * fds are carried over when switching.
+ */
+int osmo_select_set_backend(enum osmo_select_backend backend)
+{
+	switch (backend) {
+	case OSMO_SELECT_SELECT:
+#ifdef HAVE_SYS_EPOLL_H
+		if (epfd >= 0) {
+			close(epfd);
+			epfd = -1;
+			memset(ep_tbl, 0, ep_tbl_size * sizeof(*ep_tbl));
+		}
+#endif
+		break;
+	case OSMO_SELECT_EPOLL:
+#ifdef HAVE_SYS_EPOLL_H
+		if (epfd < 0) {
+			epfd = epoll_create(64);
+			if (epfd < 0)
+				return -errno;
+			fcntl(epfd, F_SETFD, FD_CLOEXEC);
+		}
+		break;
+#else
+		return -ENOTSUP;
+#endif
+	default:
+		return -EINVAL;
+	}
+
+	select_backend = backend;
+
+	return 0;
+}
+
+/*! \brief get the implementation of osmo_select_main() in use */
+enum osmo_select_backend osmo_select_get_backend(void)
+{
+	return select_backend;
+}
+
 /*! \brief Register a new file descriptor with select loop abstraction
  *  \param[in] fd osmocom file descriptor to be registered
  */
@@ -81,6 +331,11 @@ int osmo_fd_register(struct osmo_fd *fd)
 	}
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+	if (select_backend == OSMO_SELECT_EPOLL && epoll_update(fd) < 0)
+		return -ENOMEM;
+#endif
+
 	llist_add_tail(&fd->list, &osmo_fds);
 
 	return 0;
@@ -93,6 +348,10 @@ void osmo_fd_unregister(struct osmo_fd *fd)
 {
 	unregistered_count++;
 	llist_del(&fd->list);
+#ifdef HAVE_SYS_EPOLL_H
+	if (select_backend == OSMO_SELECT_EPOLL)
+		epoll_unregister(fd);
+#endif
 }
 
 /*! \brief select main loop integration
@@ -105,6 +364,11 @@ int osmo_select_main(int polling)
 	int work = 0, rc;
 	struct timeval no_time = {0, 0};
 
+#ifdef HAVE_SYS_EPOLL_H
+	if (select_backend == OSMO_SELECT_EPOLL)
+		return epoll_main(polling);
+#endif
+
 	FD_ZERO(&readset);
 	FD_ZERO(&writeset);
 	FD_ZERO(&exceptset);
@@ -121,11 +385,20 @@ int osmo_select_main(int polling)
 			FD_SET(ufd->fd, &exceptset);
 	}
 
-	osmo_timers_check();
-
 	if (!polling)
 		osmo_timers_prepare();
-	rc = select(maxfd+1, &readset, &writeset, &exceptset, polling ? &no_time : osmo_timers_nearest());
+
+	if (!polling && osmo_timers_nearest() &&
+	    osmo_clock_get_mode() == OSMO_CLOCK_VIRTUAL) {
+		/* discrete event mode: if no fd is ready right now, jump
+		 * straight to the next timer rather than waiting for it */
+		struct timeval next = *osmo_timers_nearest();
+
+		rc = select(maxfd+1, &readset, &writeset, &exceptset, &no_time);
+		if (rc == 0)
+			osmo_clock_advance(&next);
+	} else
+		rc = select(maxfd+1, &readset, &writeset, &exceptset, polling ? &no_time : osmo_timers_nearest());
 	if (rc < 0)
 		return 0;
 
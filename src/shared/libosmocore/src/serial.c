@@ -94,10 +94,10 @@ osmo_serial_init(const char *dev, speed_t baudrate)
 		goto error;
 	}
 
-	/* Set ready to read/write */
+	/* Set ready to read/write, a pty has no modem control lines */
 	v24 = TIOCM_DTR | TIOCM_RTS;
 	rc = ioctl(fd, TIOCMBIS, &v24);
-	if (rc < 0) {
+	if (rc < 0 && errno != ENOTTY) {
 		dbg_perror("ioctl(TIOCMBIS)");
 		rc = -errno;
 		goto error;
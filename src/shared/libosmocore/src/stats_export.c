@@ -0,0 +1,298 @@
+/* Export of counters to a statsd-like sink */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \addtogroup rate_ctr
+ *  @{
+ */
+
+/*! \file stats_export.c
+ *
+ * All rate counter groups and osmo_counters are written as lines
+ * "<prefix>.<group>.<idx>.<counter>:<value>|g" (osmo_counters without
+ * group and index).  The absolute values are sent as gauges, so a lost
+ * datagram doesn't lose any counts, the sink derives the rates.  Lines
+ * are packed into datagrams of at most \ref OSMO_STATS_MAX_DGRAM bytes
+ * and sent over UDP or to a unix domain datagram socket.
+ */
+
+#include "../config.h"
+
+#ifdef HAVE_SYS_SOCKET_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/linuxlist.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/socket.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/statistics.h>
+#include <osmocom/core/stats_export.h>
+
+struct osmo_stats_export {
+	int fd;
+	struct sockaddr_un sun;	/* only for unix sockets */
+	int is_unix;
+	char *prefix;
+	unsigned int interval;
+	struct osmo_timer_list timer;
+	unsigned long errors;
+
+	char buf[OSMO_STATS_MAX_DGRAM];
+	int len;
+};
+
+/* where the lines go, either a buffer or a socket */
+struct stats_sink {
+	/* snapshot */
+	char *buf;
+	size_t size;
+	size_t len;
+	/* export */
+	struct osmo_stats_export *exp;
+	const char *prefix;
+};
+
+static void stats_flush(struct osmo_stats_export *exp)
+{
+	int rc;
+
+	if (!exp->len)
+		return;
+
+	if (exp->is_unix)
+		rc = sendto(exp->fd, exp->buf, exp->len, MSG_DONTWAIT,
+			    (struct sockaddr *) &exp->sun, sizeof(exp->sun));
+	else
+		rc = send(exp->fd, exp->buf, exp->len, MSG_DONTWAIT);
+	if (rc != exp->len)
+		exp->errors++;
+
+	exp->len = 0;
+}
+
+/* statsd uses ':' and '|' as separators, counter names have ':' */
+static void stats_name(char *name)
+{
+	for (; *name; name++) {
+		if (*name == ':')
+			*name = '.';
+		else if (*name == '|' || *name == ' ')
+			*name = '_';
+	}
+}
+
+static void stats_line(struct stats_sink *sink, const char *group, int idx,
+		       const char *ctr, unsigned long long value)
+{
+	char name[128], line[192];
+	int len;
+
+	if (idx < 0)
+		snprintf(name, sizeof(name), "%s", ctr);
+	else
+		snprintf(name, sizeof(name), "%s.%u.%s", group, idx, ctr);
+	stats_name(name);
+
+	len = snprintf(line, sizeof(line), "%s%s%s:%llu|g\n",
+		       sink->prefix ? sink->prefix : "",
+		       sink->prefix ? "." : "", name, value);
+	if (len >= (int) sizeof(line))
+		len = sizeof(line) - 1;
+
+	if (!sink->exp) {
+		if (sink->len < sink->size)
+			snprintf(sink->buf + sink->len, sink->size - sink->len,
+				 "%s", line);
+		sink->len += len;
+		return;
+	}
+
+	if (sink->exp->len + len > (int) sizeof(sink->exp->buf))
+		stats_flush(sink->exp);
+	memcpy(sink->exp->buf + sink->exp->len, line, len);
+	sink->exp->len += len;
+}
+
+static int stats_group(struct rate_ctr_group *ctrg, void *data)
+{
+	unsigned int i;
+
+	for (i = 0; i < ctrg->desc->num_ctr; i++)
+		stats_line(data, ctrg->desc->group_name_prefix, ctrg->idx,
+			   ctrg->desc->ctr_desc[i].name, ctrg->ctr[i].current);
+
+	return 0;
+}
+
+static int stats_counter(struct osmo_counter *ctr, void *data)
+{
+	stats_line(data, NULL, -1, ctr->name, ctr->value);
+
+	return 0;
+}
+
+static void stats_all(struct stats_sink *sink)
+{
+	rate_ctr_for_each_group(stats_group, sink);
+	osmo_counters_for_each(stats_counter, sink);
+}
+
+/*! \brief Write the current value of all counters into a buffer
+ *  \param[out] buf buffer, always NUL terminated if \a len > 0
+ *  \param[in] len size of \a buf
+ *  \param[in] prefix prepended to all names, may be NULL
+ *  \returns length of the whole snapshot, like snprintf()
+ *
+ * The lines have the same format as the ones exported.
+ */
+int osmo_stats_snapshot(char *buf, size_t len, const char *prefix)
+{
+	struct stats_sink sink = {
+		.buf = buf,
+		.size = len,
+		.prefix = prefix,
+	};
+
+	if (len)
+		buf[0] = '\0';
+	stats_all(&sink);
+
+	return sink.len;
+}
+
+/*! \brief Send the current value of all counters to the sink now */
+int osmo_stats_export_send(struct osmo_stats_export *exp)
+{
+	struct stats_sink sink = {
+		.exp = exp,
+		.prefix = exp->prefix,
+	};
+	unsigned long errors = exp->errors;
+
+	stats_all(&sink);
+	stats_flush(exp);
+
+	return exp->errors == errors ? 0 : -EIO;
+}
+
+/*! \brief Number of datagrams that could not be sent */
+unsigned long osmo_stats_export_errors(const struct osmo_stats_export *exp)
+{
+	return exp->errors;
+}
+
+static void stats_timer_cb(void *data)
+{
+	struct osmo_stats_export *exp = data;
+
+	osmo_stats_export_send(exp);
+	osmo_timer_schedule(&exp->timer, exp->interval, 0);
+}
+
+static int stats_open(struct osmo_stats_export *exp, const char *dest)
+{
+	char host[256];
+	const char *port;
+
+	if (!strncmp(dest, "unix:", 5)) {
+		dest += 5;
+		if (strlen(dest) >= sizeof(exp->sun.sun_path))
+			return -EINVAL;
+		exp->sun.sun_family = AF_UNIX;
+		strcpy(exp->sun.sun_path, dest);
+		exp->is_unix = 1;
+		exp->fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+		return exp->fd < 0 ? -errno : 0;
+	}
+
+	/* host:port, [v6addr]:port */
+	port = strrchr(dest, ':');
+	if (!port || port - dest >= (int) sizeof(host))
+		return -EINVAL;
+	if (dest[0] == '[' && port[-1] == ']')
+		snprintf(host, sizeof(host), "%.*s", (int)(port - dest - 2),
+			 dest + 1);
+	else
+		snprintf(host, sizeof(host), "%.*s", (int)(port - dest), dest);
+
+	exp->fd = osmo_sock_init(AF_UNSPEC, SOCK_DGRAM, IPPROTO_UDP, host,
+				 atoi(port + 1), OSMO_SOCK_F_CONNECT);
+	return exp->fd < 0 ? exp->fd : 0;
+}
+
+/*! \brief Start exporting all counters periodically
+ *  \param[in] ctx talloc context
+ *  \param[in] dest "host:port" for UDP or "unix:path" for a unix domain
+ *  datagram socket
+ *  \param[in] prefix prepended to all names, may be NULL
+ *  \param[in] interval seconds between two exports, 0 to only export
+ *  on \ref osmo_stats_export_send
+ *  \returns exporter, NULL on error
+ *
+ * A missing sink is not an error, the datagrams are counted as errors
+ * until it appears.
+ */
+struct osmo_stats_export *osmo_stats_export_create(void *ctx,
+						   const char *dest,
+						   const char *prefix,
+						   unsigned int interval)
+{
+	struct osmo_stats_export *exp;
+
+	exp = talloc_zero(ctx, struct osmo_stats_export);
+	if (!exp)
+		return NULL;
+
+	if (stats_open(exp, dest) < 0) {
+		talloc_free(exp);
+		return NULL;
+	}
+
+	if (prefix)
+		exp->prefix = talloc_strdup(exp, prefix);
+	exp->interval = interval;
+	exp->timer.cb = stats_timer_cb;
+	exp->timer.data = exp;
+	if (interval)
+		osmo_timer_schedule(&exp->timer, interval, 0);
+
+	return exp;
+}
+
+/*! \brief Stop exporting and close the socket */
+void osmo_stats_export_destroy(struct osmo_stats_export *exp)
+{
+	osmo_timer_del(&exp->timer);
+	close(exp->fd);
+	talloc_free(exp);
+}
+
+#endif /* HAVE_SYS_SOCKET_H */
+
+/*! }@ */
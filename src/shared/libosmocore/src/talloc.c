@@ -275,6 +275,30 @@ static unsigned int *talloc_pool_objectcount(struct talloc_chunk *tc)
 	return (unsigned int *)((char *)tc + sizeof(struct talloc_chunk));
 }
 
+/*
+  Give pool memory back after a member has been freed. If only the pool
+  itself is left, the whole pool is free again. Otherwise, if the member
+  was the most recent allocation, the next one can reuse its space. Other
+  holes are only reused once the pool has drained.
+*/
+
+static void talloc_pool_reclaim(struct talloc_chunk *pool,
+				struct talloc_chunk *tc)
+{
+	char *next = (char *)tc + ((TC_HDR_SIZE + tc->size + 15) & ~15);
+
+	if (*talloc_pool_objectcount(pool) == 1) {
+		pool->pool = ((char *)pool + TC_HDR_SIZE + TALLOC_POOL_HDR_SIZE);
+	}
+	else if (next == (char *)pool->pool) {
+		pool->pool = tc;
+	}
+#if defined(DEVELOPER) && defined(VALGRIND_MAKE_MEM_NOACCESS)
+	VALGRIND_MAKE_MEM_NOACCESS(pool->pool,
+		((char *)pool + TC_HDR_SIZE + pool->size) - (char *)pool->pool);
+#endif
+}
+
 /*
   Allocate from a pool
 */
@@ -604,6 +628,9 @@ static inline int _talloc_free(void *ptr)
 		if (*pool_object_count == 0) {
 			free(pool);
 		}
+		else if (tc != pool && !(pool->flags & TALLOC_FLAG_FREE)) {
+			talloc_pool_reclaim(pool, tc);
+		}
 	}
 	else {
 		free(tc);
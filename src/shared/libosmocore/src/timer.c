@@ -35,14 +35,288 @@ static struct timeval *nearest_p;
  */
 
 #include <assert.h>
+#include <errno.h>
+#include <stdint.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 #include <osmocom/core/timer.h>
 #include <osmocom/core/timer_compat.h>
 #include <osmocom/core/linuxlist.h>
 
 static struct rb_root timer_root = RB_ROOT;
 
+static enum osmo_timer_backend timer_backend = OSMO_TIMER_RBTREE;
+
+
+/* Timing wheel ----------------------------------------------------------- */
+
+/* Hierarchical timing wheel, as the classic Linux kernel one: the first
+ * level has one slot per tick for the next 256 ticks, each further level
+ * 64 slots each covering a whole turn of the level below. Timers are kept
+ * in the slots through their 'list' member, and cascaded down one level
+ * whenever the level below wraps. Add and delete are O(1).
+ *
+ * The wheel runs on the monotonic clock, which osmo_timers_update() reads
+ * once per main loop iteration. Until the next osmo_timers_prepare()
+ * (i.e. from the callbacks), osmo_timer_schedule() uses that cached time,
+ * so timeouts are relative to the start of the current iteration. The
+ * select timeout is computed from a fresh reading, as the callbacks may
+ * have taken a while. */
+
+#define WHEEL_TICK_US	1000
+
+#define WHEEL_L0_BITS	8
+#define WHEEL_LN_BITS	6
+#define WHEEL_L0_SIZE	(1 << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE	(1 << WHEEL_LN_BITS)
+#define WHEEL_LEVELS	5	/* covers 2^32 ticks */
+
+#define WHEEL_SHIFT(l)	(WHEEL_L0_BITS + WHEEL_LN_BITS * ((l) - 1))
+
+static struct {
+	int init;
+	uint64_t base;		/* next tick to process */
+	unsigned int count;	/* number of active timers */
+	struct timeval now;	/* cached monotonic time */
+	int now_valid;
+
+	struct llist_head l0[WHEEL_L0_SIZE];
+	struct llist_head ln[WHEEL_LEVELS - 1][WHEEL_LN_SIZE];
+
+	/* non-empty slots (a set bit may be stale, never a clear one) */
+	uint64_t l0_map[WHEEL_L0_SIZE / 64];
+	uint64_t ln_map[WHEEL_LEVELS - 1];
+} wheel;
+
+static void wheel_read_clock(struct timeval *tv)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (osmo_clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		tv->tv_sec = ts.tv_sec;
+		tv->tv_usec = ts.tv_nsec / 1000;
+		return;
+	}
+#endif
+	osmo_gettimeofday(tv, NULL);
+}
+
+/* The time cached by osmo_timers_update() while inside the main loop
+ * iteration, a fresh one otherwise */
+static void wheel_now(struct timeval *tv)
+{
+	if (wheel.now_valid)
+		*tv = wheel.now;
+	else
+		wheel_read_clock(tv);
+}
+
+static inline uint64_t wheel_tv2tick(const struct timeval *tv, int round_up)
+{
+	uint64_t us = (uint64_t) tv->tv_sec * 1000000 + tv->tv_usec;
+	return (us + (round_up ? WHEEL_TICK_US - 1 : 0)) / WHEEL_TICK_US;
+}
+
+static void wheel_init(void)
+{
+	struct timeval now;
+	int i, l;
+
+	for (i = 0; i < WHEEL_L0_SIZE; i++)
+		INIT_LLIST_HEAD(&wheel.l0[i]);
+
+	for (l = 0; l < WHEEL_LEVELS - 1; l++)
+		for (i = 0; i < WHEEL_LN_SIZE; i++)
+			INIT_LLIST_HEAD(&wheel.ln[l][i]);
+
+	memset(wheel.l0_map, 0, sizeof(wheel.l0_map));
+	memset(wheel.ln_map, 0, sizeof(wheel.ln_map));
+
+	wheel_now(&now);
+	wheel.base = wheel_tv2tick(&now, 0);
+	wheel.init = 1;
+}
+
+static void wheel_insert(struct osmo_timer_list *timer)
+{
+	uint64_t expires = wheel_tv2tick(&timer->timeout, 1);
+	uint64_t delta;
+	unsigned int i;
+	int l;
+
+	/* already expired: the next slot to be processed */
+	if (expires < wheel.base)
+		expires = wheel.base;
+
+	delta = expires - wheel.base;
+
+	if (delta < WHEEL_L0_SIZE) {
+		i = expires & (WHEEL_L0_SIZE - 1);
+		llist_add_tail(&timer->list, &wheel.l0[i]);
+		wheel.l0_map[i / 64] |= 1ULL << (i % 64);
+		return;
+	}
+
+	/* too far away: park it in the last level, it will be put back
+	 * there when cascaded until it is close enough */
+	if (delta >> WHEEL_SHIFT(WHEEL_LEVELS))
+		expires = wheel.base + (1ULL << WHEEL_SHIFT(WHEEL_LEVELS)) - 1;
+
+	for (l = 1; l < WHEEL_LEVELS - 1; l++)
+		if (!(delta >> WHEEL_SHIFT(l + 1)))
+			break;
+
+	i = (expires >> WHEEL_SHIFT(l)) & (WHEEL_LN_SIZE - 1);
+	llist_add_tail(&timer->list, &wheel.ln[l - 1][i]);
+	wheel.ln_map[l - 1] |= 1ULL << i;
+}
+
+/* Move all timers of a slot of level l >= 1 to the levels below */
+static unsigned int wheel_cascade(int l)
+{
+	unsigned int i = (wheel.base >> WHEEL_SHIFT(l)) & (WHEEL_LN_SIZE - 1);
+	struct osmo_timer_list *this, *tmp;
+	LLIST_HEAD(slot);
+
+	llist_splice_init(&wheel.ln[l - 1][i], &slot);
+	wheel.ln_map[l - 1] &= ~(1ULL << i);
+
+	llist_for_each_entry_safe(this, tmp, &slot, list)
+		wheel_insert(this);
+
+	return i;
+}
+
+/* Index of the first set bit at or after 'from' in a bitmap, or -1 */
+static int wheel_map_next(const uint64_t *map, int n_bits, int from)
+{
+	int w;
+	uint64_t m;
+
+	for (w = from / 64; w * 64 < n_bits; w++) {
+		m = map[w];
+		if (w == from / 64)
+			m &= ~0ULL << (from % 64);
+		if (m)
+			return w * 64 + __builtin_ctzll(m);
+	}
+
+	return -1;
+}
+
+/* The clock was switched or set: start again from the new time, the
+ * pending timers keep their timeouts on it */
+static void wheel_rebase(void)
+{
+	struct osmo_timer_list *this, *tmp;
+	struct timeval now;
+	LLIST_HEAD(all);
+	int i, l;
+
+	for (i = 0; i < WHEEL_L0_SIZE; i++)
+		llist_splice_init(&wheel.l0[i], &all);
+
+	for (l = 0; l < WHEEL_LEVELS - 1; l++)
+		for (i = 0; i < WHEEL_LN_SIZE; i++)
+			llist_splice_init(&wheel.ln[l][i], &all);
+
+	memset(wheel.l0_map, 0, sizeof(wheel.l0_map));
+	memset(wheel.ln_map, 0, sizeof(wheel.ln_map));
+
+	wheel_read_clock(&now);
+	wheel.base = wheel_tv2tick(&now, 0);
+
+	llist_for_each_entry_safe(this, tmp, &all, list) {
+		llist_del(&this->list);
+		wheel_insert(this);
+	}
+}
+
+/* Process all ticks up to 'now_tick', expired timers go to 'expired' */
+static void wheel_advance(uint64_t now_tick, struct llist_head *expired)
+{
+	struct osmo_timer_list *this, *tmp;
+	unsigned int idx;
+	int l, next;
+
+	/* nothing to walk through */
+	if (!wheel.count && wheel.base <= now_tick) {
+		wheel.base = now_tick + 1;
+		return;
+	}
+
+	while (wheel.base <= now_tick) {
+		idx = wheel.base & (WHEEL_L0_SIZE - 1);
+
+		if (!idx) {
+			for (l = 1; l < WHEEL_LEVELS; l++)
+				if (wheel_cascade(l))
+					break;
+		}
+
+		if (wheel.l0_map[idx / 64] & (1ULL << (idx % 64))) {
+			wheel.l0_map[idx / 64] &= ~(1ULL << (idx % 64));
+			llist_for_each_entry_safe(this, tmp, &wheel.l0[idx], list)
+				llist_move_tail(&this->list, expired);
+		}
+
+		/* skip the empty slots, up to the next wrap at most */
+		next = wheel_map_next(wheel.l0_map, WHEEL_L0_SIZE, idx + 1);
+		if (next < 0)
+			next = WHEEL_L0_SIZE;
+
+		wheel.base += next - idx;
+		if (wheel.base > now_tick + 1)
+			wheel.base = now_tick + 1;
+	}
+}
+
+/* First tick at which something may need to be done, or UINT64_MAX */
+static uint64_t wheel_next_event(void)
+{
+	uint64_t next = UINT64_MAX, t;
+	unsigned int c, d;
+	int l, s;
+
+	/* level 0 is exact */
+	c = wheel.base & (WHEEL_L0_SIZE - 1);
+	s = wheel_map_next(wheel.l0_map, WHEEL_L0_SIZE, c);
+	if (s < 0)
+		s = wheel_map_next(wheel.l0_map, WHEEL_L0_SIZE, 0);
+	if (s >= 0)
+		next = wheel.base + ((s - c) & (WHEEL_L0_SIZE - 1));
+
+	/* upper levels: when their next non-empty slot gets cascaded */
+	for (l = 1; l < WHEEL_LEVELS; l++) {
+		uint64_t map = wheel.ln_map[l - 1];
+
+		if (!map)
+			continue;
+
+		c = (wheel.base >> WHEEL_SHIFT(l)) & (WHEEL_LN_SIZE - 1);
+		s = wheel_map_next(&map, WHEEL_LN_SIZE, c);
+		if (s < 0)
+			s = wheel_map_next(&map, WHEEL_LN_SIZE, 0);
+
+		d = (s - c) & (WHEEL_LN_SIZE - 1);
+		/* the current slot is only due now if we are right on
+		 * its boundary, otherwise it is a whole turn away */
+		if (!d && (wheel.base & ((1ULL << WHEEL_SHIFT(l)) - 1)))
+			d = WHEEL_LN_SIZE;
+
+		t = ((wheel.base >> WHEEL_SHIFT(l)) + d) << WHEEL_SHIFT(l);
+		if (t < next)
+			next = t;
+	}
+
+	return next;
+}
+
+
+/* rb-tree ---------------------------------------------------------------- */
+
 static void __add_timer(struct osmo_timer_list *timer)
 {
 	struct rb_node **new = &(timer_root.rb_node);
@@ -72,7 +346,14 @@ void osmo_timer_add(struct osmo_timer_list *timer)
 	osmo_timer_del(timer);
 	timer->active = 1;
 	INIT_LLIST_HEAD(&timer->list);
-	__add_timer(timer);
+
+	if (timer_backend == OSMO_TIMER_WHEEL) {
+		if (!wheel.init)
+			wheel_init();
+		wheel_insert(timer);
+		wheel.count++;
+	} else
+		__add_timer(timer);
 }
 
 /*! \brief schedule a timer at a given future relative time
@@ -90,7 +371,10 @@ osmo_timer_schedule(struct osmo_timer_list *timer, int seconds, int microseconds
 {
 	struct timeval current_time;
 
-	gettimeofday(&current_time, NULL);
+	if (timer_backend == OSMO_TIMER_WHEEL)
+		wheel_now(&current_time);
+	else
+		osmo_gettimeofday(&current_time, NULL);
 	timer->timeout.tv_sec = seconds;
 	timer->timeout.tv_usec = microseconds;
 	timeradd(&timer->timeout, &current_time, &timer->timeout);
@@ -107,8 +391,12 @@ void osmo_timer_del(struct osmo_timer_list *timer)
 {
 	if (timer->active) {
 		timer->active = 0;
-		rb_erase(&timer->node, &timer_root);
-		/* make sure this is not already scheduled for removal. */
+		if (timer_backend == OSMO_TIMER_WHEEL)
+			wheel.count--;
+		else
+			rb_erase(&timer->node, &timer_root);
+		/* make sure this is not already scheduled for removal
+		 * (or, with the timing wheel, still in its slot). */
 		if (!llist_empty(&timer->list))
 			llist_del_init(&timer->list);
 	}
@@ -126,6 +414,79 @@ int osmo_timer_pending(struct osmo_timer_list *timer)
 	return timer->active;
 }
 
+/*! \brief compute the time left until a timer expires
+ *  \param[in] timer the timer to be checked
+ *  \param[out] remaining time left ({0, 0} if already due)
+ *  \returns 0 if the timer is pending, -1 otherwise
+ *
+ * Unlike reading timer->timeout directly, this does not depend on which
+ * clock the selected backend is using.
+ */
+int osmo_timer_remaining(const struct osmo_timer_list *timer,
+			 struct timeval *remaining)
+{
+	struct timeval current_time;
+
+	if (!timer->active)
+		return -1;
+
+	if (timer_backend == OSMO_TIMER_WHEEL)
+		wheel_now(&current_time);
+	else
+		osmo_gettimeofday(&current_time, NULL);
+
+	if (timercmp(&timer->timeout, &current_time, >))
+		timersub(&timer->timeout, &current_time, remaining);
+	else
+		timerclear(remaining);
+
+	return 0;
+}
+
+/*! \brief select the timer implementation
+ *  \param[in] backend the backend to use from now on
+ *  \returns 0 on success, -EBUSY if timers are pending
+ *
+ * The default is the rb-tree, which has O(log n) add and delete and uses
+ * gettimeofday(). The timing wheel has O(1) add and delete at a 1ms
+ * resolution, and uses the monotonic clock: timer->timeout is then on
+ * that clock and not comparable to gettimeofday() values. This has to be
+ * called before any timer is added.
+ */
+int osmo_timers_set_backend(enum osmo_timer_backend backend)
+{
+	if (backend != OSMO_TIMER_RBTREE && backend != OSMO_TIMER_WHEEL)
+		return -EINVAL;
+
+	if (backend == timer_backend)
+		return 0;
+
+	if (osmo_timers_check())
+		return -EBUSY;
+
+	timer_backend = backend;
+	wheel.init = 0;
+	wheel.now_valid = 0;
+
+	return 0;
+}
+
+/* called by timer_clock.c when the clock is switched or set, the time
+ * cached for the loop iteration and the wheel are on the old one */
+void _osmo_timers_clock_changed(void)
+{
+	wheel.now_valid = 0;
+
+	if (wheel.init)
+		wheel_rebase();
+}
+
+/*! \brief get the selected timer implementation */
+enum osmo_timer_backend osmo_timers_get_backend(void)
+{
+	return timer_backend;
+}
+
 /*
  * if we have a nearest time return the delta between the current
  * time and the time of the nearest timer.
@@ -164,7 +525,31 @@ void osmo_timers_prepare(void)
 	struct rb_node *node;
 	struct timeval current;
 
-	gettimeofday(&current, NULL);
+	if (timer_backend == OSMO_TIMER_WHEEL) {
+		uint64_t next;
+
+		/* the callbacks of this loop iteration are done */
+		wheel.now_valid = 0;
+		wheel_read_clock(&current);
+
+		if (!wheel.count) {
+			nearest_p = NULL;
+			return;
+		}
+
+		next = wheel_next_event();
+
+		if (next != UINT64_MAX) {
+			struct timeval cand;
+			cand.tv_sec = next / (1000000 / WHEEL_TICK_US);
+			cand.tv_usec = (next % (1000000 / WHEEL_TICK_US)) * WHEEL_TICK_US;
+			update_nearest(&cand, &current);
+		} else
+			nearest_p = NULL;
+		return;
+	}
+
+	osmo_gettimeofday(&current, NULL);
 
 	node = rb_first(&timer_root);
 	if (node) {
@@ -187,16 +572,27 @@ int osmo_timers_update(void)
 	struct osmo_timer_list *this;
 	int work = 0;
 
-	gettimeofday(&current_time, NULL);
-
 	INIT_LLIST_HEAD(&timer_eviction_list);
-	for (node = rb_first(&timer_root); node; node = rb_next(node)) {
-		this = container_of(node, struct osmo_timer_list, node);
 
-		if (timercmp(&this->timeout, &current_time, >))
-			break;
+	if (timer_backend == OSMO_TIMER_WHEEL) {
+		/* the only clock read of the main loop iteration */
+		wheel_read_clock(&wheel.now);
+		wheel.now_valid = 1;
+
+		if (wheel.init)
+			wheel_advance(wheel_tv2tick(&wheel.now, 0),
+				      &timer_eviction_list);
+	} else {
+		osmo_gettimeofday(&current_time, NULL);
 
-		llist_add(&this->list, &timer_eviction_list);
+		for (node = rb_first(&timer_root); node; node = rb_next(node)) {
+			this = container_of(node, struct osmo_timer_list, node);
+
+			if (timercmp(&this->timeout, &current_time, >))
+				break;
+
+			llist_add(&this->list, &timer_eviction_list);
+		}
 	}
 
 	/*
@@ -227,6 +623,9 @@ int osmo_timers_check(void)
 	struct rb_node *node;
 	int i = 0;
 
+	if (timer_backend == OSMO_TIMER_WHEEL)
+		return wheel.count;
+
 	for (node = rb_first(&timer_root); node; node = rb_next(node)) {
 		i++;
 	}
@@ -0,0 +1,145 @@
+/*
+ * (C) 2026 by the OsmocomBB developers
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*! \addtogroup timer
+ *  @{
+ */
+
+/*! \file timer_clock.c
+ *  \brief Clock source of the timers, real or virtual
+ *
+ * In virtual mode time only moves when told to, either explicitly with
+ * osmo_clock_set() / osmo_clock_advance() or by osmo_select_main(), which
+ * then jumps straight to the next timer expiry whenever no file
+ * descriptor is ready. Timers, rate counters and anything else using
+ * these functions then run as fast as the CPU allows, in a reproducible
+ * order.
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <osmocom/core/timer.h>
+#include <osmocom/core/timer_compat.h>
+
+static enum osmo_clock_mode clock_mode = OSMO_CLOCK_REAL;
+static struct timeval virtual_time;
+
+/* in timer.c */
+void _osmo_timers_clock_changed(void);
+
+/*! \brief select the clock used by the timers
+ *  \param[in] mode real or virtual clock
+ *  \returns 0 on success, -EBUSY if timers are pending
+ *
+ * The virtual clock starts from the current real time.
+ */
+int osmo_clock_set_mode(enum osmo_clock_mode mode)
+{
+	if (mode != OSMO_CLOCK_REAL && mode != OSMO_CLOCK_VIRTUAL)
+		return -EINVAL;
+
+	if (mode == clock_mode)
+		return 0;
+
+	if (osmo_timers_check())
+		return -EBUSY;
+
+	if (mode == OSMO_CLOCK_VIRTUAL)
+		gettimeofday(&virtual_time, NULL);
+
+	clock_mode = mode;
+	_osmo_timers_clock_changed();
+
+	return 0;
+}
+
+/*! \brief get the clock used by the timers */
+enum osmo_clock_mode osmo_clock_get_mode(void)
+{
+	return clock_mode;
+}
+
+/*! \brief set the virtual time
+ *  \param[in] tv new time
+ *
+ * Pending timers keep their absolute timeouts, so setting the time back
+ * delays them.
+ */
+void osmo_clock_set(const struct timeval *tv)
+{
+	virtual_time = *tv;
+	if (clock_mode == OSMO_CLOCK_VIRTUAL)
+		_osmo_timers_clock_changed();
+}
+
+/*! \brief move the virtual time forward
+ *  \param[in] delta time to add
+ */
+void osmo_clock_advance(const struct timeval *delta)
+{
+	timeradd(&virtual_time, delta, &virtual_time);
+}
+
+/*! \brief gettimeofday() honouring the virtual clock
+ *  \param[out] tv current time
+ *  \param[in] tz passed to gettimeofday() in real mode
+ *  \returns 0 on success, as gettimeofday()
+ */
+int osmo_gettimeofday(struct timeval *tv, struct timezone *tz)
+{
+	if (clock_mode == OSMO_CLOCK_VIRTUAL) {
+		*tv = virtual_time;
+		return 0;
+	}
+
+	return gettimeofday(tv, tz);
+}
+
+/*! \brief clock_gettime() honouring the virtual clock
+ *  \param[in] clk_id clock to read in real mode
+ *  \param[out] tp current time
+ *  \returns 0 on success, as clock_gettime()
+ *
+ * All clocks read the same virtual time in virtual mode.
+ */
+int osmo_clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+	if (clock_mode == OSMO_CLOCK_VIRTUAL) {
+		tp->tv_sec = virtual_time.tv_sec;
+		tp->tv_nsec = virtual_time.tv_usec * 1000;
+		return 0;
+	}
+
+#ifdef CLOCK_MONOTONIC
+	return clock_gettime(clk_id, tp);
+#else
+	{
+		struct timeval tv;
+		int rc = gettimeofday(&tv, NULL);
+		tp->tv_sec = tv.tv_sec;
+		tp->tv_nsec = tv.tv_usec * 1000;
+		return rc;
+	}
+#endif
+}
+
+/*! }@ */
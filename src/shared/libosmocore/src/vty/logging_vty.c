@@ -38,8 +38,6 @@
 
 #define LOG_STR "Configure logging sub-system\n"
 
-extern const struct log_info *osmo_log_info;
-
 static void _vty_output(struct log_target *tgt,
 			unsigned int level, const char *line)
 {
@@ -177,8 +175,7 @@ DEFUN(logging_level,
 		return CMD_WARNING;
 	}
 
-	tgt->categories[category].enabled = 1;
-	tgt->categories[category].loglevel = level;
+	log_set_category_filter(tgt, category, 1, level);
 
 	return CMD_SUCCESS;
 }
@@ -509,6 +506,193 @@ DEFUN(cfg_no_log_file, cfg_no_log_file_cmd,
 	return CMD_SUCCESS;
 }
 
+#define BINARY_STR "Logging to a binary file, see osmo-binlog\n"
+
+DEFUN(cfg_log_binary_file, cfg_log_binary_file_cmd,
+	"log binary file .FILENAME",
+	LOG_STR BINARY_STR "Logging to a file\n" "Filename\n")
+{
+	const char *fname = argv[0];
+	struct log_target *tgt;
+
+	tgt = log_target_find(LOG_TGT_TYPE_BINARY, fname);
+	if (!tgt) {
+		tgt = log_target_create_binary(fname);
+		if (!tgt) {
+			vty_out(vty, "%% Unable to create file `%s'%s",
+				fname, VTY_NEWLINE);
+			return CMD_WARNING;
+		}
+		log_add_target(tgt);
+	}
+
+	vty->index = tgt;
+	vty->node = CFG_LOG_NODE;
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_no_log_binary_file, cfg_no_log_binary_file_cmd,
+	"no log binary file .FILENAME",
+	NO_STR LOG_STR BINARY_STR "Logging to a file\n" "Filename\n")
+{
+	const char *fname = argv[0];
+	struct log_target *tgt;
+
+	tgt = log_target_find(LOG_TGT_TYPE_BINARY, fname);
+	if (!tgt) {
+		vty_out(vty, "%% No such binary log file `%s'%s",
+			fname, VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	log_target_destroy(tgt);
+
+	return CMD_SUCCESS;
+}
+
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+
+#define ASYNC_STR "Logging through a ring buffer and a writer thread\n"
+
+static int _cfg_log_async(struct vty *vty, const char *fname)
+{
+	struct log_target *tgt;
+
+	tgt = log_target_find(LOG_TGT_TYPE_ASYNC, fname);
+	if (!tgt) {
+		tgt = log_target_create_async(fname, 256 * 1024);
+		if (!tgt) {
+			vty_out(vty, "%% Unable to create async log%s",
+				VTY_NEWLINE);
+			return CMD_WARNING;
+		}
+		log_add_target(tgt);
+	}
+
+	vty->index = tgt;
+	vty->node = CFG_LOG_NODE;
+
+	return CMD_SUCCESS;
+}
+
+static int _cfg_no_log_async(struct vty *vty, const char *fname)
+{
+	struct log_target *tgt;
+
+	tgt = log_target_find(LOG_TGT_TYPE_ASYNC, fname);
+	if (!tgt) {
+		vty_out(vty, "%% No such async log%s", VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	log_target_destroy(tgt);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(cfg_log_async_file, cfg_log_async_file_cmd,
+	"log async file .FILENAME",
+	LOG_STR ASYNC_STR "Logging to text file\n" "Filename\n")
+{
+	return _cfg_log_async(vty, argv[0]);
+}
+
+DEFUN(cfg_log_async_stderr, cfg_log_async_stderr_cmd,
+	"log async stderr",
+	LOG_STR ASYNC_STR "Logging via STDERR of the process\n")
+{
+	return _cfg_log_async(vty, NULL);
+}
+
+DEFUN(cfg_no_log_async_file, cfg_no_log_async_file_cmd,
+	"no log async file .FILENAME",
+	NO_STR LOG_STR ASYNC_STR "Logging to text file\n" "Filename\n")
+{
+	return _cfg_no_log_async(vty, argv[0]);
+}
+
+DEFUN(cfg_no_log_async_stderr, cfg_no_log_async_stderr_cmd,
+	"no log async stderr",
+	NO_STR LOG_STR ASYNC_STR "Logging via STDERR of the process\n")
+{
+	return _cfg_no_log_async(vty, NULL);
+}
+
+DEFUN(logging_async_overflow, logging_async_overflow_cmd,
+	"logging async overflow (drop|block)",
+	LOGGING_STR "Configure the ring buffer of an async log\n"
+	"What to do if the ring buffer is full\n"
+	"Drop the message and count it\n"
+	"Wait for the writer thread\n")
+{
+	struct log_target *tgt = osmo_log_vty2tgt(vty);
+
+	if (!tgt)
+		return CMD_WARNING;
+
+	if (log_target_async_set_overflow(tgt, argv[0][0] == 'b' ?
+			LOG_ASYNC_BLOCK : LOG_ASYNC_DROP) < 0) {
+		vty_out(vty, "%% Not an async log%s", VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(logging_async_size, logging_async_size_cmd,
+	"logging async buffer-size <8192-67108864>",
+	LOGGING_STR "Configure the ring buffer of an async log\n"
+	"Size of the ring buffer\n"
+	"Size in bytes, rounded up to a power of two\n")
+{
+	struct log_target *tgt = osmo_log_vty2tgt(vty);
+
+	if (!tgt)
+		return CMD_WARNING;
+
+	if (log_target_async_set_size(tgt, atoi(argv[0])) < 0) {
+		vty_out(vty, "%% Unable to resize async log%s", VTY_NEWLINE);
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(show_logging_async, show_logging_async_cmd,
+	"show logging async",
+	SHOW_STR SHOW_LOG_STR
+	"Show the ring buffer state of the async logs\n")
+{
+	struct log_target *tgt;
+
+	llist_for_each_entry(tgt, &osmo_log_target_list, entry) {
+		struct log_async_stats st;
+		enum log_async_overflow overflow;
+		unsigned int size;
+
+		if (tgt->type != LOG_TGT_TYPE_ASYNC)
+			continue;
+
+		log_target_async_get_config(tgt, &overflow, &size);
+		log_target_async_get_stats(tgt, &st);
+
+		vty_out(vty, "Async log %s, %u bytes, overflow %s:%s",
+			tgt->tgt_async.fname ? tgt->tgt_async.fname : "stderr",
+			size, overflow == LOG_ASYNC_BLOCK ? "block" : "drop",
+			VTY_NEWLINE);
+		vty_out(vty, " Fill: %lu, max %lu%s", st.fill, st.max_fill,
+			VTY_NEWLINE);
+		vty_out(vty, " Lines: %lu, dropped %lu (%lu bytes), "
+			"waits %lu%s", st.records, st.dropped,
+			st.dropped_bytes, st.blocked, VTY_NEWLINE);
+	}
+
+	return CMD_SUCCESS;
+}
+
+#endif /* HAVE_PTHREAD_H && !EMBEDDED */
+
 static int config_write_log_single(struct vty *vty, struct log_target *tgt)
 {
 	int i;
@@ -532,6 +716,31 @@ static int config_write_log_single(struct vty *vty, struct log_target *tgt)
 	case LOG_TGT_TYPE_FILE:
 		vty_out(vty, "log file %s%s", tgt->tgt_file.fname, VTY_NEWLINE);
 		break;
+	case LOG_TGT_TYPE_BINARY:
+		vty_out(vty, "log binary file %s%s", tgt->tgt_binary.fname,
+			VTY_NEWLINE);
+		break;
+	case LOG_TGT_TYPE_ASYNC:
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+	{
+		enum log_async_overflow overflow;
+		unsigned int size;
+
+		if (tgt->tgt_async.fname)
+			vty_out(vty, "log async file %s%s",
+				tgt->tgt_async.fname, VTY_NEWLINE);
+		else
+			vty_out(vty, "log async stderr%s", VTY_NEWLINE);
+
+		log_target_async_get_config(tgt, &overflow, &size);
+		vty_out(vty, "  logging async buffer-size %u%s", size,
+			VTY_NEWLINE);
+		vty_out(vty, "  logging async overflow %s%s",
+			overflow == LOG_ASYNC_BLOCK ? "block" : "drop",
+			VTY_NEWLINE);
+	}
+#endif
+		break;
 	}
 
 	vty_out(vty, "  logging color %u%s", tgt->use_color ? 1 : 0,
@@ -600,5 +809,16 @@ void logging_vty_add_cmds(const struct log_info *cat)
 	install_element(CONFIG_NODE, &cfg_log_syslog_cmd);
 	install_element(CONFIG_NODE, &cfg_log_syslog_local_cmd);
 	install_element(CONFIG_NODE, &cfg_no_log_syslog_cmd);
+#endif
+	install_element(CONFIG_NODE, &cfg_log_binary_file_cmd);
+	install_element(CONFIG_NODE, &cfg_no_log_binary_file_cmd);
+#if defined(HAVE_PTHREAD_H) && !defined(EMBEDDED)
+	install_element_ve(&show_logging_async_cmd);
+	install_element(CFG_LOG_NODE, &logging_async_overflow_cmd);
+	install_element(CFG_LOG_NODE, &logging_async_size_cmd);
+	install_element(CONFIG_NODE, &cfg_log_async_file_cmd);
+	install_element(CONFIG_NODE, &cfg_log_async_stderr_cmd);
+	install_element(CONFIG_NODE, &cfg_no_log_async_file_cmd);
+	install_element(CONFIG_NODE, &cfg_no_log_async_stderr_cmd);
 #endif
 }
@@ -21,6 +21,20 @@
  *
  */
 
+#define _GNU_SOURCE	/* sendmmsg() */
+
+#include "../config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
 #include <osmocom/core/write_queue.h>
 
 /*! \addtogroup write_queue
@@ -29,6 +43,120 @@
 
 /*! \file write_queue.c */
 
+#ifdef HAVE_SYS_SOCKET_H
+
+/* dequeue and free the first n messages */
+static void wqueue_drop(struct osmo_wqueue *queue, unsigned int n)
+{
+	while (n-- && !llist_empty(&queue->msg_queue)) {
+		--queue->current_length;
+		msgb_free(msgb_dequeue(&queue->msg_queue));
+	}
+}
+
+/* write up to queue->batch messages with one writev(), a message that
+ * was written partially stays at the head of the queue */
+static int wqueue_writev(struct osmo_wqueue *queue)
+{
+	struct iovec iov[OSMO_WQUEUE_MAX_BATCH];
+	struct msgb *msg, *tmp;
+	unsigned int n = 0;
+	ssize_t rc;
+
+	llist_for_each_entry(msg, &queue->msg_queue, list) {
+		iov[n].iov_base = msg->data;
+		iov[n].iov_len = msg->len;
+		if (++n == queue->batch)
+			break;
+	}
+
+	rc = writev(queue->bfd.fd, iov, n);
+	if (rc < 0)
+		return -errno;
+
+	llist_for_each_entry_safe(msg, tmp, &queue->msg_queue, list) {
+		if (!n--)
+			break;
+		if (rc < msg->len) {
+			msgb_pull(msg, rc);
+			break;
+		}
+		rc -= msg->len;
+		wqueue_drop(queue, 1);
+	}
+
+	return 0;
+}
+
+/* send up to queue->batch messages as separate datagrams */
+static int wqueue_sendmmsg(struct osmo_wqueue *queue)
+{
+	struct msgb *msg;
+	int rc;
+#ifdef HAVE_SENDMMSG
+	struct iovec iov[OSMO_WQUEUE_MAX_BATCH];
+	struct mmsghdr mm[OSMO_WQUEUE_MAX_BATCH];
+	unsigned int n = 0;
+
+	llist_for_each_entry(msg, &queue->msg_queue, list) {
+		iov[n].iov_base = msg->data;
+		iov[n].iov_len = msg->len;
+		memset(&mm[n], 0, sizeof(mm[n]));
+		mm[n].msg_hdr.msg_iov = &iov[n];
+		mm[n].msg_hdr.msg_iovlen = 1;
+		if (++n == queue->batch)
+			break;
+	}
+
+	rc = sendmmsg(queue->bfd.fd, mm, n, 0);
+	if (rc < 0)
+		return -errno;
+	wqueue_drop(queue, rc);
+#else
+	unsigned int n;
+
+	for (n = 0; n < queue->batch; n++) {
+		if (llist_empty(&queue->msg_queue))
+			break;
+		msg = llist_entry(queue->msg_queue.next, struct msgb, list);
+		rc = send(queue->bfd.fd, msg->data, msg->len, MSG_DONTWAIT);
+		if (rc < 0)
+			return n ? 0 : -errno;
+		wqueue_drop(queue, 1);
+	}
+#endif
+
+	return 0;
+}
+
+static int wqueue_write_batch(struct osmo_wqueue *queue)
+{
+	socklen_t len = sizeof(queue->sock_type);
+	int rc;
+
+	/* anything not a socket is written like a stream */
+	if (!queue->sock_type &&
+	    getsockopt(queue->bfd.fd, SOL_SOCKET, SO_TYPE, &queue->sock_type,
+		       &len) < 0)
+		queue->sock_type = SOCK_STREAM;
+
+	if (queue->sock_type == SOCK_STREAM)
+		rc = wqueue_writev(queue);
+	else
+		rc = wqueue_sendmmsg(queue);
+
+	if (rc == -EAGAIN || rc == -EINTR)
+		return 0;
+	/* don't try the same message again and again, like the message
+	 * is lost if write_cb fails */
+	if (rc < 0)
+		wqueue_drop(queue, 1);
+
+	return rc;
+}
+
+#endif /* HAVE_SYS_SOCKET_H */
+
 /*! \brief Select loop function for write queue handling
  *  \param[in] fd osmocom file descriptor
  *  \param[in] what bit-mask of events that have happened
@@ -55,11 +183,18 @@ int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what)
 
 		/* the queue might have been emptied */
 		if (!llist_empty(&queue->msg_queue)) {
-			--queue->current_length;
+#ifdef HAVE_SYS_SOCKET_H
+			if (queue->batch > 1)
+				wqueue_write_batch(queue);
+			else
+#endif
+			{
+				--queue->current_length;
 
-			msg = msgb_dequeue(&queue->msg_queue);
-			queue->write_cb(fd, msg);
-			msgb_free(msg);
+				msg = msgb_dequeue(&queue->msg_queue);
+				queue->write_cb(fd, msg);
+				msgb_free(msg);
+			}
 
 			if (!llist_empty(&queue->msg_queue))
 				fd->when |= BSC_FD_WRITE;
@@ -75,10 +210,35 @@ int osmo_wqueue_bfd_cb(struct osmo_fd *fd, unsigned int what)
  */
 void osmo_wqueue_init(struct osmo_wqueue *queue, int max_length)
 {
+	osmo_wqueue_init_batch(queue, max_length, 1);
+}
+
+/*! \brief Initialize a \ref osmo_wqueue structure for batched writes
+ *  \param[in] queue Write queue to operate on
+ *  \param[in] max_length Maximum length of write queue
+ *  \param[in] batch Maximum number of messages written at once, at most
+ *  \ref OSMO_WQUEUE_MAX_BATCH
+ *
+ * With \a batch > 1 \ref osmo_wqueue::write_cb is not used.  Whenever
+ * the socket is writable, up to \a batch queued messages are written
+ * with a single writev() for stream sockets and other file descriptors,
+ * or a single sendmmsg() for datagram sockets.  The part of a message
+ * that was not written by a short writev() is written next time.
+ */
+void osmo_wqueue_init_batch(struct osmo_wqueue *queue, int max_length,
+			    unsigned int batch)
+{
+	if (batch < 1)
+		batch = 1;
+	if (batch > OSMO_WQUEUE_MAX_BATCH)
+		batch = OSMO_WQUEUE_MAX_BATCH;
+
 	queue->max_length = max_length;
 	queue->current_length = 0;
 	queue->read_cb = NULL;
 	queue->write_cb = NULL;
+	queue->batch = batch;
+	queue->sock_type = 0;
 	queue->bfd.cb = osmo_wqueue_bfd_cb;
 	INIT_LLIST_HEAD(&queue->msg_queue);
 }
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/gsm/a5.h>
+
+#define NUM_FRAMES	4096
+
+static const uint8_t key[] = { 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	static pbit_t dl[NUM_FRAMES * OSMO_A5_BATCH_BYTES];
+	static pbit_t ul[NUM_FRAMES * OSMO_A5_BATCH_BYTES];
+	static const unsigned int batches[] = { 64, 256, NUM_FRAMES };
+	uint32_t fns[NUM_FRAMES];
+	ubit_t udl[114], uul[114];
+	int rounds = argc > 1 ? atoi(argv[1]) : 4;
+	int n, r, i, b;
+	double t;
+
+	for (i=0; i<NUM_FRAMES; i++)
+		fns[i] = 100000 + i;
+
+	for (n=1; n<=2; n++) {
+		t = now();
+		for (r=0; r<rounds; r++)
+			for (i=0; i<NUM_FRAMES; i++)
+				osmo_a5(n, key, fns[i], udl, uul);
+		t = now() - t;
+
+		printf("A5/%d osmo_a5       : %10.0f frames/s\n",
+			n, rounds * NUM_FRAMES / t);
+
+		for (b=0; b<sizeof(batches)/sizeof(batches[0]); b++) {
+			unsigned int bs = batches[b];
+
+			t = now();
+			for (r=0; r<rounds; r++)
+				for (i=0; i<NUM_FRAMES; i+=bs)
+					osmo_a5_batch(n, key, &fns[i], bs,
+						&dl[i * OSMO_A5_BATCH_BYTES],
+						&ul[i * OSMO_A5_BATCH_BYTES]);
+			t = now() - t;
+
+			printf("A5/%d osmo_a5_batch : %10.0f frames/s (%u per call)\n",
+				n, rounds * NUM_FRAMES / t, bs);
+		}
+	}
+
+	return 0;
+}
@@ -50,6 +50,55 @@ binstr(ubit_t *d, int n)
 	return str;
 }
 
+#define BATCH_FRAMES	300
+
+/* Batch generation against the single frame version, over more frames
+ * than one bitsliced pass handles */
+static int
+check_batch(int n)
+{
+	static pbit_t bdl[BATCH_FRAMES * OSMO_A5_BATCH_BYTES];
+	static pbit_t bul[BATCH_FRAMES * OSMO_A5_BATCH_BYTES];
+	uint32_t fns[BATCH_FRAMES];
+	ubit_t udl[114], uul[114];
+	pbit_t pdl[OSMO_A5_BATCH_BYTES], pul[OSMO_A5_BATCH_BYTES];
+	int i;
+
+	for (i=0; i<BATCH_FRAMES; i++)
+		fns[i] = (fn + i * 7) % (26 * 51 * 2048);
+
+	memset(bdl, 0xaa, sizeof(bdl));
+	memset(bul, 0xaa, sizeof(bul));
+
+	if (osmo_a5_batch(n, key, fns, BATCH_FRAMES, bdl, bul))
+		return -1;
+
+	for (i=0; i<BATCH_FRAMES; i++) {
+		osmo_a5(n, key, fns[i], udl, uul);
+		memset(pdl, 0, sizeof(pdl));
+		memset(pul, 0, sizeof(pul));
+		osmo_ubit2pbit(pdl, udl, 114);
+		osmo_ubit2pbit(pul, uul, 114);
+
+		if (memcmp(pdl, &bdl[i * OSMO_A5_BATCH_BYTES], OSMO_A5_BATCH_BYTES) ||
+		    memcmp(pul, &bul[i * OSMO_A5_BATCH_BYTES], OSMO_A5_BATCH_BYTES))
+			return -1;
+	}
+
+	/* Known vectors, one direction only */
+	memset(bdl, 0xaa, sizeof(bdl));
+	osmo_a5_batch(n, key, &fn, 1, bdl, NULL);
+	if (memcmp(bdl, &dl[15*n], 15) || bdl[15] != 0xaa)
+		return -1;
+
+	memset(bul, 0xaa, sizeof(bul));
+	osmo_a5_batch(n, key, &fn, 1, NULL, bul);
+	if (memcmp(bul, &ul[15*n], 15) || bul[15] != 0xaa)
+		return -1;
+
+	return 0;
+}
+
 int main(int argc, char **argv)
 {
 	ubit_t exp[114];
@@ -92,6 +141,15 @@ int main(int argc, char **argv)
 			fprintf(stderr, "[!] A5/%d UL failed", n);
 			exit(1);
 		}
+
+		/* Batch */
+		if (!check_batch(n))
+			printf("A5/%d - batch: OK\n", n);
+		else {
+			printf("A5/%d - batch: BAD\n", n);
+			fprintf(stderr, "[!] A5/%d batch failed", n);
+			exit(1);
+		}
 	}
 
 	return 0;
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/core/bits.h>
+
+#define MAX_BITS	1100
+#define MAX_OFS		10
+
+/* Bit-at-a-time reference conversions */
+static void
+ref_ubit2pbit_ext(pbit_t *out, unsigned int out_ofs, const ubit_t *in,
+		  unsigned int in_ofs, unsigned int num_bits, int lsb_mode)
+{
+	unsigned int i, op, bn;
+
+	for (i=0; i<num_bits; i++) {
+		op = out_ofs + i;
+		bn = lsb_mode ? (op&7) : (7-(op&7));
+		if (in[in_ofs+i])
+			out[op>>3] |= 1 << bn;
+		else
+			out[op>>3] &= ~(1 << bn);
+	}
+}
+
+static void
+ref_pbit2ubit_ext(ubit_t *out, unsigned int out_ofs, const pbit_t *in,
+		  unsigned int in_ofs, unsigned int num_bits, int lsb_mode)
+{
+	unsigned int i, ip, bn;
+
+	for (i=0; i<num_bits; i++) {
+		ip = in_ofs + i;
+		bn = lsb_mode ? (ip&7) : (7-(ip&7));
+		out[out_ofs+i] = !!(in[ip>>3] & (1<<bn));
+	}
+}
+
+static int
+check(const char *name, int ok)
+{
+	printf("%-30s: %s\n", name, ok ? "OK" : "FAIL");
+	return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	static const ubit_t pattern[] = { 1, 0, 1, 1, 0, 0, 0, 1, 1, 1, 1, 1 };
+	ubit_t u[MAX_BITS + MAX_OFS], u2[MAX_BITS + MAX_OFS], u3[MAX_BITS + MAX_OFS];
+	pbit_t p[MAX_BITS / 8 + 4], p2[MAX_BITS / 8 + 4];
+	sbit_t s[MAX_BITS];
+	unsigned int n, o_in, o_out, i;
+	int lsb, ok, rv, rc = 0;
+
+	srandom(0x1234);
+
+	for (i=0; i<sizeof(u); i++)
+		u[i] = random() & 1;
+	for (i=0; i<sizeof(p); i++)
+		p[i] = random();
+
+	/* Known answers */
+	memset(p2, 0, sizeof(p2));
+	rv = osmo_ubit2pbit(p2, pattern, sizeof(pattern));
+	printf("ubit2pbit : %s(%d)\n", osmo_hexdump(p2, rv), rv);
+	memset(u2, 0xaa, sizeof(u2));
+	rv = osmo_pbit2ubit(u2, p2, sizeof(pattern));
+	printf("pbit2ubit : %s(%d)\n", osmo_hexdump(u2, rv), rv);
+	rv = osmo_ubit2sbit(s, pattern, 4);
+	printf("ubit2sbit : %s(%d)\n", osmo_hexdump((uint8_t *) s, rv), rv);
+	s[1] = 0;
+	rv = osmo_sbit2ubit(u2, s, 4);
+	printf("sbit2ubit : %s(%d)\n", osmo_hexdump(u2, rv), rv);
+
+	/* Plain conversions, all lengths through the vector and tail paths */
+	ok = 1;
+	for (n=0; n<=MAX_BITS; n += (n < 300 ? 1 : 97)) {
+		memset(p2, 0, sizeof(p2));
+		ref_ubit2pbit_ext(p2, 0, u, 0, n, 0);
+		memset(p, 0xff, sizeof(p));
+		rv = osmo_ubit2pbit(p, u, n);
+		if (rv != (n + 7) / 8 || memcmp(p, p2, rv))
+			ok = 0;
+		if (p[rv] != 0xff)
+			ok = 0;
+
+		memset(u2, 0xaa, sizeof(u2));
+		memset(u3, 0xaa, sizeof(u3));
+		ref_pbit2ubit_ext(u3, 0, p, 0, n, 0);
+		rv = osmo_pbit2ubit(u2, p, n);
+		if (rv != n || memcmp(u2, u3, sizeof(u2)))
+			ok = 0;
+	}
+	rc |= check("ubit2pbit / pbit2ubit", ok);
+
+	/* Non-zero ubits other than 1 are taken as 1 */
+	for (i=0; i<MAX_BITS; i++)
+		u2[i] = u[i] ? (i & 0x7f) | 1 : 0;
+	osmo_ubit2pbit(p, u, MAX_BITS);
+	osmo_ubit2pbit(p2, u2, MAX_BITS);
+	rc |= check("ubit2pbit non-binary input", !memcmp(p, p2, MAX_BITS / 8));
+
+	/* Extended versions, any offsets and both bit orders */
+	ok = 1;
+	for (lsb=0; lsb<2; lsb++)
+	for (o_in=0; o_in<MAX_OFS; o_in++)
+	for (o_out=0; o_out<MAX_OFS; o_out++)
+	for (n=0; n<=MAX_BITS - 2 * MAX_OFS; n += (n < 80 ? 1 : 131)) {
+		memset(p, 0x5a, sizeof(p));
+		memset(p2, 0x5a, sizeof(p2));
+		ref_ubit2pbit_ext(p2, o_out, u, o_in, n, lsb);
+		rv = osmo_ubit2pbit_ext(p, o_out, u, o_in, n, lsb);
+		if ((n && rv != (o_out + n - 1) / 8 + 1) || memcmp(p, p2, sizeof(p)))
+			ok = 0;
+
+		memset(u2, 0xaa, sizeof(u2));
+		memset(u3, 0xaa, sizeof(u3));
+		ref_pbit2ubit_ext(u3, o_out, p, o_in, n, lsb);
+		rv = osmo_pbit2ubit_ext(u2, o_out, p, o_in, n, lsb);
+		if (rv != o_out + n || memcmp(u2, u3, sizeof(u2)))
+			ok = 0;
+	}
+	rc |= check("ubit2pbit_ext / pbit2ubit_ext", ok);
+
+	/* Soft bits */
+	ok = 1;
+	for (n=0; n<=MAX_BITS; n += (n < 100 ? 1 : 97)) {
+		for (i=0; i<n; i++)
+			s[i] = random();
+		rv = osmo_sbit2ubit(u2, s, n);
+		for (i=0; i<n; i++)
+			if (u2[i] != (s[i] < 0))
+				ok = 0;
+		if (rv != n)
+			ok = 0;
+
+		rv = osmo_ubit2sbit(s, u, n);
+		for (i=0; i<n; i++)
+			if (s[i] != (u[i] ? -127 : 127))
+				ok = 0;
+		if (rv != n)
+			ok = 0;
+	}
+	rc |= check("sbit2ubit / ubit2sbit", ok);
+
+	return rc;
+}
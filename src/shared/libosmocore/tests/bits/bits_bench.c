@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/bits.h>
+
+#define NUM_BITS	(8 * 1024)
+
+/* The former bit-at-a-time conversions, as a baseline */
+static int
+old_ubit2pbit(pbit_t *out, const ubit_t *in, unsigned int num_bits)
+{
+	unsigned int i;
+	uint8_t curbyte = 0;
+	pbit_t *outptr = out;
+
+	for (i = 0; i < num_bits; i++) {
+		uint8_t bitnum = 7 - (i % 8);
+
+		curbyte |= (in[i] << bitnum);
+
+		if(i % 8 == 7){
+			*outptr++ = curbyte;
+			curbyte = 0;
+		}
+	}
+	if (num_bits % 8)
+		*outptr++ = curbyte;
+
+	return outptr - out;
+}
+
+static int
+old_pbit2ubit(ubit_t *out, const pbit_t *in, unsigned int num_bits)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_bits; i++)
+		out[i] = (in[i >> 3] >> (7 - (i & 7))) & 1;
+
+	return num_bits;
+}
+
+static int
+old_sbit2ubit(ubit_t *out, const sbit_t *in, unsigned int num_bits)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_bits; i++)
+		out[i] = in[i] < 0;
+
+	return num_bits;
+}
+
+static int
+old_ubit2sbit(sbit_t *out, const ubit_t *in, unsigned int num_bits)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_bits; i++)
+		out[i] = in[i] ? -127 : 127;
+
+	return num_bits;
+}
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Keeps the compiler from dropping the loops */
+static volatile unsigned int sink;
+
+#define BENCH(label, call)						\
+	do {								\
+		double t = now();					\
+		for (i = 0; i < rounds; i++) {				\
+			call;						\
+			sink += i;					\
+		}							\
+		t = now() - t;						\
+		printf("%-34s : %8.1f Mbit/s\n", label,			\
+			(double) rounds * NUM_BITS / t / 1e6);		\
+	} while (0)
+
+int main(int argc, char **argv)
+{
+	static ubit_t u[NUM_BITS + 8], u2[NUM_BITS + 8];
+	static pbit_t p[NUM_BITS / 8 + 1];
+	static sbit_t s[NUM_BITS];
+	int rounds = argc > 1 ? atoi(argv[1]) : 20000;
+	int i;
+
+	srandom(42);
+
+	for (i = 0; i < NUM_BITS; i++) {
+		u[i] = random() & 1;
+		s[i] = random();
+	}
+
+	BENCH("ubit2pbit (bit loop)", old_ubit2pbit(p, u, NUM_BITS));
+	BENCH("osmo_ubit2pbit", osmo_ubit2pbit(p, u, NUM_BITS));
+	BENCH("osmo_ubit2pbit_ext (ofs 3, 5)",
+		osmo_ubit2pbit_ext(p, 3, u, 5, NUM_BITS - 8, 0));
+	BENCH("osmo_ubit2pbit_ext (lsb)",
+		osmo_ubit2pbit_ext(p, 0, u, 0, NUM_BITS, 1));
+
+	BENCH("pbit2ubit (bit loop)", old_pbit2ubit(u2, p, NUM_BITS));
+	BENCH("osmo_pbit2ubit", osmo_pbit2ubit(u2, p, NUM_BITS));
+	BENCH("osmo_pbit2ubit_ext (ofs 3, 5)",
+		osmo_pbit2ubit_ext(u2, 3, p, 5, NUM_BITS - 8, 0));
+	BENCH("osmo_pbit2ubit_ext (lsb)",
+		osmo_pbit2ubit_ext(u2, 0, p, 0, NUM_BITS, 1));
+
+	BENCH("sbit2ubit (loop)", old_sbit2ubit(u2, s, NUM_BITS));
+	BENCH("osmo_sbit2ubit", osmo_sbit2ubit(u2, s, NUM_BITS));
+
+	BENCH("ubit2sbit (loop)", old_ubit2sbit(s, u, NUM_BITS));
+	BENCH("osmo_ubit2sbit", osmo_ubit2sbit(s, u, NUM_BITS));
+
+	return 0;
+}
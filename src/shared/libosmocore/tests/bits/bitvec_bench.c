@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/bitvec.h>
+#include <osmocom/gsm/rxlev_stat.h>
+
+/* The former bit-at-a-time functions, as a baseline */
+static int
+old_get_uint(struct bitvec *bv, int num_bits)
+{
+	int i;
+	unsigned int ui = 0;
+
+	for (i = 0; i < num_bits; i++) {
+		int bit = bitvec_get_bit_pos(bv, bv->cur_bit);
+		if (bit < 0)
+			return bit;
+		if (bit)
+			ui |= (1 << (num_bits - i - 1));
+		bv->cur_bit++;
+	}
+
+	return ui;
+}
+
+static int
+old_find_bit_pos(const struct bitvec *bv, unsigned int n, enum bit_value val)
+{
+	unsigned int i;
+
+	for (i = n; i < bv->data_len*8; i++) {
+		if (bitvec_get_bit_pos(bv, i) == val)
+			return i;
+	}
+
+	return -1;
+}
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* SI 3 rest octets with all optional parts present */
+static uint8_t si3_rest[] = { 0xd4, 0x6d, 0xfb, 0x2b, };
+
+static volatile int sink;
+
+/* the decoder of layer23's sysinfo.c */
+static void
+decode_si3_rest(int (*get_uint)(struct bitvec *, int))
+{
+	struct bitvec bv = { .data = si3_rest, .data_len = sizeof(si3_rest) };
+	int v = 0;
+
+	if (bitvec_get_bit_high(&bv) == H) {
+		v += get_uint(&bv, 1);
+		v += get_uint(&bv, 6);
+		v += get_uint(&bv, 3);
+		v += get_uint(&bv, 5);
+	}
+	if (bitvec_get_bit_high(&bv) == H)
+		v += get_uint(&bv, 2);
+	v += bitvec_get_bit_high(&bv);
+	v += bitvec_get_bit_high(&bv);
+	if (bitvec_get_bit_high(&bv) == H)
+		v += get_uint(&bv, 3);
+	if (bitvec_get_bit_high(&bv) == H) {
+		v += get_uint(&bv, 3);
+		v += get_uint(&bv, 1);
+	}
+	sink = v;
+}
+
+static double
+run_si3(int n, int (*get_uint)(struct bitvec *, int))
+{
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<n; i++)
+		decode_si3_rest(get_uint);
+	t = now() - t;
+
+	return n / t;
+}
+
+/* what rxlev_stat_dump() does, without the printing */
+static double
+run_rxlev(int n, const struct rxlev_stats *st,
+	  int (*find)(const struct bitvec *, unsigned int, enum bit_value))
+{
+	struct bitvec bv = { .data_len = NUM_ARFCNS/8 };
+	double t;
+	int i, r, arfcn, found = 0;
+
+	t = now();
+	for (i=0; i<n; i++) {
+		for (r = NUM_RXLEVS-1; r >= 0; r--) {
+			bv.data = (uint8_t *) st->rxlev_buckets[r];
+			arfcn = -1;
+			while ((arfcn = find(&bv, arfcn + 1, ONE)) >= 0)
+				found++;
+		}
+	}
+	t = now() - t;
+	sink = found;
+
+	return n / t;
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	struct rxlev_stats st;
+	int i;
+
+	printf("SI3 rest octets (old)   : %12.0f msgs/s\n",
+		run_si3(n, old_get_uint));
+	printf("SI3 rest octets (words) : %12.0f msgs/s\n",
+		run_si3(n, bitvec_get_uint));
+
+	/* a GSM 900 power scan: 124 ARFCNs spread over the rxlevs */
+	rxlev_stat_reset(&st);
+	for (i = 1; i <= 124; i++)
+		rxlev_stat_input(&st, i, rand() % 64);
+	printf("rxlev scan (old)        : %12.0f dumps/s\n",
+		run_rxlev(n / 1000, &st, old_find_bit_pos));
+	printf("rxlev scan (words)      : %12.0f dumps/s\n",
+		run_rxlev(n / 1000, &st, bitvec_find_bit_pos));
+
+	return 0;
+}
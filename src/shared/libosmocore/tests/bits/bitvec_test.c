@@ -0,0 +1,225 @@
+/*
+ * bitvec test, the word based functions against bit by bit references
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <osmocom/core/bitvec.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/rxlev_stat.h>
+
+#define LEN	23
+
+static uint8_t data[LEN], ref[LEN];
+
+static int ref_bit(const uint8_t *buf, unsigned int i)
+{
+	return (buf[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static void ref_set(uint8_t *buf, unsigned int i, int bit)
+{
+	buf[i / 8] &= ~(0x80 >> (i % 8));
+	if (bit)
+		buf[i / 8] |= 0x80 >> (i % 8);
+}
+
+static void fill(void)
+{
+	int i;
+
+	for (i = 0; i < LEN; i++)
+		data[i] = rand();
+	memcpy(ref, data, LEN);
+}
+
+static void test_uint(void)
+{
+	struct bitvec bv = { .data = data, .data_len = LEN };
+	unsigned int pos, exp, val;
+	int n, i, ok = 1;
+
+	fill();
+	for (pos = 0; pos < LEN * 8; pos++) {
+		for (n = 1; n <= 31 && pos + n <= LEN * 8; n++) {
+			exp = 0;
+			for (i = 0; i < n; i++)
+				exp = (exp << 1) | ref_bit(data, pos + i);
+			bv.cur_bit = pos;
+			val = bitvec_get_uint(&bv, n);
+			if (val != exp || bv.cur_bit != pos + n)
+				ok = 0;
+		}
+	}
+	printf("get_uint: %s\n", ok ? "ok" : "FAILED");
+
+	ok = 1;
+	for (pos = 0; pos < LEN * 8; pos++) {
+		for (n = 1; n <= 32 && pos + n <= LEN * 8; n++) {
+			val = rand();
+			for (i = 0; i < n; i++)
+				ref_set(ref, pos + i, (val >> (n - i - 1)) & 1);
+			bv.cur_bit = pos;
+			bitvec_set_uint(&bv, val, n);
+			if (memcmp(data, ref, LEN) || bv.cur_bit != pos + n)
+				ok = 0;
+		}
+	}
+	printf("set_uint: %s\n", ok ? "ok" : "FAILED");
+
+	/* running over the end is still done bit by bit */
+	bv.cur_bit = LEN * 8 - 3;
+	n = bitvec_get_uint(&bv, 5);
+	printf("get_uint over the end: %d, cur_bit %u\n", n,
+		bv.cur_bit - (LEN * 8 - 3));
+	bv.cur_bit = LEN * 8 - 3;
+	n = bitvec_set_uint(&bv, 0x1f, 5);
+	printf("set_uint over the end: %d, cur_bit %u, last 0x%02x\n", n,
+		bv.cur_bit - (LEN * 8 - 3), data[LEN - 1] & 0x07);
+}
+
+static void test_bytes(void)
+{
+	struct bitvec bv = { .data = data, .data_len = LEN };
+	uint8_t buf[LEN], exp[LEN];
+	unsigned int pos, cnt, i;
+	int ok = 1;
+
+	fill();
+	for (pos = 0; pos < LEN * 8; pos++) {
+		for (cnt = 0; pos + cnt * 8 <= LEN * 8; cnt++) {
+			for (i = 0; i < cnt * 8; i++)
+				ref_set(exp, i, ref_bit(data, pos + i));
+			bv.cur_bit = pos;
+			if (bitvec_get_bytes(&bv, buf, cnt)
+			 || memcmp(buf, exp, cnt) || bv.cur_bit != pos + cnt * 8)
+				ok = 0;
+		}
+	}
+	printf("get_bytes: %s\n", ok ? "ok" : "FAILED");
+
+	ok = 1;
+	for (pos = 0; pos < LEN * 8; pos++) {
+		for (cnt = 0; pos + cnt * 8 <= LEN * 8; cnt++) {
+			for (i = 0; i < cnt; i++)
+				buf[i] = rand();
+			for (i = 0; i < cnt * 8; i++)
+				ref_set(ref, pos + i, ref_bit(buf, i));
+			bv.cur_bit = pos;
+			if (bitvec_set_bytes(&bv, buf, cnt)
+			 || memcmp(data, ref, LEN) || bv.cur_bit != pos + cnt * 8)
+				ok = 0;
+		}
+	}
+	printf("set_bytes: %s\n", ok ? "ok" : "FAILED");
+
+	bv.cur_bit = 1;
+	printf("get_bytes over the end: %d\n",
+		bitvec_get_bytes(&bv, buf, LEN) == -EINVAL);
+	printf("set_bytes over the end: %d\n",
+		bitvec_set_bytes(&bv, buf, LEN) == -EINVAL);
+}
+
+static void test_find(void)
+{
+	struct bitvec bv = { .data = data, .data_len = LEN };
+	unsigned int n, i, k;
+	int exp, val, ok = 1;
+
+	for (k = 0; k < 100; k++) {
+		/* sparse ones and sparse zeros */
+		for (i = 0; i < LEN; i++)
+			data[i] = (rand() % 8) ? 0x00 : 1 << (rand() % 8);
+		if (k & 1)
+			for (i = 0; i < LEN; i++)
+				data[i] ^= 0xff;
+		for (val = ZERO; val <= ONE; val++) {
+			for (n = 0; n <= LEN * 8; n++) {
+				exp = -1;
+				for (i = n; i < LEN * 8; i++) {
+					if (ref_bit(data, i) == val) {
+						exp = i;
+						break;
+					}
+				}
+				if (bitvec_find_bit_pos(&bv, n, val) != exp)
+					ok = 0;
+			}
+		}
+		for (n = 1, i = 0; i < LEN * 8; i++) {
+			if (!ref_bit(data, i))
+				continue;
+			if (bitvec_get_nth_set_bit(&bv, n++) != i)
+				ok = 0;
+		}
+		if (bitvec_get_nth_set_bit(&bv, n) != 0)
+			ok = 0;
+	}
+	printf("find_bit_pos, get_nth_set_bit: %s\n", ok ? "ok" : "FAILED");
+	printf("find L: %d\n", bitvec_find_bit_pos(&bv, 0, L));
+}
+
+static void test_high(void)
+{
+	static uint8_t pad[] = { 0x2b, 0xd4 };
+	struct bitvec bv = { .data = pad, .data_len = sizeof(pad) };
+	int i;
+
+	printf("L/H:");
+	for (i = 0; i < 16; i++)
+		printf(" %c", bitvec_get_bit_high(&bv) == H ? 'H' : 'L');
+	printf(", after end %d\n", bitvec_get_bit_high(&bv) == -EINVAL);
+}
+
+static void test_rxlev(void)
+{
+	struct rxlev_stats st;
+	static const uint16_t arfcns[] = { 0, 1, 63, 64, 65, 512, 1000, 1023 };
+	int i, arfcn;
+
+	rxlev_stat_reset(&st);
+	for (i = 0; i < ARRAY_SIZE(arfcns); i++)
+		rxlev_stat_input(&st, arfcns[i], 20);
+	rxlev_stat_input(&st, 100, 63);
+
+	printf("rxlev 20:");
+	arfcn = -1;
+	while ((arfcn = rxlev_stat_get_next(&st, 20, arfcn)) >= 0)
+		printf(" %d", arfcn);
+	printf("\nrxlev 63:");
+	arfcn = -1;
+	while ((arfcn = rxlev_stat_get_next(&st, 63, arfcn)) >= 0)
+		printf(" %d", arfcn);
+	printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+	srand(1);
+
+	test_uint();
+	test_bytes();
+	test_find();
+	test_high();
+	test_rxlev();
+
+	return 0;
+}
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/conv.h>
+#include <osmocom/core/utils.h>
+
+#define MAX_LEN_BITS	1024
+#define MAX_STATES	64
+#define BATCH_SIZE	16
+
+
+/* ------------------------------------------------------------------------ */
+/* Benchmark codes                                                          */
+/* ------------------------------------------------------------------------ */
+
+/* Non-recursive codes built from their generator polynomials, D^k being
+ * bit k, so the state layout matches the code tables in conv_test.c */
+struct bench_code {
+	const char *name;
+	int K;
+	int N;
+	int len;
+	unsigned int poly[4];
+	struct osmo_conv_code code;
+	uint8_t next_output[MAX_STATES][2];
+	uint8_t next_state[MAX_STATES][2];
+};
+
+static struct bench_code codes[] = {
+	{
+		.name = "GSM xCCH       (K=5, N=2)",
+		.K = 5, .N = 2, .len = 224,
+		.poly = { 031, 033 },
+	},
+	{
+		.name = "K=7 rate 1/2   (K=7, N=2)",
+		.K = 7, .N = 2, .len = 224,
+		.poly = { 0171, 0133 },
+	},
+	{
+		.name = "K=7 rate 1/3   (K=7, N=3)",
+		.K = 7, .N = 3, .len = 165,
+		.poly = { 0133, 0145, 0175 },
+	},
+	{ /* end */ },
+};
+
+static void
+build_code(struct bench_code *bc)
+{
+	int n_states = 1 << (bc->K - 1);
+	int s, b, j;
+
+	for (s=0; s<n_states; s++) {
+		for (b=0; b<2; b++) {
+			unsigned int reg = (s << 1) | b;
+			uint8_t out = 0;
+
+			for (j=0; j<bc->N; j++)
+				out = (out << 1) | (__builtin_popcount(reg & bc->poly[j]) & 1);
+
+			bc->next_output[s][b] = out;
+			bc->next_state[s][b] = reg & (n_states - 1);
+		}
+	}
+
+	bc->code.N = bc->N;
+	bc->code.K = bc->K;
+	bc->code.len = bc->len;
+	bc->code.term = CONV_TERM_FLUSH;
+	bc->code.next_output = (const uint8_t (*)[2]) bc->next_output;
+	bc->code.next_state = (const uint8_t (*)[2]) bc->next_state;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/* Main                                                                     */
+/* ------------------------------------------------------------------------ */
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+	static const enum osmo_conv_backend backends[] = {
+		CONV_BACKEND_SCALAR, CONV_BACKEND_SSE2, CONV_BACKEND_AVX2,
+	};
+	struct bench_code *bc;
+	ubit_t bu[MAX_LEN_BITS], ref[MAX_LEN_BITS], out[MAX_LEN_BITS];
+	sbit_t bs[MAX_LEN_BITS], *batch_in;
+	ubit_t *batch_out;
+	int blocks = argc > 1 ? atoi(argv[1]) : 20000;
+
+	srandom(42);
+
+	batch_in  = malloc(sizeof(sbit_t) * MAX_LEN_BITS * BATCH_SIZE);
+	batch_out = malloc(sizeof(ubit_t) * MAX_LEN_BITS * BATCH_SIZE);
+
+	for (bc=codes; bc->name; bc++)
+	{
+		struct osmo_conv_decoder decoder;
+		struct osmo_conv_encode_lut *lut;
+		double t;
+		int i, b, l;
+
+		build_code(bc);
+
+		/* One noisy block, decoded over and over */
+		for (i=0; i<bc->len; i++)
+			bu[i] = random() & 1;
+
+		l = osmo_conv_encode(&bc->code, bu, out);
+		for (i=0; i<l; i++) {
+			int v = (out[i] ? -64 : 64) + (int)(random() % 161) - 80;
+			bs[i] = v < -127 ? -127 : (v > 127 ? 127 : v);
+		}
+
+		osmo_conv_decode_set_backend(CONV_BACKEND_SCALAR);
+		osmo_conv_decode(&bc->code, bs, ref);
+
+		for (b=0; b<ARRAY_SIZE(backends); b++) {
+			if (osmo_conv_decode_set_backend(backends[b]))
+				continue;
+
+			t = now();
+			for (i=0; i<blocks; i++)
+				osmo_conv_decode(&bc->code, bs, out);
+			t = now() - t;
+
+			printf("%s %-6s : %10.0f blocks/s%s\n",
+				bc->name, osmo_conv_backend_name(backends[b]),
+				blocks / t,
+				memcmp(ref, out, bc->len) ? " MISMATCH" : "");
+		}
+
+		/* Same with a reused decoder, BATCH_SIZE blocks per call */
+		osmo_conv_decode_set_backend(CONV_BACKEND_AUTO);
+		osmo_conv_decode_init(&decoder, &bc->code, 0, 0);
+
+		for (i=0; i<BATCH_SIZE; i++)
+			memcpy(&batch_in[i * l], bs, l);
+
+		t = now();
+		for (i=0; i<blocks; i+=BATCH_SIZE)
+			osmo_conv_decode_batch(&decoder, batch_in, batch_out,
+				BATCH_SIZE, NULL);
+		t = now() - t;
+
+		printf("%s %-6s : %10.0f blocks/s (batch of %d)%s\n",
+			bc->name, osmo_conv_backend_name(osmo_conv_decode_get_backend()),
+			blocks / t, BATCH_SIZE,
+			memcmp(ref, &batch_out[(BATCH_SIZE - 1) * bc->len], bc->len) ?
+				" MISMATCH" : "");
+
+		osmo_conv_decode_deinit(&decoder);
+
+		/* Encoders */
+		t = now();
+		for (i=0; i<blocks; i++)
+			osmo_conv_encode(&bc->code, bu, out);
+		t = now() - t;
+
+		printf("%s encode : %10.0f blocks/s\n", bc->name, blocks / t);
+
+		lut = osmo_conv_encode_lut_alloc(&bc->code);
+
+		t = now();
+		for (i=0; i<blocks; i++)
+			osmo_conv_encode_lut(lut, bu, batch_out);
+		t = now() - t;
+
+		printf("%s encode : %10.0f blocks/s (table driven)%s\n",
+			bc->name, blocks / t,
+			memcmp(out, batch_out, l) ? " MISMATCH" : "");
+
+		osmo_conv_encode_lut_free(lut);
+	}
+
+	free(batch_out);
+	free(batch_in);
+
+	return 0;
+}
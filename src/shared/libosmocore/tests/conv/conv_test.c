@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include <osmocom/core/bits.h>
@@ -355,6 +356,130 @@ sbit_to_ubit(ubit_t *dst, sbit_t *src, int n)
 }
 
 
+static void
+ubit_to_noisy_sbit(sbit_t *dst, ubit_t *src, int n)
+{
+	int i;
+	for (i=0; i<n; i++) {
+		int v = (src[i] ? -64 : 64) + (int)(random() % 161) - 80;
+		dst[i] = v < -127 ? -127 : (v > 127 ? 127 : v);
+	}
+}
+
+static int
+check_backends(const struct osmo_conv_code *code, int in_len,
+               ubit_t *bu0, ubit_t *bu1, sbit_t *bs)
+{
+	static const enum osmo_conv_backend backends[] = {
+		CONV_BACKEND_SSE2, CONV_BACKEND_AVX2,
+	};
+	ubit_t ref[MAX_LEN_BITS];
+	int i, b, l, rv_ref, rv;
+
+	for (i=0; i<3; i++) {
+		fill_random(bu0, in_len);
+		l = osmo_conv_encode(code, bu0, bu1);
+		ubit_to_noisy_sbit(bs, bu1, l);
+
+		osmo_conv_decode_set_backend(CONV_BACKEND_SCALAR);
+		rv_ref = osmo_conv_decode(code, bs, ref);
+
+		for (b=0; b<ARRAY_SIZE(backends); b++) {
+			if (osmo_conv_decode_set_backend(backends[b]))
+				continue;
+
+			rv = osmo_conv_decode(code, bs, bu0);
+			if (rv != rv_ref || memcmp(ref, bu0, in_len)) {
+				fprintf(stderr, "[!] Backend %s differs from scalar\n",
+					osmo_conv_backend_name(backends[b]));
+				osmo_conv_decode_set_backend(CONV_BACKEND_AUTO);
+				return -1;
+			}
+		}
+	}
+
+	osmo_conv_decode_set_backend(CONV_BACKEND_AUTO);
+
+	return 0;
+}
+
+static int
+check_lut(const struct conv_test_vector *tst, ubit_t *bu0, ubit_t *bu1)
+{
+	struct osmo_conv_encode_lut *lut;
+	ubit_t ref[MAX_LEN_BITS];
+	int i, l, err = 0;
+
+	lut = osmo_conv_encode_lut_alloc(tst->code);
+	if (!lut)
+		return -1;
+
+	for (i=0; i<4; i++) {
+		/* Pre computed vector first, then random ones */
+		if (i == 0 && tst->has_vec) {
+			osmo_pbit2ubit(bu0, tst->vec_in, tst->in_len);
+			osmo_pbit2ubit(ref, tst->vec_out, tst->out_len);
+		} else {
+			fill_random(bu0, tst->in_len);
+			osmo_conv_encode(tst->code, bu0, ref);
+		}
+
+		l = osmo_conv_encode_lut(lut, bu0, bu1);
+		if (l != tst->out_len || memcmp(ref, bu1, l)) {
+			err = -1;
+			break;
+		}
+	}
+
+	osmo_conv_encode_lut_free(lut);
+
+	return err;
+}
+
+static int
+check_batch(const struct osmo_conv_code *code, int in_len, int out_len)
+{
+	struct osmo_conv_decoder decoder;
+	ubit_t *bu_in, *bu_coded, *bu_out;
+	sbit_t *bs;
+	int i, rv[4], err = 0;
+
+	bu_in    = malloc(sizeof(ubit_t) * in_len * 4);
+	bu_coded = malloc(sizeof(ubit_t) * out_len * 4);
+	bu_out   = malloc(sizeof(ubit_t) * in_len * 4);
+	bs       = malloc(sizeof(sbit_t) * out_len * 4);
+
+	for (i=0; i<4; i++) {
+		fill_random(&bu_in[i * in_len], in_len);
+		osmo_conv_encode(code, &bu_in[i * in_len], &bu_coded[i * out_len]);
+	}
+
+	ubit_to_sbit(bs, bu_coded, out_len * 4);
+
+	osmo_conv_decode_init(&decoder, code, 0, 0);
+
+	if (osmo_conv_decode_batch(&decoder, bs, bu_out, 4, rv))
+		err = -1;
+
+	for (i=0; i<4; i++) {
+		if (rv[i] != 0)
+			err = -1;
+	}
+
+	if (memcmp(bu_in, bu_out, in_len * 4))
+		err = -1;
+
+	osmo_conv_decode_deinit(&decoder);
+
+	free(bs);
+	free(bu_out);
+	free(bu_coded);
+	free(bu_in);
+
+	return err;
+}
+
+
 int main(int argc, char argv[])
 {
 	const struct conv_test_vector *tst;
@@ -474,6 +599,38 @@ int main(int argc, char argv[])
 			printf("OK\n");
 		}
 
+		/* Check table driven encoder */
+		printf("[.] Table driven encoding : ");
+
+		if (check_lut(tst, bu0, bu1)) {
+			printf("ERROR !\n");
+			fprintf(stderr, "[!] Failed table driven encoding\n");
+			return -1;
+		}
+
+		printf("OK\n");
+
+		/* Check decoder reuse over several blocks */
+		printf("[.] Batch decoding : ");
+
+		if (check_batch(tst->code, tst->in_len, tst->out_len)) {
+			printf("ERROR !\n");
+			fprintf(stderr, "[!] Failed batch decoding\n");
+			return -1;
+		}
+
+		printf("OK\n");
+
+		/* Check accelerated decoders against the reference one */
+		printf("[.] Backend cross-check : ");
+
+		if (check_backends(tst->code, tst->in_len, bu0, bu1, bs)) {
+			printf("ERROR !\n");
+			return -1;
+		}
+
+		printf("OK\n");
+
 		/* Spacing */
 		printf("\n");
 	}
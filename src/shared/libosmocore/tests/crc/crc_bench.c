@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/crc16.h>
+#include <osmocom/core/crcgen.h>
+#include <osmocom/core/utils.h>
+
+/* Same codes as crc_test.c */
+static const struct osmo_crc8gen_code gsm0503_tch_fr_crc3 = {
+	.bits = 3, .poly = 0x3, .init = 0x0, .remainder = 0x7,
+};
+static const struct osmo_crc8gen_code gsm0503_rach_crc6 = {
+	.bits = 6, .poly = 0x2f, .init = 0x00, .remainder = 0x3f,
+};
+static const struct osmo_crc8gen_code gsm0503_tch_efr_crc8 = {
+	.bits = 8, .poly = 0x1d, .init = 0x00, .remainder = 0x00,
+};
+static const struct osmo_crc16gen_code gsm0503_sch_crc10 = {
+	.bits = 10, .poly = 0x175, .init = 0x000, .remainder = 0x3ff,
+};
+static const struct osmo_crc16gen_code gsm0503_cs234_crc16 = {
+	.bits = 16, .poly = 0x1021, .init = 0x0000, .remainder = 0xffff,
+};
+static const struct osmo_crc32gen_code crc32_bzip2 = {
+	.bits = 32, .poly = 0x04c11db7, .init = 0xffffffff, .remainder = 0xffffffff,
+};
+static const struct osmo_crc64gen_code gsm0503_fire_crc40 = {
+	.bits = 40, .poly = 0x0004820009ULL, .init = 0, .remainder = 0xffffffffffULL,
+};
+
+#define LEN_BITS	456
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static volatile uint64_t sink;
+
+/* Runs of the bitwise, table/hard-bits and table/packed-bits variants */
+#define BENCH_CODE(XX, code)						\
+	do {								\
+		static struct osmo_crc##XX##gen_table tab;		\
+		uint##XX##_t c0 = 0, c1 = 0, c2 = 0;			\
+		double t0, t1, t2;					\
+		int i;							\
+									\
+		osmo_crc##XX##gen_table_init(&tab, &code);		\
+									\
+		t0 = now();						\
+		for (i=0; i<n; i++)					\
+			c0 ^= osmo_crc##XX##gen_compute_bits(&code, ub, LEN_BITS);	\
+		t0 = now() - t0;					\
+		t1 = now();						\
+		for (i=0; i<n; i++)					\
+			c1 ^= osmo_crc##XX##gen_table_compute_bits(&tab, ub, LEN_BITS);	\
+		t1 = now() - t1;					\
+		t2 = now();						\
+		for (i=0; i<n; i++)					\
+			c2 ^= osmo_crc##XX##gen_table_compute_pbits(&tab, pb, LEN_BITS);	\
+		t2 = now() - t2;					\
+		sink += c0;						\
+									\
+		printf("%-22s: %9.0f %9.0f (x%4.1f) %9.0f (x%5.1f) blocks/s%s\n", \
+			#code, n / t0, n / t1, t0 / t1, n / t2, t0 / t2,	\
+			(c0 != c1 || c0 != c2) ? " MISMATCH" : "");	\
+	} while (0)
+
+int main(int argc, char **argv)
+{
+	static ubit_t ub[LEN_BITS];
+	static pbit_t pb[(LEN_BITS + 7) / 8];
+	static uint8_t buf[4096];
+	int n = argc > 1 ? atoi(argv[1]) : 200000;
+	uint16_t c0 = 0, c1 = 0;
+	double t0, t1;
+	int i, j;
+
+	srandom(42);
+
+	for (i=0; i<LEN_BITS; i++)
+		ub[i] = random() & 1;
+	osmo_ubit2pbit(pb, ub, LEN_BITS);
+
+	printf("%d bit blocks          bitwise   table/ubit         table/pbit\n",
+		LEN_BITS);
+
+	BENCH_CODE(8,  gsm0503_tch_fr_crc3);
+	BENCH_CODE(8,  gsm0503_rach_crc6);
+	BENCH_CODE(8,  gsm0503_tch_efr_crc8);
+	BENCH_CODE(16, gsm0503_sch_crc10);
+	BENCH_CODE(16, gsm0503_cs234_crc16);
+	BENCH_CODE(32, crc32_bzip2);
+	BENCH_CODE(64, gsm0503_fire_crc40);
+
+	/* osmo_crc16() on 4k buffers, byte table vs slice-by-8 */
+	for (i=0; i<sizeof(buf); i++)
+		buf[i] = random();
+
+	t0 = now();
+	for (i=0; i<n/100; i++)
+		for (j=0; j<sizeof(buf); j++)
+			c0 = osmo_crc16_byte(c0, buf[j]);
+	t0 = now() - t0;
+
+	t1 = now();
+	for (i=0; i<n/100; i++)
+		c1 = osmo_crc16(c1, buf, sizeof(buf));
+	t1 = now() - t1;
+
+	printf("osmo_crc16            : %6.1f MB/s bytewise, %6.1f MB/s sliced (x%.1f)%s\n",
+		(n/100) * sizeof(buf) / t0 / 1e6, (n/100) * sizeof(buf) / t1 / 1e6,
+		t0 / t1, c0 != c1 ? " MISMATCH" : "");
+
+	return 0;
+}
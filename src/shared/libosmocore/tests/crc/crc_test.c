@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <osmocom/core/bits.h>
+#include <osmocom/core/crc16.h>
+#include <osmocom/core/crcgen.h>
+#include <osmocom/core/utils.h>
+
+#define MAX_LEN_BITS	1024
+
+
+/* ------------------------------------------------------------------------ */
+/* Test codes                                                               */
+/* ------------------------------------------------------------------------ */
+
+/* GSM TCH/FS class 1a parity */
+static const struct osmo_crc8gen_code gsm0503_tch_fr_crc3 = {
+	.bits = 3,
+	.poly = 0x3,
+	.init = 0x0,
+	.remainder = 0x7,
+};
+
+/* GSM RACH */
+static const struct osmo_crc8gen_code gsm0503_rach_crc6 = {
+	.bits = 6,
+	.poly = 0x2f,
+	.init = 0x00,
+	.remainder = 0x3f,
+};
+
+/* GSM TCH/EFS */
+static const struct osmo_crc8gen_code gsm0503_tch_efr_crc8 = {
+	.bits = 8,
+	.poly = 0x1d,
+	.init = 0x00,
+	.remainder = 0x00,
+};
+
+/* GSM SCH */
+static const struct osmo_crc16gen_code gsm0503_sch_crc10 = {
+	.bits = 10,
+	.poly = 0x175,
+	.init = 0x000,
+	.remainder = 0x3ff,
+};
+
+/* GPRS CS-2/3/4 */
+static const struct osmo_crc16gen_code gsm0503_cs234_crc16 = {
+	.bits = 16,
+	.poly = 0x1021,
+	.init = 0x0000,
+	.remainder = 0xffff,
+};
+
+/* CRC-32 as in bzip2, for the known answer */
+static const struct osmo_crc32gen_code crc32_bzip2 = {
+	.bits = 32,
+	.poly = 0x04c11db7,
+	.init = 0xffffffff,
+	.remainder = 0xffffffff,
+};
+
+/* GSM xCCH fire code */
+static const struct osmo_crc64gen_code gsm0503_fire_crc40 = {
+	.bits = 40,
+	.poly = 0x0004820009ULL,
+	.init = 0x0000000000ULL,
+	.remainder = 0xffffffffffULL,
+};
+
+
+/* ------------------------------------------------------------------------ */
+/* Main                                                                     */
+/* ------------------------------------------------------------------------ */
+
+static const int lengths[] = {
+	0, 1, 3, 7, 8, 9, 15, 16, 17, 63, 64, 65, 71, 72, 127, 184, 224, 456,
+};
+
+/* Compare bitwise, table driven hard-bits and table driven packed bits on
+ * random input of various lengths */
+#define CHECK_CODE(XX, code)						\
+	do {								\
+		struct osmo_crc##XX##gen_table tab;			\
+		int i, j, err = 0;					\
+									\
+		osmo_crc##XX##gen_table_init(&tab, &code);		\
+									\
+		for (i=0; i<ARRAY_SIZE(lengths); i++) {			\
+			int len = lengths[i];				\
+			uint##XX##_t c0, c1, c2;			\
+									\
+			for (j=0; j<len; j++)				\
+				ub[j] = random() & 1;			\
+			memset(pb, 0, sizeof(pb));			\
+			osmo_ubit2pbit(pb, ub, len);			\
+									\
+			c0 = osmo_crc##XX##gen_compute_bits(&code, ub, len);		\
+			c1 = osmo_crc##XX##gen_table_compute_bits(&tab, ub, len);	\
+			c2 = osmo_crc##XX##gen_table_compute_pbits(&tab, pb, len);	\
+									\
+			if (c0 != c1 || c0 != c2)			\
+				err = 1;				\
+		}							\
+									\
+		printf("[+] %-24s: %s\n", #code, err ? "ERROR" : "OK");	\
+		rc |= err;						\
+	} while (0)
+
+int main(int argc, char **argv)
+{
+	static const uint8_t check[] = "123456789";
+	static ubit_t ub[MAX_LEN_BITS];
+	static pbit_t pb[MAX_LEN_BITS / 8];
+	struct osmo_crc32gen_table tab32;
+	uint8_t buf[1000];
+	uint16_t c16_ref;
+	int i, rc = 0;
+
+	srandom(42);
+
+	CHECK_CODE(8,  gsm0503_tch_fr_crc3);
+	CHECK_CODE(8,  gsm0503_rach_crc6);
+	CHECK_CODE(8,  gsm0503_tch_efr_crc8);
+	CHECK_CODE(16, gsm0503_sch_crc10);
+	CHECK_CODE(16, gsm0503_cs234_crc16);
+	CHECK_CODE(32, crc32_bzip2);
+	CHECK_CODE(64, gsm0503_fire_crc40);
+
+	/* Known answers */
+	osmo_crc32gen_table_init(&tab32, &crc32_bzip2);
+	printf("[+] CRC-32/BZIP2 check : 0x%08x\n",
+		osmo_crc32gen_table_compute_pbits(&tab32, check, 72));
+	printf("[+] CRC-16 check       : 0x%04x\n",
+		osmo_crc16(0, check, 9));
+
+	/* osmo_crc16() slice-by-8 vs byte at a time, all lengths & offsets */
+	for (i=0; i<sizeof(buf); i++)
+		buf[i] = random();
+
+	for (i=0; i<64; i++) {
+		int j, len = (i * 37) % 200;
+
+		c16_ref = 0x1234;
+		for (j=0; j<len; j++)
+			c16_ref = osmo_crc16_byte(c16_ref, buf[i + j]);
+
+		if (osmo_crc16(0x1234, &buf[i], len) != c16_ref)
+			rc = 1;
+	}
+	printf("[+] osmo_crc16 bulk    : %s\n", rc ? "ERROR" : "OK");
+
+	return rc;
+}
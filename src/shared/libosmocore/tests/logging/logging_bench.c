@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <osmocom/core/logging.h>
+#include <osmocom/core/utils.h>
+
+enum {
+	DRR,
+	DCS,
+	DL1C,
+};
+
+static struct log_info_cat cats[] = {
+	[DRR] = {
+		.name = "DRR",
+		.description = "Radio Resource",
+		.enabled = 1, .loglevel = LOGL_NOTICE,
+	},
+	[DCS] = {
+		.name = "DCS",
+		.description = "Cell selection",
+		.enabled = 1, .loglevel = LOGL_NOTICE,
+	},
+	[DL1C] = {
+		.name = "DL1C",
+		.description = "Layer 1 control",
+		.enabled = 1, .loglevel = LOGL_DEBUG,
+	},
+};
+
+static const struct log_info info = {
+	.cat = cats,
+	.num_cat = ARRAY_SIZE(cats),
+};
+
+static unsigned int written;
+
+static void null_output(struct log_target *target, unsigned int level,
+			const char *string)
+{
+	written++;
+}
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* the kind of argument typically found in LOGP calls */
+static uint8_t frame[23];
+
+static double
+run(int n, int subsys, int level)
+{
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<n; i++)
+		LOGP(subsys, level, "arfcn %d fn %d: %s\n", i & 1023, i,
+			osmo_hexdump(frame, sizeof(frame)));
+	t = now() - t;
+
+	return n / t;
+}
+
+/* what LOGP used to expand to, arguments always evaluated */
+static double
+run_unchecked(int n, int subsys, int level)
+{
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<n; i++)
+		logp2(subsys, level, __FILE__, __LINE__, 0,
+			"arfcn %d fn %d: %s\n", i & 1023, i,
+			osmo_hexdump(frame, sizeof(frame)));
+	t = now() - t;
+
+	return n / t;
+}
+
+int main(int argc, char **argv)
+{
+	struct log_target *tgt;
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	int i;
+
+	log_init(&info, NULL);
+
+	/* three targets, like stderr + file + vty */
+	for (i=0; i<3; i++) {
+		tgt = log_target_create();
+		tgt->output = null_output;
+		log_set_all_filter(tgt, 1);
+		log_add_target(tgt);
+	}
+
+	printf("DRR  DEBUG (disabled)  : %12.0f msgs/s\n", run(n, DRR, LOGL_DEBUG));
+	printf("DCS  INFO  (disabled)  : %12.0f msgs/s\n", run(n, DCS, LOGL_INFO));
+	printf("DRR  DEBUG (unchecked) : %12.0f msgs/s\n", run_unchecked(n / 10, DRR, LOGL_DEBUG));
+	printf("DL1C DEBUG (enabled)   : %12.0f msgs/s\n", run(n / 10, DL1C, LOGL_DEBUG));
+	printf("written %u\n", written);
+
+	/* file output from the main loop vs. through the writer thread
+	 * vs. unformatted binary records */
+	while (!llist_empty(&osmo_log_target_list)) {
+		tgt = llist_entry(osmo_log_target_list.next,
+				  struct log_target, entry);
+		log_target_destroy(tgt);
+	}
+
+	for (i=0; i<3; i++) {
+		static const char *names[] = { "file  ", "async ", "binary" };
+		char fname[] = "/tmp/logging_bench.XXXXXX";
+		struct log_async_stats st;
+		double t;
+
+		close(mkstemp(fname));
+		if (i == 2)
+			tgt = log_target_create_binary(fname);
+		else if (i)
+			tgt = log_target_create_async(fname, 1024 * 1024);
+		else
+			tgt = log_target_create_file(fname);
+		log_set_all_filter(tgt, 1);
+		log_set_print_timestamp(tgt, 1);
+		log_add_target(tgt);
+
+		t = run(n / 10, DL1C, LOGL_DEBUG);
+		printf("DL1C DEBUG (%s): %12.0f msgs/s", names[i], t);
+		if (i == 1) {
+			log_target_async_get_stats(tgt, &st);
+			printf(", dropped %lu, max fill %lu", st.dropped,
+				st.max_fill);
+		}
+		printf("\n");
+
+		log_target_destroy(tgt);
+		unlink(fname);
+	}
+
+	return 0;
+}
@@ -0,0 +1,380 @@
+/*
+ * logging test, level summary and argument evaluation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <osmocom/core/logging.h>
+#include <osmocom/core/logging_binary.h>
+#include <osmocom/core/timer.h>
+#include <osmocom/core/utils.h>
+
+enum {
+	DRR,
+	DCS,
+};
+
+static struct log_info_cat cats[] = {
+	[DRR] = {
+		.name = "DRR",
+		.description = "Radio Resource",
+		.enabled = 1, .loglevel = LOGL_NOTICE,
+	},
+	[DCS] = {
+		.name = "DCS",
+		.description = "Cell selection",
+		.enabled = 0, .loglevel = LOGL_DEBUG,
+	},
+};
+
+static const struct log_info info = {
+	.cat = cats,
+	.num_cat = ARRAY_SIZE(cats),
+};
+
+static int evaluated;
+static int written;
+
+static int arg(int v)
+{
+	evaluated++;
+	return v;
+}
+
+static void test_output(struct log_target *target, unsigned int level,
+			const char *string)
+{
+	written++;
+}
+
+static void check(const char *what, int subsys, int level)
+{
+	evaluated = written = 0;
+	LOGP(subsys, level, "%d\n", arg(1));
+	printf("%-32s: check %d, evaluated %d, written %d\n", what,
+		log_check_level(subsys, level), evaluated, written);
+}
+
+/* lines must be "<n>\n" with n increasing, returns number of lines */
+static int check_file(const char *fname, int *in_order)
+{
+	char line[64];
+	FILE *f;
+	int n = 0, last = -1;
+
+	*in_order = 1;
+	f = fopen(fname, "r");
+	while (fgets(line, sizeof(line), f)) {
+		int v = atoi(line);
+		if (v <= last)
+			*in_order = 0;
+		last = v;
+		n++;
+	}
+	fclose(f);
+
+	return n;
+}
+
+static void test_async(int overflow, unsigned int size, int lines)
+{
+	char fname[] = "/tmp/logging_test.XXXXXX";
+	struct log_async_stats st;
+	struct log_target *tgt;
+	int i, n, in_order, fd;
+
+	fd = mkstemp(fname);
+	close(fd);
+
+	tgt = log_target_create_async(fname, size);
+	log_set_all_filter(tgt, 1);
+	log_set_use_color(tgt, 0);
+	log_set_category_filter(tgt, DRR, 1, LOGL_DEBUG);
+	log_target_async_set_overflow(tgt, overflow);
+	log_add_target(tgt);
+
+	for (i = 0; i < lines; i++)
+		LOGPC(DRR, LOGL_INFO, "%d\n", i);
+
+	log_target_async_flush(tgt);
+	log_target_async_get_stats(tgt, &st);
+	log_target_destroy(tgt);
+
+	n = check_file(fname, &in_order);
+	unlink(fname);
+
+	printf("async %s: all accounted for %d, in order %d, empty %d",
+		overflow == LOG_ASYNC_BLOCK ? "block" : "drop ",
+		st.records + st.dropped == lines && n == st.records,
+		in_order, st.fill == 0);
+	if (overflow == LOG_ASYNC_BLOCK)
+		printf(", written %d", n);
+	printf("\n");
+}
+
+static void print_binary(struct log_bin_reader *r, int max)
+{
+	struct log_bin_entry e;
+
+	while (max-- && log_bin_reader_next(r, &e) > 0) {
+		const char *file = strrchr(e.file, '/');
+
+		if (!e.cont)
+			printf("%lu.%06u <%4.4x> %u %s:%u ",
+				(unsigned long) (e.time_us / 1000000),
+				(unsigned int) (e.time_us % 1000000),
+				e.subsys, e.level, file ? file + 1 : e.file,
+				e.line);
+		printf("%s", e.text);
+	}
+}
+
+static void test_binary(void)
+{
+	char fname[] = "/tmp/logging_test.XXXXXX";
+	struct timeval tv = { 1000, 0 };
+	struct timeval sec = { 1, 0 };
+	struct log_bin_reader *r;
+	struct log_target *tgt;
+	char fmt[16], fmt2[16], buf[] = "abcdefgh";
+	long long ll = -1234567890123LL;
+	FILE *f;
+	int i;
+
+	close(mkstemp(fname));
+	osmo_clock_set_mode(OSMO_CLOCK_VIRTUAL);
+	osmo_clock_set(&tv);
+
+	tgt = log_target_create_binary(fname);
+	log_target_binary_set_segment_size(tgt, 256);
+	log_set_all_filter(tgt, 1);
+	log_set_category_filter(tgt, DRR, 1, LOGL_DEBUG);
+	log_add_target(tgt);
+
+	LOGP(DRR, LOGL_INFO, "int %d %5u %-3x|%c|%hhd\n", -42, 42u, 0xab,
+		'z', 300);
+	LOGP(DRR, LOGL_NOTICE, "long %ld %lld %zu %jd\n", -1L, ll,
+		sizeof(ll), (intmax_t) 7);
+	LOGP(DRR, LOGL_ERROR, "float %.3f %e %Lg\n", 3.14159, 1e10,
+		(long double) 0.5);
+	LOGP(DRR, LOGL_INFO, "str %s|%.3s|%.*s|%*s|%s|%%\n", "hello", buf,
+		2, buf + 4, 4, "x", (char *) NULL);
+	LOGP(DRR, LOGL_INFO, "pos %2$s %1$s\n", "a", "b");
+	LOGP(DRR, LOGL_INFO, "start ");
+	LOGPC(DRR, LOGL_INFO, "cont %d\n", 1);
+
+	/* formats not in the program, each in its own buffer */
+	strcpy(fmt, "dyn %d\n");
+	LOGP(DRR, LOGL_INFO, fmt, 1);
+	strcpy(fmt2, "dyn %s\n");
+	LOGP(DRR, LOGL_INFO, fmt2, "two");
+
+	for (i = 0; i < 20; i++) {
+		osmo_clock_advance(&sec);
+		LOGP(DRR, LOGL_DEBUG, "tick %d\n", i);
+	}
+
+	log_target_destroy(tgt);
+	osmo_clock_set_mode(OSMO_CLOCK_REAL);
+
+	f = fopen(fname, "r");
+	r = log_bin_reader_open(NULL, f);
+	printf("binary log:\n");
+	print_binary(r, -1);
+
+	printf("seek to 1015.5:\n");
+	log_bin_reader_seek(r, 1015500000ULL);
+	print_binary(r, 2);
+	printf("seek to 900:\n");
+	log_bin_reader_seek(r, 900000000ULL);
+	print_binary(r, 1);
+
+	log_bin_reader_close(r);
+	fclose(f);
+	unlink(fname);
+}
+
+/* more formats than the writer's table starts with, as in layer23 */
+static void test_binary_many(void)
+{
+	static char fmts[1500][8];
+	char fname[] = "/tmp/logging_test.XXXXXX";
+	struct log_bin_reader *r;
+	struct log_bin_entry e;
+	struct log_bin_hdr hdr;
+	struct log_target *tgt;
+	int msg = 0, text = 0, decoded = 0;
+	FILE *f;
+	int i;
+
+	close(mkstemp(fname));
+	tgt = log_target_create_binary(fname);
+	log_set_all_filter(tgt, 1);
+	log_set_category_filter(tgt, DRR, 1, LOGL_DEBUG);
+	log_add_target(tgt);
+
+	for (i = 0; i < ARRAY_SIZE(fmts); i++) {
+		strcpy(fmts[i], "%d\n");
+		LOGP(DRR, LOGL_DEBUG, fmts[i], i);
+	}
+
+	log_target_destroy(tgt);
+
+	f = fopen(fname, "r");
+	while (fread(&hdr, sizeof(hdr), 1, f) == 1) {
+		if (hdr.type == LOG_BIN_MSG)
+			msg++;
+		else if (hdr.type == LOG_BIN_TEXT)
+			text++;
+		fseek(f, hdr.len - sizeof(hdr), SEEK_CUR);
+	}
+
+	rewind(f);
+	r = log_bin_reader_open(NULL, f);
+	while (log_bin_reader_next(r, &e) > 0) {
+		if (atoi(e.text) == decoded)
+			decoded++;
+	}
+	log_bin_reader_close(r);
+	fclose(f);
+	unlink(fname);
+
+	printf("binary many: msg %d, text %d, decoded %d\n", msg, text,
+		decoded);
+}
+
+/* the timestamp is the time of logging, not of writing the line */
+static void test_async_stamp(void)
+{
+	char fname[] = "/tmp/logging_test.XXXXXX";
+	struct timeval tv = { 1000000000, 500000 };
+	struct timeval later = { 5, 0 };
+	struct log_target *tgt;
+	char line[128], expect[64];
+	time_t tm = tv.tv_sec;
+	char *s;
+	FILE *f;
+
+	close(mkstemp(fname));
+	osmo_clock_set_mode(OSMO_CLOCK_VIRTUAL);
+	osmo_clock_set(&tv);
+
+	tgt = log_target_create_async(fname, 8192);
+	log_set_all_filter(tgt, 1);
+	log_set_use_color(tgt, 0);
+	log_set_print_timestamp(tgt, 1);
+	log_set_category_filter(tgt, DRR, 1, LOGL_DEBUG);
+	log_add_target(tgt);
+
+	LOGP(DRR, LOGL_INFO, "stamped\n");
+	LOGPC(DRR, LOGL_INFO, "cont\n");
+	osmo_clock_advance(&later);
+	log_target_async_flush(tgt);
+	log_target_destroy(tgt);
+	osmo_clock_set_mode(OSMO_CLOCK_REAL);
+
+	s = ctime(&tm);
+	snprintf(expect, sizeof(expect), "%.*s <0000> ", (int)strlen(s) - 1, s);
+
+	f = fopen(fname, "r");
+	if (!fgets(line, sizeof(line), f))
+		line[0] = '\0';
+	printf("async stamp: time of logging %d",
+		!strncmp(line, expect, strlen(expect)) &&
+		strstr(line, " stamped\n") != NULL);
+	if (!fgets(line, sizeof(line), f))
+		line[0] = '\0';
+	printf(", continuation without %d\n", !strcmp(line, "cont\n"));
+	fclose(f);
+	unlink(fname);
+}
+
+int main(int argc, char **argv)
+{
+	struct log_target *tgt, *tgt2;
+
+	log_init(&info, NULL);
+
+	check("no target", DRR, LOGL_ERROR);
+
+	tgt = log_target_create();
+	tgt->output = test_output;
+	log_add_target(tgt);
+	check("no filter", DRR, LOGL_ERROR);
+
+	log_set_all_filter(tgt, 1);
+	check("DRR notice, ERROR", DRR, LOGL_ERROR);
+	check("DRR notice, INFO", DRR, LOGL_INFO);
+	check("DCS disabled, ERROR", DCS, LOGL_ERROR);
+	check("DLGLOBAL notice, NOTICE", DLGLOBAL, LOGL_NOTICE);
+	check("DLMI disabled, FATAL", DLMI, LOGL_FATAL);
+
+	log_set_category_filter(tgt, DCS, 1, LOGL_INFO);
+	check("DCS info, INFO", DCS, LOGL_INFO);
+	check("DCS info, DEBUG", DCS, LOGL_DEBUG);
+
+	log_set_log_level(tgt, LOGL_ERROR);
+	check("global error, DCS NOTICE", DCS, LOGL_NOTICE);
+	check("global error, DRR FATAL", DRR, LOGL_FATAL);
+	log_set_log_level(tgt, 0);
+
+	log_parse_category_mask(tgt, "DRR,1");
+	check("mask DRR,1, DRR DEBUG", DRR, LOGL_DEBUG);
+	check("mask DRR,1, DCS FATAL", DCS, LOGL_FATAL);
+
+	/* a second target enabling more */
+	tgt2 = log_target_create();
+	tgt2->output = test_output;
+	log_set_all_filter(tgt2, 1);
+	log_set_category_filter(tgt2, DCS, 1, LOGL_NOTICE);
+	log_add_target(tgt2);
+	check("two targets, DCS NOTICE", DCS, LOGL_NOTICE);
+	check("two targets, DRR DEBUG", DRR, LOGL_DEBUG);
+
+	log_target_destroy(tgt);
+	check("one left, DRR DEBUG", DRR, LOGL_DEBUG);
+	log_target_destroy(tgt2);
+	check("none left, DCS FATAL", DCS, LOGL_FATAL);
+
+	/* DEBUGP is at debug level */
+	tgt = log_target_create();
+	tgt->output = test_output;
+	log_set_all_filter(tgt, 1);
+	log_add_target(tgt);
+	evaluated = written = 0;
+	DEBUGP(DRR, "%d\n", arg(1));
+	printf("%-32s: evaluated %d, written %d\n", "DEBUGP DRR", evaluated,
+		written);
+	log_set_category_filter(tgt, DRR, 1, LOGL_DEBUG);
+	DEBUGP(DRR, "%d\n", arg(1));
+	printf("%-32s: evaluated %d, written %d\n", "DEBUGP DRR debug",
+		evaluated, written);
+
+	log_target_destroy(tgt);
+
+	test_async(LOG_ASYNC_BLOCK, 8192, 20000);
+	test_async(LOG_ASYNC_DROP, 8192, 20000);
+	test_async_stamp();
+	test_binary();
+	test_binary_many();
+
+	return 0;
+}
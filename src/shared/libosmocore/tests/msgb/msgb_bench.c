@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/utils.h>
+
+#define BURST		16
+#define MAX_SINKS	8
+#define FRAME_SIZE	1024
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Allocate a burst of messages, fill a header, release them again,
+ * which is roughly what a L1CTL / LAPDm round trip does */
+static double
+run(int rounds, uint16_t size)
+{
+	struct msgb *msgs[BURST];
+	double t;
+	int i, j;
+
+	t = now();
+	for (i=0; i<rounds; i++) {
+		for (j=0; j<BURST; j++) {
+			msgs[j] = msgb_alloc(size, "bench");
+			memset(msgb_put(msgs[j], 23), 0x2b, 23);
+		}
+		for (j=0; j<BURST; j++)
+			msgb_free(msgs[j]);
+	}
+	t = now() - t;
+
+	return (double)rounds * BURST / t;
+}
+
+/* Hand one frame to n sinks (write queues, GSMTAP, the stack), either
+ * as a copy per sink or as shared clones, and drain the sinks */
+static double
+run_fanout(int rounds, int n, int clone)
+{
+	struct llist_head sinks[MAX_SINKS];
+	struct msgb *msg, *m;
+	double t;
+	int i, j;
+
+	for (j=0; j<n; j++)
+		INIT_LLIST_HEAD(&sinks[j]);
+
+	t = now();
+	for (i=0; i<rounds; i++) {
+		msg = msgb_alloc(FRAME_SIZE + 32, "rx");
+		memset(msgb_put(msg, FRAME_SIZE), i, FRAME_SIZE);
+
+		for (j=0; j<n; j++) {
+			if (clone) {
+				m = msgb_clone_shared(msg, "sink");
+			} else {
+				m = msgb_alloc(FRAME_SIZE + 32, "sink");
+				memcpy(msgb_put(m, msg->len), msg->data, msg->len);
+			}
+			msgb_enqueue(&sinks[j], m);
+		}
+		msgb_free(msg);
+
+		for (j=0; j<n; j++)
+			while ((m = msgb_dequeue(&sinks[j])))
+				msgb_free(m);
+	}
+	t = now() - t;
+
+	return rounds / t;
+}
+
+int main(int argc, char **argv)
+{
+	static const uint16_t sizes[] = { 64, 256, 1024, 4096 };
+	struct msgb_pool_stats st[MSGB_POOL_CLASSES];
+	int rounds = argc > 1 ? atoi(argv[1]) : 200000;
+	double t_talloc, t_pool;
+	int s, i;
+
+	for (s=0; s<ARRAY_SIZE(sizes); s++) {
+		msgb_pool_init(0);
+		t_talloc = run(rounds, sizes[s]);
+
+		msgb_pool_init(BURST);
+		t_pool = run(rounds, sizes[s]);
+
+		printf("msgb %4u : talloc %10.0f msgs/s, pool %10.0f msgs/s (x%.2f)\n",
+			sizes[s], t_talloc, t_pool, t_pool / t_talloc);
+	}
+
+	msgb_pool_get_stats(st);
+	for (i=0; i<MSGB_POOL_CLASSES; i++)
+		printf("class %4u : hits %u misses %u free %u\n",
+			st[i].size, st[i].hits, st[i].misses, st[i].free);
+
+	msgb_pool_init(0);
+
+	for (s=1; s<=MAX_SINKS; s*=2) {
+		t_talloc = run_fanout(rounds / 4, s, 0);
+		t_pool = run_fanout(rounds / 4, s, 1);
+		printf("fan-out %d : copy %10.0f frames/s, clone %10.0f frames/s (x%.2f)\n",
+			s, t_talloc, t_pool, t_pool / t_talloc);
+	}
+
+	return 0;
+}
@@ -0,0 +1,190 @@
+/*
+ * msgb allocator test, talloc path and pool
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <osmocom/core/msgb.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+static void dump_stats(void)
+{
+	struct msgb_pool_stats st[MSGB_POOL_CLASSES];
+	int i;
+
+	msgb_pool_get_stats(st);
+	for (i = 0; i < MSGB_POOL_CLASSES; i++) {
+		if (!st[i].hits && !st[i].misses && !st[i].free)
+			continue;
+		printf("  class %4u: hits %u misses %u free %u\n",
+			st[i].size, st[i].hits, st[i].misses, st[i].free);
+	}
+}
+
+static int check_fresh(struct msgb *msg, uint16_t size)
+{
+	return msg->len == 0 && msg->data_len == size &&
+		msg->head == msg->_data && msg->data == msg->_data &&
+		msg->tail == msg->_data && !msg->l1h && !msg->l2h &&
+		!msg->l3h && !msg->l4h && !msg->lchan && !msg->dst &&
+		!msg->cb[0] && !msg->cb[4] && msgb_tailroom(msg) == size;
+}
+
+static void test_talloc(void *ctx)
+{
+	struct msgb *msg;
+
+	printf("Testing the talloc path\n");
+
+	msg = msgb_alloc(200, "test");
+	printf("  fresh: %d\n", check_fresh(msg, 200));
+	printf("  live: %zu\n", talloc_total_blocks(ctx));
+	msgb_free(msg);
+	printf("  live after free: %zu\n", talloc_total_blocks(ctx));
+}
+
+static void test_pool(void *ctx)
+{
+	struct msgb *msg, *msg2;
+	void *p;
+	int i;
+
+	printf("Testing the pool\n");
+	msgb_pool_init(2);
+
+	msg = msgb_alloc(200, "first");
+	printf("  fresh: %d\n", check_fresh(msg, 200));
+	msgb_put(msg, 10);
+	msgb_push(msg, 0);
+	msg->l2h = msg->data;
+	msg->cb[0] = 42;
+	p = msg;
+	msgb_free(msg);
+	printf("  live after free: %zu\n", talloc_total_blocks(ctx));
+
+	/* same class, the one just released comes back, cleared */
+	msg = msgb_alloc(150, "second");
+	printf("  reused: %d\n", msg == p);
+	printf("  fresh: %d\n", check_fresh(msg, 150));
+	printf("  name: %s\n", talloc_get_name(msg));
+	printf("  live: %zu\n", talloc_total_blocks(ctx));
+
+	/* a different class is a miss */
+	msg2 = msgb_alloc(1000, "third");
+	printf("  fresh: %d\n", check_fresh(msg2, 1000));
+	msgb_free(msg2);
+	msgb_free(msg);
+	dump_stats();
+
+	/* larger than any class, not pooled */
+	msg = msgb_alloc(8000, "large");
+	printf("  fresh: %d\n", check_fresh(msg, 8000));
+	msgb_free(msg);
+
+	/* the freelist is bounded */
+	{
+		struct msgb *msgs[4];
+		for (i = 0; i < ARRAY_SIZE(msgs); i++)
+			msgs[i] = msgb_alloc(60, "bounded");
+		for (i = 0; i < ARRAY_SIZE(msgs); i++)
+			msgb_free(msgs[i]);
+	}
+	dump_stats();
+
+	msgb_pool_init(0);
+	dump_stats();
+	printf("  live after drain: %zu\n", talloc_total_blocks(ctx));
+}
+
+static void test_clone(void *ctx)
+{
+	struct msgb *msg, *c1, *c2, *c3;
+	uint8_t *d;
+
+	printf("Testing shared clones\n");
+
+	msg = msgb_alloc(64, "orig");
+	msgb_reserve(msg, 4);
+	d = msgb_put(msg, 8);
+	memcpy(d, "\x01\x02\x03\x04\x05\x06\x07\x08", 8);
+	msg->l2h = d + 2;
+	msg->cb[1] = 23;
+	printf("  shared: %d\n", msgb_is_shared(msg));
+
+	c1 = msgb_clone_shared(msg, "clone 1");
+	c2 = msgb_clone_shared(msg, "clone 2");
+	printf("  shared: %d %d %d\n", msgb_is_shared(msg),
+		msgb_is_shared(c1), msgb_is_shared(c2));
+	printf("  same data: %d, len %u, l2 %u, cb %lu, tailroom %d\n",
+		c1->data == msg->data, msgb_length(c1), msgb_l2len(c1),
+		c1->cb[1], msgb_tailroom(c1));
+
+	/* private cursors */
+	msgb_pull(c1, 3);
+	printf("  pulled clone: %s\n", osmo_hexdump_nospc(c1->data, c1->len));
+	printf("  orig: %s\n", osmo_hexdump_nospc(msg->data, msg->len));
+
+	/* clone of a clone refers to the original data */
+	c3 = msgb_clone_shared(c1, "clone 3");
+	printf("  clone of clone: %s\n", osmo_hexdump_nospc(c3->data, c3->len));
+	printf("  live: %zu\n", talloc_total_blocks(ctx));
+
+	/* original goes first, the data stays around for the clones */
+	msgb_free(msg);
+	printf("  orig freed, live: %zu, clone 2: %s\n",
+		talloc_total_blocks(ctx), osmo_hexdump_nospc(c2->data, c2->len));
+	/* an emptied clone gets no room to write into the shared data */
+	msgb_reset(c2);
+	printf("  reset clone: len %u, headroom %d, tailroom %d\n",
+		msgb_length(c2), msgb_headroom(c2), msgb_tailroom(c2));
+	printf("  clone 3 after reset: %s\n",
+		osmo_hexdump_nospc(c3->data, c3->len));
+	msgb_free(c2);
+	msgb_free(c1);
+	printf("  two clones freed, live: %zu, clone 3: %s\n",
+		talloc_total_blocks(ctx), osmo_hexdump_nospc(c3->data, c3->len));
+	msgb_free(c3);
+	printf("  all freed, live: %zu\n", talloc_total_blocks(ctx));
+
+	/* same with the clones going first, and through the pool */
+	msgb_pool_init(2);
+	msg = msgb_alloc(64, "orig");
+	c1 = msgb_clone_shared(msg, "clone 1");
+	msgb_free(c1);
+	printf("  clone freed, shared: %d\n", msgb_is_shared(msg));
+	msgb_free(msg);
+	printf("  all freed, live: %zu\n", talloc_total_blocks(ctx));
+	dump_stats();
+	msgb_pool_init(0);
+}
+
+int main(int argc, char **argv)
+{
+	void *ctx = talloc_named_const(NULL, 0, "msgb test");
+
+	msgb_set_talloc_ctx(ctx);
+
+	test_talloc(ctx);
+	test_pool(ctx);
+	test_clone(ctx);
+
+	talloc_free(ctx);
+	return 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * select loop test, run on all available backends
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include <osmocom/core/select.h>
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+
+#define NUM_PAIRS	200
+
+struct pair {
+	struct osmo_fd ofd;	/* our end */
+	int peer;		/* the other end */
+	unsigned int fired;
+	unsigned int what;
+};
+
+static struct pair *pairs;
+static int num_pairs;
+
+static int pair_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct pair *p = ofd->data;
+	char buf[16];
+
+	p->fired++;
+	p->what |= what;
+
+	if (what & BSC_FD_READ)
+		read(ofd->fd, buf, sizeof(buf));
+
+	return 0;
+}
+
+/* Unregisters and closes the pair given as priv_nr */
+static int kill_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct pair *other = &pairs[ofd->priv_nr];
+
+	pair_cb(ofd, what);
+
+	if (other->ofd.fd >= 0) {
+		osmo_fd_unregister(&other->ofd);
+		close(other->ofd.fd);
+		other->ofd.fd = -1;
+	}
+
+	return 0;
+}
+
+/* reads nothing, but stops further reports */
+static int stop_cb(struct osmo_fd *ofd, unsigned int what)
+{
+	struct pair *p = ofd->data;
+
+	p->fired++;
+	ofd->when &= ~BSC_FD_READ;
+
+	return 0;
+}
+
+static void open_pair(struct pair *p)
+{
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+		perror("socketpair");
+		exit(1);
+	}
+
+	p->ofd.fd = sv[0];
+	p->ofd.when = BSC_FD_READ;
+	p->ofd.cb = pair_cb;
+	p->ofd.data = p;
+	p->peer = sv[1];
+	osmo_fd_register(&p->ofd);
+}
+
+static void open_pairs(int n)
+{
+	int i;
+
+	num_pairs = n;
+	pairs = talloc_zero_array(NULL, struct pair, n);
+
+	for (i = 0; i < n; i++)
+		open_pair(&pairs[i]);
+}
+
+static void close_pairs(void)
+{
+	int i;
+
+	for (i = 0; i < num_pairs; i++) {
+		if (pairs[i].ofd.fd >= 0) {
+			osmo_fd_unregister(&pairs[i].ofd);
+			close(pairs[i].ofd.fd);
+		}
+		if (pairs[i].peer >= 0)
+			close(pairs[i].peer);
+	}
+
+	talloc_free(pairs);
+	pairs = NULL;
+}
+
+static void reset_counts(void)
+{
+	int i;
+
+	for (i = 0; i < num_pairs; i++)
+		pairs[i].fired = pairs[i].what = 0;
+}
+
+static int total_fired(void)
+{
+	int i, n = 0;
+
+	for (i = 0; i < num_pairs; i++)
+		n += pairs[i].fired;
+
+	return n;
+}
+
+static void check(const char *name, const char *what, int ok)
+{
+	printf("%-6s: %-32s %s\n", name, what, ok ? "OK" : "FAIL");
+	if (!ok)
+		exit(1);
+}
+
+static void run_tests(const char *name)
+{
+	open_pairs(NUM_PAIRS);
+
+	/* nothing ready */
+	osmo_select_main(1);
+	check(name, "idle", total_fired() == 0);
+
+	/* a few readable ones */
+	write(pairs[3].peer, "a", 1);
+	write(pairs[77].peer, "b", 1);
+	write(pairs[199].peer, "c", 1);
+	osmo_select_main(1);
+	check(name, "readable", total_fired() == 3 &&
+		pairs[3].what == BSC_FD_READ && pairs[77].fired == 1 &&
+		pairs[199].fired == 1);
+
+	/* drained, so level triggered reports stop */
+	reset_counts();
+	osmo_select_main(1);
+	check(name, "drained", total_fired() == 0);
+
+	/* 'when' changed directly, as done by the write queues */
+	pairs[10].ofd.when |= BSC_FD_WRITE;
+	osmo_select_main(1);
+	check(name, "write enabled", total_fired() == 1 &&
+		pairs[10].what == BSC_FD_WRITE);
+
+	reset_counts();
+	pairs[10].ofd.when &= ~BSC_FD_WRITE;
+	osmo_select_main(1);
+	check(name, "write disabled", total_fired() == 0);
+
+	/* 'when' changed directly by the fd's own callback */
+	reset_counts();
+	pairs[11].ofd.cb = stop_cb;
+	write(pairs[11].peer, "g", 1);
+	osmo_select_main(1);
+	osmo_select_main(1);
+	check(name, "disabled by callback", pairs[11].fired == 1);
+
+	/* two ready fds unregistering each other: only one may run */
+	reset_counts();
+	pairs[20].ofd.cb = kill_cb;
+	pairs[20].ofd.priv_nr = 21;
+	pairs[21].ofd.cb = kill_cb;
+	pairs[21].ofd.priv_nr = 20;
+	write(pairs[20].peer, "d", 1);
+	write(pairs[21].peer, "e", 1);
+	osmo_select_main(1);
+	check(name, "unregister from callback", total_fired() == 1);
+
+	/* peer closed: reported as readable */
+	reset_counts();
+	close(pairs[30].peer);
+	pairs[30].peer = -1;
+	osmo_select_main(1);
+	check(name, "hangup", pairs[30].fired == 1 &&
+		pairs[30].what == BSC_FD_READ);
+
+	/* no interest at all: not reported, even though hung up */
+	reset_counts();
+	pairs[30].ofd.when = 0;
+	osmo_select_main(1);
+	check(name, "no interest", total_fired() == 0);
+
+	/* fd number reused by a new registration */
+	reset_counts();
+	osmo_fd_unregister(&pairs[40].ofd);
+	close(pairs[40].ofd.fd);
+	close(pairs[40].peer);
+	open_pair(&pairs[40]);
+	write(pairs[40].peer, "f", 1);
+	osmo_select_main(1);
+	check(name, "fd reused", total_fired() == 1 && pairs[40].fired == 1);
+
+	close_pairs();
+}
+
+/* Benchmark: one ready fd among many registered ones */
+static void run_bench(const char *name, int n, int loops)
+{
+	struct timespec t0, t1;
+	int i;
+
+	open_pairs(n);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < loops; i++) {
+		write(pairs[(i * 7919) % n].peer, "x", 1);
+		osmo_select_main(1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	printf("%-6s: %d fds, one ready: %10.0f loops/s%s\n", name, n,
+		loops / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9),
+		total_fired() == loops ? "" : " MISSED EVENTS");
+
+	close_pairs();
+}
+
+int main(int argc, char **argv)
+{
+	static const struct {
+		const char *name;
+		enum osmo_select_backend backend;
+	} backends[] = {
+		{ "select", OSMO_SELECT_SELECT },
+		{ "epoll", OSMO_SELECT_EPOLL },
+	};
+	int bench = argc > 1 ? atoi(argv[1]) : 0;
+	int b;
+
+	for (b = 0; b < ARRAY_SIZE(backends); b++) {
+		if (osmo_select_set_backend(backends[b].backend)) {
+			printf("%s: not available\n", backends[b].name);
+			continue;
+		}
+
+		if (bench)
+			run_bench(backends[b].name, bench, 200000);
+		else
+			run_tests(backends[b].name);
+	}
+
+	return 0;
+}
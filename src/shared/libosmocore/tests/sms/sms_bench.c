@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/gsm/gsm_utils.h>
+
+/* The former septet-at-a-time functions, as a baseline and reference */
+static unsigned char old_alphabet[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x0a, 0xff, 0xff, 0x0d, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0x20, 0x21, 0x22, 0x23, 0x02, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c,
+	0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
+	0x3c, 0x3d, 0x3e, 0x3f, 0x00, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a,
+	0x4b, 0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+	0x5a, 0x3c, 0x2f, 0x3e, 0x14, 0x11, 0xff, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+	0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77,
+	0x78, 0x79, 0x7a, 0x28, 0x40, 0x29, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0x0c, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x5e, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x40, 0xff, 0x01, 0xff,
+	0x03, 0xff, 0x7b, 0x7d, 0xff, 0xff, 0xff, 0xff, 0xff, 0x5c, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x5b, 0x7e, 0x5d, 0xff, 0x7c, 0xff, 0xff, 0xff,
+	0xff, 0x5b, 0x0e, 0x1c, 0x09, 0xff, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x5d,
+	0xff, 0xff, 0xff, 0xff, 0x5c, 0xff, 0x0b, 0xff, 0xff, 0xff, 0x5e, 0xff, 0xff, 0x1e, 0x7f,
+	0xff, 0xff, 0xff, 0x7b, 0x0f, 0x1d, 0xff, 0x04, 0x05, 0xff, 0xff, 0x07, 0xff, 0xff, 0xff,
+	0xff, 0x7d, 0x08, 0xff, 0xff, 0xff, 0x7c, 0xff, 0x0c, 0x06, 0xff, 0xff, 0x7e, 0xff, 0xff
+};
+
+static int old_septet_lookup(uint8_t ch)
+{
+	int i = 0;
+	for (; i < sizeof(old_alphabet); i++) {
+		if (old_alphabet[i] == ch)
+			return i;
+	}
+	return -1;
+}
+
+static int
+old_7bit_decode_hdr(char *text, const uint8_t *user_data, uint8_t septet_l, uint8_t ud_hdr_ind)
+{
+	int i = 0;
+	int shift = 0;
+
+	uint8_t *rtext = calloc(septet_l, sizeof(uint8_t));
+	uint8_t tmp;
+
+	if (ud_hdr_ind) {
+		shift = ((user_data[0] + 1) * 8) / 7;
+		if ((((user_data[0] + 1) * 8) % 7) != 0)
+			shift++;
+		septet_l = septet_l - shift;
+	}
+
+	for (i = 0; i < septet_l; i++) {
+		rtext[i] =
+			((user_data[((i + shift) * 7 + 7) >> 3] <<
+			  (7 - (((i + shift) * 7 + 7) & 7))) |
+			 (user_data[((i + shift) * 7) >> 3] >>
+			  (((i + shift) * 7) & 7))) & 0x7f;
+	}
+
+	for (i = 0; i < septet_l; i++) {
+		if(rtext[i] == 0x1b && i + 1 < septet_l){
+			tmp = rtext[i+1];
+			*(text++) = old_alphabet[0x7f + tmp];
+			i++;
+			continue;
+		}
+
+		*(text++) = old_septet_lookup(rtext[i]);
+	}
+
+	if (ud_hdr_ind)
+		i += shift;
+	*text = '\0';
+	free(rtext);
+
+	return i;
+}
+
+static int
+old_septet_encode(uint8_t *result, const char *data)
+{
+	int i, y = 0;
+	uint8_t ch;
+	for (i = 0; i < strlen(data); i++) {
+		ch = data[i];
+		switch(ch){
+		case 0x0c:
+		case 0x5e:
+		case 0x7b:
+		case 0x7d:
+		case 0x5c:
+		case 0x5b:
+		case 0x7e:
+		case 0x5d:
+		case 0x7c:
+			result[y++] = 0x1b;
+		default:
+			result[y] = old_alphabet[ch];
+			break;
+		}
+		y++;
+	}
+
+	return y;
+}
+
+static int
+old_septets2octets(uint8_t *result, uint8_t *rdata, uint8_t septet_len, uint8_t padding)
+{
+	int i = 0, z = 0;
+	uint8_t cb, nb;
+	int shift = 0;
+	uint8_t *data = calloc(septet_len + 1, sizeof(uint8_t));
+
+	if (padding) {
+		shift = 7 - padding;
+		memcpy(data + 1, rdata, septet_len);
+		septet_len++;
+	} else
+		memcpy(data, rdata, septet_len);
+
+	for (i = 0; i < septet_len; i++) {
+		if (shift == 7) {
+			if (i + 1 < septet_len) {
+				shift = 0;
+				continue;
+			} else if (i + 1 == septet_len)
+				break;
+		}
+
+		cb = (data[i] & 0x7f) >> shift;
+		if (i + 1 < septet_len) {
+			nb = (data[i + 1] & 0x7f) << (7 - shift);
+			cb = cb | nb;
+		}
+
+		result[z++] = cb;
+		shift++;
+	}
+
+	free(data);
+
+	return z;
+}
+
+static int
+old_7bit_encode(uint8_t *result, const char *data)
+{
+	int y;
+	uint8_t *rdata = calloc(strlen(data) * 2, sizeof(uint8_t));
+	y = old_septet_encode(rdata, data);
+	old_septets2octets(result, rdata, y, 0);
+	free(rdata);
+
+	return y;
+}
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* compare against the old functions with random input */
+static int
+check(void)
+{
+	uint8_t sept[255], a[256], b[256];
+	char ta[512], tb[512];
+	int n, p, ra, rb, errors = 0;
+
+	for (n = 0; n < 255; n++) {
+		for (p = 0; p < 8; p++) {
+			int i;
+
+			for (i = 0; i < n; i++)
+				sept[i] = rand();
+			memset(a, 0x42, sizeof(a));
+			memset(b, 0x42, sizeof(b));
+			ra = old_septets2octets(a, sept, n, p);
+			rb = gsm_septets2octets(b, sept, n, p);
+			if (ra != rb || memcmp(a, b, sizeof(a)))
+				errors++;
+		}
+
+		/* a header of up to 6 octets */
+		for (p = 0; p < 2; p++) {
+			int i;
+
+			for (i = 0; i < sizeof(a); i++)
+				a[i] = rand();
+			a[0] %= 6;
+			if (p && n < (a[0] + 1) * 8 / 7 + 1)
+				continue;
+			ra = old_7bit_decode_hdr(ta, a, n, p);
+			rb = gsm_7bit_decode_hdr(tb, a, n, p);
+			if (ra != rb || strcmp(ta, tb))
+				errors++;
+		}
+	}
+
+	return errors;
+}
+
+static const char text[] =
+	"this is a testmessage. this is a testmessage. this is a testmessage. "
+	"this is a testmessage. this is a {testmessage}. cut here .....: end";
+
+static volatile int sink;
+
+static double
+run_encode(int n, int (*encode)(uint8_t *, const char *))
+{
+	uint8_t ud[160];
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<n; i++)
+		sink = encode(ud, text);
+	t = now() - t;
+
+	return n / t;
+}
+
+static double
+run_decode(int n, int (*decode)(char *, const uint8_t *, uint8_t, uint8_t))
+{
+	uint8_t ud[160];
+	char out[200];
+	double t;
+	int i, len;
+
+	len = gsm_7bit_encode(ud, text);
+
+	t = now();
+	for (i=0; i<n; i++)
+		sink = decode(out, ud, len, 0);
+	t = now() - t;
+
+	return n / t;
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	printf("mismatches against old functions: %d\n", check());
+
+	printf("encode 160 chars (old)  : %12.0f msgs/s\n",
+		run_encode(n / 10, old_7bit_encode));
+	printf("encode 160 chars (words): %12.0f msgs/s\n",
+		run_encode(n, gsm_7bit_encode));
+	printf("decode 160 chars (old)  : %12.0f msgs/s\n",
+		run_decode(n / 10, old_7bit_decode_hdr));
+	printf("decode 160 chars (words): %12.0f msgs/s\n",
+		run_decode(n, gsm_7bit_decode_hdr));
+
+	return 0;
+}
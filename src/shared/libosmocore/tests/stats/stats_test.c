@@ -0,0 +1,142 @@
+/*
+ * rate counter group lookup and counter export test
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <osmocom/core/talloc.h>
+#include <osmocom/core/utils.h>
+#include <osmocom/core/rate_ctr.h>
+#include <osmocom/core/statistics.h>
+#include <osmocom/core/stats_export.h>
+
+enum {
+	MS_CTR_RX,
+	MS_CTR_TX,
+};
+
+static const struct rate_ctr_desc ms_ctr_desc[] = {
+	[MS_CTR_RX] = { "l1ctl:rx", "Frames received" },
+	[MS_CTR_TX] = { "l1ctl:tx", "Frames sent" },
+};
+
+static const struct rate_ctr_group_desc ms_ctrg_desc = {
+	.group_name_prefix = "ms",
+	.group_description = "Mobile station",
+	.num_ctr = ARRAY_SIZE(ms_ctr_desc),
+	.ctr_desc = ms_ctr_desc,
+};
+
+static const struct rate_ctr_group_desc bts_ctrg_desc = {
+	.group_name_prefix = "bts",
+	.group_description = "BTS",
+	.num_ctr = ARRAY_SIZE(ms_ctr_desc),
+	.ctr_desc = ms_ctr_desc,
+};
+
+static void test_lookup(void)
+{
+	void *ctx = talloc_named_const(NULL, 0, "test");
+	struct rate_ctr_group *grp[100], *g;
+	int i, ok = 1;
+
+	for (i = 0; i < 100; i++)
+		grp[i] = rate_ctr_group_alloc(ctx, i & 1 ? &bts_ctrg_desc :
+					      &ms_ctrg_desc, i / 2);
+
+	for (i = 0; i < 100; i++) {
+		g = rate_ctr_get_group_by_name_idx(i & 1 ? "bts" : "ms", i / 2);
+		if (g != grp[i])
+			ok = 0;
+	}
+	printf("lookup of 100 groups: %s\n", ok ? "ok" : "FAILED");
+	printf("ms 50: %p\n", rate_ctr_get_group_by_name_idx("ms", 50));
+	printf("foo 0: %p\n", rate_ctr_get_group_by_name_idx("foo", 0));
+
+	rate_ctr_group_free(grp[0]);
+	printf("ms 0 after free: %p\n", rate_ctr_get_group_by_name_idx("ms", 0));
+
+	/* freeing the parent unregisters the groups */
+	talloc_free(ctx);
+	printf("bts 7 after parent free: %p\n",
+		rate_ctr_get_group_by_name_idx("bts", 7));
+}
+
+static void test_export(void)
+{
+	struct rate_ctr_group *g0, *g1;
+	struct osmo_stats_export *exp;
+	struct osmo_counter *ctr;
+	struct sockaddr_un sun;
+	char path[] = "/tmp/stats_test.XXXXXX";
+	char buf[2048];
+	int fd, len, rc;
+
+	g0 = rate_ctr_group_alloc(NULL, &ms_ctrg_desc, 0);
+	g1 = rate_ctr_group_alloc(NULL, &ms_ctrg_desc, 1);
+	ctr = osmo_counter_alloc("global|drops");
+	rate_ctr_add(&g0->ctr[MS_CTR_RX], 10);
+	rate_ctr_inc(&g0->ctr[MS_CTR_TX]);
+	rate_ctr_add(&g1->ctr[MS_CTR_RX], 3);
+	osmo_counter_inc(ctr);
+
+	len = osmo_stats_snapshot(buf, sizeof(buf), "l23");
+	printf("snapshot (%d):\n%s", len, buf);
+	len = osmo_stats_snapshot(buf, 20, NULL);
+	printf("truncated (%d): %s\n", len, buf);
+
+	close(mkstemp(path));
+	unlink(path);
+	fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	strcpy(sun.sun_path, path);
+
+	exp = osmo_stats_export_create(NULL, "unix:/nonexistent/sink", "l23", 0);
+	rc = osmo_stats_export_send(exp);
+	printf("no sink: send %d, errors %lu\n", rc,
+		osmo_stats_export_errors(exp));
+	osmo_stats_export_destroy(exp);
+
+	bind(fd, (struct sockaddr *) &sun, sizeof(sun));
+	snprintf(buf, sizeof(buf), "unix:%s", path);
+	exp = osmo_stats_export_create(NULL, buf, "l23", 0);
+	printf("send %d\n", osmo_stats_export_send(exp));
+	len = recv(fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+	buf[len > 0 ? len : 0] = '\0';
+	printf("received (%d):\n%s", len, buf);
+	osmo_stats_export_destroy(exp);
+
+	close(fd);
+	unlink(path);
+	osmo_counter_free(ctr);
+	rate_ctr_group_free(g0);
+	rate_ctr_group_free(g1);
+}
+
+int main(int argc, char **argv)
+{
+	test_lookup();
+	test_export();
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <osmocom/core/talloc.h>
+
+/* count the calls that reach the system allocator */
+extern void *__libc_malloc(size_t size);
+static unsigned long mallocs;
+
+void *malloc(size_t size)
+{
+	mallocs++;
+	return __libc_malloc(size);
+}
+
+#define TRANS_SIZE	936	/* struct gsm_trans */
+#define SI_SIZE		1452	/* struct gsm48_sysinfo */
+#define SCAN_CELLS	32
+/* room for the talloc header of each member */
+#define HDR_SPACE	128
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* a call with a parallel SMS: two transactions at a time */
+static double
+run_trans(void *ctx, int rounds)
+{
+	void *t1, *t2;
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<rounds; i++) {
+		t1 = talloc_zero_size(ctx, TRANS_SIZE);
+		t2 = talloc_zero_size(ctx, TRANS_SIZE);
+		talloc_free(t1);
+		talloc_free(t2);
+	}
+	t = now() - t;
+
+	return rounds / t;
+}
+
+/* sysinfo of all cells found in a scan, flushed before the next scan */
+static double
+run_scan(void *ctx, int rounds)
+{
+	void *si[SCAN_CELLS];
+	double t;
+	int i, j;
+
+	t = now();
+	for (i=0; i<rounds; i++) {
+		for (j=0; j<SCAN_CELLS; j++)
+			si[j] = talloc_zero_size(ctx, SI_SIZE);
+		for (j=0; j<SCAN_CELLS; j++)
+			talloc_free(si[j]);
+	}
+	t = now() - t;
+
+	return rounds / t;
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	void *ctx = talloc_named_const(NULL, 0, "bench");
+	void *pool;
+	unsigned long m;
+	double r;
+
+	m = mallocs;
+	r = run_trans(ctx, n);
+	printf("trans (talloc): %10.0f rounds/s, %lu mallocs\n", r,
+		mallocs - m);
+
+	pool = talloc_pool(ctx, 4 * (TRANS_SIZE + HDR_SPACE));
+	m = mallocs;
+	r = run_trans(pool, n);
+	printf("trans (pool)  : %10.0f rounds/s, %lu mallocs\n", r,
+		mallocs - m);
+	talloc_free(pool);
+
+	m = mallocs;
+	r = run_scan(ctx, n / 100);
+	printf("scan  (talloc): %10.0f rounds/s, %lu mallocs\n", r,
+		mallocs - m);
+
+	pool = talloc_pool(ctx, SCAN_CELLS * (SI_SIZE + HDR_SPACE));
+	m = mallocs;
+	r = run_scan(pool, n / 100);
+	printf("scan  (pool)  : %10.0f rounds/s, %lu mallocs\n", r,
+		mallocs - m);
+	talloc_free(pool);
+
+	talloc_free(ctx);
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * talloc pool test
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <osmocom/core/talloc.h>
+
+#define POOL_SIZE	4096
+
+static char *pool;
+
+static int in_pool(const void *ptr)
+{
+	return (const char *) ptr >= pool &&
+	       (const char *) ptr < pool + POOL_SIZE;
+}
+
+static void test_pool(void)
+{
+	void *a, *b, *c, *d, *big;
+
+	pool = talloc_pool(NULL, POOL_SIZE);
+
+	a = talloc_size(pool, 100);
+	b = talloc_size(pool, 100);
+	c = talloc_size(a, 100);
+	printf("members in pool: %d %d\n", in_pool(a), in_pool(b));
+	printf("children of members in pool: %d\n", in_pool(c));
+
+	/* too big, falls back to malloc */
+	big = talloc_size(pool, POOL_SIZE);
+	printf("big member in pool: %d\n", in_pool(big));
+	talloc_free(big);
+
+	/* the most recent allocation is given back */
+	talloc_free(c);
+	d = talloc_size(pool, 100);
+	printf("reused last: %d\n", d == c);
+
+	/* a hole is not reused while other members are alive */
+	talloc_free(a);
+	c = talloc_size(pool, 100);
+	printf("reused hole: %d\n", c == a);
+	printf("blocks: %lu\n", (unsigned long) talloc_total_blocks(pool));
+
+	/* once drained, the pool starts over */
+	talloc_free(b);
+	talloc_free(c);
+	talloc_free(d);
+	b = talloc_size(pool, 100);
+	printf("reused after drain: %d\n", b == a);
+
+	/* members may outlive the pool */
+	talloc_steal(NULL, b);
+	talloc_free(pool);
+	memset(b, 0x55, 100);
+	c = talloc_size(b, 10);
+	printf("stolen member still usable: %d\n", c != NULL);
+	talloc_free(b);
+}
+
+static void test_drain_loop(void)
+{
+	void *objs[8];
+	int i, j, ok = 1;
+
+	pool = talloc_pool(NULL, POOL_SIZE);
+
+	/* a transaction-like pattern, never needs malloc */
+	for (i = 0; i < 1000; i++) {
+		for (j = 0; j < 8; j++) {
+			objs[j] = talloc_zero_size(pool, 200);
+			if (!in_pool(objs[j]))
+				ok = 0;
+		}
+		for (j = 0; j < 8; j++)
+			talloc_free(objs[(j * 3) & 7]);
+	}
+	printf("alloc/free loop stays in pool: %s\n", ok ? "ok" : "FAILED");
+
+	talloc_free(pool);
+}
+
+int main(int argc, char **argv)
+{
+	test_pool();
+	test_drain_loop();
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * timers across switches and steps of the clock
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <osmocom/core/timer.h>
+#include <osmocom/core/select.h>
+#include <osmocom/core/utils.h>
+
+static int fired;
+
+static void timer_cb(void *data)
+{
+	fired++;
+}
+
+static struct osmo_timer_list timer = {
+	.cb = timer_cb,
+};
+
+/* run the main loop until the 10ms timer fired, at most 500ms real time
+ * or 1000 iterations */
+static int run_10ms(void)
+{
+	struct timeval start, now;
+	int i;
+
+	fired = 0;
+	osmo_timer_schedule(&timer, 0, 10000);
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < 1000 && !fired; i++) {
+		osmo_select_main(0);
+		gettimeofday(&now, NULL);
+		if ((now.tv_sec - start.tv_sec) * 1000000 +
+		    now.tv_usec - start.tv_usec > 500000)
+			break;
+	}
+
+	osmo_timer_del(&timer);
+
+	return fired;
+}
+
+static void test_clock(const char *name)
+{
+	struct timeval tv;
+
+	printf("%s:\n", name);
+
+	osmo_clock_set_mode(OSMO_CLOCK_REAL);
+	printf("  real: %d\n", run_10ms());
+
+	osmo_clock_set_mode(OSMO_CLOCK_VIRTUAL);
+	printf("  real -> virtual: %d\n", run_10ms());
+
+	osmo_gettimeofday(&tv, NULL);
+	tv.tv_sec -= 3600;
+	osmo_clock_set(&tv);
+	printf("  virtual set back: %d\n", run_10ms());
+
+	tv.tv_sec += 7200;
+	osmo_clock_set(&tv);
+	printf("  virtual set forward: %d\n", run_10ms());
+
+	/* a pending timer keeps its time when the clock is set back */
+	fired = 0;
+	osmo_timer_schedule(&timer, 0, 10000);
+	osmo_gettimeofday(&tv, NULL);
+	tv.tv_sec -= 1;
+	osmo_clock_set(&tv);
+	tv.tv_sec = 0;
+	tv.tv_usec = 999000;
+	osmo_clock_advance(&tv);
+	osmo_select_main(1);
+	printf("  pending, set back 1s, advanced 999ms: %d", fired);
+	tv.tv_usec = 12000;
+	osmo_clock_advance(&tv);
+	osmo_select_main(1);
+	printf(", 12ms more: %d\n", fired);
+
+	osmo_clock_set_mode(OSMO_CLOCK_REAL);
+	printf("  virtual -> real: %d\n", run_10ms());
+}
+
+int main(int argc, char **argv)
+{
+	/* a hang is a failure */
+	alarm(10);
+
+	test_clock("rb-tree");
+
+	osmo_timers_set_backend(OSMO_TIMER_WHEEL);
+	test_clock("wheel");
+
+	return 0;
+}
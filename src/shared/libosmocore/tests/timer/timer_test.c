@@ -26,6 +26,8 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <getopt.h>
+#include <time.h>
+#include <unistd.h>
 
 #include <osmocom/core/talloc.h>
 #include <osmocom/core/timer.h>
@@ -89,11 +91,12 @@ static void main_timer_fired(void *data)
 			fprintf(stderr, "timer_test: OOM!\n");
 			return;
 		}
-		gettimeofday(&v->start, NULL);
+		osmo_gettimeofday(&v->start, NULL);
 		v->timer.cb = secondary_timer_fired;
 		v->timer.data = v;
 		unsigned int seconds = (random() % 10) + 1;
 		v->stop.tv_sec = v->start.tv_sec + seconds;
+		v->stop.tv_usec = v->start.tv_usec;
 		osmo_timer_schedule(&v->timer, seconds, 0);
 		llist_add(&v->head, &timer_test_list);
 	}
@@ -109,7 +112,11 @@ static void secondary_timer_fired(void *data)
 	struct test_timer *v = data, *this, *tmp;
 	struct timeval current, res, precision = { 1, 0 };
 
-	gettimeofday(&current, NULL);
+	/* with the virtual clock, timers fire on time (to the wheel's 1ms) */
+	if (osmo_clock_get_mode() == OSMO_CLOCK_VIRTUAL)
+		precision.tv_sec = 0, precision.tv_usec = 1000;
+
+	osmo_gettimeofday(&current, NULL);
 
 	timersub(&current, &v->stop, &res);
 	if (timercmp(&res, &precision, >)) {
@@ -138,6 +145,111 @@ static void secondary_timer_fired(void *data)
 	}
 }
 
+/* Benchmark: many timers being (re-)armed, as with lots of MS instances
+ * restarting their T200/T3210/... all the time */
+
+struct bench_timer {
+	struct osmo_timer_list timer;
+	struct timespec due;
+};
+
+static unsigned int bench_fired;
+static long bench_late_max, bench_late_sum;
+
+static double ts_diff(const struct timespec *a, const struct timespec *b)
+{
+	return (a->tv_sec - b->tv_sec) + (a->tv_nsec - b->tv_nsec) / 1e9;
+}
+
+static void bench_timer_fired(void *data)
+{
+	struct bench_timer *bt = data;
+	struct timespec now;
+	long late;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	late = ts_diff(&now, &bt->due) * 1e6;
+	if (late > bench_late_max)
+		bench_late_max = late;
+	bench_late_sum += late;
+	bench_fired++;
+}
+
+static void run_bench(const char *name, enum osmo_timer_backend backend,
+		      int n)
+{
+	struct bench_timer *bt;
+	struct timespec t0, t1;
+	clock_t c0;
+	int i, r, iterations = 0;
+
+	if (osmo_timers_set_backend(backend)) {
+		fprintf(stderr, "cannot select backend %s\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	bt = talloc_zero_array(NULL, struct bench_timer, n);
+	for (i = 0; i < n; i++) {
+		bt[i].timer.cb = bench_timer_fired;
+		bt[i].timer.data = &bt[i];
+	}
+
+	/* arm all of them, 1..30s away */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < n; i++)
+		osmo_timer_schedule(&bt[i].timer, random() % 30 + 1,
+				    random() % 1000000);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fprintf(stdout, "%-7s: schedule %d timers:   %10.0f ops/s\n",
+		name, n, n / ts_diff(&t1, &t0));
+
+	/* re-arm them all, ten times over */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (r = 0; r < 10; r++)
+		for (i = 0; i < n; i++)
+			osmo_timer_schedule(&bt[i].timer, random() % 30 + 1,
+					    random() % 1000000);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fprintf(stdout, "%-7s: re-arm %d timers:     %10.0f ops/s\n",
+		name, n, 10 * n / ts_diff(&t1, &t0));
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < n; i++)
+		osmo_timer_del(&bt[i].timer);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	fprintf(stdout, "%-7s: delete %d timers:     %10.0f ops/s\n",
+		name, n, n / ts_diff(&t1, &t0));
+
+	/* let them all expire within 500ms, in the select loop */
+	bench_fired = 0;
+	bench_late_max = bench_late_sum = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < n; i++) {
+		int us = random() % 500000;
+
+		bt[i].due = t0;
+		bt[i].due.tv_nsec += us * 1000;
+		if (bt[i].due.tv_nsec >= 1000000000) {
+			bt[i].due.tv_sec++;
+			bt[i].due.tv_nsec -= 1000000000;
+		}
+		osmo_timer_schedule(&bt[i].timer, 0, us);
+	}
+
+	c0 = clock();
+	while (bench_fired < n) {
+		osmo_select_main(0);
+		iterations++;
+	}
+	fprintf(stdout, "%-7s: expire %d timers:     %10.3f s CPU, "
+		"%d loops, late avg %ld us max %ld us\n",
+		name, n, (double) (clock() - c0) / CLOCKS_PER_SEC, iterations,
+		bench_late_sum / n, bench_late_max);
+
+	talloc_free(bt);
+}
+
 static void alarm_handler(int signum)
 {
 	fprintf(stderr, "ERROR: We took too long to run the timer test, "
@@ -147,15 +259,24 @@ static void alarm_handler(int signum)
 
 int main(int argc, char *argv[])
 {
-	int c;
+	int c, bench = 0;
 
 	if (signal(SIGALRM, alarm_handler) == SIG_ERR) {
 		perror("cannot register signal handler");
 		exit(EXIT_FAILURE);
 	}
 
-	while ((c = getopt_long(argc, argv, "s:", NULL, NULL)) != -1) {
+	while ((c = getopt_long(argc, argv, "s:wvb:", NULL, NULL)) != -1) {
 	switch(c) {
+		case 'w':
+			osmo_timers_set_backend(OSMO_TIMER_WHEEL);
+			break;
+		case 'v':
+			osmo_clock_set_mode(OSMO_CLOCK_VIRTUAL);
+			break;
+		case 'b':
+			bench = atoi(optarg);
+			break;
 		case 's':
 			timer_nsteps = atoi(optarg);
 			if (timer_nsteps <= 0) {
@@ -169,6 +290,12 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (bench > 0) {
+		run_bench("rbtree", OSMO_TIMER_RBTREE, bench);
+		run_bench("wheel", OSMO_TIMER_WHEEL, bench);
+		exit(EXIT_SUCCESS);
+	}
+
 	fprintf(stdout, "Running timer test for %u steps, accepting "
 		"imprecision of %u.%.6u seconds\n",
 		timer_nsteps, TIMER_PRES_SECS, TIMER_PRES_USECS);
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/tlv.h>
+
+#include "tlv_msgs.h"
+
+static double
+now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* keep the compiler from dropping the lookups */
+static volatile uintptr_t sink;
+
+/* parse and look up the IEs like the receive functions do */
+static double
+run(const struct tlv_msg *m, int n)
+{
+	struct tlv_parsed tp;
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<n; i++) {
+		tlv_parse(&tp, m->def, m->data, m->len, m->lv_tag, 0);
+		sink += (uintptr_t) TLVP_VAL(&tp, GSM48_IE_CAUSE);
+		sink += (uintptr_t) TLVP_VAL(&tp, GSM48_IE_PROGR_IND);
+		sink += (uintptr_t) TLVP_VAL(&tp, GSM48_IE_MOBILE_ID);
+	}
+	t = now() - t;
+
+	return n / t;
+}
+
+static double
+run_sparse(const struct tlv_msg *m, int n)
+{
+	struct tlv_sparse ts;
+	double t;
+	int i;
+
+	t = now();
+	for (i=0; i<n; i++) {
+		tlv_parse_sparse(&ts, m->def, m->data, m->len, m->lv_tag, 0);
+		sink += (uintptr_t) TLVS_VAL(&ts, GSM48_IE_CAUSE);
+		sink += (uintptr_t) TLVS_VAL(&ts, GSM48_IE_PROGR_IND);
+		sink += (uintptr_t) TLVS_VAL(&ts, GSM48_IE_MOBILE_ID);
+	}
+	t = now() - t;
+
+	return n / t;
+}
+
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : 10000000;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tlv_msgs); i++) {
+		const struct tlv_msg *m = &tlv_msgs[i];
+
+		printf("%-28s: %10.0f msgs/s full, %10.0f msgs/s sparse\n",
+			m->name, run(m, n), run_sparse(m, n));
+	}
+
+	return 0;
+}
@@ -0,0 +1,35 @@
+/* Representative GSM 04.08 messages, only the part after the header
+ * and the fixed mandatory IEs, i.e. what is handed to the TLV parser */
+
+#include <osmocom/gsm/gsm48.h>
+#include <osmocom/gsm/protocol/gsm_04_08.h>
+
+struct tlv_msg {
+	const char *name;
+	const struct tlv_definition *def;
+	uint8_t lv_tag;
+	uint8_t len;
+	uint8_t data[64];
+};
+
+static const struct tlv_msg tlv_msgs[] = {
+	{ "CC SETUP", &gsm48_att_tlvdef, 0, 22, {
+		GSM48_IE_BEARER_CAP, 0x01, 0xa0,
+		GSM48_IE_FACILITY, 0x02, 0xa1, 0x00,
+		GSM48_IE_PROGR_IND, 0x02, 0xea, 0x88,
+		GSM48_IE_SIGNAL, 0x00,
+		GSM48_IE_CALLING_BCD, 0x07, 0x81, 0x21, 0x43, 0x65, 0x87,
+			0x09, 0xf1,
+		} },
+	{ "CC DISCONNECT", &gsm48_att_tlvdef, GSM48_IE_CAUSE, 11, {
+		0x02, 0xe0, 0x90,
+		GSM48_IE_PROGR_IND, 0x02, 0xea, 0x88,
+		GSM48_IE_USER_USER, 0x02, 0x00, 0x00,
+		} },
+	{ "MM LOCATION UPDATING ACCEPT", &gsm48_mm_att_tlvdef, 0, 11, {
+		GSM48_IE_MOBILE_ID, 0x08, 0x49, 0x06, 0x10, 0x32, 0x54,
+			0x76, 0x98, 0xf0,
+		GSM48_IE_FOLLOW_ON_PROC,
+		} },
+	{ "RR CHANNEL RELEASE", &gsm48_rr_att_tlvdef, 0, 0, { } },
+};
@@ -0,0 +1,104 @@
+/*
+ * TLV parser test
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <osmocom/core/utils.h>
+#include <osmocom/gsm/tlv.h>
+
+#include "tlv_msgs.h"
+
+/* both parsers must find the same IEs */
+static void compare(const char *name, const struct tlv_definition *def,
+		    const uint8_t *buf, int len, uint8_t lv_tag)
+{
+	struct tlv_parsed tp;
+	struct tlv_sparse ts;
+	int rc, rcs, i, ok = 1;
+
+	/* leftovers of an earlier parse must not show */
+	memset(&ts, 0xff, sizeof(ts));
+
+	rc = tlv_parse(&tp, def, buf, len, lv_tag, 0);
+	rcs = tlv_parse_sparse(&ts, def, buf, len, lv_tag, 0);
+
+	for (i = 0; i < 256; i++) {
+		if (TLVP_PRESENT(&tp, i) != TLVS_PRESENT(&ts, i))
+			ok = 0;
+		if (TLVP_PRESENT(&tp, i)
+		 && (TLVP_LEN(&tp, i) != TLVS_LEN(&ts, i)
+		  || TLVP_VAL(&tp, i) != TLVS_VAL(&ts, i)))
+			ok = 0;
+	}
+	printf("%s: %d/%d IEs, %s\n", name, rc, rcs, ok ? "ok" : "FAILED");
+}
+
+static void test_msgs(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(tlv_msgs); i++)
+		compare(tlv_msgs[i].name, tlv_msgs[i].def, tlv_msgs[i].data,
+			tlv_msgs[i].len, tlv_msgs[i].lv_tag);
+}
+
+static void test_special(void)
+{
+	struct tlv_sparse ts;
+	uint8_t buf[3 * (TLV_SPARSE_MAX_IE + 1)];
+	static const uint8_t dup[] = {
+		GSM48_IE_CAUSE, 0x01, 0x10,
+		GSM48_IE_CAUSE, 0x02, 0x20, 0x21,
+	};
+	static const uint8_t trunc[] = {
+		GSM48_IE_CAUSE, 0x01, 0x10,
+		GSM48_IE_PROGR_IND, 0x02, 0xea,
+	};
+	int i, rc;
+
+	compare("duplicate IE", &gsm48_att_tlvdef, dup, sizeof(dup), 0);
+	tlv_parse_sparse(&ts, &gsm48_att_tlvdef, dup, sizeof(dup), 0, 0);
+	printf("last one wins: len %d\n", TLVS_LEN(&ts, GSM48_IE_CAUSE));
+
+	compare("truncated IE", &gsm48_att_tlvdef, trunc, sizeof(trunc), 0);
+	rc = tlv_parse_sparse(&ts, &gsm48_att_tlvdef, trunc, sizeof(trunc),
+			      0, 0);
+	printf("truncated: %d, cause %s\n", rc,
+		TLVS_PRESENT(&ts, GSM48_IE_CAUSE) ? "present" : "missing");
+
+	for (i = 0; i < TLV_SPARSE_MAX_IE + 1; i++) {
+		buf[i * 3] = GSM48_IE_FACILITY;
+		buf[i * 3 + 1] = 1;
+		buf[i * 3 + 2] = i;
+	}
+	rc = tlv_parse_sparse(&ts, &gsm48_att_tlvdef, buf, sizeof(buf) - 3,
+			      0, 0);
+	printf("%d IEs: %d\n", TLV_SPARSE_MAX_IE, rc);
+	rc = tlv_parse_sparse(&ts, &gsm48_att_tlvdef, buf, sizeof(buf), 0, 0);
+	printf("%d IEs: %d\n", TLV_SPARSE_MAX_IE + 1, rc);
+}
+
+int main(int argc, char **argv)
+{
+	test_msgs();
+	test_special();
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * write queue test, one by one and batched
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+#include <osmocom/core/write_queue.h>
+#include <osmocom/core/msgb.h>
+
+static unsigned int written;
+
+static int write_cb(struct osmo_fd *fd, struct msgb *msg)
+{
+	written++;
+	return write(fd->fd, msg->data, msg->len);
+}
+
+/* message i has i + 1 octets of value i */
+static void enqueue(struct osmo_wqueue *wq, int num, int size)
+{
+	struct msgb *msg;
+	int i;
+
+	for (i = 0; i < num; i++) {
+		msg = msgb_alloc(size ? size : i + 1, "wqueue test");
+		memset(msgb_put(msg, size ? size : i + 1), i, size ? size : i + 1);
+		osmo_wqueue_enqueue(wq, msg);
+	}
+}
+
+static void init(struct osmo_wqueue *wq, int type, int batch, int *peer)
+{
+	int sv[2];
+
+	socketpair(AF_UNIX, type, 0, sv);
+	fcntl(sv[0], F_SETFL, O_NONBLOCK);
+	fcntl(sv[1], F_SETFL, O_NONBLOCK);
+	osmo_wqueue_init_batch(wq, 100, batch);
+	wq->bfd.fd = sv[0];
+	wq->write_cb = write_cb;
+	*peer = sv[1];
+}
+
+static void fini(struct osmo_wqueue *wq, int peer)
+{
+	osmo_wqueue_clear(wq);
+	close(wq->bfd.fd);
+	close(peer);
+}
+
+static void test_single(void)
+{
+	struct osmo_wqueue wq;
+	uint8_t buf[256];
+	int peer, len;
+
+	init(&wq, SOCK_STREAM, 1, &peer);
+	enqueue(&wq, 3, 0);
+	osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+	len = read(peer, buf, sizeof(buf));
+	printf("single: write_cb %u, read %d, left %u, want write %d\n",
+		written, len, wq.current_length,
+		!!(wq.bfd.when & BSC_FD_WRITE));
+	fini(&wq, peer);
+}
+
+static void test_stream(void)
+{
+	struct osmo_wqueue wq;
+	uint8_t buf[256];
+	int peer, len, i, ok = 1;
+
+	init(&wq, SOCK_STREAM, 4, &peer);
+	enqueue(&wq, 10, 0);
+	osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+	len = read(peer, buf, sizeof(buf));
+	printf("stream: read %d, left %u, want write %d\n", len,
+		wq.current_length, !!(wq.bfd.when & BSC_FD_WRITE));
+
+	osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+	osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+	len += read(peer, buf + len, sizeof(buf) - len);
+	printf("stream: read %d, left %u, want write %d\n", len,
+		wq.current_length, !!(wq.bfd.when & BSC_FD_WRITE));
+
+	for (i = 0; i < len; i++) {
+		/* 0, 1, 1, 2, 2, 2, ... */
+		static int n = 0, m = 0;
+		if (buf[i] != n)
+			ok = 0;
+		if (++m > n) {
+			n++;
+			m = 0;
+		}
+	}
+	printf("stream: content %s, write_cb %u\n", ok ? "ok" : "FAILED",
+		written);
+	fini(&wq, peer);
+}
+
+/* the socket buffer fills up in the middle of a message */
+static void test_partial(void)
+{
+	struct osmo_wqueue wq;
+	uint8_t buf[4096];
+	int peer, len, i, total = 0, rounds = 0, ok = 1;
+	int sndbuf = 4096;
+
+	init(&wq, SOCK_STREAM, 16, &peer);
+	setsockopt(wq.bfd.fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+	enqueue(&wq, 64, 1000);
+
+	while (wq.current_length && rounds < 10000) {
+		osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+		while ((len = read(peer, buf, sizeof(buf))) > 0) {
+			for (i = 0; i < len; i++) {
+				if (buf[i] != (total + i) / 1000)
+					ok = 0;
+			}
+			total += len;
+		}
+		rounds++;
+	}
+	printf("partial: read %d, left %u, content %s, took more than one "
+		"write: %d\n", total, wq.current_length, ok ? "ok" : "FAILED",
+		rounds > 1);
+	fini(&wq, peer);
+}
+
+static void test_dgram(void)
+{
+	struct osmo_wqueue wq;
+	uint8_t buf[256];
+	int peer, len, n = 0, ok = 1;
+
+	init(&wq, SOCK_DGRAM, 16, &peer);
+	enqueue(&wq, 10, 0);
+	osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+	while ((len = recv(peer, buf, sizeof(buf), 0)) > 0) {
+		if (len != n + 1 || buf[0] != n || buf[len - 1] != n)
+			ok = 0;
+		n++;
+	}
+	printf("dgram: %d datagrams, content %s, left %u, want write %d\n",
+		n, ok ? "ok" : "FAILED", wq.current_length,
+		!!(wq.bfd.when & BSC_FD_WRITE));
+	fini(&wq, peer);
+}
+
+static void test_error(void)
+{
+	struct osmo_wqueue wq;
+	int peer;
+
+	init(&wq, SOCK_STREAM, 8, &peer);
+	enqueue(&wq, 3, 0);
+	close(peer);
+	osmo_wqueue_bfd_cb(&wq.bfd, BSC_FD_WRITE);
+	printf("error: left %u, want write %d\n", wq.current_length,
+		!!(wq.bfd.when & BSC_FD_WRITE));
+	osmo_wqueue_clear(&wq);
+	close(wq.bfd.fd);
+}
+
+int main(int argc, char **argv)
+{
+	/* writes to the closed peer */
+	signal(SIGPIPE, SIG_IGN);
+
+	test_single();
+	test_stream();
+	test_partial();
+	test_dgram();
+	test_error();
+
+	return 0;
+}
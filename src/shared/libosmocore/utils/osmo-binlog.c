@@ -0,0 +1,156 @@
+/* Utility program to turn binary logs into text */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <osmocom/core/logging_binary.h>
+
+enum time_mode {
+	TIME_NONE,
+	TIME_DATE,
+	TIME_EPOCH,
+};
+
+static uint64_t parse_time(const char *str)
+{
+	return (uint64_t) (strtod(str, NULL) * 1000000.0);
+}
+
+static void print_entry(const struct log_bin_entry *e, enum time_mode tm)
+{
+	if (!e->cont) {
+		time_t sec = e->time_us / 1000000;
+		char *timestr;
+
+		switch (tm) {
+		case TIME_DATE:
+			timestr = ctime(&sec);
+			timestr[strlen(timestr)-1] = '\0';
+			printf("%s ", timestr);
+			break;
+		case TIME_EPOCH:
+			printf("%lu.%06u ", (unsigned long) sec,
+				(unsigned int) (e->time_us % 1000000));
+			break;
+		case TIME_NONE:
+			break;
+		}
+		printf("<%4.4x> %s:%d ", e->subsys, e->file, e->line);
+	}
+	fputs(e->text, stdout);
+}
+
+static void help(const char *progname)
+{
+	printf("Usage: %s [-h] [-t] [-u] [-s start] [-e end] [file]\n",
+		progname);
+	printf("  -h --help		This text\n");
+	printf("  -t --timestamp	Prefix messages with the date\n");
+	printf("  -u --epoch		Prefix messages with seconds.microseconds\n");
+	printf("  -s --start SEC	Skip messages before SEC since the epoch\n");
+	printf("  -e --end SEC		Stop after SEC since the epoch\n");
+	printf("Reads standard input if no file is given\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct log_bin_reader *r;
+	struct log_bin_entry e;
+	enum time_mode tm = TIME_NONE;
+	uint64_t start = 0, end = 0;
+	FILE *in = stdin;
+	int rc;
+
+	while (1) {
+		int option_index = 0, c;
+		static const struct option long_options[] = {
+			{ "help", 0, 0, 'h' },
+			{ "timestamp", 0, 0, 't' },
+			{ "epoch", 0, 0, 'u' },
+			{ "start", 1, 0, 's' },
+			{ "end", 1, 0, 'e' },
+			{ 0, 0, 0, 0 }
+		};
+
+		c = getopt_long(argc, argv, "htus:e:",
+				long_options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+			help(argv[0]);
+			exit(0);
+		case 't':
+			tm = TIME_DATE;
+			break;
+		case 'u':
+			tm = TIME_EPOCH;
+			break;
+		case 's':
+			start = parse_time(optarg);
+			break;
+		case 'e':
+			end = parse_time(optarg);
+			break;
+		default:
+			help(argv[0]);
+			exit(2);
+		}
+	}
+
+	if (optind < argc) {
+		in = fopen(argv[optind], "r");
+		if (!in) {
+			fprintf(stderr, "Can't open %s: %s\n", argv[optind],
+				strerror(errno));
+			exit(1);
+		}
+	}
+
+	r = log_bin_reader_open(NULL, in);
+	if (!r)
+		exit(1);
+
+	if (start && log_bin_reader_seek(r, start) < 0) {
+		fprintf(stderr, "Not a binary log\n");
+		exit(1);
+	}
+
+	while ((rc = log_bin_reader_next(r, &e)) > 0) {
+		if (end && e.time_us > end)
+			break;
+		print_entry(&e, tm);
+	}
+
+	if (rc < 0) {
+		fprintf(stderr, "Broken binary log: %s\n", strerror(-rc));
+		exit(1);
+	}
+
+	log_bin_reader_close(r);
+
+	return 0;
+}
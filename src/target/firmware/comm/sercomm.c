@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 
 #include <osmocom/core/msgb.h>
@@ -206,6 +207,75 @@ int sercomm_drv_pull(uint8_t *ch)
 	return 1;
 }
 
+/* does this octet need to be escaped? */
+static inline int sercomm_needs_escape(uint8_t ch)
+{
+	return ch == HDLC_FLAG || ch == HDLC_ESCAPE || ch == 0x00;
+}
+
+/* fetch up to len octets of to-be-transmitted serial data, framing and
+ * escaping as many queued messages as fit.  This continues exactly where
+ * sercomm_drv_pull() stopped and vice versa. */
+int sercomm_drv_pull_bulk(uint8_t *buf, unsigned int len)
+{
+	unsigned long flags;
+	unsigned int n = 0, i;
+	uint8_t *data, *run, *end;
+
+	sercomm_lock(&flags);
+
+	while (n < len) {
+		if (!sercomm.tx.msg) {
+			/* dequeue a new message from the queues */
+			for (i = 0; i < ARRAY_SIZE(sercomm.tx.dlci_queues); i++) {
+				sercomm.tx.msg = msgb_dequeue(&sercomm.tx.dlci_queues[i]);
+				if (sercomm.tx.msg)
+					break;
+			}
+			if (!sercomm.tx.msg)
+				break;
+			/* start of a new message, send start flag octet */
+			buf[n++] = HDLC_FLAG;
+			sercomm.tx.next_char = sercomm.tx.msg->data;
+			continue;
+		}
+
+		data = sercomm.tx.next_char;
+
+		if (sercomm.tx.state == RX_ST_ESCAPE) {
+			/* the escape octet went out with the last pull,
+			 * the octet has already been inverted */
+			buf[n++] = *sercomm.tx.next_char++;
+			sercomm.tx.state = RX_ST_DATA;
+		} else if (data >= sercomm.tx.msg->tail) {
+			/* send end-of-message octet */
+			buf[n++] = HDLC_FLAG;
+			msgb_free(sercomm.tx.msg);
+			sercomm.tx.msg = NULL;
+			sercomm.tx.next_char = NULL;
+		} else if (sercomm_needs_escape(*data)) {
+			buf[n++] = HDLC_ESCAPE;
+			/* invert bit 5 of the next octet to be sent */
+			*data ^= (1 << 5);
+			sercomm.tx.state = RX_ST_ESCAPE;
+		} else {
+			/* copy the run of octets that need no escaping */
+			end = sercomm.tx.msg->tail;
+			if (end > data + (len - n))
+				end = data + (len - n);
+			for (run = data; run < end && !sercomm_needs_escape(*run);
+			     run++)
+				;
+			memcpy(buf + n, data, run - data);
+			n += run - data;
+			sercomm.tx.next_char = run;
+		}
+	}
+
+	sercomm_unlock(&flags);
+	return n;
+}
+
 /* register a handler for a given DLCI */
 int sercomm_register_rx_cb(uint8_t dlci, dlci_cb_t cb)
 {
@@ -295,3 +365,67 @@ int sercomm_drv_rx_char(uint8_t ch)
 
 	return 1;
 }
+
+/* first octet in [p, end) that is a flag or an escape octet, or end */
+static inline const uint8_t *sercomm_find_ctrl(const uint8_t *p,
+					       const uint8_t *end)
+{
+#ifdef HOST_BUILD
+	const uint8_t *c;
+
+	c = memchr(p, HDLC_FLAG, end - p);
+	if (c)
+		end = c;
+	c = memchr(p, HDLC_ESCAPE, end - p);
+	return c ? c : end;
+#else
+	while (p < end && *p != HDLC_FLAG && *p != HDLC_ESCAPE)
+		p++;
+	return p;
+#endif
+}
+
+/* the driver has received a block of octets, pass it into sercomm layer.
+ * Same as calling sercomm_drv_rx_char() for each octet, but runs of
+ * frame data are copied at once.  Returns the number of dropped octets */
+int sercomm_drv_rx_buf(const uint8_t *buf, unsigned int len)
+{
+	const uint8_t *p = buf, *end = buf + len, *run;
+	unsigned int room;
+	int dropped = 0;
+
+	while (p < end) {
+		switch (sercomm.rx.state) {
+		case RX_ST_WAIT_START:
+			/* everything up to the next flag is ignored */
+			while (p < end && *p != HDLC_FLAG)
+				p++;
+			if (p == end)
+				return dropped;
+			break;
+		case RX_ST_DATA:
+			if (!sercomm.rx.msg)
+				break;
+			room = msgb_tailroom(sercomm.rx.msg);
+			if (room > (unsigned int) (end - p))
+				room = end - p;
+			/* a full msgb or a control octet is left to
+			 * sercomm_drv_rx_char() */
+			run = sercomm_find_ctrl(p, p + room);
+			if (run > p) {
+				memcpy(msgb_put(sercomm.rx.msg, run - p), p,
+				       run - p);
+				p = run;
+				continue;
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (!sercomm_drv_rx_char(*p++))
+			dropped++;
+	}
+
+	return dropped;
+}
@@ -45,9 +45,15 @@ int sercomm_register_rx_cb(uint8_t dlci, dlci_cb_t cb);
 
 /* fetch one octet of to-be-transmitted serial data. returns 0 if no more data */
 int sercomm_drv_pull(uint8_t *ch);
+/* fetch up to len octets of to-be-transmitted serial data, as many
+   messages as fit. returns the number of octets, 0 if no more data */
+int sercomm_drv_pull_bulk(uint8_t *buf, unsigned int len);
 /* the driver has received one byte, pass it into sercomm layer.
    returns 1 in case of success, 0 in case of unrecognized char */
 int sercomm_drv_rx_char(uint8_t ch);
+/* the driver has received a block of octets, pass it into sercomm layer.
+   returns the number of unrecognized octets */
+int sercomm_drv_rx_buf(const uint8_t *buf, unsigned int len);
 
 static inline struct msgb *sercomm_alloc_msgb(unsigned int len)
 {